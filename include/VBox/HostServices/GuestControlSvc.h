@@ -73,6 +73,18 @@ enum eProcessStatus
  */
 #define INPUT_FLAG_NONE                     0x0
 #define INPUT_FLAG_EOF                      RT_BIT(0)
+/** Internal: Queue the input on the guest and report its status once all of
+ *  it was written, so the host can have several blocks in flight. Only used
+ *  when the guest reported PROC_STS_STARTED_FLAG_INPUT_QUEUE. */
+#define INPUT_FLAG_QUEUE                    RT_BIT(31)
+
+/**
+ * Flags reported by the guest along with PROC_STS_STARTED.
+ */
+#define PROC_STS_STARTED_FLAG_NONE          0x0
+/** The guest handles INPUT_FLAG_QUEUE and input blocks of up to
+ *  GUESTPROCESS_MAX_INPUT_QUEUE_BLOCK bytes. */
+#define PROC_STS_STARTED_FLAG_INPUT_QUEUE   RT_BIT(0)
 
 /**
  * Execution flags.
@@ -103,6 +115,13 @@ enum eProcessStatus
 #define GUESTPROCESS_MAX_ENV_LEN            _64K
 #define GUESTPROCESS_MAX_USER_LEN           128
 #define GUESTPROCESS_MAX_PASSWORD_LEN       128
+/** Maximum size of a single block of input without INPUT_FLAG_QUEUE. */
+#define GUESTPROCESS_MAX_INPUT_BLOCK        _64K
+/** Maximum size of a single block of input with INPUT_FLAG_QUEUE. */
+#define GUESTPROCESS_MAX_INPUT_QUEUE_BLOCK  _512K
+/** Maximum number of queued input blocks the host may have in flight per
+ *  process, bounds the guest memory used for the queue. */
+#define GUESTPROCESS_MAX_INPUT_QUEUE_BLOCKS 8
 
 /** @name Internal tools built into VBoxService which are used in order to
  *        accomplish tasks host<->guest.
@@ -284,7 +284,9 @@ enum eGuestFn
     /** Enumerate guest properties */
     ENUM_PROPS = 5,
     /** Poll for guest notifications */
-    GET_NOTIFICATION = 6
+    GET_NOTIFICATION = 6,
+    /** Set several guest properties in one go */
+    SET_PROPS = 7
 };
 
 /**
@@ -446,6 +448,20 @@ typedef struct _EnumProperties
     HGCMFunctionParameter size;
 } EnumProperties;
 
+/** The guest is requesting to change several properties in one go */
+typedef struct _SetProperties
+{
+    VBoxGuestHGCMCallInfo hdr;
+
+    /**
+     * Null-separated array of strings with the properties to set.  (IN pointer)
+     * The strings come in sequences of name, value and flags, with the same
+     * criteria as for the parameters of SetProperty.  The list is terminated
+     * by an empty string after a "flags" entry (or at the start).
+     */
+    HGCMFunctionParameter strings;
+} SetProperties;
+
 /**
  * The guest is polling for notifications on changes to properties, specifying
  * a set of patterns to match the names of changed properties against and
@@ -65,6 +65,11 @@
 #define VBOX_SHARED_CLIPBOARD_FN_READ_DATA         3
 /* Send data in requested format to host. */
 #define VBOX_SHARED_CLIPBOARD_FN_WRITE_DATA        4
+/* Obtain data in specified format from host, a chunk at a time. */
+#define VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK   5
+
+/* Offset passed to VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK to abandon a transfer. */
+#define VBOX_SHARED_CLIPBOARD_CHUNK_CANCEL         UINT32_MAX
 
 /*
  * The host messages for the guest.
@@ -132,6 +137,30 @@ typedef struct _VBoxClipboardWriteData
 
 #define VBOX_SHARED_CLIPBOARD_CPARMS_WRITE_DATA 2
 
+typedef struct _VBoxClipboardReadDataChunk
+{
+    VBoxGuestHGCMCallInfo hdr;
+
+    /* Requested format. */
+    HGCMFunctionParameter format; /* IN uint32_t */
+
+    /* Offset of the chunk in the data.  Offset 0 starts a new transfer,
+     * the host then keeps the data until the guest has read all of it,
+     * starts another transfer or passes VBOX_SHARED_CLIPBOARD_CHUNK_CANCEL.
+     */
+    HGCMFunctionParameter offset; /* IN uint32_t */
+
+    /* The chunk buffer.  The host fills it up to its size or to the
+     * end of the data, whichever comes first. */
+    HGCMFunctionParameter ptr;    /* IN linear pointer. */
+
+    /* Total size of the data. */
+    HGCMFunctionParameter size;   /* OUT uint32_t */
+
+} VBoxClipboardReadDataChunk;
+
+#define VBOX_SHARED_CLIPBOARD_CPARMS_READ_DATA_CHUNK 4
+
 #pragma pack ()
 
 #endif
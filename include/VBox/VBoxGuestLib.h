@@ -447,6 +447,7 @@ VBGLR3DECL(int)     VbglR3ClipboardConnect(uint32_t *pu32ClientId);
 VBGLR3DECL(int)     VbglR3ClipboardDisconnect(uint32_t u32ClientId);
 VBGLR3DECL(int)     VbglR3ClipboardGetHostMsg(uint32_t u32ClientId, uint32_t *pMsg, uint32_t *pfFormats);
 VBGLR3DECL(int)     VbglR3ClipboardReadData(uint32_t u32ClientId, uint32_t fFormat, void *pv, uint32_t cb, uint32_t *pcb);
+VBGLR3DECL(int)     VbglR3ClipboardReadDataChunk(uint32_t u32ClientId, uint32_t fFormat, uint32_t offChunk, void *pv, uint32_t cb, uint32_t *pcbTotal);
 VBGLR3DECL(int)     VbglR3ClipboardReportFormats(uint32_t u32ClientId, uint32_t fFormats);
 VBGLR3DECL(int)     VbglR3ClipboardWriteData(uint32_t u32ClientId, uint32_t fFormat, void *pv, uint32_t cb);
 /** @} */
@@ -516,6 +517,8 @@ VBGLR3DECL(int)     VbglR3GuestPropWrite(uint32_t u32ClientId, const char *pszNa
 VBGLR3DECL(int)     VbglR3GuestPropWriteValue(uint32_t u32ClientId, const char *pszName, const char *pszValue);
 VBGLR3DECL(int)     VbglR3GuestPropWriteValueV(uint32_t u32ClientId, const char *pszName, const char *pszValueFormat, va_list va);
 VBGLR3DECL(int)     VbglR3GuestPropWriteValueF(uint32_t u32ClientId, const char *pszName, const char *pszValueFormat, ...);
+VBGLR3DECL(int)     VbglR3GuestPropWriteMulti(uint32_t u32ClientId, uint32_t cProps, const char * const *papszNames,
+                                              const char * const *papszValues, const char * const *papszFlags);
 VBGLR3DECL(int)     VbglR3GuestPropRead(uint32_t u32ClientId, const char *pszName, void *pvBuf, uint32_t cbBuf, char **ppszValue, uint64_t *pu64Timestamp, char **ppszFlags, uint32_t *pcbBufActual);
 VBGLR3DECL(int)     VbglR3GuestPropReadValue(uint32_t ClientId, const char *pszName, char *pszValue, uint32_t cchValue, uint32_t *pcchValueActual);
 VBGLR3DECL(int)     VbglR3GuestPropReadValueAlloc(uint32_t u32ClientId, const char *pszName, char **ppszValue);
@@ -182,6 +182,7 @@ typedef enum
 #endif /* VBOX_WITH_64_BITS_GUESTS */
     VMMDevReq_HGCMCancel                 = 64,
     VMMDevReq_HGCMCancel2                = 65,
+    VMMDevReq_HGCMSetCompletionRing      = 66,
 #endif
     VMMDevReq_VideoAccelEnable           = 70,
     VMMDevReq_VideoAccelFlush            = 71,
@@ -1830,6 +1831,58 @@ typedef struct
 } VMMDevHGCMCancel2;
 AssertCompileSize(VMMDevHGCMCancel2, 24+4);
 
+/**
+ * HGCM completion ring.
+ *
+ * Lives in physically contiguous guest memory which the guest registers with
+ * VMMDevReq_HGCMSetCompletionRing.  Before raising VMMDEV_EVENT_HGCM for an
+ * asynchronously completed request, the host appends the physical address of
+ * the request, so the guest can wake up its waiter directly instead of
+ * checking every pending request.
+ *
+ * Both indexes are free running, the entry for an index is
+ * aGCPhysReqs[index % cEntries]. The guest must zero the ring before
+ * registering it.
+ */
+typedef struct
+{
+    /** Index of the next entry the host writes. Written by the host. */
+    uint32_t volatile idxProducer;
+    /** Index of the next entry the guest reads. Written by the guest. */
+    uint32_t volatile idxConsumer;
+    /** Set by the host when a completion could not be posted because the ring
+     * was full. The guest clears it and then checks every pending request. */
+    uint32_t volatile fOverflow;
+    /** Reserved, MBZ. */
+    uint32_t          u32Reserved;
+    /** Physical addresses of the completed requests. */
+    uint64_t          aGCPhysReqs[1];
+} VMMDevHGCMCompletionRing;
+AssertCompileSize(VMMDevHGCMCompletionRing, 16+8);
+
+/**
+ * HGCM completion ring registration request structure.
+ *
+ * Used by VMMDevReq_HGCMSetCompletionRing.
+ *
+ * VINF_SUCCESS when registered or unregistered.
+ * VERR_INVALID_PARAMETER if the ring address or the number of entries is invalid.
+ */
+typedef struct
+{
+    /** Header. */
+    VMMDevRequestHeader header;
+    /** The page aligned physical address of the VMMDevHGCMCompletionRing,
+     * 0 to unregister the current ring. */
+    uint64_t GCPhysRing;
+    /** The number of entries in aGCPhysReqs, a power of two. The ring must
+     * fit into one page. */
+    uint32_t cEntries;
+    /** Reserved, MBZ. */
+    uint32_t u32Reserved;
+} VMMDevHGCMSetCompletionRing;
+AssertCompileSize(VMMDevHGCMSetCompletionRing, 24+16);
+
 #endif /* VBOX_WITH_HGCM */
 
 
@@ -1900,6 +1953,8 @@ DECLINLINE(size_t) vmmdevGetRequestSize(VMMDevRequestType requestType)
 #endif /* VBOX_WITH_64_BITS_GUESTS */
         case VMMDevReq_HGCMCancel:
             return sizeof(VMMDevHGCMCancel);
+        case VMMDevReq_HGCMSetCompletionRing:
+            return sizeof(VMMDevHGCMSetCompletionRing);
 #endif /* VBOX_WITH_HGCM */
         case VMMDevReq_VideoAccelEnable:
             return sizeof(VMMDevVideoAccelEnable);
@@ -274,7 +274,7 @@ public:
     void readMachineRegistry(const xml::ElementNode &elmMachineRegistry);
     void readDHCPServers(const xml::ElementNode &elmDHCPServers);
 
-    void write(const com::Utf8Str strFilename);
+    void write(const com::Utf8Str strFilename, bool fFlushTmpDir = true);
 
     Host                    host;
     SystemProperties        systemProperties;
@@ -1116,7 +1116,7 @@ public:
 
     void importMachineXML(const xml::ElementNode &elmMachine);
 
-    void write(const com::Utf8Str &strFilename);
+    void write(const com::Utf8Str &strFilename, bool fFlushTmpDir = true);
 
     enum
     {
@@ -1004,7 +1004,8 @@ typedef struct VUSBURB
          * @param   pUrb    The URB.
          */
         DECLCALLBACKMEMBER(void, pfnFree)(PVUSBURB pUrb);
-        /** Submit timestamp. (logging only) */
+        /** Submit timestamp (RTTimeNanoTS), for logging and the UrbLatency
+         * statistics.  Zero if the URB was never submitted. */
         uint64_t        u64SubmitTS;
         /** The allocated data length. */
         uint32_t        cbDataAllocated;
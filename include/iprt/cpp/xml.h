@@ -251,8 +251,10 @@ public:
      * @param aMode     File mode.
      * @param aFileName File name.
      * @param aFlushIt  Whether to flush a writable file before closing it.
+     * @param aFlushParent  Whether to flush the parent directory as well when
+     *                  flushing the file before closing it.
      */
-    File(Mode aMode, const char *aFileName, bool aFlushIt = false);
+    File(Mode aMode, const char *aFileName, bool aFlushIt = false, bool aFlushParent = true);
 
     /**
      * Uses the given file handle to perform file operations. This file
@@ -721,6 +723,20 @@ public:
      */
     void write(const char *pcszFilename, bool fSafe);
 
+    /**
+     * Same as write(const char *, bool), except that the caller can choose not
+     * to flush the directory when the temporary file is closed.  The directory
+     * changes are still flushed after the rename.  This saves a sync for
+     * callers which write the same file frequently.
+     *
+     * @param   pcszFilename    The name of the output file.
+     * @param   fSafe           See write(const char *, bool).
+     * @param   fFlushTmpDir    Whether to flush the directory when closing
+     *                          the temporary file.  Ignored if @a fSafe is
+     *                          @c false.
+     */
+    void write(const char *pcszFilename, bool fSafe, bool fFlushTmpDir);
+
     static int WriteCallback(void *aCtxt, const char *aBuf, int aLen);
     static int CloseCallback(void *aCtxt);
 
@@ -730,7 +746,7 @@ public:
     static const char * const s_pszPrevSuff;
 
 private:
-    void writeInternal(const char *pcszFilename, bool fSafe);
+    void writeInternal(const char *pcszFilename, bool fSafe, bool fFlushDir);
 
     /* Obscure class data */
     struct Data;
@@ -1760,6 +1760,10 @@
 # define RTZipDecompCreate                              RT_MANGLER(RTZipDecompCreate)
 # define RTZipDecompDestroy                             RT_MANGLER(RTZipDecompDestroy)
 # define RTZipDecompress                                RT_MANGLER(RTZipDecompress)
+# define RTZipParCompCreate                             RT_MANGLER(RTZipParCompCreate)
+# define RTZipParCompDestroy                            RT_MANGLER(RTZipParCompDestroy)
+# define RTZipParCompFinish                             RT_MANGLER(RTZipParCompFinish)
+# define RTZipParCompress                               RT_MANGLER(RTZipParCompress)
 # define RTZipGzipDecompressIoStream                    RT_MANGLER(RTZipGzipDecompressIoStream)
 # define RTZipTarCmd                                    RT_MANGLER(RTZipTarCmd)
 # define RTZipTarFsStreamFromIoStream                   RT_MANGLER(RTZipTarFsStreamFromIoStream)
@@ -39,6 +39,12 @@ RT_C_DECLS_BEGIN
  *
  * @param   phStrCache          Where to return the string cache handle.
  * @param   pszName             The name of the cache (for debug purposes).
+ *
+ * @remarks The memory backing the strings is only freed when the cache is
+ *          destroyed, strings whose reference count drops to zero are kept
+ *          around for reuse.  Caches that see a steady flow of distinct,
+ *          short lived strings will therefore keep growing; use a cache
+ *          of their own that is destroyed from time to time.
  */
 RTDECL(int) RTStrCacheCreate(PRTSTRCACHE phStrCache, const char *pszName);
 
@@ -103,6 +109,9 @@ RTDECL(uint32_t) RTStrCacheRetain(const char *psz);
  * @param   hStrCache           Handle to the string cache. Passing NIL is ok,
  *                              but this may come a performance hit.
  * @param   psz                 Pointer to a cached string.
+ *
+ * @remarks Releasing the last reference does not free the string, it stays
+ *          in the cache until RTStrCacheDestroy.  See RTStrCacheCreate.
  */
 RTDECL(uint32_t) RTStrCacheRelease(RTSTRCACHE hStrCache, const char *psz);
 
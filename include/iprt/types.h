@@ -2119,6 +2119,8 @@ typedef const RTUUID *PCRTUUID;
 typedef struct RTZIPCOMP   *PRTZIPCOMP;
 /** Decompressor handle. */
 typedef struct RTZIPDECOMP *PRTZIPDECOMP;
+/** Parallel compressor handle. */
+typedef struct RTZIPPARCOMP *PRTZIPPARCOMP;
 
 
 /**
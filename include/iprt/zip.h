@@ -86,6 +86,8 @@ typedef enum RTZIPTYPE
     RTZIPTYPE_LZJB,
     /** Lempel-Ziv-Oberhumer compression. */
     RTZIPTYPE_LZO,
+    /** LZ4 compression, fast and suitable for parallel compression. */
+    RTZIPTYPE_LZ4,
     /** End of valid the valid compression types.  */
     RTZIPTYPE_END
 } RTZIPTYPE;
@@ -178,6 +180,59 @@ RTDECL(int)     RTZipDecompress(PRTZIPDECOMP pZip, void *pvBuf, size_t cbBuf, si
 RTDECL(int)     RTZipDecompDestroy(PRTZIPDECOMP pZip);
 
 
+/**
+ * Create a parallel stream compressor instance.
+ *
+ * The input is cut into frames of @a cbFrame bytes which are compressed
+ * independently by a set of worker threads.  The output is delivered to
+ * @a pfnOut in order, on the calling thread, and is a regular compressed
+ * stream that can be read back using RTZipDecompCreate.
+ *
+ * @returns iprt status code.
+ * @retval  VERR_NOT_SUPPORTED if @a enmType cannot be compressed in parallel.
+ *          Currently only RTZIPTYPE_LZ4 (and RTZIPTYPE_AUTO) can.
+ * @param   ppZip       Where to store the instance handle.
+ * @param   pvUser      User argument which will be passed on to pfnOut.
+ * @param   pfnOut      Callback for consuming output of compression.
+ * @param   enmType     Type of compressor to create.
+ * @param   enmLevel    Compression level.
+ * @param   cThreads    The number of worker threads, 0 for one per online
+ *                      CPU.
+ * @param   cbFrame     The frame size, 0 for the default (1MB).
+ */
+RTDECL(int)     RTZipParCompCreate(PRTZIPPARCOMP *ppZip, void *pvUser, PFNRTZIPOUT pfnOut, RTZIPTYPE enmType,
+                                   RTZIPLEVEL enmLevel, uint32_t cThreads, size_t cbFrame);
+
+/**
+ * Queues a chunk of memory for parallel compression.
+ *
+ * This may call the output callback with frames that have completed.
+ *
+ * @returns iprt status code.
+ * @param   pZip        The parallel compressor instance.
+ * @param   pvBuf       Pointer to buffer containing the bits to compress.
+ * @param   cbBuf       Number of bytes to compress.
+ */
+RTDECL(int)     RTZipParCompress(PRTZIPPARCOMP pZip, const void *pvBuf, size_t cbBuf);
+
+/**
+ * Finishes the parallel compression.
+ * This will wait for all frames and write out the remaining data.
+ *
+ * @returns iprt status code.
+ * @param   pZip        The parallel compressor instance.
+ */
+RTDECL(int)     RTZipParCompFinish(PRTZIPPARCOMP pZip);
+
+/**
+ * Destroys the parallel compressor instance, terminating the workers.
+ *
+ * @returns iprt status code.
+ * @param   pZip        The parallel compressor instance.  NULL is ignored.
+ */
+RTDECL(int)     RTZipParCompDestroy(PRTZIPPARCOMP pZip);
+
+
 /**
  * Compress a chunk of memory into a block.
  *
@@ -327,6 +327,99 @@ static void vboxGuestTermUnfixGuestMappings(PVBOXGUESTDEVEXT pDevExt)
 }
 
 
+#ifdef VBOX_WITH_HGCM
+/** The number of entries in the HGCM completion ring. */
+#define VBOXGUEST_HGCM_RING_ENTRIES     256
+AssertCompile(sizeof(VMMDevHGCMCompletionRing) + (VBOXGUEST_HGCM_RING_ENTRIES - 1) * sizeof(uint64_t) <= PAGE_SIZE);
+
+/**
+ * Allocates the HGCM completion ring and registers it with the host.
+ *
+ * This is not fatal if it fails (older hosts don't know the request), the
+ * ISR then checks every pending HGCM request for completion.
+ *
+ * @param   pDevExt     The device extension.
+ */
+static void vboxGuestInitHGCMCompletionRing(PVBOXGUESTDEVEXT pDevExt)
+{
+    VMMDevHGCMSetCompletionRing *pReq;
+    RTR0MEMOBJ hMemObj;
+    int rc = RTR0MemObjAllocCont(&hMemObj, PAGE_SIZE, false /* fExecutable */);
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("vboxGuestInitHGCMCompletionRing: RTR0MemObjAllocCont failed, rc=%Rrc\n", rc));
+        return;
+    }
+    RT_BZERO(RTR0MemObjAddress(hMemObj), PAGE_SIZE);
+
+    rc = VbglGRAlloc((VMMDevRequestHeader **)&pReq, sizeof(*pReq), VMMDevReq_HGCMSetCompletionRing);
+    if (RT_SUCCESS(rc))
+    {
+        pReq->GCPhysRing  = RTR0MemObjGetPagePhysAddr(hMemObj, 0);
+        pReq->cEntries    = VBOXGUEST_HGCM_RING_ENTRIES;
+        pReq->u32Reserved = 0;
+        rc = VbglGRPerform(&pReq->header);
+        VbglGRFree(&pReq->header);
+    }
+    if (RT_SUCCESS(rc))
+    {
+        RTSpinlockAcquire(pDevExt->EventSpinlock);
+        pDevExt->hHGCMRingMemObj  = hMemObj;
+        pDevExt->cHGCMRingEntries = VBOXGUEST_HGCM_RING_ENTRIES;
+        pDevExt->pHGCMRing        = (VMMDevHGCMCompletionRing volatile *)RTR0MemObjAddress(hMemObj);
+        RTSpinlockReleaseNoInts(pDevExt->EventSpinlock);
+    }
+    else
+    {
+        Log(("vboxGuestInitHGCMCompletionRing: not using a completion ring, rc=%Rrc\n", rc));
+        RTR0MemObjFree(hMemObj, false /* fFreeMappings */);
+    }
+}
+
+
+/**
+ * Undo what vboxGuestInitHGCMCompletionRing did.
+ *
+ * @param   pDevExt     The device extension.
+ */
+static void vboxGuestTermHGCMCompletionRing(PVBOXGUESTDEVEXT pDevExt)
+{
+    if (pDevExt->hHGCMRingMemObj != NIL_RTR0MEMOBJ)
+    {
+        /*
+         * Tell the host to stop using the ring, then free it. (Leak the memory
+         * if the host might still write to it.)
+         */
+        VMMDevHGCMSetCompletionRing *pReq;
+        int rc = VbglGRAlloc((VMMDevRequestHeader **)&pReq, sizeof(*pReq), VMMDevReq_HGCMSetCompletionRing);
+        if (RT_SUCCESS(rc))
+        {
+            pReq->GCPhysRing  = 0;
+            pReq->cEntries    = 0;
+            pReq->u32Reserved = 0;
+            rc = VbglGRPerform(&pReq->header);
+            VbglGRFree(&pReq->header);
+        }
+
+        RTSpinlockAcquire(pDevExt->EventSpinlock);
+        pDevExt->pHGCMRing        = NULL;
+        pDevExt->cHGCMRingEntries = 0;
+        RTSpinlockReleaseNoInts(pDevExt->EventSpinlock);
+
+        if (RT_SUCCESS(rc))
+        {
+            rc = RTR0MemObjFree(pDevExt->hHGCMRingMemObj, false /* fFreeMappings */);
+            AssertRC(rc);
+        }
+        else
+            LogRel(("vboxGuestTermHGCMCompletionRing: Failed to unregister the HGCM completion ring! rc=%Rrc\n", rc));
+
+        pDevExt->hHGCMRingMemObj = NIL_RTR0MEMOBJ;
+    }
+}
+#endif /* VBOX_WITH_HGCM */
+
+
 /**
  * Sets the interrupt filter mask during initialization and termination.
  *
@@ -775,6 +868,10 @@ int VBoxGuestInitDevExt(PVBOXGUESTDEVEXT pDevExt, uint16_t IOPortBase,
     RTListInit(&pDevExt->WaitList);
 #ifdef VBOX_WITH_HGCM
     RTListInit(&pDevExt->HGCMWaitList);
+    pDevExt->HGCMWaitTree = NULL;
+    pDevExt->pHGCMRing = NULL;
+    pDevExt->cHGCMRingEntries = 0;
+    pDevExt->hHGCMRingMemObj = NIL_RTR0MEMOBJ;
 #endif
 #ifdef VBOXGUEST_USE_DEFERRED_WAKE_UP
     RTListInit(&pDevExt->WakeUpList);
@@ -876,6 +973,9 @@ int VBoxGuestInitDevExt(PVBOXGUESTDEVEXT pDevExt, uint16_t IOPortBase,
                     if (RT_SUCCESS(rc))
                     {
                         vboxGuestInitFixateGuestMappings(pDevExt);
+#ifdef VBOX_WITH_HGCM
+                        vboxGuestInitHGCMCompletionRing(pDevExt);
+#endif
 
 #ifdef DEBUG
                         testSetMouseStatus();  /* Other tests? */
@@ -951,6 +1051,9 @@ void VBoxGuestDeleteDevExt(PVBOXGUESTDEVEXT pDevExt)
      * Clean up the bits that involves the host first.
      */
     vboxGuestTermUnfixGuestMappings(pDevExt);
+#ifdef VBOX_WITH_HGCM
+    vboxGuestTermHGCMCompletionRing(pDevExt);
+#endif
     VBoxGuestSetGuestCapabilities(0, UINT32_MAX);       /* clears all capabilities */
     vboxGuestSetFilterMask(pDevExt, 0);                 /* filter all events */
     vboxGuestCloseMemBalloon(pDevExt, (PVBOXGUESTSESSION)NULL);
@@ -1142,6 +1245,7 @@ static PVBOXGUESTWAIT VBoxGuestWaitAlloc(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSES
     pWait->pSession = pSession;
 #ifdef VBOX_WITH_HGCM
     pWait->pHGCMReq = NULL;
+    pWait->HGCMReqNode.Key = NULL;
 #endif
     RTSemEventMultiReset(pWait->Event);
     return pWait;
@@ -1162,6 +1266,11 @@ static void VBoxGuestWaitFreeLocked(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTWAIT pWa
     pWait->fReqEvents = 0;
     pWait->fResEvents = 0;
 #ifdef VBOX_WITH_HGCM
+    if (pWait->HGCMReqNode.Key)
+    {
+        RTAvlPVRemove(&pDevExt->HGCMWaitTree, pWait->HGCMReqNode.Key);
+        pWait->HGCMReqNode.Key = NULL;
+    }
     pWait->pHGCMReq = NULL;
 #endif
 #ifdef VBOXGUEST_USE_DEFERRED_WAKE_UP
@@ -1845,14 +1954,17 @@ static int VBoxGuestHGCMAsyncWaitCallbackWorker(VMMDevHGCMRequestHeader volatile
     }
     pWait->fReqEvents = VMMDEV_EVENT_HGCM;
     pWait->pHGCMReq = pHdr;
+    pWait->HGCMReqNode.Key = (AVLPVKEY)(uintptr_t)VbglPhysHeapGetPhysAddr((void *)pHdr);
 
     /*
      * Re-enter the spinlock and re-check for the condition.
      * If the condition is met, return.
-     * Otherwise link us into the HGCM wait list and go to sleep.
+     * Otherwise link us into the HGCM wait list and tree and go to sleep.
      */
     RTSpinlockAcquire(pDevExt->EventSpinlock);
     RTListAppend(&pDevExt->HGCMWaitList, &pWait->ListNode);
+    if (!RTAvlPVInsert(&pDevExt->HGCMWaitTree, &pWait->HGCMReqNode))
+        pWait->HGCMReqNode.Key = NULL; /* paranoia, the list walk still finds us. */
     if ((pHdr->fu32Flags & VBOX_HGCM_REQ_DONE) != 0)
     {
         VBoxGuestWaitFreeLocked(pDevExt, pWait);
@@ -2903,6 +3015,37 @@ int VBoxGuestCommonIOCtl(unsigned iFunction, PVBOXGUESTDEVEXT pDevExt, PVBOXGUES
 
 
 
+#ifdef VBOX_WITH_HGCM
+/**
+ * Wakes up a thread waiting for an HGCM request to complete.
+ *
+ * The caller must own the wait spinlock !
+ *
+ * @returns IPRT status code of the signalling.
+ * @param   pDevExt         The device extension.
+ * @param   pWait           The wait-for-event entry in HGCMWaitList.
+ */
+static int VBoxGuestHGCMWakeUpLocked(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTWAIT pWait)
+{
+    int rc = VINF_SUCCESS;
+    if (pWait->HGCMReqNode.Key)
+    {
+        RTAvlPVRemove(&pDevExt->HGCMWaitTree, pWait->HGCMReqNode.Key);
+        pWait->HGCMReqNode.Key = NULL;
+    }
+    pWait->fResEvents = VMMDEV_EVENT_HGCM;
+    RTListNodeRemove(&pWait->ListNode);
+# ifdef VBOXGUEST_USE_DEFERRED_WAKE_UP
+    RTListAppend(&pDevExt->WakeUpList, &pWait->ListNode);
+# else
+    RTListAppend(&pDevExt->WokenUpList, &pWait->ListNode);
+    rc = RTSemEventMultiSignal(pWait->Event);
+# endif
+    return rc;
+}
+#endif /* VBOX_WITH_HGCM */
+
+
 /**
  * Common interrupt service routine.
  *
@@ -2967,24 +3110,44 @@ bool VBoxGuestCommonISR(PVBOXGUESTDEVEXT pDevExt)
 
 #ifdef VBOX_WITH_HGCM
             /*
-             * The HGCM event/list is kind of different in that we evaluate all entries.
+             * The host posts each completed request to the completion ring, so
+             * we can wake up its waiter directly. All waiters are checked if
+             * there is no ring, if the ring overflowed, or if nothing was posted
+             * (the host lost the ring, e.g. when restoring an older saved state).
              */
             if (fEvents & VMMDEV_EVENT_HGCM)
             {
-                RTListForEachSafe(&pDevExt->HGCMWaitList, pWait, pSafe, VBOXGUESTWAIT, ListNode)
+                VMMDevHGCMCompletionRing volatile *pRing = pDevExt->pHGCMRing;
+                bool fCheckAll = true;
+                if (pRing)
                 {
-                    if (pWait->pHGCMReq->fu32Flags & VBOX_HGCM_REQ_DONE)
+                    uint32_t const cEntries    = pDevExt->cHGCMRingEntries;
+                    uint32_t       idxConsumer = pRing->idxConsumer;
+                    uint32_t const idxProducer = ASMAtomicReadU32(&pRing->idxProducer);
+                    if (idxProducer - idxConsumer <= cEntries)
                     {
-                        pWait->fResEvents = VMMDEV_EVENT_HGCM;
-                        RTListNodeRemove(&pWait->ListNode);
-# ifdef VBOXGUEST_USE_DEFERRED_WAKE_UP
-                        RTListAppend(&pDevExt->WakeUpList, &pWait->ListNode);
-# else
-                        RTListAppend(&pDevExt->WokenUpList, &pWait->ListNode);
-                        rc |= RTSemEventMultiSignal(pWait->Event);
-# endif
+                        fCheckAll = idxProducer == idxConsumer;
+                        while (idxConsumer != idxProducer)
+                        {
+                            AVLPVKEY Key = (AVLPVKEY)(uintptr_t)pRing->aGCPhysReqs[idxConsumer & (cEntries - 1)];
+                            pWait = (PVBOXGUESTWAIT)RTAvlPVGet(&pDevExt->HGCMWaitTree, Key);
+                            if (   pWait
+                                && (pWait->pHGCMReq->fu32Flags & VBOX_HGCM_REQ_DONE))
+                                rc |= VBoxGuestHGCMWakeUpLocked(pDevExt, pWait);
+                            idxConsumer++;
+                        }
                     }
+                    ASMAtomicWriteU32(&pRing->idxConsumer, idxProducer);
+                    if (ASMAtomicXchgU32(&pRing->fOverflow, 0))
+                        fCheckAll = true;
                 }
+
+                if (fCheckAll)
+                    RTListForEachSafe(&pDevExt->HGCMWaitList, pWait, pSafe, VBOXGUESTWAIT, ListNode)
+                    {
+                        if (pWait->pHGCMReq->fu32Flags & VBOX_HGCM_REQ_DONE)
+                            rc |= VBoxGuestHGCMWakeUpLocked(pDevExt, pWait);
+                    }
                 fEvents &= ~VMMDEV_EVENT_HGCM;
             }
 #endif
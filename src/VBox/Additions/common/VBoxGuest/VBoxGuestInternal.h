@@ -28,6 +28,7 @@
 #define ___VBoxGuestInternal_h
 
 #include <iprt/types.h>
+#include <iprt/avl.h>
 #include <iprt/list.h>
 #include <iprt/semaphore.h>
 #include <iprt/spinlock.h>
@@ -77,6 +78,9 @@ typedef struct VBOXGUESTWAIT
 #ifdef VBOX_WITH_HGCM
     /** The HGCM request we're waiting for to complete. */
     VMMDevHGCMRequestHeader volatile *pHGCMReq;
+    /** Node in VBOXGUESTDEVEXT::HGCMWaitTree, the key is the physical address
+     * of pHGCMReq. The key is NULL while not in the tree. */
+    AVLPVNODECORE               HGCMReqNode;
 #endif
 } VBOXGUESTWAIT;
 
@@ -138,6 +142,16 @@ typedef struct VBOXGUESTDEVEXT
      * the other lists which are only evaluated till the first thread has
      * been woken up. */
     RTLISTANCHOR                HGCMWaitList;
+    /** The entries of HGCMWaitList by the physical address of their request, so
+     * that the ISR can look up the waiter for a completion ring entry. */
+    AVLPVTREE                   HGCMWaitTree;
+    /** The HGCM completion ring shared with the host, NULL if the host does
+     * not support it.  Changed while holding EventSpinlock. */
+    VMMDevHGCMCompletionRing volatile *pHGCMRing;
+    /** The number of entries in pHGCMRing, a power of two. */
+    uint32_t                    cHGCMRingEntries;
+    /** The memory object backing pHGCMRing. */
+    RTR0MEMOBJ                  hHGCMRingMemObj;
 #endif
 #ifdef VBOXGUEST_USE_DEFERRED_WAKE_UP
     /** List of wait-for-event entries that needs waking up
@@ -26,8 +26,10 @@
 
 #include "VBGLInternal.h"
 
+#include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/semaphore.h>
+#include <iprt/string.h>
 #include <iprt/alloc.h>
 
 /* Physical memory heap consists of double linked list
@@ -52,6 +54,13 @@
  * merged together. Current implementation merges blocks only
  * when there is a block after the just freed one.
  *
+ * Small requests (up to 2KB) are rounded up to a power of two size
+ * class. When such a block is freed it is parked in a small lock-free
+ * per class cache instead of going back to the lists, and the next
+ * allocation of that class takes it from there without touching the
+ * heap mutex or searching the free list. Cached blocks stay marked as
+ * allocated, so the heap itself never sees them.
+ *
  */
 
 #define VBGL_PH_ASSERT      Assert
@@ -77,6 +86,9 @@
 /* Heap block bit flags */
 #define VBGL_PH_BF_ALLOCATED (0x1)
 
+/* Log2 of the smallest block cache size class */
+#define VBGL_PH_CACHE_MIN_SHIFT (6)
+
 struct _VBGLPHYSHEAPBLOCK
 {
     uint32_t u32Signature;
@@ -189,6 +201,75 @@ DECLINLINE(void) vbglPhysHeapLeave (void)
 }
 
 
+/* Returns the cache size class for an allocation of cbSize bytes, -1 if too big. */
+DECLINLINE(int) vbglPhysHeapCacheClassForAlloc (uint32_t cbSize)
+{
+    int iClass = 0;
+
+    while ((UINT32_C(1) << (VBGL_PH_CACHE_MIN_SHIFT + iClass)) < cbSize)
+    {
+        if (++iClass >= VBGL_PH_CACHE_CLASSES)
+            return -1;
+    }
+
+    return iClass;
+}
+
+/* Returns the cache size class a free block of cbDataSize bytes can serve, -1 if none. */
+DECLINLINE(int) vbglPhysHeapCacheClassForFree (uint32_t cbDataSize)
+{
+    int iClass = VBGL_PH_CACHE_CLASSES - 1;
+
+    if (   cbDataSize < (UINT32_C(1) << VBGL_PH_CACHE_MIN_SHIFT)
+        || cbDataSize >= (UINT32_C(2) << (VBGL_PH_CACHE_MIN_SHIFT + iClass)))
+        return -1;
+
+    while ((UINT32_C(1) << (VBGL_PH_CACHE_MIN_SHIFT + iClass)) > cbDataSize)
+        iClass--;
+
+    return iClass;
+}
+
+static VBGLPHYSHEAPBLOCK *vbglPhysHeapCacheGet (int iClass)
+{
+    VBGLPHYSHEAPBLOCK * volatile *papSlots = &g_vbgldata.apCachedBlocks[iClass][0];
+    unsigned i;
+
+    for (i = 0; i < VBGL_PH_CACHE_SLOTS; i++)
+    {
+        if (papSlots[i])
+        {
+            /* Only the thread that swaps in the NULL gets the block. */
+            VBGLPHYSHEAPBLOCK *pBlock = ASMAtomicXchgPtrT (&papSlots[i], NULL, VBGLPHYSHEAPBLOCK *);
+            if (pBlock)
+                return pBlock;
+        }
+    }
+
+    return NULL;
+}
+
+static bool vbglPhysHeapCachePut (VBGLPHYSHEAPBLOCK *pBlock)
+{
+    int iClass = vbglPhysHeapCacheClassForFree (pBlock->cbDataSize);
+    VBGLPHYSHEAPBLOCK * volatile *papSlots;
+    unsigned i;
+
+    if (iClass < 0)
+        return false;
+
+    papSlots = &g_vbgldata.apCachedBlocks[iClass][0];
+    for (i = 0; i < VBGL_PH_CACHE_SLOTS; i++)
+    {
+        if (   !papSlots[i]
+            && ASMAtomicCmpXchgPtr (&papSlots[i], pBlock, NULL))
+            return true;
+    }
+
+    return false;
+}
+
+
 static void vbglPhysHeapInitBlock (VBGLPHYSHEAPBLOCK *pBlock, VBGLPHYSHEAPCHUNK *pChunk, uint32_t cbDataSize)
 {
     VBGL_PH_ASSERT(pBlock != NULL);
@@ -394,8 +475,26 @@ void vbglPhysHeapChunkDelete (VBGLPHYSHEAPCHUNK *pChunk)
 DECLVBGL(void *) VbglPhysHeapAlloc (uint32_t cbSize)
 {
     VBGLPHYSHEAPBLOCK *pBlock, *iter;
-    int rc = vbglPhysHeapEnter ();
+    int rc;
+    int iClass = vbglPhysHeapCacheClassForAlloc (cbSize);
+
+    if (iClass >= 0)
+    {
+        /* Fast path, reuse a cached block without taking the heap mutex. */
+        pBlock = vbglPhysHeapCacheGet (iClass);
+        if (pBlock)
+        {
+            VBGL_PH_ASSERTMsg(pBlock->u32Signature == VBGL_PH_BLOCKSIGNATURE && (pBlock->fu32Flags & VBGL_PH_BF_ALLOCATED),
+                             ("pBlock = %p, pBlock->u32Signature = %08X, pBlock->fu32Flags = %08X\n",
+                              pBlock, pBlock->u32Signature, pBlock->fu32Flags));
+            return vbglPhysHeapBlock2Data (pBlock);
+        }
 
+        /* Round up to the class size so the block can be cached when freed. */
+        cbSize = UINT32_C(1) << (VBGL_PH_CACHE_MIN_SHIFT + iClass);
+    }
+
+    rc = vbglPhysHeapEnter ();
     if (RT_FAILURE(rc))
         return NULL;
 
@@ -514,24 +613,26 @@ DECLVBGL(void) VbglPhysHeapFree (void *p)
 {
     VBGLPHYSHEAPBLOCK *pBlock;
     VBGLPHYSHEAPBLOCK *pNeighbour;
-
-    int rc = vbglPhysHeapEnter ();
-    if (RT_FAILURE(rc))
-        return;
-
-    dumpheap ("pre free");
+    int rc;
 
     pBlock = vbglPhysHeapData2Block (p);
 
     if (!pBlock)
-    {
-        vbglPhysHeapLeave ();
         return;
-    }
 
     VBGL_PH_ASSERTMsg((pBlock->fu32Flags & VBGL_PH_BF_ALLOCATED) != 0,
                      ("pBlock = %p, pBlock->fu32Flags = %08X\n", pBlock, pBlock->fu32Flags));
 
+    /* Fast path, park small blocks in the cache for the next allocation. */
+    if (vbglPhysHeapCachePut (pBlock))
+        return;
+
+    rc = vbglPhysHeapEnter ();
+    if (RT_FAILURE(rc))
+        return;
+
+    dumpheap ("pre free");
+
     /* Exclude from allocated list */
     vbglPhysHeapExcludeBlock (pBlock);
 
@@ -611,6 +712,8 @@ DECLVBGL(int) VbglPhysHeapInit (void)
 {
     int rc = VINF_SUCCESS;
 
+    memset ((void *)&g_vbgldata.apCachedBlocks[0][0], 0, sizeof (g_vbgldata.apCachedBlocks));
+
     /* Allocate the first chunk of the heap. */
     VBGLPHYSHEAPBLOCK *pBlock = vbglPhysHeapChunkAlloc (0);
 
@@ -624,6 +727,9 @@ DECLVBGL(int) VbglPhysHeapInit (void)
 
 DECLVBGL(void) VbglPhysHeapTerminate (void)
 {
+    /* The cached blocks go away together with their chunks. */
+    memset ((void *)&g_vbgldata.apCachedBlocks[0][0], 0, sizeof (g_vbgldata.apCachedBlocks));
+
     while (g_vbgldata.pChunkHead)
     {
         vbglPhysHeapChunkDelete (g_vbgldata.pChunkHead);
@@ -53,6 +53,11 @@ typedef struct _VBGLPHYSHEAPBLOCK VBGLPHYSHEAPBLOCK;
 struct _VBGLPHYSHEAPCHUNK;
 typedef struct _VBGLPHYSHEAPCHUNK VBGLPHYSHEAPCHUNK;
 
+/** Number of size classes in the physical heap block cache, 64 bytes thru 2KB. */
+#define VBGL_PH_CACHE_CLASSES   6
+/** Number of blocks the physical heap block cache holds per size class. */
+#define VBGL_PH_CACHE_SLOTS     8
+
 #ifndef VBGL_VBOXGUEST
 struct VBGLHGCMHANDLEDATA
 {
@@ -90,6 +95,10 @@ typedef struct _VBGLDATA
     VBGLPHYSHEAPCHUNK *pChunkHead;
 
     RTSEMFASTMUTEX mutexHeap;
+
+    /** Lock-free cache of freed blocks, indexed by size class. The cached
+     * blocks are still allocated as far as the lists above are concerned. */
+    VBGLPHYSHEAPBLOCK * volatile apCachedBlocks[VBGL_PH_CACHE_CLASSES][VBGL_PH_CACHE_SLOTS];
     /** @} */
 
     /**
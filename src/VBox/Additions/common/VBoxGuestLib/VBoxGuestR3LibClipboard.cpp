@@ -172,6 +172,51 @@ VBGLR3DECL(int) VbglR3ClipboardReadData(uint32_t u32ClientId, uint32_t fFormat,
 }
 
 
+/**
+ * Reads a chunk of the host clipboard data.
+ *
+ * Offset 0 starts a new transfer.  If the data fits into the buffer, that is
+ * all there is to it, otherwise the caller reads the following chunks by
+ * offset until it has *pcbTotal bytes, or abandons the transfer by passing
+ * VBOX_SHARED_CLIPBOARD_CHUNK_CANCEL.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_IMPLEMENTED    If the host does not support chunked reads,
+ *                                  use VbglR3ClipboardReadData() then.
+ *
+ * @param   u32ClientId     The client id returned by VbglR3ClipboardConnect().
+ * @param   fFormat         The format we're requesting the data in.
+ * @param   offChunk        The offset of the chunk in the data.
+ * @param   pv              Where to store the chunk.
+ * @param   cb              The size of the buffer pointed to by pv.  The
+ *                          chunk is this size except at the end of the data.
+ * @param   pcbTotal        The total size of the host clipboard data.
+ */
+VBGLR3DECL(int) VbglR3ClipboardReadDataChunk(uint32_t u32ClientId, uint32_t fFormat, uint32_t offChunk,
+                                             void *pv, uint32_t cb, uint32_t *pcbTotal)
+{
+    VBoxClipboardReadDataChunk Msg;
+
+    Msg.hdr.result = VERR_WRONG_ORDER;
+    Msg.hdr.u32ClientID = u32ClientId;
+    Msg.hdr.u32Function = VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK;
+    Msg.hdr.cParms = 4;
+    VbglHGCMParmUInt32Set(&Msg.format, fFormat);
+    VbglHGCMParmUInt32Set(&Msg.offset, offChunk);
+    VbglHGCMParmPtrSet(&Msg.ptr, pv, cb);
+    VbglHGCMParmUInt32Set(&Msg.size, 0);
+
+    int rc = vbglR3DoIOCtl(VBOXGUEST_IOCTL_HGCM_CALL(sizeof(Msg)), &Msg, sizeof(Msg));
+    if (RT_SUCCESS(rc))
+    {
+        rc = Msg.hdr.result;
+        if (RT_SUCCESS(rc))
+            rc = VbglHGCMParmUInt32Get(&Msg.size, pcbTotal);
+    }
+    return rc;
+}
+
+
 /**
  * Advertises guest clipboard formats to the host.
  *
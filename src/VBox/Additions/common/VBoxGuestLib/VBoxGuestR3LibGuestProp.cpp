@@ -293,6 +293,81 @@ VBGLR3DECL(int) VbglR3GuestPropWriteValueF(uint32_t u32ClientId, const char *psz
     va_end(va);
     return rc;
 }
+
+
+/**
+ * Write several properties in one go.
+ *
+ * The host sets either all of them or none, and only notifies its listeners
+ * about the ones which really changed.  Hosts which don't know about this get
+ * the properties written one by one.
+ *
+ * @returns VBox status code.
+ *
+ * @param   u32ClientId     The client ID returned by VbglR3InvsSvcConnect().
+ * @param   cProps          The number of properties to write.
+ * @param   papszNames      The property names.  Must be valid UTF-8.
+ * @param   papszValues     The property values.  Must be valid UTF-8.
+ * @param   papszFlags      The property flags.  NULL entries mean no flags.
+ */
+VBGLR3DECL(int) VbglR3GuestPropWriteMulti(uint32_t u32ClientId, uint32_t cProps, const char * const *papszNames,
+                                          const char * const *papszValues, const char * const *papszFlags)
+{
+    AssertPtrReturn(papszNames, VERR_INVALID_POINTER);
+    AssertPtrReturn(papszValues, VERR_INVALID_POINTER);
+    AssertPtrReturn(papszFlags, VERR_INVALID_POINTER);
+
+    /*
+     * Pack the name, value and flags triples, terminated by an empty string.
+     */
+    size_t cbBuf = 1;
+    for (uint32_t i = 0; i < cProps; i++)
+    {
+        AssertPtrReturn(papszNames[i], VERR_INVALID_POINTER);
+        AssertPtrReturn(papszValues[i], VERR_INVALID_POINTER);
+        cbBuf += strlen(papszNames[i]) + 1 + strlen(papszValues[i]) + 1
+               + (papszFlags[i] ? strlen(papszFlags[i]) : 0) + 1;
+    }
+    AssertReturn(cbBuf <= UINT32_MAX, VERR_TOO_MUCH_DATA);
+    char *pchBuf = (char *)RTMemAlloc(cbBuf);
+    if (!pchBuf)
+        return VERR_NO_MEMORY;
+    char *pch = pchBuf;
+    for (uint32_t i = 0; i < cProps; i++)
+    {
+        const char *apsz[3] = { papszNames[i], papszValues[i], papszFlags[i] ? papszFlags[i] : "" };
+        for (unsigned j = 0; j < RT_ELEMENTS(apsz); j++)
+        {
+            size_t cb = strlen(apsz[j]) + 1;
+            memcpy(pch, apsz[j], cb);
+            pch += cb;
+        }
+    }
+    *pch = '\0';
+
+    SetProperties Msg;
+
+    Msg.hdr.result = VERR_WRONG_ORDER;
+    Msg.hdr.u32ClientID = u32ClientId;
+    Msg.hdr.u32Function = SET_PROPS;
+    Msg.hdr.cParms = 1;
+    VbglHGCMParmPtrSet(&Msg.strings, pchBuf, (uint32_t)cbBuf);
+    int rc = vbglR3DoIOCtl(VBOXGUEST_IOCTL_HGCM_CALL(sizeof(Msg)), &Msg, sizeof(Msg));
+    if (RT_SUCCESS(rc))
+        rc = Msg.hdr.result;
+    RTMemFree(pchBuf);
+
+    /*
+     * Older hosts only know how to set one property at a time.
+     */
+    if (rc == VERR_NOT_IMPLEMENTED)
+    {
+        rc = VINF_SUCCESS;
+        for (uint32_t i = 0; i < cProps && RT_SUCCESS(rc); i++)
+            rc = VbglR3GuestPropWrite(u32ClientId, papszNames[i], papszValues[i], papszFlags[i] ? papszFlags[i] : "");
+    }
+    return rc;
+}
 #endif /* VBOX_VBGLR3_XFREE86 */
 
 /**
@@ -246,7 +246,7 @@ DECLCALLBACK(int) VBoxServiceControlWorker(bool volatile *pfShutdown)
 
     /* Allocate a scratch buffer for commands which also send
      * payload data with them. */
-    uint32_t cbScratchBuf = _64K; /** @todo Make buffer size configurable via guest properties/argv! */
+    uint32_t cbScratchBuf = GUESTPROCESS_MAX_INPUT_QUEUE_BLOCK; /** @todo Make buffer size configurable via guest properties/argv! */
     AssertReturn(RT_IS_POWER_OF_TWO(cbScratchBuf), VERR_INVALID_PARAMETER);
     uint8_t *pvScratchBuf = (uint8_t*)RTMemAlloc(cbScratchBuf);
     AssertPtrReturn(pvScratchBuf, VERR_NO_MEMORY);
@@ -581,12 +581,14 @@ int VBoxServiceControlListSet(VBOXSERVICECTRLTHREADLISTTYPE enmList,
  * @return  IPRT status code.
  * @param   uPID                    PID of process to set the input for.
  * @param   fPendingClose           Flag indicating whether this is the last input block sent to the process.
+ * @param   fQueue                  Flag indicating whether to queue the input, the process
+ *                                  thread then reports the input status to the host.
  * @param   pvBuf                   Pointer to a buffer containing the actual input data.
  * @param   cbBuf                   Size (in bytes) of the input buffer data.
  * @param   pcbWritten              Pointer to number of bytes written to the process.  Optional.
  */
 int VBoxServiceControlSetInput(uint32_t uPID, uint32_t uCID,
-                               bool fPendingClose,
+                               bool fPendingClose, bool fQueue,
                                void *pvBuf, uint32_t cbBuf,
                                uint32_t *pcbWritten)
 {
@@ -594,11 +596,14 @@ int VBoxServiceControlSetInput(uint32_t uPID, uint32_t uCID,
     /* cbBuf is optional. */
     /* pcbWritten is optional. */
 
+    VBOXSERVICECTRLREQUESTTYPE enmType;
+    if (fQueue)
+        enmType = fPendingClose ? VBOXSERVICECTRLREQUEST_STDIN_QUEUE_EOF : VBOXSERVICECTRLREQUEST_STDIN_QUEUE;
+    else
+        enmType = fPendingClose ? VBOXSERVICECTRLREQUEST_STDIN_WRITE_EOF : VBOXSERVICECTRLREQUEST_STDIN_WRITE;
+
     PVBOXSERVICECTRLREQUEST pRequest;
-    int rc = VBoxServiceControlThreadRequestAllocEx(&pRequest,
-                                                      fPendingClose
-                                                    ? VBOXSERVICECTRLREQUEST_STDIN_WRITE_EOF
-                                                    : VBOXSERVICECTRLREQUEST_STDIN_WRITE,
+    int rc = VBoxServiceControlThreadRequestAllocEx(&pRequest, enmType,
                                                     pvBuf, cbBuf, uCID);
     if (RT_SUCCESS(rc))
     {
@@ -671,10 +676,15 @@ static int VBoxServiceControlHandleCmdSetInput(uint32_t idClient, uint32_t cParm
                                uPID, cbSize);
         }
 
-        rc = VBoxServiceControlSetInput(uPID, uContextID, fPendingClose, pvScratchBuf,
+        bool const fQueue = RT_BOOL(uFlags & INPUT_FLAG_QUEUE);
+        rc = VBoxServiceControlSetInput(uPID, uContextID, fPendingClose, fQueue, pvScratchBuf,
                                         cbSize, &cbWritten);
         VBoxServiceVerbose(4, "[PID %u]: Written input, CID=%u, rc=%Rrc, uFlags=0x%x, fPendingClose=%d, cbSize=%u, cbWritten=%u\n",
                            uPID, uContextID, rc, uFlags, fPendingClose, cbSize, cbWritten);
+        /* Queued input is reported by the process thread once it was written. */
+        if (   RT_SUCCESS(rc)
+            && fQueue)
+            return VINF_SUCCESS;
         if (RT_SUCCESS(rc))
         {
             uStatus = INPUT_STS_WRITTEN;
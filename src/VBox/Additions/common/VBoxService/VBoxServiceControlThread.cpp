@@ -41,6 +41,16 @@
 
 using namespace guestControl;
 
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The increment (in bytes) by which a process output buffer grows. */
+#define VBOXSERVICECTRL_OUTBUF_CHUNK        _64K
+/** Maximum amount (in bytes) of output buffered per stream before we stop
+ *  reading the pipe and let the guest process block on writing. */
+#define VBOXSERVICECTRL_OUTBUF_MAX          (16 * VBOXSERVICECTRL_OUTBUF_CHUNK)
+
 /* Internal functions. */
 static int vboxServiceControlThreadRequestCancel(PVBOXSERVICECTRLREQUEST pThread);
 
@@ -79,6 +89,12 @@ static int gstsvcCntlExecThreadInit(PVBOXSERVICECTRLTHREAD pThread,
 
     pThread->uPID         = 0;          /* Don't have a PID yet. */
     pThread->pRequest     = NULL;       /* No request assigned yet. */
+    RTListInit(&pThread->StdInQueue);
+    RT_ZERO(pThread->StdOut);
+    RT_ZERO(pThread->StdErr);
+    pThread->cbOutputRead      = 0;
+    pThread->cOutputReads      = 0;
+    pThread->cOutputReadsEmpty = 0;
     pThread->uFlags       = pProcess->uFlags;
     pThread->uTimeLimitMS = (   pProcess->uTimeLimitMS == UINT32_MAX
                              || pProcess->uTimeLimitMS == 0)
@@ -312,6 +328,97 @@ static int VBoxServiceControlThreadHandleStdInErrorEvent(RTPOLLSET hPollSet, uin
 }
 
 
+/**
+ * Reports the input status of a queued stdin block to the host and frees it.
+ *
+ * @param   pThread             The process' thread handle.
+ * @param   pBlock              The block, will be unlinked and freed.
+ * @param   uStatus             The input status to report (INPUT_STS_XXX).
+ * @param   uFlags              The flags to report, the IPRT status code for
+ *                              INPUT_STS_ERROR.
+ */
+static void vboxServiceControlThreadStdInComplete(PVBOXSERVICECTRLTHREAD pThread, PVBOXSERVICECTRLINBLOCK pBlock,
+                                                  uint32_t uStatus, uint32_t uFlags)
+{
+    VBoxServiceVerbose(4, "[PID %u]: Queued input processed, CID=%u, uStatus=%u, uFlags=0x%x, cbWritten=%u\n",
+                       pThread->uPID, pBlock->uCID, uStatus, uFlags, pBlock->offData);
+    int rc = VbglR3GuestCtrlExecReportStatusIn(pThread->uClientID, pBlock->uCID, pThread->uPID,
+                                               uStatus, uFlags, pBlock->offData);
+    if (RT_FAILURE(rc))
+        VBoxServiceError("[PID %u]: Failed to report input status! Error: %Rrc\n",
+                         pThread->uPID, rc);
+
+    RTListNodeRemove(&pBlock->Node);
+    RTMemFree(pBlock);
+}
+
+
+/**
+ * Fails all queued stdin blocks, used when the pipe is gone.
+ *
+ * @param   pThread             The process' thread handle.
+ */
+static void vboxServiceControlThreadStdInPurge(PVBOXSERVICECTRLTHREAD pThread)
+{
+    PVBOXSERVICECTRLINBLOCK pBlock, pNext;
+    RTListForEachSafe(&pThread->StdInQueue, pBlock, pNext, VBOXSERVICECTRLINBLOCK, Node)
+        vboxServiceControlThreadStdInComplete(pThread, pBlock, INPUT_STS_TERMINATED, 0 /* uFlags */);
+}
+
+
+/**
+ * Writes as much of the queued stdin input as the pipe takes, reporting the
+ * blocks which were written completely to the host.
+ *
+ * The pipe is only polled for writing while there is queued input left.
+ *
+ * @param   pThread             The process' thread handle.
+ * @param   hPollSet            The polling set.
+ * @param   phStdInW            The standard input pipe handle.
+ */
+static void vboxServiceControlThreadStdInFlush(PVBOXSERVICECTRLTHREAD pThread, RTPOLLSET hPollSet, PRTPIPE phStdInW)
+{
+    PVBOXSERVICECTRLINBLOCK pBlock, pNext;
+    RTListForEachSafe(&pThread->StdInQueue, pBlock, pNext, VBOXSERVICECTRLINBLOCK, Node)
+    {
+        if (*phStdInW == NIL_RTPIPE)
+            break;
+
+        if (pBlock->offData < pBlock->cbData)
+        {
+            size_t cbWritten = 0;
+            int rc = RTPipeWrite(*phStdInW, &pBlock->abData[pBlock->offData],
+                                 pBlock->cbData - pBlock->offData, &cbWritten);
+            if (RT_FAILURE(rc))
+            {
+                vboxServiceControlThreadStdInComplete(pThread, pBlock, INPUT_STS_ERROR, (uint32_t)rc);
+                VBoxServiceControlThreadCloseStdIn(hPollSet, phStdInW);
+                break;
+            }
+            pBlock->offData += (uint32_t)cbWritten;
+            if (pBlock->offData < pBlock->cbData)
+                break; /* The pipe is full, wait until it's writable again. */
+        }
+
+        bool const fEndOfFile = pBlock->fEndOfFile;
+        vboxServiceControlThreadStdInComplete(pThread, pBlock, INPUT_STS_WRITTEN, 0 /* uFlags */);
+        if (fEndOfFile)
+            VBoxServiceControlThreadCloseStdIn(hPollSet, phStdInW);
+    }
+
+    if (*phStdInW == NIL_RTPIPE)
+        vboxServiceControlThreadStdInPurge(pThread);
+    else
+    {
+        int rc2 = RTPollSetEventsChange(hPollSet, VBOXSERVICECTRLPIPEID_STDIN,
+                                          RTListIsEmpty(&pThread->StdInQueue)
+                                        ? RTPOLL_EVT_ERROR
+                                        : RTPOLL_EVT_ERROR | RTPOLL_EVT_WRITE);
+        AssertRC(rc2);
+    }
+}
+
+
 /**
  * Handle pending output data or error on standard out or standard error.
  *
@@ -368,54 +475,177 @@ static int VBoxServiceControlThreadHandleOutputError(RTPOLLSET hPollSet, uint32_
 }
 
 
+/**
+ * Reads everything a guest process output pipe currently has to offer into
+ * the output buffer.
+ *
+ * The pipe gets closed and removed from the poll set once it has been drained
+ * after the guest process closed its end.  If the buffer is full the pipe is
+ * taken out of the poll set until the host fetched some output.
+ *
+ * @param   hPollSet            The polling set.
+ * @param   pBuf                The output buffer to fill.
+ * @param   phPipeR             The pipe handle.
+ * @param   idPollHnd           The pipe ID in the poll set.
+ */
+static void vboxServiceControlThreadOutBufFill(RTPOLLSET hPollSet, PVBOXSERVICECTRLOUTBUF pBuf,
+                                               PRTPIPE phPipeR, uint32_t idPollHnd)
+{
+    bool fFull = false;
+    while (*phPipeR != NIL_RTPIPE)
+    {
+        size_t offWrite = pBuf->offRead + pBuf->cbUsed;
+        if (offWrite == pBuf->cbAlloc)
+        {
+            /* Make room at the end of the buffer, moving the data to the
+             * start before growing it. */
+            if (pBuf->offRead)
+            {
+                memmove(pBuf->pbData, pBuf->pbData + pBuf->offRead, pBuf->cbUsed);
+                pBuf->offRead = 0;
+            }
+            else if (pBuf->cbAlloc < VBOXSERVICECTRL_OUTBUF_MAX)
+            {
+                uint8_t *pbNew = (uint8_t *)RTMemRealloc(pBuf->pbData, pBuf->cbAlloc + VBOXSERVICECTRL_OUTBUF_CHUNK);
+                if (!pbNew)
+                {
+                    fFull = true;
+                    break;
+                }
+                pBuf->pbData   = pbNew;
+                pBuf->cbAlloc += VBOXSERVICECTRL_OUTBUF_CHUNK;
+            }
+            else
+            {
+                fFull = true;
+                break;
+            }
+            offWrite = pBuf->offRead + pBuf->cbUsed;
+        }
+
+        size_t cbRead = 0;
+        int rc = RTPipeRead(*phPipeR, pBuf->pbData + offWrite, pBuf->cbAlloc - offWrite, &cbRead);
+        if (RT_FAILURE(rc))
+        {
+            /* The guest process closed its end (or something went wrong)
+             * and everything has been read, so get rid of the pipe.  The
+             * host sees the end of the stream once the buffer is drained. */
+            VBoxServiceVerbose(3, "VBoxServiceControlThreadOutBufFill: idPollHnd=%u closed, rc=%Rrc, %zu bytes buffered\n",
+                               idPollHnd, rc, pBuf->cbUsed);
+            if (!pBuf->fThrottled)
+            {
+                int rc2 = RTPollSetRemove(hPollSet, idPollHnd);
+                AssertMsg(RT_SUCCESS(rc2) || rc2 == VERR_POLL_HANDLE_ID_NOT_FOUND, ("%Rrc\n", rc2));
+            }
+            pBuf->fThrottled = false;
+            RTPipeClose(*phPipeR);
+            *phPipeR = NIL_RTPIPE;
+            return;
+        }
+        pBuf->cbUsed += cbRead;
+        if (rc == VINF_TRY_AGAIN || !cbRead)
+            break;
+    }
+
+    if (   fFull
+        && !pBuf->fThrottled)
+    {
+        VBoxServiceVerbose(4, "VBoxServiceControlThreadOutBufFill: idPollHnd=%u full, throttling\n", idPollHnd);
+        int rc2 = RTPollSetRemove(hPollSet, idPollHnd);
+        AssertMsg(RT_SUCCESS(rc2) || rc2 == VERR_POLL_HANDLE_ID_NOT_FOUND, ("%Rrc\n", rc2));
+        pBuf->fThrottled = true;
+    }
+}
+
+
+/**
+ * Hands out buffered output of a guest process and resumes polling the
+ * pipe if it was throttled.
+ *
+ * @returns Number of bytes copied to @a pvDst.
+ * @param   hPollSet            The polling set.
+ * @param   pBuf                The output buffer to read from.
+ * @param   hPipeR              The pipe handle.
+ * @param   idPollHnd           The pipe ID in the poll set.
+ * @param   pvDst               Where to copy the output to.
+ * @param   cbDst               Size (in bytes) of @a pvDst.
+ */
+static size_t vboxServiceControlThreadOutBufRead(RTPOLLSET hPollSet, PVBOXSERVICECTRLOUTBUF pBuf,
+                                                 RTPIPE hPipeR, uint32_t idPollHnd, void *pvDst, size_t cbDst)
+{
+    size_t cbCopy = RT_MIN(cbDst, pBuf->cbUsed);
+    if (cbCopy)
+    {
+        memcpy(pvDst, pBuf->pbData + pBuf->offRead, cbCopy);
+        pBuf->offRead += cbCopy;
+        pBuf->cbUsed  -= cbCopy;
+    }
+
+    if (!pBuf->cbUsed)
+    {
+        pBuf->offRead = 0;
+        /* Don't hang on to a big buffer after a burst of output. */
+        if (pBuf->cbAlloc > VBOXSERVICECTRL_OUTBUF_CHUNK)
+        {
+            RTMemFree(pBuf->pbData);
+            pBuf->pbData  = NULL;
+            pBuf->cbAlloc = 0;
+        }
+    }
+
+    if (   pBuf->fThrottled
+        && cbCopy
+        && hPipeR != NIL_RTPIPE)
+    {
+        int rc2 = RTPollSetAddPipe(hPollSet, hPipeR, RTPOLL_EVT_READ | RTPOLL_EVT_ERROR, idPollHnd);
+        if (RT_SUCCESS(rc2))
+            pBuf->fThrottled = false;
+        else
+            VBoxServiceError("Unable to resume polling idPollHnd=%u, rc=%Rrc\n", idPollHnd, rc2);
+    }
+    return cbCopy;
+}
+
+
+/**
+ * Frees an output buffer.
+ *
+ * @param   pBuf                The output buffer to free.
+ */
+static void vboxServiceControlThreadOutBufFree(PVBOXSERVICECTRLOUTBUF pBuf)
+{
+    RTMemFree(pBuf->pbData);
+    RT_ZERO(*pBuf);
+}
+
+
 /**
  * Handle pending output data or error on standard out or standard error.
  *
- * @returns IPRT status code from client send.
+ * @returns IPRT status code.
  * @param   hPollSet            The polling set.
  * @param   fPollEvt            The event mask returned by RTPollNoResume.
  * @param   phPipeR             The pipe handle.
  * @param   idPollHnd           The pipe ID to handle.
- *
+ * @param   pBuf                The output buffer of the pipe.
  */
 static int VBoxServiceControlThreadHandleOutputEvent(RTPOLLSET hPollSet, uint32_t fPollEvt,
-                                                     PRTPIPE phPipeR, uint32_t idPollHnd)
+                                                     PRTPIPE phPipeR, uint32_t idPollHnd,
+                                                     PVBOXSERVICECTRLOUTBUF pBuf)
 {
 #if 0
     VBoxServiceVerbose(4, "VBoxServiceControlThreadHandleOutputEvent: fPollEvt=0x%x, idPollHnd=%u\n",
                        fPollEvt, idPollHnd);
 #endif
 
+    /* Pull in the output right away so that it is ready when the host asks
+     * for it; this also closes the pipe once the process is done with it. */
     int rc = VINF_SUCCESS;
+    vboxServiceControlThreadOutBufFill(hPollSet, pBuf, phPipeR, idPollHnd);
 
-#ifdef DEBUG
-    size_t cbReadable;
-    rc = RTPipeQueryReadable(*phPipeR, &cbReadable);
-    if (   RT_SUCCESS(rc)
-        && cbReadable)
-    {
-        VBoxServiceVerbose(4, "VBoxServiceControlThreadHandleOutputEvent: cbReadable=%ld\n",
-                           cbReadable);
-    }
-#endif
-
-#if 0
-    //if (fPollEvt & RTPOLL_EVT_READ)
-    {
-        size_t cbRead = 0;
-        uint8_t byData[_64K];
-        rc = RTPipeRead(*phPipeR,
-                        byData, sizeof(byData), &cbRead);
-        VBoxServiceVerbose(4, "VBoxServiceControlThreadHandleOutputEvent cbRead=%u, rc=%Rrc\n",
-                           cbRead, rc);
-
-        /* Make sure we go another poll round in case there was too much data
-           for the buffer to hold. */
-        fPollEvt &= RTPOLL_EVT_ERROR;
-    }
-#endif
-
-    if (fPollEvt & RTPOLL_EVT_ERROR)
+    if (   (fPollEvt & RTPOLL_EVT_ERROR)
+        && *phPipeR != NIL_RTPIPE
+        && !pBuf->fThrottled)
         rc = VBoxServiceControlThreadHandleOutputError(hPollSet, fPollEvt,
                                                        phPipeR, idPollHnd);
     return rc;
@@ -490,34 +720,75 @@ static int VBoxServiceControlThreadHandleRequest(RTPOLLSET hPollSet, uint32_t fP
             break;
         }
 
+        case VBOXSERVICECTRLREQUEST_STDIN_QUEUE:
+        case VBOXSERVICECTRLREQUEST_STDIN_QUEUE_EOF:
+        {
+            /*
+             * Take a copy of the input and write what the pipe takes right
+             * away, the rest goes out when the pipe becomes writable again.
+             * The input status is reported once a block is written completely.
+             */
+            AssertReturn(pRequest->cbData <= GUESTPROCESS_MAX_INPUT_QUEUE_BLOCK, VERR_INVALID_PARAMETER);
+            AssertReturn(!pRequest->cbData || pRequest->pvData, VERR_INVALID_POINTER);
+            if (*phStdInW == NIL_RTPIPE)
+            {
+                rcReq = VERR_BAD_PIPE;
+                pRequest->cbData = 0;
+                break;
+            }
+
+            PVBOXSERVICECTRLINBLOCK pBlock = (PVBOXSERVICECTRLINBLOCK)
+                RTMemAlloc(RT_OFFSETOF(VBOXSERVICECTRLINBLOCK, abData[pRequest->cbData]));
+            if (!pBlock)
+            {
+                rcReq = VERR_NO_MEMORY;
+                pRequest->cbData = 0;
+                break;
+            }
+            pBlock->uCID       = pRequest->uCID;
+            pBlock->fEndOfFile = pRequest->enmType == VBOXSERVICECTRLREQUEST_STDIN_QUEUE_EOF;
+            pBlock->cbData     = (uint32_t)pRequest->cbData;
+            pBlock->offData    = 0;
+            if (pRequest->cbData)
+                memcpy(pBlock->abData, pRequest->pvData, pRequest->cbData);
+            RTListAppend(&pThread->StdInQueue, &pBlock->Node);
+
+            vboxServiceControlThreadStdInFlush(pThread, hPollSet, phStdInW);
+            break;
+        }
+
         case VBOXSERVICECTRLREQUEST_STDOUT_READ:
         case VBOXSERVICECTRLREQUEST_STDERR_READ:
         {
             AssertPtrReturn(pRequest->pvData, VERR_INVALID_POINTER);
             AssertReturn(pRequest->cbData, VERR_INVALID_PARAMETER);
 
-            PRTPIPE pPipeR = pRequest->enmType == VBOXSERVICECTRLREQUEST_STDERR_READ
-                           ? phStdErrR : phStdOutR;
-            AssertPtr(pPipeR);
-
-            size_t cbRead = 0;
-            if (*pPipeR != NIL_RTPIPE)
-            {
-                rcReq = RTPipeRead(*pPipeR,
-                                   pRequest->pvData, pRequest->cbData, &cbRead);
-                if (RT_FAILURE(rcReq))
-                {
-                    RTPollSetRemove(hPollSet, pRequest->enmType == VBOXSERVICECTRLREQUEST_STDERR_READ
-                                              ? VBOXSERVICECTRLPIPEID_STDERR : VBOXSERVICECTRLPIPEID_STDOUT);
-                    RTPipeClose(*pPipeR);
-                    *pPipeR = NIL_RTPIPE;
-                    if (rcReq == VERR_BROKEN_PIPE)
-                        rcReq = VINF_EOF;
-                }
-            }
-            else
+            /*
+             * Serve the request from the output buffer right away with
+             * whatever we've got.  The request is performed by the single
+             * guest control dispatcher, which waits for us while holding the
+             * thread lock, so making it wait for more output here would stall
+             * the guest control traffic of all processes.
+             */
+            bool const              fStdErr   = pRequest->enmType == VBOXSERVICECTRLREQUEST_STDERR_READ;
+            PVBOXSERVICECTRLOUTBUF  pBuf      = fStdErr ? &pThread->StdErr : &pThread->StdOut;
+            PRTPIPE                 phPipeR   = fStdErr ? phStdErrR : phStdOutR;
+            uint32_t const          idPollHnd = fStdErr ? VBOXSERVICECTRLPIPEID_STDERR : VBOXSERVICECTRLPIPEID_STDOUT;
+
+            /* Get the latest output first. */
+            vboxServiceControlThreadOutBufFill(hPollSet, pBuf, phPipeR, idPollHnd);
+
+            size_t cbRead = vboxServiceControlThreadOutBufRead(hPollSet, pBuf, *phPipeR, idPollHnd,
+                                                               pRequest->pvData, pRequest->cbData);
+            if (   !cbRead
+                && *phPipeR == NIL_RTPIPE)
                 rcReq = VINF_EOF;
 
+            pThread->cOutputReads++;
+            pThread->cbOutputRead += cbRead;
+            if (!cbRead)
+                pThread->cOutputReadsEmpty++;
+
             /* Report back actual data read (if any). */
             pRequest->cbData = cbRead;
             break;
@@ -601,7 +872,7 @@ static int VBoxServiceControlThreadProcLoop(PVBOXSERVICECTRLTHREAD pThread,
     VBoxServiceVerbose(2, "[PID %u]: Process \"%s\" started, CID=%u, User=%s\n",
                        pThread->uPID, pThread->pszCmd, pThread->uContextID, pThread->pszUser);
     rc = VbglR3GuestCtrlExecReportStatus(pThread->uClientID, pThread->uContextID,
-                                         pThread->uPID, PROC_STS_STARTED, 0 /* u32Flags */,
+                                         pThread->uPID, PROC_STS_STARTED, PROC_STS_STARTED_FLAG_INPUT_QUEUE,
                                          NULL /* pvData */, 0 /* cbData */);
 
     /*
@@ -628,17 +899,23 @@ static int VBoxServiceControlThreadProcLoop(PVBOXSERVICECTRLTHREAD pThread,
             switch (idPollHnd)
             {
                 case VBOXSERVICECTRLPIPEID_STDIN:
-                    rc = VBoxServiceControlThreadHandleStdInErrorEvent(hPollSet, fPollEvt, phStdInW);
+                    if (fPollEvt & RTPOLL_EVT_ERROR)
+                    {
+                        rc = VBoxServiceControlThreadHandleStdInErrorEvent(hPollSet, fPollEvt, phStdInW);
+                        vboxServiceControlThreadStdInPurge(pThread);
+                    }
+                    else
+                        vboxServiceControlThreadStdInFlush(pThread, hPollSet, phStdInW);
                     break;
 
                 case VBOXSERVICECTRLPIPEID_STDOUT:
                     rc = VBoxServiceControlThreadHandleOutputEvent(hPollSet, fPollEvt,
-                                                                   phStdOutR, idPollHnd);
+                                                                   phStdOutR, idPollHnd, &pThread->StdOut);
                     break;
 
                 case VBOXSERVICECTRLPIPEID_STDERR:
                     rc = VBoxServiceControlThreadHandleOutputEvent(hPollSet, fPollEvt,
-                                                                   phStdErrR, idPollHnd);
+                                                                   phStdErrR, idPollHnd, &pThread->StdErr);
                     break;
 
                 case VBOXSERVICECTRLPIPEID_IPC_NOTIFY:
@@ -690,7 +967,9 @@ static int VBoxServiceControlThreadProcLoop(PVBOXSERVICECTRLTHREAD pThread,
          */
         if (   !fProcessAlive
             && *phStdOutR == NIL_RTPIPE
-            && *phStdErrR == NIL_RTPIPE)
+            && *phStdErrR == NIL_RTPIPE
+            && !pThread->StdOut.cbUsed
+            && !pThread->StdErr.cbUsed)
             break;
 
         /*
@@ -745,6 +1024,30 @@ static int VBoxServiceControlThreadProcLoop(PVBOXSERVICECTRLTHREAD pThread,
         AssertRC(rc2);
     }
 
+    /*
+     * Pipes which were throttled are not in the poll set anymore and
+     * therefore are considered closed by our caller, so close them here.
+     */
+    if (pThread->StdOut.fThrottled && *phStdOutR != NIL_RTPIPE)
+    {
+        RTPipeClose(*phStdOutR);
+        *phStdOutR = NIL_RTPIPE;
+    }
+    if (pThread->StdErr.fThrottled && *phStdErrR != NIL_RTPIPE)
+    {
+        RTPipeClose(*phStdErrR);
+        *phStdErrR = NIL_RTPIPE;
+    }
+
+    uint64_t const cMsElapsed = RTTimeMilliTS() - MsStart;
+    VBoxServiceVerbose(1, "[PID %u]: Output: %RU64 bytes in %u reads (%u empty), %RU64 bytes/s, %zu bytes left\n",
+                       pThread->uPID, pThread->cbOutputRead, pThread->cOutputReads,
+                       pThread->cOutputReadsEmpty, pThread->cbOutputRead * RT_MS_1SEC / RT_MAX(cMsElapsed, 1),
+                       pThread->StdOut.cbUsed + pThread->StdErr.cbUsed);
+    vboxServiceControlThreadOutBufFree(&pThread->StdOut);
+    vboxServiceControlThreadOutBufFree(&pThread->StdErr);
+    vboxServiceControlThreadStdInPurge(pThread);
+
     /*
      * Try kill the process if it's still alive at this point.
      */
@@ -1534,11 +1837,8 @@ static int VBoxServiceControlThreadProcessWorker(PVBOXSERVICECTRLTHREAD pThread)
                         rc = RTPollSetCreate(&hPollSet);
                         if (RT_SUCCESS(rc))
                         {
-                            uint32_t uFlags = RTPOLL_EVT_ERROR;
-#if 0
-                            /* Add reading event to pollset to get some more information. */
-                            uFlags |= RTPOLL_EVT_READ;
-#endif
+                            /* Output is read as soon as it arrives, see VBoxServiceControlThreadHandleOutputEvent(). */
+                            uint32_t uFlags = RTPOLL_EVT_READ | RTPOLL_EVT_ERROR;
                             /* Stdin. */
                             if (RT_SUCCESS(rc))
                                 rc = RTPollSetAddPipe(hPollSet, pThread->pipeStdInW, RTPOLL_EVT_ERROR, VBOXSERVICECTRLPIPEID_STDIN);
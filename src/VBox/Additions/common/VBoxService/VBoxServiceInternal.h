@@ -143,6 +143,13 @@ typedef enum VBOXSERVICECTRLREQUESTTYPE
     /** Same as VBOXSERVICECTRLREQUEST_STDIN_WRITE, but
      *  marks the end of input. */
     VBOXSERVICECTRLREQUEST_STDIN_WRITE_EOF  = 71,
+    /** Queues input for stdin (INPUT_FLAG_QUEUE), the input
+     *  status is reported to the host by the process thread
+     *  once the input has been written. */
+    VBOXSERVICECTRLREQUEST_STDIN_QUEUE      = 72,
+    /** Same as VBOXSERVICECTRLREQUEST_STDIN_QUEUE, but
+     *  marks the end of input. */
+    VBOXSERVICECTRLREQUEST_STDIN_QUEUE_EOF  = 73,
     /** Kill/terminate process.
      *  @todo Implement this! */
     VBOXSERVICECTRLREQUEST_KILL             = 90,
@@ -201,6 +208,49 @@ typedef struct VBOXSERVICECTRLREQUEST
 /** Pointer to request. */
 typedef VBOXSERVICECTRLREQUEST *PVBOXSERVICECTRLREQUEST;
 
+/**
+ * A block of input for a guest process' stdin which was queued with
+ * INPUT_FLAG_QUEUE and has not been written to the pipe completely yet.
+ */
+typedef struct VBOXSERVICECTRLINBLOCK
+{
+    /** Node in VBOXSERVICECTRLTHREAD::StdInQueue. */
+    RTLISTNODE                 Node;
+    /** The context ID to report the input status with. */
+    uint32_t                   uCID;
+    /** Whether to close stdin after this block. */
+    bool                       fEndOfFile;
+    /** Size (in bytes) of the input. */
+    uint32_t                   cbData;
+    /** How much of it has been written to the pipe so far. */
+    uint32_t                   offData;
+    /** The input (variable size). */
+    uint8_t                    abData[1];
+} VBOXSERVICECTRLINBLOCK;
+/** Pointer to a queued input block. */
+typedef VBOXSERVICECTRLINBLOCK *PVBOXSERVICECTRLINBLOCK;
+
+/**
+ * Output of a guest process' stdout or stderr which has been read
+ * from the pipe but not yet been fetched by the host.
+ */
+typedef struct VBOXSERVICECTRLOUTBUF
+{
+    /** The buffer; NULL if not allocated yet. */
+    uint8_t                   *pbData;
+    /** Size (in bytes) of the allocated buffer. */
+    size_t                     cbAlloc;
+    /** Offset of the first byte not fetched yet. */
+    size_t                     offRead;
+    /** Number of bytes buffered, starting at offRead. */
+    size_t                     cbUsed;
+    /** Set if the pipe was taken out of the poll set because
+     *  the buffer is full. */
+    bool                       fThrottled;
+} VBOXSERVICECTRLOUTBUF;
+/** Pointer to an output buffer. */
+typedef VBOXSERVICECTRLOUTBUF *PVBOXSERVICECTRLOUTBUF;
+
 /**
  * Structure holding information for starting a guest
  * process.
@@ -280,11 +330,24 @@ typedef struct VBOXSERVICECTRLTHREAD
     /** StdIn pipe for addressing writes to the
      *  guest process' stdin.*/
     RTPIPE                          pipeStdInW;
+    /** Queued stdin input (VBOXSERVICECTRLINBLOCK), oldest first.
+     *  Only accessed by the process thread. */
+    RTLISTANCHOR                    StdInQueue;
     /** The notification pipe associated with this guest process.
      *  This is NIL_RTPIPE for output pipes. */
     RTPIPE                          hNotificationPipeW;
     /** The other end of hNotificationPipeW. */
     RTPIPE                          hNotificationPipeR;
+    /** Buffered stdout output. */
+    VBOXSERVICECTRLOUTBUF           StdOut;
+    /** Buffered stderr output. */
+    VBOXSERVICECTRLOUTBUF           StdErr;
+    /** Number of output bytes handed to the host. */
+    uint64_t                        cbOutputRead;
+    /** Number of output read requests handled. */
+    uint32_t                        cOutputReads;
+    /** Number of output read requests which returned no data. */
+    uint32_t                        cOutputReadsEmpty;
 } VBOXSERVICECTRLTHREAD;
 /** Pointer to thread data. */
 typedef VBOXSERVICECTRLTHREAD *PVBOXSERVICECTRLTHREAD;
@@ -325,6 +388,8 @@ typedef struct VBOXSERVICEVEPROPCACHE
     RTLISTANCHOR    NodeHead;
     /** Critical section for thread-safe use. */
     RTCRITSECT      CritSect;
+    /** Whether updates are collected for VBoxServicePropCacheBatchCommit(). */
+    bool            fBatch;
 } VBOXSERVICEVEPROPCACHE;
 /** Pointer to a guest property cache. */
 typedef VBOXSERVICEVEPROPCACHE *PVBOXSERVICEVEPROPCACHE;
@@ -348,6 +413,9 @@ typedef struct VBOXSERVICEVEPROPCACHEENTRY
     char       *pszValueReset;
     /** Flags. */
     uint32_t    fFlags;
+    /** Whether pszValue still has to be written by
+     *  VBoxServicePropCacheBatchCommit(). */
+    bool        fPending;
 } VBOXSERVICEVEPROPCACHEENTRY;
 /** Pointer to a cached guest property. */
 typedef VBOXSERVICEVEPROPCACHEENTRY *PVBOXSERVICEVEPROPCACHEENTRY;
@@ -81,6 +81,7 @@ PVBOXSERVICEVEPROPCACHEENTRY vboxServicePropCacheInsertEntryInternal(PVBOXSERVIC
         pNode->pszValue = NULL;
         pNode->fFlags = 0;
         pNode->pszValueReset = NULL;
+        pNode->fPending = false;
 
         int rc = RTCritSectEnter(&pCache->CritSect);
         if (RT_SUCCESS(rc))
@@ -155,6 +156,7 @@ int VBoxServicePropCacheCreate(PVBOXSERVICEVEPROPCACHE pCache, uint32_t uClientI
      *  r=bird: Use a magic. */
     RTListInit(&pCache->NodeHead);
     pCache->uClientID = uClientId;
+    pCache->fBatch = false;
     return RTCritSectInit(&pCache->CritSect);
 }
 
@@ -257,7 +259,17 @@ int VBoxServicePropCacheUpdate(PVBOXSERVICEVEPROPCACHE pCache, const char *pszNa
             else if (pNode->pszValue == NULL)
                 fUpdate = true;
 
-            if (fUpdate)
+            if (fUpdate && pCache->fBatch)
+            {
+                /* Remember the update for VBoxServicePropCacheBatchCommit(). */
+                RTStrFree(pNode->pszValue);
+                pNode->pszValue = RTStrDup(pszValue);
+                if (pNode->pszValue)
+                    pNode->fPending = true;
+                else
+                    rc = VERR_NO_MEMORY;
+            }
+            else if (fUpdate)
             {
                 /* Write the update. */
                 rc = vboxServicePropCacheWritePropF(pCache->uClientID, pNode->pszName, pNode->fFlags, pszValue);
@@ -288,6 +300,7 @@ int VBoxServicePropCacheUpdate(PVBOXSERVICEVEPROPCACHE pCache, const char *pszNa
                     /* Delete property (but do not remove from cache) if not deleted yet. */
                     RTStrFree(pNode->pszValue);
                     pNode->pszValue = NULL;
+                    pNode->fPending = false;
                 }
             }
             else
@@ -387,6 +400,130 @@ int VBoxServicePropCacheFlush(PVBOXSERVICEVEPROPCACHE pCache)
 }
 
 
+/**
+ * Starts collecting the value updates of the cache, so they can be written to
+ * the host in one go by VBoxServicePropCacheBatchCommit().  Deletions are still
+ * written right away.
+ *
+ * @returns VBox status code.
+ * @param   pCache          The property cache.
+ */
+int VBoxServicePropCacheBatchBegin(PVBOXSERVICEVEPROPCACHE pCache)
+{
+    AssertPtrReturn(pCache, VERR_INVALID_POINTER);
+
+    int rc = RTCritSectEnter(&pCache->CritSect);
+    if (RT_SUCCESS(rc))
+    {
+        Assert(!pCache->fBatch);
+        pCache->fBatch = true;
+        rc = RTCritSectLeave(&pCache->CritSect);
+    }
+    return rc;
+}
+
+
+/**
+ * Writes the value updates collected since VBoxServicePropCacheBatchBegin() to
+ * the host in one go, so it only wakes up its listeners once.
+ *
+ * The host leaves properties alone whose value didn't change, so the ones
+ * flagged VBOXSERVICEPROPCACHEFLAG_ALWAYS_UPDATE are written separately
+ * afterwards.  Being beacons, they then also come after the data they vouch
+ * for.
+ *
+ * @returns VBox status code.
+ * @param   pCache          The property cache.
+ */
+int VBoxServicePropCacheBatchCommit(PVBOXSERVICEVEPROPCACHE pCache)
+{
+    AssertPtrReturn(pCache, VERR_INVALID_POINTER);
+
+    int rc = RTCritSectEnter(&pCache->CritSect);
+    if (RT_FAILURE(rc))
+        return rc;
+    Assert(pCache->fBatch);
+    pCache->fBatch = false;
+
+    uint32_t cPending = 0;
+    PVBOXSERVICEVEPROPCACHEENTRY pNodeIt = NULL;
+    RTListForEach(&pCache->NodeHead, pNodeIt, VBOXSERVICEVEPROPCACHEENTRY, NodeSucc)
+    {
+        if (   pNodeIt->fPending
+            && !(pNodeIt->fFlags & VBOXSERVICEPROPCACHEFLAG_ALWAYS_UPDATE))
+            cPending++;
+    }
+
+    if (cPending)
+    {
+        const char **papszNames = (const char **)RTMemAlloc(cPending * 3 * sizeof(char *));
+        if (papszNames)
+        {
+            const char **papszValues = &papszNames[cPending];
+            const char **papszFlags  = &papszNames[cPending * 2];
+            uint32_t i = 0;
+            RTListForEach(&pCache->NodeHead, pNodeIt, VBOXSERVICEVEPROPCACHEENTRY, NodeSucc)
+            {
+                if (   pNodeIt->fPending
+                    && !(pNodeIt->fFlags & VBOXSERVICEPROPCACHEFLAG_ALWAYS_UPDATE))
+                {
+                    papszNames[i]  = pNodeIt->pszName;
+                    papszValues[i] = pNodeIt->pszValue;
+                    /* See vboxServicePropCacheWritePropF() for the transient flags. */
+                    papszFlags[i]  = pNodeIt->fFlags & VBOXSERVICEPROPCACHEFLAG_TRANSIENT ? "TRANSRESET" : NULL;
+                    i++;
+                }
+            }
+
+            rc = VbglR3GuestPropWriteMulti(pCache->uClientID, cPending, papszNames, papszValues, papszFlags);
+            if (rc == VERR_PARSE_ERROR)
+            {
+                /* Host does not support the "TRANSRESET" flag. */
+                for (i = 0; i < cPending; i++)
+                    if (papszFlags[i])
+                        papszFlags[i] = "TRANSIENT";
+                rc = VbglR3GuestPropWriteMulti(pCache->uClientID, cPending, papszNames, papszValues, papszFlags);
+            }
+            VBoxServiceVerbose(4, "[PropCache %p]: Written %RU32 properties, rc=%Rrc\n",
+                               pCache, cPending, rc);
+            RTMemFree(papszNames);
+        }
+        else
+            rc = VERR_NO_MEMORY;
+    }
+
+    RTListForEach(&pCache->NodeHead, pNodeIt, VBOXSERVICEVEPROPCACHEENTRY, NodeSucc)
+    {
+        if (!pNodeIt->fPending)
+            continue;
+        pNodeIt->fPending = false;
+
+        int rc2 = VINF_SUCCESS;
+        if (pNodeIt->fFlags & VBOXSERVICEPROPCACHEFLAG_ALWAYS_UPDATE)
+        {
+            rc2 = vboxServicePropCacheWritePropF(pCache->uClientID, pNodeIt->pszName, pNodeIt->fFlags,
+                                                 "%s", pNodeIt->pszValue);
+            VBoxServiceVerbose(4, "[PropCache %p]: Written \"%s\"=\"%s\" (flags: %x), rc=%Rrc\n",
+                               pCache, pNodeIt->pszName, pNodeIt->pszValue, pNodeIt->fFlags, rc2);
+            if (RT_SUCCESS(rc))
+                rc = rc2;
+        }
+        else if (RT_FAILURE(rc))
+            rc2 = rc;
+
+        /* Forget the values which didn't make it, so the next update writes them again. */
+        if (RT_FAILURE(rc2))
+        {
+            RTStrFree(pNodeIt->pszValue);
+            pNodeIt->pszValue = NULL;
+        }
+    }
+
+    RTCritSectLeave(&pCache->CritSect);
+    return rc;
+}
+
+
 /**
  * Reset all temporary properties and destroy the cache.
  *
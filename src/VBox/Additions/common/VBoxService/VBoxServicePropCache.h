@@ -42,6 +42,8 @@ int VBoxServicePropCacheUpdateEntry(PVBOXSERVICEVEPROPCACHE pCache, const char *
 int VBoxServicePropCacheUpdate(PVBOXSERVICEVEPROPCACHE pCache, const char *pszName, const char *pszValueFormat, ...);
 int VBoxServicePropCacheUpdateByPath(PVBOXSERVICEVEPROPCACHE pCache, const char *pszValue, uint32_t fFlags, const char *pszPathFormat, ...);
 int VBoxServicePropCacheFlush(PVBOXSERVICEVEPROPCACHE pCache);
+int VBoxServicePropCacheBatchBegin(PVBOXSERVICEVEPROPCACHE pCache);
+int VBoxServicePropCacheBatchCommit(PVBOXSERVICEVEPROPCACHE pCache);
 void VBoxServicePropCacheDestroy(PVBOXSERVICEVEPROPCACHE pCache);
 # endif /* VBOX_WITH_GUEST_PROPS */
 
@@ -28,8 +28,7 @@
 # include <winternl.h>
 
 #elif defined(RT_OS_LINUX)
-# include <iprt/ctype.h>
-# include <iprt/stream.h>
+# include <iprt/file.h>
 # include <unistd.h>
 
 #elif defined(RT_OS_SOLARIS)
@@ -71,6 +70,14 @@ typedef struct _VBOXSTATSCONTEXT
     NTSTATUS (WINAPI *pfnNtQuerySystemInformation)(SYSTEM_INFORMATION_CLASS SystemInformationClass, PVOID SystemInformation, ULONG SystemInformationLength, PULONG ReturnLength);
     void     (WINAPI *pfnGlobalMemoryStatusEx)(LPMEMORYSTATUSEX lpBuffer);
     BOOL     (WINAPI *pfnGetPerformanceInfo)(PPERFORMANCE_INFORMATION pPerformanceInformation, DWORD cb);
+#elif defined(RT_OS_LINUX)
+    /** /proc/meminfo, kept open and re-read from the start every interval. */
+    RTFILE                hFileMemInfo;
+    /** /proc/stat, kept open and re-read from the start every interval. */
+    RTFILE                hFileStat;
+#elif defined(RT_OS_SOLARIS)
+    /** The kstat handle, kept open and updated every interval. */
+    kstat_ctl_t          *pStatKern;
 #endif
 } VBOXSTATSCONTEXT;
 
@@ -116,6 +123,12 @@ static DECLCALLBACK(int) VBoxServiceVMStatsInit(void)
     RT_ZERO(gCtx.au64LastCpuLoad_Kernel);
     RT_ZERO(gCtx.au64LastCpuLoad_User);
     RT_ZERO(gCtx.au64LastCpuLoad_Nice);
+#if defined(RT_OS_LINUX)
+    gCtx.hFileMemInfo           = NIL_RTFILE;
+    gCtx.hFileStat              = NIL_RTFILE;
+#elif defined(RT_OS_SOLARIS)
+    gCtx.pStatKern              = NULL;
+#endif
 
     rc = VbglR3StatQueryInterval(&gCtx.cMsStatInterval);
     if (RT_SUCCESS(rc))
@@ -156,6 +169,77 @@ static DECLCALLBACK(int) VBoxServiceVMStatsInit(void)
 }
 
 
+#ifdef RT_OS_LINUX
+/**
+ * Reads the start of a /proc file into a buffer.
+ *
+ * The file is opened on first use and then kept open, procfs regenerates
+ * the content for every read from offset 0.
+ *
+ * @returns IPRT status code.
+ * @param   pszPath     The file to read.
+ * @param   phFile      Where the file handle is kept.
+ * @param   pszBuf      Where to return the zero terminated content.
+ * @param   cbBuf       The size of the buffer.
+ */
+static int VBoxServiceVMStatsReadProcFile(const char *pszPath, PRTFILE phFile, char *pszBuf, size_t cbBuf)
+{
+    int rc;
+    if (*phFile == NIL_RTFILE)
+    {
+        rc = RTFileOpen(phFile, pszPath, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_NONE);
+        if (RT_FAILURE(rc))
+        {
+            *phFile = NIL_RTFILE;
+            return rc;
+        }
+    }
+
+    size_t cbRead = 0;
+    rc = RTFileReadAt(*phFile, 0, pszBuf, cbBuf - 1, &cbRead);
+    if (RT_FAILURE(rc))
+    {
+        /* Try reopening it next time. */
+        RTFileClose(*phFile);
+        *phFile = NIL_RTFILE;
+        return rc;
+    }
+    pszBuf[cbRead] = '\0';
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Looks up a value (in kB) in the content of /proc/meminfo.
+ *
+ * @returns The value in bytes, 0 if not found.
+ * @param   pszMemInfo  The content of /proc/meminfo.
+ * @param   pszField    The field name including the colon.
+ */
+static uint64_t VBoxServiceVMStatsGetMemInfo(const char *pszMemInfo, const char *pszField)
+{
+    size_t const cchField = strlen(pszField);
+    const char  *psz      = pszMemInfo;
+    while (psz && *psz)
+    {
+        if (!strncmp(psz, pszField, cchField))
+        {
+            char    *pszNext;
+            uint64_t u64Kb;
+            int rc = RTStrToUInt64Ex(RTStrStripL(psz + cchField), &pszNext, 0, &u64Kb);
+            if (RT_SUCCESS(rc))
+                return u64Kb * _1K;
+            break;
+        }
+        psz = strchr(psz, '\n');
+        if (psz)
+            psz++;
+    }
+    return 0;
+}
+#endif /* RT_OS_LINUX */
+
+
 /**
  * Gathers VM statistics and reports them to the host.
  */
@@ -236,22 +320,40 @@ static void VBoxServiceVMStatsReport(void)
     if (    !rc
         &&  cbReturned == cbStruct)
     {
-        if (gCtx.au64LastCpuLoad_Kernel == 0)
+        /* The host keeps a single CPU load per VM, so sum up the times of
+           all processors and report them in one go. */
+        uint64_t u64Idle = 0, u64Kernel = 0, u64User = 0;
+        for (uint32_t i = 0; i < systemInfo.dwNumberOfProcessors; i++)
+        {
+            u64Idle   += pProcInfo[i].IdleTime.QuadPart;
+            u64Kernel += pProcInfo[i].KernelTime.QuadPart;
+            u64User   += pProcInfo[i].UserTime.QuadPart;
+        }
+
+        if (gCtx.au64LastCpuLoad_Kernel[0] == 0)
         {
             /* first time */
-            gCtx.au64LastCpuLoad_Idle[0]    = pProcInfo->IdleTime.QuadPart;
-            gCtx.au64LastCpuLoad_Kernel[0]  = pProcInfo->KernelTime.QuadPart;
-            gCtx.au64LastCpuLoad_User[0]    = pProcInfo->UserTime.QuadPart;
+            gCtx.au64LastCpuLoad_Idle[0]    = u64Idle;
+            gCtx.au64LastCpuLoad_Kernel[0]  = u64Kernel;
+            gCtx.au64LastCpuLoad_User[0]    = u64User;
 
             Sleep(250);
 
             rc = gCtx.pfnNtQuerySystemInformation(SystemProcessorPerformanceInformation, pProcInfo, cbStruct, &cbReturned);
             Assert(!rc);
+
+            u64Idle = u64Kernel = u64User = 0;
+            for (uint32_t i = 0; i < systemInfo.dwNumberOfProcessors; i++)
+            {
+                u64Idle   += pProcInfo[i].IdleTime.QuadPart;
+                u64Kernel += pProcInfo[i].KernelTime.QuadPart;
+                u64User   += pProcInfo[i].UserTime.QuadPart;
+            }
         }
 
-        uint64_t deltaIdle    = (pProcInfo->IdleTime.QuadPart   - gCtx.au64LastCpuLoad_Idle[0]);
-        uint64_t deltaKernel  = (pProcInfo->KernelTime.QuadPart - gCtx.au64LastCpuLoad_Kernel[0]);
-        uint64_t deltaUser    = (pProcInfo->UserTime.QuadPart   - gCtx.au64LastCpuLoad_User[0]);
+        uint64_t deltaIdle    = (u64Idle   - gCtx.au64LastCpuLoad_Idle[0]);
+        uint64_t deltaKernel  = (u64Kernel - gCtx.au64LastCpuLoad_Kernel[0]);
+        uint64_t deltaUser    = (u64User   - gCtx.au64LastCpuLoad_User[0]);
         deltaKernel          -= deltaIdle;  /* idle time is added to kernel time */
         uint64_t ullTotalTime = deltaIdle + deltaKernel + deltaUser;
         if (ullTotalTime == 0) /* Prevent division through zero. */
@@ -263,78 +365,39 @@ static void VBoxServiceVMStatsReport(void)
 
         req.guestStats.u32StatCaps |= VBOX_GUEST_STAT_CPU_LOAD_IDLE | VBOX_GUEST_STAT_CPU_LOAD_KERNEL | VBOX_GUEST_STAT_CPU_LOAD_USER;
 
-        gCtx.au64LastCpuLoad_Idle[0]   = pProcInfo->IdleTime.QuadPart;
-        gCtx.au64LastCpuLoad_Kernel[0] = pProcInfo->KernelTime.QuadPart;
-        gCtx.au64LastCpuLoad_User[0]   = pProcInfo->UserTime.QuadPart;
-        /** @todo SMP: report details for each CPU?  */
+        gCtx.au64LastCpuLoad_Idle[0]   = u64Idle;
+        gCtx.au64LastCpuLoad_Kernel[0] = u64Kernel;
+        gCtx.au64LastCpuLoad_User[0]   = u64User;
     }
 
-    for (uint32_t i = 0; i < systemInfo.dwNumberOfProcessors; i++)
-    {
-        req.guestStats.u32CpuId = i;
-
-        rc = VbglR3StatReport(&req);
-        if (RT_SUCCESS(rc))
-            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics (CPU %u) reported successfully!\n", i);
-        else
-            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: DeviceIoControl (stats report) failed with %d\n", GetLastError());
-    }
+    req.guestStats.u32CpuId = 0;
+    int rc2 = VbglR3StatReport(&req);
+    if (RT_SUCCESS(rc2))
+        VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics reported successfully!\n");
+    else
+        VBoxServiceVerbose(3, "VBoxStatsReportStatistics: DeviceIoControl (stats report) failed with %d\n", GetLastError());
 
     RTMemFree(pProcInfo);
 
 #elif defined(RT_OS_LINUX)
     VMMDevReportGuestStats req;
     RT_ZERO(req);
-    PRTSTREAM pStrm;
-    char szLine[256];
-    char *psz;
+    /* All we need is at the start of the files; the per-CPU and interrupt
+       lines of /proc/stat can get rather long, so don't read them at all. */
+    char szBuf[_4K];
 
-    int rc = RTStrmOpen("/proc/meminfo", "r", &pStrm);
+    int rc = VBoxServiceVMStatsReadProcFile("/proc/meminfo", &gCtx.hFileMemInfo, szBuf, sizeof(szBuf));
     if (RT_SUCCESS(rc))
     {
-        uint64_t u64Kb;
-        uint64_t u64Total = 0, u64Free = 0, u64Buffers = 0, u64Cached = 0, u64PagedTotal = 0;
-        for (;;)
-        {
-            rc = RTStrmGetLine(pStrm, szLine, sizeof(szLine));
-            if (RT_FAILURE(rc))
-                break;
-            if (strstr(szLine, "MemTotal:") == szLine)
-            {
-                rc = RTStrToUInt64Ex(RTStrStripL(&szLine[9]), &psz, 0, &u64Kb);
-                if (RT_SUCCESS(rc))
-                    u64Total = u64Kb * _1K;
-            }
-            else if (strstr(szLine, "MemFree:") == szLine)
-            {
-                rc = RTStrToUInt64Ex(RTStrStripL(&szLine[8]), &psz, 0, &u64Kb);
-                if (RT_SUCCESS(rc))
-                    u64Free = u64Kb * _1K;
-            }
-            else if (strstr(szLine, "Buffers:") == szLine)
-            {
-                rc = RTStrToUInt64Ex(RTStrStripL(&szLine[8]), &psz, 0, &u64Kb);
-                if (RT_SUCCESS(rc))
-                    u64Buffers = u64Kb * _1K;
-            }
-            else if (strstr(szLine, "Cached:") == szLine)
-            {
-                rc = RTStrToUInt64Ex(RTStrStripL(&szLine[7]), &psz, 0, &u64Kb);
-                if (RT_SUCCESS(rc))
-                    u64Cached = u64Kb * _1K;
-            }
-            else if (strstr(szLine, "SwapTotal:") == szLine)
-            {
-                rc = RTStrToUInt64Ex(RTStrStripL(&szLine[10]), &psz, 0, &u64Kb);
-                if (RT_SUCCESS(rc))
-                    u64PagedTotal = u64Kb * _1K;
-            }
-        }
+        uint64_t u64Total      = VBoxServiceVMStatsGetMemInfo(szBuf, "MemTotal:");
+        uint64_t u64Free       = VBoxServiceVMStatsGetMemInfo(szBuf, "MemFree:");
+        uint64_t u64Buffers    = VBoxServiceVMStatsGetMemInfo(szBuf, "Buffers:");
+        uint64_t u64Cached     = VBoxServiceVMStatsGetMemInfo(szBuf, "Cached:");
+        uint64_t u64PagedTotal = VBoxServiceVMStatsGetMemInfo(szBuf, "SwapTotal:");
         req.guestStats.u32PhysMemTotal   = u64Total / _4K;
         req.guestStats.u32PhysMemAvail   = (u64Free + u64Buffers + u64Cached) / _4K;
         req.guestStats.u32MemSystemCache = (u64Buffers + u64Cached) / _4K;
         req.guestStats.u32PageFileSize   = u64PagedTotal / _4K;
-        RTStrmClose(pStrm);
     }
     else
         VBoxServiceVerbose(3, "VBoxStatsReportStatistics: memory info not available!\n");
@@ -361,91 +424,83 @@ static void VBoxServiceVMStatsReport(void)
     /** @todo req.guestStats.u32MemKernelPaged, make any sense?  = u32MemKernelTotal? */
     /** @todo req.guestStats.u32MemKernelNonPaged, make any sense? = 0? */
 
-    bool fCpuInfoAvail = false;
-    rc = RTStrmOpen("/proc/stat", "r", &pStrm);
-    if (RT_SUCCESS(rc))
+    /*
+     * The first line of /proc/stat has the load summed up over all CPUs.
+     * The host keeps a single CPU load per VM, so that's what we report
+     * instead of sending one request per CPU.
+     */
+    rc = VBoxServiceVMStatsReadProcFile("/proc/stat", &gCtx.hFileStat, szBuf, sizeof(szBuf));
+    if (   RT_SUCCESS(rc)
+        && !strncmp(szBuf, "cpu ", 4))
     {
-        for (;;)
+        char *psz = &szBuf[4];
+
+        uint64_t u64User = 0;
+        rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64User);
+
+        uint64_t u64Nice = 0;
+        if (RT_SUCCESS(rc))
+            rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64Nice);
+
+        uint64_t u64System = 0;
+        if (RT_SUCCESS(rc))
+            rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64System);
+
+        uint64_t u64Idle = 0;
+        if (RT_SUCCESS(rc))
+            rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64Idle);
+
+        if (RT_SUCCESS(rc))
         {
-            rc = RTStrmGetLine(pStrm, szLine, sizeof(szLine));
-            if (RT_FAILURE(rc))
-                break;
-            if (   strstr(szLine, "cpu") == szLine
-                && strlen(szLine) > 3
-                && RT_C_IS_DIGIT(szLine[3]))
-            {
-                uint32_t u32CpuId;
-                rc = RTStrToUInt32Ex(&szLine[3], &psz, 0, &u32CpuId);
-                if (u32CpuId < VMM_MAX_CPU_COUNT)
-                {
-                    uint64_t u64User = 0;
-                    if (RT_SUCCESS(rc))
-                        rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64User);
-
-                    uint64_t u64Nice = 0;
-                    if (RT_SUCCESS(rc))
-                        rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64Nice);
-
-                    uint64_t u64System = 0;
-                    if (RT_SUCCESS(rc))
-                        rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64System);
-
-                    uint64_t u64Idle = 0;
-                    if (RT_SUCCESS(rc))
-                        rc = RTStrToUInt64Ex(RTStrStripL(psz), &psz, 0, &u64Idle);
-
-                    uint64_t u64DeltaIdle   = u64Idle   - gCtx.au64LastCpuLoad_Idle[u32CpuId];
-                    uint64_t u64DeltaSystem = u64System - gCtx.au64LastCpuLoad_Kernel[u32CpuId];
-                    uint64_t u64DeltaUser   = u64User   - gCtx.au64LastCpuLoad_User[u32CpuId];
-                    uint64_t u64DeltaNice   = u64Nice   - gCtx.au64LastCpuLoad_Nice[u32CpuId];
-
-                    uint64_t u64DeltaAll    = u64DeltaIdle
-                                            + u64DeltaSystem
-                                            + u64DeltaUser
-                                            + u64DeltaNice;
-                    if (u64DeltaAll == 0) /* Prevent division through zero. */
-                        u64DeltaAll = 1;
-
-                    gCtx.au64LastCpuLoad_Idle[u32CpuId]   = u64Idle;
-                    gCtx.au64LastCpuLoad_Kernel[u32CpuId] = u64System;
-                    gCtx.au64LastCpuLoad_User[u32CpuId]   = u64User;
-                    gCtx.au64LastCpuLoad_Nice[u32CpuId]   = u64Nice;
-
-                    req.guestStats.u32CpuId = u32CpuId;
-                    req.guestStats.u32CpuLoad_Idle   = (uint32_t)(u64DeltaIdle   * 100 / u64DeltaAll);
-                    req.guestStats.u32CpuLoad_Kernel = (uint32_t)(u64DeltaSystem * 100 / u64DeltaAll);
-                    req.guestStats.u32CpuLoad_User   = (uint32_t)((u64DeltaUser
-                                                                 + u64DeltaNice) * 100 / u64DeltaAll);
-                    req.guestStats.u32StatCaps |= VBOX_GUEST_STAT_CPU_LOAD_IDLE
-                                               |  VBOX_GUEST_STAT_CPU_LOAD_KERNEL
-                                               |  VBOX_GUEST_STAT_CPU_LOAD_USER;
-                    fCpuInfoAvail = true;
-                    rc = VbglR3StatReport(&req);
-                    if (RT_SUCCESS(rc))
-                        VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics (CPU %u) reported successfully!\n", u32CpuId);
-                    else
-                        VBoxServiceVerbose(3, "VBoxStatsReportStatistics: stats report failed with rc=%Rrc\n", rc);
-                }
-                else
-                    VBoxServiceVerbose(3, "VBoxStatsReportStatistics: skipping information for CPU%u\n", u32CpuId);
-            }
+            uint64_t u64DeltaIdle   = u64Idle   - gCtx.au64LastCpuLoad_Idle[0];
+            uint64_t u64DeltaSystem = u64System - gCtx.au64LastCpuLoad_Kernel[0];
+            uint64_t u64DeltaUser   = u64User   - gCtx.au64LastCpuLoad_User[0];
+            uint64_t u64DeltaNice   = u64Nice   - gCtx.au64LastCpuLoad_Nice[0];
+
+            uint64_t u64DeltaAll    = u64DeltaIdle
+                                    + u64DeltaSystem
+                                    + u64DeltaUser
+                                    + u64DeltaNice;
+            if (u64DeltaAll == 0) /* Prevent division through zero. */
+                u64DeltaAll = 1;
+
+            gCtx.au64LastCpuLoad_Idle[0]   = u64Idle;
+            gCtx.au64LastCpuLoad_Kernel[0] = u64System;
+            gCtx.au64LastCpuLoad_User[0]   = u64User;
+            gCtx.au64LastCpuLoad_Nice[0]   = u64Nice;
+
+            req.guestStats.u32CpuId = 0;
+            req.guestStats.u32CpuLoad_Idle   = (uint32_t)(u64DeltaIdle   * 100 / u64DeltaAll);
+            req.guestStats.u32CpuLoad_Kernel = (uint32_t)(u64DeltaSystem * 100 / u64DeltaAll);
+            req.guestStats.u32CpuLoad_User   = (uint32_t)((u64DeltaUser
+                                                         + u64DeltaNice) * 100 / u64DeltaAll);
+            req.guestStats.u32StatCaps |= VBOX_GUEST_STAT_CPU_LOAD_IDLE
+                                       |  VBOX_GUEST_STAT_CPU_LOAD_KERNEL
+                                       |  VBOX_GUEST_STAT_CPU_LOAD_USER;
         }
-        RTStrmClose(pStrm);
     }
-    if (!fCpuInfoAvail)
-    {
+    if (!(req.guestStats.u32StatCaps & VBOX_GUEST_STAT_CPU_LOAD_IDLE))
         VBoxServiceVerbose(3, "VBoxStatsReportStatistics: CPU info not available!\n");
-        rc = VbglR3StatReport(&req);
-        if (RT_SUCCESS(rc))
-            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics reported successfully!\n");
-        else
-            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: stats report failed with rc=%Rrc\n", rc);
-    }
+
+    rc = VbglR3StatReport(&req);
+    if (RT_SUCCESS(rc))
+        VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics reported successfully!\n");
+    else
+        VBoxServiceVerbose(3, "VBoxStatsReportStatistics: stats report failed with rc=%Rrc\n", rc);
 
 #elif defined(RT_OS_SOLARIS)
     VMMDevReportGuestStats req;
     RT_ZERO(req);
-    kstat_ctl_t *pStatKern = kstat_open();
+    /* Opening kstat walks the whole kstat chain, so keep it open and only
+       bring the chain up to date every interval. */
+    if (!gCtx.pStatKern)
+        gCtx.pStatKern = kstat_open();
+    else if (kstat_chain_update(gCtx.pStatKern) == -1)
+    {
+        kstat_close(gCtx.pStatKern);
+        gCtx.pStatKern = kstat_open();
+    }
+    kstat_ctl_t *pStatKern = gCtx.pStatKern;
     if (pStatKern)
     {
         /*
@@ -533,12 +588,13 @@ static void VBoxServiceVMStatsReport(void)
 #endif
 
         /*
-         * CPU statistics.
+         * CPU statistics.  The host keeps a single CPU load per VM, so sum
+         * up the ticks of all CPUs and report them in one go.
          */
         cpu_stat_t StatCPU;
         RT_ZERO(StatCPU);
         kstat_t *pStatNode = NULL;
-        uint32_t cCPUs = 0;
+        uint64_t u64Idle = 0, u64User = 0, u64System = 0;
         bool fCpuInfoAvail = false;
         for (pStatNode = pStatKern->kc_chain; pStatNode != NULL; pStatNode = pStatNode->ks_next)
         {
@@ -546,57 +602,52 @@ static void VBoxServiceVMStatsReport(void)
             {
                 rc = kstat_read(pStatKern, pStatNode, &StatCPU);
                 if (rc == -1)
+                {
+                    fCpuInfoAvail = false;
                     break;
+                }
 
-                uint64_t u64Idle   = StatCPU.cpu_sysinfo.cpu[CPU_IDLE];
-                uint64_t u64User   = StatCPU.cpu_sysinfo.cpu[CPU_USER];
-                uint64_t u64System = StatCPU.cpu_sysinfo.cpu[CPU_KERNEL];
-
-                uint64_t u64DeltaIdle   = u64Idle   - gCtx.au64LastCpuLoad_Idle[cCPUs];
-                uint64_t u64DeltaSystem = u64System - gCtx.au64LastCpuLoad_Kernel[cCPUs];
-                uint64_t u64DeltaUser   = u64User   - gCtx.au64LastCpuLoad_User[cCPUs];
-
-                uint64_t u64DeltaAll    = u64DeltaIdle + u64DeltaSystem + u64DeltaUser;
-                if (u64DeltaAll == 0) /* Prevent division through zero. */
-                    u64DeltaAll = 1;
-
-                gCtx.au64LastCpuLoad_Idle[cCPUs]   = u64Idle;
-                gCtx.au64LastCpuLoad_Kernel[cCPUs] = u64System;
-                gCtx.au64LastCpuLoad_User[cCPUs]   = u64User;
-
-                req.guestStats.u32CpuId = cCPUs;
-                req.guestStats.u32CpuLoad_Idle   = (uint32_t)(u64DeltaIdle   * 100 / u64DeltaAll);
-                req.guestStats.u32CpuLoad_Kernel = (uint32_t)(u64DeltaSystem * 100 / u64DeltaAll);
-                req.guestStats.u32CpuLoad_User   = (uint32_t)(u64DeltaUser   * 100 / u64DeltaAll);
-
-                req.guestStats.u32StatCaps |= VBOX_GUEST_STAT_CPU_LOAD_IDLE
-                                           |  VBOX_GUEST_STAT_CPU_LOAD_KERNEL
-                                           |  VBOX_GUEST_STAT_CPU_LOAD_USER;
+                u64Idle   += StatCPU.cpu_sysinfo.cpu[CPU_IDLE];
+                u64User   += StatCPU.cpu_sysinfo.cpu[CPU_USER];
+                u64System += StatCPU.cpu_sysinfo.cpu[CPU_KERNEL];
                 fCpuInfoAvail = true;
-
-                rc = VbglR3StatReport(&req);
-                if (RT_SUCCESS(rc))
-                    VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics (CPU %u) reported successfully!\n", cCPUs);
-                else
-                    VBoxServiceVerbose(3, "VBoxStatsReportStatistics: stats report failed with rc=%Rrc\n", rc);
-                cCPUs++;
             }
         }
 
-        /*
-         * Report whatever statistics were collected.
-         */
-        if (!fCpuInfoAvail)
+        if (fCpuInfoAvail)
         {
-            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: CPU info not available!\n");
-            rc = VbglR3StatReport(&req);
-            if (RT_SUCCESS(rc))
-                VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics reported successfully!\n");
-            else
-                VBoxServiceVerbose(3, "VBoxStatsReportStatistics: stats report failed with rc=%Rrc\n", rc);
+            uint64_t u64DeltaIdle   = u64Idle   - gCtx.au64LastCpuLoad_Idle[0];
+            uint64_t u64DeltaSystem = u64System - gCtx.au64LastCpuLoad_Kernel[0];
+            uint64_t u64DeltaUser   = u64User   - gCtx.au64LastCpuLoad_User[0];
+
+            uint64_t u64DeltaAll    = u64DeltaIdle + u64DeltaSystem + u64DeltaUser;
+            if (u64DeltaAll == 0) /* Prevent division through zero. */
+                u64DeltaAll = 1;
+
+            gCtx.au64LastCpuLoad_Idle[0]   = u64Idle;
+            gCtx.au64LastCpuLoad_Kernel[0] = u64System;
+            gCtx.au64LastCpuLoad_User[0]   = u64User;
+
+            req.guestStats.u32CpuId = 0;
+            req.guestStats.u32CpuLoad_Idle   = (uint32_t)(u64DeltaIdle   * 100 / u64DeltaAll);
+            req.guestStats.u32CpuLoad_Kernel = (uint32_t)(u64DeltaSystem * 100 / u64DeltaAll);
+            req.guestStats.u32CpuLoad_User   = (uint32_t)(u64DeltaUser   * 100 / u64DeltaAll);
+
+            req.guestStats.u32StatCaps |= VBOX_GUEST_STAT_CPU_LOAD_IDLE
+                                       |  VBOX_GUEST_STAT_CPU_LOAD_KERNEL
+                                       |  VBOX_GUEST_STAT_CPU_LOAD_USER;
         }
+        else
+            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: CPU info not available!\n");
 
-        kstat_close(pStatKern);
+        /*
+         * Report whatever statistics were collected.
+         */
+        rc = VbglR3StatReport(&req);
+        if (RT_SUCCESS(rc))
+            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: new statistics reported successfully!\n");
+        else
+            VBoxServiceVerbose(3, "VBoxStatsReportStatistics: stats report failed with rc=%Rrc\n", rc);
     }
 
 #else
@@ -684,6 +735,24 @@ DECLCALLBACK(int) VBoxServiceVMStatsWorker(bool volatile *pfShutdown)
 static DECLCALLBACK(void) VBoxServiceVMStatsTerm(void)
 {
     VBoxServiceVerbose(3, "VBoxServiceVMStatsTerm\n");
+#if defined(RT_OS_LINUX)
+    if (gCtx.hFileMemInfo != NIL_RTFILE)
+    {
+        RTFileClose(gCtx.hFileMemInfo);
+        gCtx.hFileMemInfo = NIL_RTFILE;
+    }
+    if (gCtx.hFileStat != NIL_RTFILE)
+    {
+        RTFileClose(gCtx.hFileStat);
+        gCtx.hFileStat = NIL_RTFILE;
+    }
+#elif defined(RT_OS_SOLARIS)
+    if (gCtx.pStatKern)
+    {
+        kstat_close(gCtx.pStatKern);
+        gCtx.pStatKern = NULL;
+    }
+#endif
     return;
 }
 
@@ -1191,11 +1191,18 @@ DECLCALLBACK(int) VBoxServiceVMInfoWorker(bool volatile *pfShutdown)
      */
     for (;;)
     {
-        rc = vboxserviceVMInfoWriteUsers();
+        /* Hand the changes of this round to the host in one go. */
+        rc = VBoxServicePropCacheBatchBegin(&g_VMInfoPropCache);
         if (RT_FAILURE(rc))
             break;
 
-        rc = vboxserviceVMInfoWriteNetwork();
+        rc = vboxserviceVMInfoWriteUsers();
+        if (RT_SUCCESS(rc))
+            rc = vboxserviceVMInfoWriteNetwork();
+
+        int rcCommit = VBoxServicePropCacheBatchCommit(&g_VMInfoPropCache);
+        if (RT_FAILURE(rcCommit))
+            VBoxServiceError("VMInfo: Writing the guest properties failed with rc=%Rrc\n", rcCommit);
         if (RT_FAILURE(rc))
             break;
 
@@ -298,6 +298,146 @@ struct file_operations sf_dir_fops =
 };
 
 
+/**
+ * Sets the stable file ID the host reported for a file system object. The
+ * inode number alone is only unique per host device, so the device is part
+ * of the ID. host_ino is 0 if there is no ID. Directories are not hashed by
+ * host ID as they must never end up with more than one dentry.
+ */
+static void sf_host_ino(struct sf_inode_info *sf_i, PSHFLFSOBJINFO info)
+{
+    if (   info->Attr.enmAdditional == SHFLFSOBJATTRADD_UNIX
+        && !RTFS_IS_DIRECTORY(info->Attr.fMode))
+    {
+        sf_i->host_dev = info->Attr.u.Unix.INodeIdDevice;
+        sf_i->host_ino = info->Attr.u.Unix.INodeId;
+    }
+    else
+    {
+        sf_i->host_dev = 0;
+        sf_i->host_ino = 0;
+    }
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0)
+static int sf_inode_test(struct inode *inode, void *data)
+{
+    struct sf_inode_info *sf_i = GET_INODE_INFO(inode);
+    struct sf_inode_info *sf_new_i = data;
+
+    return    sf_i
+           && sf_i->host_ino == sf_new_i->host_ino
+           && sf_i->host_dev == sf_new_i->host_dev;
+}
+
+static int sf_inode_set(struct inode *inode, void *data)
+{
+    struct sf_inode_info *sf_new_i = data;
+
+    inode->i_ino = (ino_t)sf_new_i->host_ino;
+    SET_INODE_INFO(inode, sf_new_i);
+    return 0;
+}
+#endif
+
+/**
+ * Get the inode for a file system object which was just looked up or created.
+ *
+ * If the host provides a stable file ID, the inode is hashed by it so that
+ * the inode and its page cache survive dentry eviction and hard links share
+ * one inode. Otherwise a new inode with a made up number is allocated.
+ *
+ * @param sb            super block
+ * @param sf_new_i      inode information with the path set. If an existing
+ *                      inode is returned, sf_new_i and the path are consumed
+ *                      (freed or moved over). Left alone on failure.
+ * @param info          file information
+ * @returns the initialized and unlocked inode, NULL on failure
+ */
+static struct inode *sf_get_inode(struct super_block *sb, struct sf_inode_info *sf_new_i,
+                                  PSHFLFSOBJINFO info)
+{
+    struct sf_glob_info *sf_g = GET_GLOB_INFO(sb);
+    struct inode *inode;
+    ino_t ino;
+
+    sf_host_ino(sf_new_i, info);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0)
+    if (sf_new_i->host_ino)
+    {
+        struct sf_inode_info *sf_i;
+        struct dentry *alias;
+
+        for (;;)
+        {
+            inode = iget5_locked(sb, (unsigned long)(sf_new_i->host_ino ^ sf_new_i->host_dev),
+                                 sf_inode_test, sf_inode_set, sf_new_i);
+            if (!inode)
+                return NULL;
+
+            if (inode->i_state & I_NEW)
+            {
+                sf_init_inode(sf_g, inode, info);
+                unlock_new_inode(inode);
+                return inode;
+            }
+
+            if (!RTFS_IS_SYMLINK(info->Attr.fMode) == !S_ISLNK(inode->i_mode))
+                break;
+
+            /* The host reused the ID for another kind of object, forget the old inode. */
+            remove_inode_hash(inode);
+            iput(inode);
+        }
+
+        /* Drop cached pages if the file was changed behind our back. */
+        if (   inode->i_size != info->cbObject
+            || inode->i_mtime.tv_sec != RTTimeSpecGetSeconds(&info->ModificationTime))
+# if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 20)
+            invalidate_mapping_pages(inode->i_mapping, 0, -1);
+# else
+            invalidate_inode_pages(inode->i_mapping);
+# endif
+        sf_init_inode(sf_g, inode, info);
+
+        /* Keep the path of the inode while it is still reachable by another name
+           (a hard link), otherwise take the new one (the object was renamed on
+           the host). Nobody can be using the old path if there is no alias. */
+        sf_i = GET_INODE_INFO(inode);
+        alias = d_find_alias(inode);
+        if (alias)
+        {
+            dput(alias);
+            kfree(sf_new_i->path);
+        }
+        else
+        {
+            kfree(sf_i->path);
+            sf_i->path = sf_new_i->path;
+        }
+        kfree(sf_new_i);
+        return inode;
+    }
+#endif
+
+    ino = iunique(sb, 1);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 4, 25)
+    inode = iget_locked(sb, ino);
+#else
+    inode = iget(sb, ino);
+#endif
+    if (!inode)
+        return NULL;
+
+    SET_INODE_INFO(inode, sf_new_i);
+    sf_init_inode(sf_g, inode, info);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 4, 25)
+    unlock_new_inode(inode);
+#endif
+    return inode;
+}
+
 /* iops */
 
 /**
@@ -322,7 +462,6 @@ static struct dentry *sf_lookup(struct inode *parent, struct dentry *dentry
     struct sf_glob_info *sf_g;
     SHFLSTRING *path;
     struct inode *inode;
-    ino_t ino;
     SHFLFSOBJINFO fsinfo;
 
     TRACE();
@@ -359,28 +498,17 @@ static struct dentry *sf_lookup(struct inode *parent, struct dentry *dentry
             goto fail1;
         }
         sf_new_i->handle = SHFL_HANDLE_NIL;
+        sf_new_i->force_restat = 0;
         sf_new_i->force_reread = 0;
+        sf_new_i->path = path;
 
-        ino = iunique(parent->i_sb, 1);
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 4, 25)
-        inode = iget_locked(parent->i_sb, ino);
-#else
-        inode = iget(parent->i_sb, ino);
-#endif
+        inode = sf_get_inode(parent->i_sb, sf_new_i, &fsinfo);
         if (!inode)
         {
             LogFunc(("iget failed\n"));
             err = -ENOMEM;          /* XXX: ??? */
             goto fail2;
         }
-
-        SET_INODE_INFO(inode, sf_new_i);
-        sf_init_inode(sf_g, inode, &fsinfo);
-        sf_new_i->path = path;
-
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 4, 25)
-        unlock_new_inode(inode);
-#endif
     }
 
     sf_i->force_restat = 0;
@@ -419,9 +547,8 @@ static int sf_instantiate(struct inode *parent, struct dentry *dentry,
                           SHFLSTRING *path, PSHFLFSOBJINFO info, SHFLHANDLE handle)
 {
     int err;
-    ino_t ino;
     struct inode *inode;
-    struct sf_inode_info *sf_new_i;
+    struct sf_inode_info *sf_i, *sf_new_i;
     struct sf_glob_info *sf_g = GET_GLOB_INFO(parent->i_sb);
 
     TRACE();
@@ -435,12 +562,12 @@ static int sf_instantiate(struct inode *parent, struct dentry *dentry,
         goto fail0;
     }
 
-    ino = iunique(parent->i_sb, 1);
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 4, 25)
-    inode = iget_locked(parent->i_sb, ino);
-#else
-    inode = iget(parent->i_sb, ino);
-#endif
+    sf_new_i->path = path;
+    sf_new_i->handle = SHFL_HANDLE_NIL;
+    sf_new_i->force_restat = 1;
+    sf_new_i->force_reread = 0;
+
+    inode = sf_get_inode(parent->i_sb, sf_new_i, info);
     if (!inode)
     {
         LogFunc(("iget failed\n"));
@@ -448,20 +575,17 @@ static int sf_instantiate(struct inode *parent, struct dentry *dentry,
         goto fail1;
     }
 
-    sf_init_inode(sf_g, inode, info);
-    sf_new_i->path = path;
-    SET_INODE_INFO(inode, sf_new_i);
-    sf_new_i->force_restat = 1;
-    sf_new_i->force_reread = 0;
+    /* sf_new_i is gone if a cached inode was reused. */
+    sf_i = GET_INODE_INFO(inode);
+    sf_i->force_restat = 1;
 
     d_instantiate(dentry, inode);
 
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 4, 25)
-    unlock_new_inode(inode);
-#endif
-
     /* Store this handle if we leave the handle open. */
-    sf_new_i->handle = handle;
+    if (sf_i->handle == SHFL_HANDLE_NIL)
+        sf_i->handle = handle;
+    else if (handle != SHFL_HANDLE_NIL)
+        vboxCallClose(&client_handle, &sf_g->map, handle);
     return 0;
 
 fail1:
@@ -654,6 +778,10 @@ static int sf_unlink_aux(struct inode *parent, struct dentry *dentry, int fDirec
     /* directory content changed */
     sf_i->force_reread = 1;
 
+    /* The host may reuse the file ID, don't let a later lookup find this inode. */
+    if (!fDirectory && dentry && dentry->d_inode)
+        remove_inode_hash(dentry->d_inode);
+
     err = 0;
 
 fail1:
@@ -739,6 +867,9 @@ static int sf_rename(struct inode *old_parent, struct dentry *old_dentry,
             if (RT_SUCCESS(rc))
             {
                 kfree(old_path);
+                /* A replaced target is gone, see sf_unlink_aux. */
+                if (new_dentry->d_inode)
+                    remove_inode_hash(new_dentry->d_inode);
                 sf_new_i->force_restat = 1;
                 sf_old_i->force_restat = 1; /* XXX: needed? */
                 /* Set the new relative path in the inode. */
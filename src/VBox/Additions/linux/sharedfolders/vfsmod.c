@@ -253,6 +253,8 @@ static int sf_read_super_aux(struct super_block *sb, void *data, int flags)
     }
 
     sf_i->handle = SHFL_HANDLE_NIL;
+    sf_i->host_dev = 0;
+    sf_i->host_ino = 0;
     sf_i->path = kmalloc(sizeof(SHFLSTRING) + 1, GFP_KERNEL);
     if (!sf_i->path)
     {
@@ -63,6 +63,10 @@ struct sf_inode_info
     /* handle valid if a file was created with sf_create_aux until it will
      * be opened with sf_reg_open() */
     SHFLHANDLE handle;
+    /* host file ID (st_dev and st_ino) the inode is hashed by, host_ino is 0
+     * if the inode number was made up with iunique() */
+    uint32_t host_dev;
+    uint64_t host_ino;
 };
 
 struct sf_dir_info
@@ -53,6 +53,9 @@ struct _VBOXCLIPBOARDCONTEXT
 /** Only one client is supported. There seems to be no need for more clients. */
 static VBOXCLIPBOARDCONTEXT g_ctx;
 
+/** The size of the chunks we read the host clipboard data in. */
+#define VBOX_CLIPBOARD_CHUNK_SIZE _64K
+
 
 /**
  * Transfer clipboard data from the guest to the host.
@@ -72,6 +75,63 @@ static int vboxClipboardSendData(uint32_t u32Format, void *pv, uint32_t cb)
 }
 
 
+/**
+ * Get clipboard data from the host a chunk at a time, so that large data
+ * crosses to the guest once instead of being fetched again after the size is
+ * known.
+ *
+ * @returns VBox result code
+ * @returns VERR_NOT_IMPLEMENTED if the host does not support chunked reads
+ * @param   u32Format The format of the data being requested
+ * @retval  ppv       On success, this will point to a buffer to be freed
+ *                    with RTMemFree containing the data read.
+ * @retval  pcb       On success, this contains the number of bytes of data
+ *                    returned
+ */
+static int vboxClipboardReadDataChunked(uint32_t u32Format, void **ppv,
+                                        uint32_t *pcb)
+{
+    uint32_t cbChunk = VBOX_CLIPBOARD_CHUNK_SIZE;
+    uint32_t cbTotal = 0;
+    uint8_t *pb = (uint8_t *)RTMemAlloc(cbChunk);
+
+    if (RT_UNLIKELY(!pb))
+        return VERR_NO_MEMORY;
+    int rc = VbglR3ClipboardReadDataChunk(g_ctx.client, u32Format, 0, pb,
+                                          cbChunk, &cbTotal);
+    if (RT_SUCCESS(rc) && cbTotal > cbChunk)
+    {
+        uint8_t *pbNew = (uint8_t *)RTMemRealloc(pb, cbTotal);
+        if (RT_UNLIKELY(!pbNew))
+            rc = VERR_NO_MEMORY;
+        else
+            pb = pbNew;
+        for (uint32_t off = cbChunk; RT_SUCCESS(rc) && off < cbTotal;
+             off += cbChunk)
+        {
+            uint32_t cbTotalChunk;
+            rc = VbglR3ClipboardReadDataChunk(g_ctx.client, u32Format, off,
+                                              pb + off,
+                                              RT_MIN(cbChunk, cbTotal - off),
+                                              &cbTotalChunk);
+        }
+        /* Tell the host to drop the rest of the data if we gave up. */
+        if (RT_FAILURE(rc))
+            VbglR3ClipboardReadDataChunk(g_ctx.client, u32Format,
+                                         VBOX_SHARED_CLIPBOARD_CHUNK_CANCEL,
+                                         pb, cbChunk, &cbTotal);
+    }
+    if (RT_SUCCESS(rc))
+    {
+        *ppv = pb;
+        *pcb = cbTotal;
+    }
+    else
+        RTMemFree(pb);
+    return rc;
+}
+
+
 /**
  * Get clipboard data from the host.
  *
@@ -85,12 +145,23 @@ static int vboxClipboardSendData(uint32_t u32Format, void *pv, uint32_t cb)
 int ClipRequestDataForX11(VBOXCLIPBOARDCONTEXT *pCtx, uint32_t u32Format,
                           void **ppv, uint32_t *pcb)
 {
-    int rc = VINF_SUCCESS;
+    int rc;
     uint32_t cb = 1024;
-    void *pv = RTMemAlloc(cb);
+    void *pv;
 
     *ppv = 0;
     LogRelFlowFunc(("u32Format=%u\n", u32Format));
+    rc = vboxClipboardReadDataChunked(u32Format, ppv, pcb);
+    if (rc != VERR_NOT_IMPLEMENTED)
+    {
+        if (RT_FAILURE(rc))
+            *pcb = 0;
+        LogRelFlowFunc(("returning %Rrc\n", rc));
+        return rc;
+    }
+    /* Older hosts only hand out the data as a whole. */
+    rc = VINF_SUCCESS;
+    pv = RTMemAlloc(cb);
     if (RT_UNLIKELY(!pv))
         rc = VERR_NO_MEMORY;
     if (RT_SUCCESS(rc))
@@ -1166,6 +1166,23 @@ int AUD_get_buffer_size_out (SWVoiceOut *sw)
     return sw->hw->samples << sw->hw->info.shift;
 }
 
+/*
+ * The audio timer only runs while there is at least one enabled host voice,
+ * a VM with idle audio hardware shouldn't burn CPU cycles on it.
+ */
+static int audio_is_timer_needed (AudioState *s)
+{
+    return audio_pcm_hw_find_any_enabled_out (s, NULL) != NULL
+        || audio_pcm_hw_find_any_enabled_in (s, NULL) != NULL;
+}
+
+static void audio_timer_wakeup (AudioState *s)
+{
+    if (s->ts && !TMTimerIsActive (s->ts)) {
+        TMTimerSet (s->ts, TMTimerGet (s->ts) + conf.period.ticks);
+    }
+}
+
 void AUD_set_active_out (SWVoiceOut *sw, int on)
 {
     HWVoiceOut *hw;
@@ -1185,6 +1202,7 @@ void AUD_set_active_out (SWVoiceOut *sw, int on)
                 hw->enabled = 1;
                 hw->pcm_ops->ctl_out (hw, VOICE_ENABLE);
             }
+            audio_timer_wakeup (&glob_audio_state);
         }
         else {
             if (hw->enabled) {
@@ -1227,6 +1245,7 @@ void AUD_set_active_in (SWVoiceIn *sw, int on)
                 hw->pcm_ops->ctl_in (hw, VOICE_ENABLE);
             }
             sw->total_hw_samples_acquired = hw->total_samples_captured;
+            audio_timer_wakeup (&glob_audio_state);
         }
         else {
             if (hw->enabled) {
@@ -1525,7 +1544,10 @@ static void audio_timer (void *opaque)
     audio_run_in (s);
     audio_run_capture (s);
 
-    TMTimerSet (s->ts, TMTimerGet (s->ts) + conf.period.ticks);
+    /* Go to sleep when all voices are idle, AUD_set_active_out/in wakes us up. */
+    if (audio_is_timer_needed (s)) {
+        TMTimerSet (s->ts, TMTimerGet (s->ts) + conf.period.ticks);
+    }
 }
 
 static struct audio_option audio_options[] = {
@@ -325,6 +325,33 @@ DECLINLINE(bool) vga_is_dirty(VGAState *pThis, RTGCPHYS offVRAM)
     return ASMBitTest(&pThis->au32DirtyBitmap[0], offVRAM >> PAGE_SHIFT);
 }
 
+/**
+ * Tests if any VRAM page in the given range is dirty.
+ *
+ * This scans the bitmap a word at a time, which is a lot cheaper than testing
+ * each page of every scanline when the guest isn't drawing.  Only pages which
+ * are displayed get their dirty bits reset, so the range must not go beyond
+ * what the caller draws.
+ *
+ * @returns true if at least one page is dirty.
+ * @returns false if all pages are clean.
+ * @param   pThis           VGA instance data.
+ * @param   offVRAMStart    Offset into the VRAM buffer of the first byte.
+ * @param   offVRAMEnd      Offset into the VRAM buffer of the last byte - exclusive.
+ */
+DECLINLINE(bool) vga_is_any_dirty(VGAState *pThis, RTGCPHYS offVRAMStart, RTGCPHYS offVRAMEnd)
+{
+    Assert(offVRAMStart < offVRAMEnd);
+    Assert(offVRAMEnd <= pThis->vram_size);
+    uint32_t const iPage    = offVRAMStart >> PAGE_SHIFT;
+    uint32_t const iPageEnd = (offVRAMEnd + PAGE_OFFSET_MASK) >> PAGE_SHIFT;
+    Assert(RT_ALIGN_32(iPageEnd, 32) <= RT_ELEMENTS(pThis->au32DirtyBitmap) * 32);
+    if (ASMBitTest(&pThis->au32DirtyBitmap[0], iPage))
+        return true;
+    int const iBit = ASMBitNextSet(&pThis->au32DirtyBitmap[0], RT_ALIGN_32(iPageEnd, 32), iPage);
+    return iBit >= 0 && (uint32_t)iBit < iPageEnd;
+}
+
 /**
  * Reset dirty flags in a give range.
  *
@@ -2180,6 +2207,31 @@ static int vga_draw_graphic(VGAState *s, bool full_update, bool fFailOnResize, b
 #endif
     addr1 = (s->start_addr * 4);
     bwidth = (width * bits + 7) / 8;    /* The visible width of a scanline. */
+
+    /*
+     * If no displayed VRAM page was written since the last refresh and no
+     * scanline was invalidated explicitly, the loop below would not update
+     * anything.  This is the common case for an idle guest, so skip walking
+     * the scanlines.  The scanlines are taken from at most height * line_offset
+     * bytes starting at start_addr, and from the start of the VRAM after the
+     * line compare split.  Don't bother with the CGA/MDA address wrapping.
+     */
+    if (   !full_update
+        && (s->cr[0x17] & 3) == 3
+        && line_offset >= 0
+        && bwidth > 0
+        && ASMBitFirstSet(&s->invalidated_y_table[0], RT_ALIGN_32(height, 32)) < 0)
+    {
+        uint64_t const cbScanned = (uint64_t)line_offset * height + bwidth;
+        uint64_t const offEnd    = addr1 + cbScanned;
+        if (   offEnd <= s->vram_size
+            && !vga_is_any_dirty(s, addr1, offEnd)
+            && (   s->line_compare >= (uint32_t)height
+                || (   cbScanned <= s->vram_size
+                    && !vga_is_any_dirty(s, 0, cbScanned))))
+            return VINF_SUCCESS;
+    }
+
     y_start = -1;
     page_min = 0x7fffffff;
     page_max = -1;
@@ -4595,6 +4647,28 @@ static DECLCALLBACK(void) vgaDummyRefresh(PPDMIDISPLAYCONNECTOR pInterface)
 #define IDISPLAYPORT_2_VGASTATE(pInterface) ( (PVGASTATE)((uintptr_t)pInterface - RT_OFFSETOF(VGASTATE, IPort)) )
 
 
+/**
+ * Internal vgaPortUpdateDisplayAll worker called under pThis->lock.
+ */
+static int updateDisplayAll(PVGASTATE pThis)
+{
+    PPDMDEVINS pDevIns = pThis->CTX_SUFF(pDevIns);
+
+    /* The dirty bits array has been just cleared, reset handlers as well. */
+    if (pThis->GCPhysVRAM && pThis->GCPhysVRAM != NIL_RTGCPHYS)
+        PGMHandlerPhysicalReset(PDMDevHlpGetVM(pDevIns), pThis->GCPhysVRAM);
+    if (pThis->fRemappedVGA)
+    {
+        IOMMMIOResetRegion(PDMDevHlpGetVM(pDevIns), 0x000a0000);
+        pThis->fRemappedVGA = false;
+    }
+
+    pThis->graphic_mode = -1; /* force full update */
+
+    return vga_update_display(pThis, true, false, true);
+}
+
+
 /**
  * Update the display with any changed regions.
  *
@@ -4621,6 +4695,28 @@ static DECLCALLBACK(int) vgaPortUpdateDisplay(PPDMIDISPLAYPORT pInterface)
 #endif /* VBOX_WITH_HGSMI */
 
     STAM_COUNTER_INC(&pThis->StatUpdateDisp);
+
+    /*
+     * Without a consumer (no framebuffer attached) there is nothing to render,
+     * so don't bother re-arming the write handlers either; that would only make
+     * the guest take write faults for nothing.  Redraw everything once a
+     * consumer shows up again since writes went untracked in the meantime.
+     */
+    if (pThis->pDrv->cBits == 0)
+    {
+        pThis->fSkippedRefresh = true;
+        PDMCritSectLeave(&pThis->lock);
+        return VINF_SUCCESS;
+    }
+    if (pThis->fSkippedRefresh)
+    {
+        pThis->fSkippedRefresh = false;
+        pThis->fHasDirtyBits = false;
+        rc = updateDisplayAll(pThis);
+        PDMCritSectLeave(&pThis->lock);
+        return rc;
+    }
+
     if (pThis->fHasDirtyBits && pThis->GCPhysVRAM && pThis->GCPhysVRAM != NIL_RTGCPHYS)
     {
         PGMHandlerPhysicalReset(PDMDevHlpGetVM(pDevIns), pThis->GCPhysVRAM);
@@ -4643,28 +4739,6 @@ static DECLCALLBACK(int) vgaPortUpdateDisplay(PPDMIDISPLAYPORT pInterface)
 }
 
 
-/**
- * Internal vgaPortUpdateDisplayAll worker called under pThis->lock.
- */
-static int updateDisplayAll(PVGASTATE pThis)
-{
-    PPDMDEVINS pDevIns = pThis->CTX_SUFF(pDevIns);
-
-    /* The dirty bits array has been just cleared, reset handlers as well. */
-    if (pThis->GCPhysVRAM && pThis->GCPhysVRAM != NIL_RTGCPHYS)
-        PGMHandlerPhysicalReset(PDMDevHlpGetVM(pDevIns), pThis->GCPhysVRAM);
-    if (pThis->fRemappedVGA)
-    {
-        IOMMMIOResetRegion(PDMDevHlpGetVM(pDevIns), 0x000a0000);
-        pThis->fRemappedVGA = false;
-    }
-
-    pThis->graphic_mode = -1; /* force full update */
-
-    return vga_update_display(pThis, true, false, true);
-}
-
-
 /**
  * Update the entire display.
  *
@@ -312,7 +312,10 @@ typedef struct VGAState {
     bool                        fRemappedVGA;
     /** Whether to render the guest VRAM to the framebuffer memory. False only for some LFB modes. */
     bool                        fRenderVRAM;
-    bool                        Padding1[2];
+    /** Set when refreshes were skipped because there was no display consumer;
+     * the handlers were not re-armed, so the next refresh must be a full one. */
+    bool                        fSkippedRefresh;
+    bool                        Padding1[1];
 
     /** The physical address the VRAM was assigned. */
     RTGCPHYS                    GCPhysVRAM;
@@ -337,6 +337,8 @@ typedef struct OHCI
     STAMCOUNTER         StatCanceledGenUrbs;
     /** Dropped URBs (endpoint halted, or URB canceled). */
     STAMCOUNTER         StatDroppedUrbs;
+    /** Bulk list runs triggered by the HCD setting BLF. */
+    STAMCOUNTER         StatBulkListKicks;
     /** Profiling ohciFrameBoundaryTimer. */
     STAMPROFILE         StatTimer;
 
@@ -4032,12 +4034,39 @@ static int HcCommandStatus_w(POHCI pOhci, uint32_t iReg, uint32_t val)
         LogRel(("OHCI: Software reset\n"));
         ohciDoReset(pOhci, OHCI_USB_SUSPEND, false /* N/A */);
     }
+    else if (    (val & OHCI_STATUS_BLF)
+             &&  (pOhci->ctl & (OHCI_CTL_HCFS | OHCI_CTL_BLE)) == (OHCI_USB_OPERATIONAL | OHCI_CTL_BLE)
+             &&  pOhci->hcca < OHCI_HCCA_MASK
+             &&  pOhci->hcca >= ~OHCI_HCCA_MASK)
+    {
+        /*
+         * Don't leave the new bulk TDs sitting until the next frame (which can be
+         * up to 20ms away when idle), start processing the list immediately.
+         * The completions are reaped by the frame timer, so also leave idle mode
+         * and re-arm the timer at full rate right away rather than at the next
+         * start of frame.
+         */
+        STAM_COUNTER_INC(&pOhci->StatBulkListKicks);
+        ohciServiceBulkList(pOhci);
+        pOhci->fIdle = false;
+        if (pOhci->cIdleCycles)
+        {
+            pOhci->cIdleCycles = 0;
+            ohciCalcTimerIntervals(pOhci, OHCI_DEFAULT_TIMER_FREQ);
+            TMTimerSet(pOhci->CTX_SUFF(pEndOfFrameTimer), pOhci->SofTime + pOhci->cTicksPerFrame);
+        }
+    }
 #else
     if ((pOhci->status | val) & OHCI_STATUS_HCR)
     {
         LogFlow(("HcCommandStatus_w: reset -> VINF_IOM_R3_MMIO_WRITE\n"));
         return VINF_IOM_R3_MMIO_WRITE;
     }
+    if (val & OHCI_STATUS_BLF)
+    {
+        LogFlow(("HcCommandStatus_w: BLF -> VINF_IOM_R3_MMIO_WRITE\n"));
+        return VINF_IOM_R3_MMIO_WRITE;
+    }
     pOhci->status |= val;
 #endif
     return VINF_SUCCESS;
@@ -5626,6 +5655,7 @@ static DECLCALLBACK(int) ohciR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
     PDMDevHlpSTAMRegister(pDevIns, &pOhci->StatCanceledIsocUrbs, STAMTYPE_COUNTER, "/Devices/OHCI/CanceledIsocUrbs", STAMUNIT_OCCURENCES,     "Detected canceled isochronous URBs.");
     PDMDevHlpSTAMRegister(pDevIns, &pOhci->StatCanceledGenUrbs,  STAMTYPE_COUNTER, "/Devices/OHCI/CanceledGenUrbs",  STAMUNIT_OCCURENCES,     "Detected canceled general URBs.");
     PDMDevHlpSTAMRegister(pDevIns, &pOhci->StatDroppedUrbs,      STAMTYPE_COUNTER, "/Devices/OHCI/DroppedUrbs",      STAMUNIT_OCCURENCES,     "Dropped URBs (endpoint halted, or URB canceled).");
+    PDMDevHlpSTAMRegister(pDevIns, &pOhci->StatBulkListKicks,    STAMTYPE_COUNTER, "/Devices/OHCI/BulkListKicks",    STAMUNIT_OCCURENCES,     "Bulk list runs triggered by the HCD setting BLF.");
     PDMDevHlpSTAMRegister(pDevIns, &pOhci->StatTimer,            STAMTYPE_PROFILE, "/Devices/OHCI/Timer",            STAMUNIT_TICKS_PER_CALL, "Profiling ohciFrameBoundaryTimer.");
 #endif
 
@@ -326,6 +326,21 @@ static PVUSBDEV vusbRhFindDevByAddress(PVUSBROOTHUB pRh, uint8_t Address)
 }
 
 
+/**
+ * Gets the free URB pool size class for a data buffer size.
+ *
+ * @returns Index into VUSBROOTHUB::apFreeUrbs.
+ * @param   cbData      The data buffer size.
+ */
+DECLINLINE(unsigned) vusbRhUrbPoolClass(uint32_t cbData)
+{
+    unsigned iClass = 0;
+    while (iClass < VUSB_URB_POOL_CLASSES - 1 && cbData > (uint32_t)_1K << iClass)
+        iClass++;
+    return iClass;
+}
+
+
 /**
  * Callback for freeing an URB.
  * @param   pUrb    The URB to free.
@@ -353,15 +368,16 @@ static DECLCALLBACK(void) vusbRhFreeUrb(PVUSBURB pUrb)
     }
 
     /*
-     * Put it into the LIFO of free URBs.
+     * Put it into the LIFO of free URBs of its size class.
      * (No ppPrev is needed here.)
      */
+    unsigned const iClass = vusbRhUrbPoolClass(pUrb->VUsb.cbDataAllocated);
     RTCritSectEnter(&pRh->CritSect);
     pUrb->enmState = VUSBURBSTATE_FREE;
     pUrb->VUsb.ppPrev = NULL;
-    pUrb->VUsb.pNext = pRh->pFreeUrbs;
-    pRh->pFreeUrbs = pUrb;
-    Assert(pRh->pFreeUrbs->enmState == VUSBURBSTATE_FREE);
+    pUrb->VUsb.pNext = pRh->apFreeUrbs[iClass];
+    pRh->apFreeUrbs[iClass] = pUrb;
+    Assert(pRh->apFreeUrbs[iClass]->enmState == VUSBURBSTATE_FREE);
     RTCritSectLeave(&pRh->CritSect);
 }
 
@@ -373,15 +389,18 @@ PVUSBURB vusbRhNewUrb(PVUSBROOTHUB pRh, uint8_t DstAddress, uint32_t cbData, uin
 {
     /*
      * Reuse or allocate a new URB.
+     *
+     * The free URBs are kept in lists by size class and only the class of the
+     * request is searched, so this is usually a matter of taking the list head
+     * and small requests never tie up the big data buffers used by MSDs.
      */
-    /** @todo try find a best fit, MSD which submits rather big URBs intermixed with small control
-     * messages ends up with a 2+ of these big URBs when a single one is sufficient.  */
     /** @todo The allocations should be done by the device, at least as an option, since the devices
      * frequently wish to associate their own stuff with the in-flight URB or need special buffering
      * (isochronous on Darwin for instance). */
+    unsigned const iClass = vusbRhUrbPoolClass(cbData);
     RTCritSectEnter(&pRh->CritSect);
     PVUSBURB pUrbPrev = NULL;
-    PVUSBURB pUrb = pRh->pFreeUrbs;
+    PVUSBURB pUrb = pRh->apFreeUrbs[iClass];
     while (pUrb)
     {
         if (    pUrb->VUsb.cbDataAllocated >= cbData
@@ -395,7 +414,7 @@ PVUSBURB vusbRhNewUrb(PVUSBROOTHUB pRh, uint8_t DstAddress, uint32_t cbData, uin
         if (pUrbPrev)
             pUrbPrev->VUsb.pNext = pUrb->VUsb.pNext;
         else
-            pRh->pFreeUrbs = pUrb->VUsb.pNext;
+            pRh->apFreeUrbs[iClass] = pUrb->VUsb.pNext;
         Assert(pUrb->u32Magic == VUSBURB_MAGIC);
         Assert(pUrb->VUsb.pvFreeCtx == pRh);
         Assert(pUrb->VUsb.pfnFree == vusbRhFreeUrb);
@@ -404,10 +423,10 @@ PVUSBURB vusbRhNewUrb(PVUSBROOTHUB pRh, uint8_t DstAddress, uint32_t cbData, uin
     }
     else
     {
-        /* allocate a new one. */
-        uint32_t cbDataAllocated = cbData <= _4K  ? RT_ALIGN_32(cbData, _1K)
-                                 : cbData <= _32K ? RT_ALIGN_32(cbData, _4K)
-                                                  : RT_ALIGN_32(cbData, 16*_1K);
+        /* allocate a new one, all URBs of a size class except the last one have the same size. */
+        uint32_t cbDataAllocated = iClass < VUSB_URB_POOL_CLASSES - 1
+                                 ? (uint32_t)_1K << iClass
+                                 : RT_ALIGN_32(cbData, 16*_1K);
         uint32_t cTdsAllocated = RT_ALIGN_32(cTds, 16);
 
         pUrb = (PVUSBURB)RTMemAlloc(    RT_OFFSETOF(VUSBURB, abData[cbDataAllocated + 16])
@@ -857,16 +876,17 @@ static DECLCALLBACK(void) vusbRhDestruct(PPDMDRVINS pDrvIns)
     /*
      * Free all URBs.
      */
-    while (pRh->pFreeUrbs)
-    {
-        PVUSBURB pUrb = pRh->pFreeUrbs;
-        pRh->pFreeUrbs = pUrb->VUsb.pNext;
+    for (unsigned iClass = 0; iClass < RT_ELEMENTS(pRh->apFreeUrbs); iClass++)
+        while (pRh->apFreeUrbs[iClass])
+        {
+            PVUSBURB pUrb = pRh->apFreeUrbs[iClass];
+            pRh->apFreeUrbs[iClass] = pUrb->VUsb.pNext;
 
-        pUrb->u32Magic = 0;
-        pUrb->enmState = VUSBURBSTATE_INVALID;
-        pUrb->VUsb.pNext = NULL;
-        RTMemFree(pUrb);
-    }
+            pUrb->u32Magic = 0;
+            pUrb->enmState = VUSBURBSTATE_INVALID;
+            pUrb->VUsb.pNext = NULL;
+            RTMemFree(pUrb);
+        }
     if (pRh->Hub.pszName)
     {
         RTStrFree(pRh->Hub.pszName);
@@ -1006,6 +1026,12 @@ static DECLCALLBACK(int) vusbRhConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_INTR].StatReqWriteBytes, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES, "Interrupt transfer.",                            "/VUSB/%d/ReqWriteBytes/Intr",          pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_ISOC].StatReqWriteBytes, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES, "Isochronous transfer.",                          "/VUSB/%d/ReqWriteBytes/Isoc",          pDrvIns->iInstance);
 
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->Total.StatUrbLatency,                        STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL, "Time from URB submission to completion.", "/VUSB/%d/UrbLatency",                 pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_BULK].StatUrbLatency,    STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL, "Bulk transfer.",                          "/VUSB/%d/UrbLatency/Bulk",            pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_CTRL].StatUrbLatency,    STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL, "Control transfer.",                       "/VUSB/%d/UrbLatency/Ctrl",            pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_INTR].StatUrbLatency,    STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL, "Interrupt transfer.",                     "/VUSB/%d/UrbLatency/Intr",            pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_ISOC].StatUrbLatency,    STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL, "Isochronous transfer.",                   "/VUSB/%d/UrbLatency/Isoc",            pDrvIns->iInstance);
+
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->Total.StatActBytes,                          STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES, "Actual total transfer.",                         "/VUSB/%d/ActBytes",                    pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_BULK].StatActBytes,      STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES, "Bulk transfer.",                                 "/VUSB/%d/ActBytes/Bulk",               pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->aTypes[VUSBXFERTYPE_CTRL].StatActBytes,      STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES, "Control transfer.",                              "/VUSB/%d/ActBytes/Ctrl",               pDrvIns->iInstance);
@@ -320,6 +320,9 @@ typedef struct VUSBROOTHUBTYPESTATS
     STAMCOUNTER         StatActBytes;
     STAMCOUNTER         StatActReadBytes;
     STAMCOUNTER         StatActWriteBytes;
+
+    /** Time from submission to completion (nanoseconds). */
+    STAMPROFILE         StatUrbLatency;
 } VUSBROOTHUBTYPESTATS, *PVUSBROOTHUBTYPESTATS;
 
 
@@ -327,6 +330,10 @@ typedef struct VUSBROOTHUBTYPESTATS
 /** The address hash table size. */
 #define VUSB_ADDR_HASHSZ    5
 
+/** The number of size classes in the free URB pool.
+ * The classes are 1K, 2K, 4K, 8K, 16K, 32K and everything larger. */
+#define VUSB_URB_POOL_CLASSES   7
+
 /**
  * The instance data of a root hub driver.
  *
@@ -361,10 +368,10 @@ typedef struct VUSBROOTHUB
     /** Availability Bitmap. */
     VUSBPORTBITMAP          Bitmap;
 
-    /** Critical section protecting the free list. */
+    /** Critical section protecting the free lists. */
     RTCRITSECT              CritSect;
-    /** Chain of free URBs. (Singly linked) */
-    PVUSBURB                pFreeUrbs;
+    /** Chains of free URBs, one per size class. (Singly linked) */
+    PVUSBURB                apFreeUrbs[VUSB_URB_POOL_CLASSES];
     /** The number of URBs in the pool. */
     uint32_t                cUrbsInPool;
     /** Version of the attached Host Controller. */
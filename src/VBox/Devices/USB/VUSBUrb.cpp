@@ -1079,6 +1079,13 @@ void vusbUrbCompletionRh(PVUSBURB pUrb)
             STAM_COUNTER_INC(&pRh->Total.StatUrbsFailed);
             STAM_COUNTER_INC(&pRh->aTypes[pUrb->enmType].StatUrbsFailed);
         }
+
+        if (pUrb->VUsb.u64SubmitTS)
+        {
+            uint64_t const cNsLatency = RTTimeNanoTS() - pUrb->VUsb.u64SubmitTS;
+            STAM_PROFILE_ADD_PERIOD(&pRh->Total.StatUrbLatency, cNsLatency);
+            STAM_PROFILE_ADD_PERIOD(&pRh->aTypes[pUrb->enmType].StatUrbLatency, cNsLatency);
+        }
     }
 #endif /* VBOX_WITH_STATISTICS */
 
@@ -1828,7 +1835,7 @@ int vusbUrbSubmit(PVUSBURB pUrb)
         return VERR_VUSB_DEVICE_IS_RESETTING;
     }
 
-#ifdef LOG_ENABLED
+#if defined(LOG_ENABLED) || defined(VBOX_WITH_STATISTICS)
     /* stamp it */
     pUrb->VUsb.u64SubmitTS = RTTimeNanoTS();
 #endif
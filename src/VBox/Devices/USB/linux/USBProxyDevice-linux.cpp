@@ -1698,6 +1698,45 @@ static VUSBSTATUS vusbProxyLinuxUrbGetStatus(PUSBPROXYURBLNX pUrbLnx)
 }
 
 
+/**
+ * Waits for an URB to complete.
+ *
+ * It seems to me that the path of poll() is shorter and
+ * involves less semaphores than ioctl() on usbfs.
+ *
+ * @returns true if something completed, false on timeout or error.
+ * @param   pProxyDev   The device.
+ * @param   pDevLnx     The linux device data.
+ * @param   cMillies    Number of milliseconds to wait.
+ */
+static bool usbProxyLinuxUrbReapWait(PUSBPROXYDEV pProxyDev, PUSBPROXYDEVLNX pDevLnx, RTMSINTERVAL cMillies)
+{
+    for (;;)
+    {
+        struct pollfd pfd;
+        pfd.fd = RTFileToNative(pDevLnx->hFile);
+        pfd.events = POLLOUT | POLLWRNORM /* completed async */
+                   | POLLERR | POLLHUP    /* disconnected */;
+        pfd.revents = 0;
+        int rc = poll(&pfd, 1, cMillies);
+        Log(("usbProxyLinuxUrbReap: poll rc = %d\n", rc));
+        if (rc >= 1)
+            return true;
+        if (rc >= 0 /*|| errno == ETIMEOUT*/)
+        {
+            vusbProxyLinuxUrbDoTimeouts(pProxyDev, pDevLnx);
+            return false;
+        }
+        if (errno != EAGAIN)
+        {
+            Log(("usb-linux: Reap URB - poll -> %d errno=%d pProxyDev=%s\n", rc, errno, usbProxyGetName(pProxyDev)));
+            return false;
+        }
+        Log(("usbProxyLinuxUrbReap: poll again - weird!!!\n"));
+    }
+}
+
+
 /**
  * Reap URBs in-flight on a device.
  *
@@ -1746,43 +1785,13 @@ static PVUSBURB usbProxyLinuxUrbReap(PUSBPROXYDEV pProxyDev, RTMSINTERVAL cMilli
         if (!pDevLnx->pInFlightHead)
             return NULL;
 
-        /*
-         * Block for requested period.
-         *
-         * It seems to me that the path of poll() is shorter and
-         * involves less semaphores than ioctl() on usbfs. So, we'll
-         * do a poll regardless of whether cMillies == 0 or not.
-         */
-        if (cMillies)
-        {
-
-            for (;;)
-            {
-                struct pollfd pfd;
-                pfd.fd = RTFileToNative(pDevLnx->hFile);
-                pfd.events = POLLOUT | POLLWRNORM /* completed async */
-                           | POLLERR | POLLHUP    /* disconnected */;
-                pfd.revents = 0;
-                int rc = poll(&pfd, 1, cMillies);
-                Log(("usbProxyLinuxUrbReap: poll rc = %d\n", rc));
-                if (rc >= 1)
-                    break;
-                if (rc >= 0 /*|| errno == ETIMEOUT*/)
-                {
-                    vusbProxyLinuxUrbDoTimeouts(pProxyDev, pDevLnx);
-                    return NULL;
-                }
-                if (errno != EAGAIN)
-                {
-                    Log(("usb-linux: Reap URB - poll -> %d errno=%d pProxyDev=%s\n", rc, errno, usbProxyGetName(pProxyDev)));
-                    return NULL;
-                }
-                Log(("usbProxyLinuxUrbReap: poll again - weird!!!\n"));
-            }
-        }
-
         /*
          * Reap URBs, non-blocking.
+         *
+         * We only block for the requested period when nothing has completed
+         * yet.  When the device is busy there usually is a completed URB
+         * waiting already, and polling first would just cost another system
+         * call for every URB.
          */
         for (;;)
         {
@@ -1790,6 +1799,13 @@ static PVUSBURB usbProxyLinuxUrbReap(PUSBPROXYDEV pProxyDev, RTMSINTERVAL cMilli
             while (ioctl(RTFileToNative(pDevLnx->hFile), USBDEVFS_REAPURBNDELAY, &pKUrb))
                 if (errno != EINTR)
                 {
+                    if (errno == EAGAIN && cMillies)
+                    {
+                        if (!usbProxyLinuxUrbReapWait(pProxyDev, pDevLnx, cMillies))
+                            return NULL;
+                        cMillies = 0;
+                        continue;
+                    }
                     if (errno == ENODEV)
                         usbProxLinuxUrbUnplugged(pProxyDev);
                     else if (errno == EAGAIN)
@@ -89,7 +89,9 @@
            && RT_LOWORD(additionsVersion) >  RT_LOWORD(VMMDEV_VERSION) ) )
 
 /** The saved state version. */
-#define VMMDEV_SAVED_STATE_VERSION                              15
+#define VMMDEV_SAVED_STATE_VERSION                              16
+/** The saved state version which is missing the HGCM completion ring. */
+#define VMMDEV_SAVED_STATE_VERSION_MISSING_HGCM_COMPLETION_RING 15
 /** The saved state version which is missing the guest facility statuses. */
 #define VMMDEV_SAVED_STATE_VERSION_MISSING_FACILITY_STATUSES    14
 /** The saved state version which is missing the guestInfo2 bits. */
@@ -1937,6 +1939,23 @@ static DECLCALLBACK(int) vmmdevRequestHandler(PPDMDEVINS pDevIns, void *pvUser,
             }
             break;
         }
+
+        case VMMDevReq_HGCMSetCompletionRing:
+        {
+            if (pRequestHeader->size != sizeof(VMMDevHGCMSetCompletionRing))
+            {
+                AssertMsgFailed(("VMMDevReq_HGCMSetCompletionRing structure has invalid size!\n"));
+                pRequestHeader->rc = VERR_INVALID_PARAMETER;
+            }
+            else
+            {
+                VMMDevHGCMSetCompletionRing *pHGCMSetRing = (VMMDevHGCMSetCompletionRing *)pRequestHeader;
+
+                Log(("VMMDevReq_HGCMSetCompletionRing\n"));
+                pRequestHeader->rc = vmmdevHGCMSetCompletionRing (pThis, pHGCMSetRing->GCPhysRing, pHGCMSetRing->cEntries);
+            }
+            break;
+        }
 #endif /* VBOX_WITH_HGCM */
 
         case VMMDevReq_HGCMCancel:
@@ -3133,6 +3152,12 @@ static DECLCALLBACK(int) vmmdevSaveExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
         SSMR3PutS64(pSSM, RTTimeSpecGetNano(&pThis->aFacilityStatuses[i].TimeSpecTS));
     }
 
+#ifdef VBOX_WITH_HGCM
+    SSMR3PutGCPhys(pSSM, pThis->GCPhysHGCMRing);
+    SSMR3PutU32(pSSM, pThis->cHGCMRingEntries);
+    SSMR3PutU32(pSSM, pThis->idxHGCMRingProducer);
+#endif /* VBOX_WITH_HGCM */
+
     return VINF_SUCCESS;
 }
 
@@ -3253,6 +3278,16 @@ static DECLCALLBACK(int) vmmdevLoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uin
         }
     }
 
+#ifdef VBOX_WITH_HGCM
+    if (uVersion > VMMDEV_SAVED_STATE_VERSION_MISSING_HGCM_COMPLETION_RING)
+    {
+        SSMR3GetGCPhys(pSSM, &pThis->GCPhysHGCMRing);
+        SSMR3GetU32(pSSM, &pThis->cHGCMRingEntries);
+        rc = SSMR3GetU32(pSSM, &pThis->idxHGCMRingProducer);
+        AssertRCReturn(rc, rc);
+    }
+#endif /* VBOX_WITH_HGCM */
+
 
     /*
      * On a resume, we send the capabilities changed message so
@@ -3427,6 +3462,11 @@ static DECLCALLBACK(void) vmmdevReset(PPDMDEVINS pDevIns)
     /* Clear the "HGCM event enabled" flag so the event can be automatically reenabled.  */
     pThis->u32HGCMEnabled = 0;
 
+    /* The guest registers a new completion ring when its driver starts. */
+    pThis->GCPhysHGCMRing = NIL_RTGCPHYS;
+    pThis->cHGCMRingEntries = 0;
+    pThis->idxHGCMRingProducer = 0;
+
     /*
      * Clear the event variables.
      *
@@ -3773,6 +3813,9 @@ static DECLCALLBACK(int) vmmdevConstruct(PPDMDEVINS pDevIns, int iInstance, PCFG
     rc = RTCritSectInit(&pThis->critsectHGCMCmdList);
     AssertRCReturn(rc, rc);
     pThis->u32HGCMEnabled = 0;
+    pThis->GCPhysHGCMRing = NIL_RTGCPHYS;
+    pThis->cHGCMRingEntries = 0;
+    pThis->idxHGCMRingProducer = 0;
 #endif /* VBOX_WITH_HGCM */
 
     /* In this version of VirtualBox the GUI checks whether "needs host cursor"
@@ -1723,6 +1723,93 @@ int vmmdevHGCMCancel2 (VMMDevState *pThis, RTGCPHYS GCPhys)
     return rc;
 }
 
+/**
+ * Handles VMMDevReq_HGCMSetCompletionRing.
+ *
+ * @returns VBox status code that the guest should see.
+ * @param   pThis       The VMMDev instance data.
+ * @param   GCPhysRing  The address of the guest's completion ring, 0 to
+ *                      unregister it.
+ * @param   cEntries    The number of entries in the ring.
+ *
+ * @thread EMT
+ */
+int vmmdevHGCMSetCompletionRing (VMMDevState *pThis, RTGCPHYS GCPhysRing, uint32_t cEntries)
+{
+    if (GCPhysRing == 0)
+    {
+        Log(("vmmdevHGCMSetCompletionRing: unregistered\n"));
+        pThis->GCPhysHGCMRing      = NIL_RTGCPHYS;
+        pThis->cHGCMRingEntries    = 0;
+        pThis->idxHGCMRingProducer = 0;
+        return VINF_SUCCESS;
+    }
+
+    if (    (GCPhysRing & PAGE_OFFSET_MASK)
+        ||  GCPhysRing == NIL_RTGCPHYS
+        ||  cEntries == 0
+        ||  (cEntries & (cEntries - 1))
+        ||  cEntries > (PAGE_SIZE - RT_OFFSETOF(VMMDevHGCMCompletionRing, aGCPhysReqs)) / sizeof(uint64_t))
+    {
+        Log(("vmmdevHGCMSetCompletionRing: GCPhysRing=%RGp cEntries=%#x\n", GCPhysRing, cEntries));
+        return VERR_INVALID_PARAMETER;
+    }
+
+    /* The guest zeroed the ring before registering it. */
+    pThis->GCPhysHGCMRing      = GCPhysRing;
+    pThis->cHGCMRingEntries    = cEntries;
+    pThis->idxHGCMRingProducer = 0;
+    LogRel(("VMMDev: HGCM completion ring at %RGp with %u entries\n", GCPhysRing, cEntries));
+    return VINF_SUCCESS;
+}
+
+/**
+ * Appends a completed request to the guest's HGCM completion ring, if the
+ * guest registered one.  Sets the overflow flag instead if the ring is full.
+ *
+ * This must be done after the request has been written back and before the
+ * guest is notified.
+ *
+ * @param   pThis       The VMMDev instance data.
+ * @param   GCPhysReq   The address of the completed request.
+ *
+ * @thread EMT
+ */
+static void vmmdevHGCMPostCompletion (VMMDevState *pThis, RTGCPHYS GCPhysReq)
+{
+    PPDMDEVINS pDevIns = pThis->pDevIns;
+
+    PDMCritSectEnter(&pThis->CritSect, VERR_SEM_BUSY);
+    if (pThis->GCPhysHGCMRing != NIL_RTGCPHYS)
+    {
+        RTGCPHYS const GCPhysRing = pThis->GCPhysHGCMRing;
+        uint32_t idxConsumer = 0;
+        PDMDevHlpPhysRead(pDevIns, GCPhysRing + RT_OFFSETOF(VMMDevHGCMCompletionRing, idxConsumer),
+                          &idxConsumer, sizeof(idxConsumer));
+
+        /* A consumer index ahead of the producer wraps around and counts as full. */
+        if (pThis->idxHGCMRingProducer - idxConsumer < pThis->cHGCMRingEntries)
+        {
+            uint32_t const iEntry   = pThis->idxHGCMRingProducer & (pThis->cHGCMRingEntries - 1);
+            uint64_t const u64Entry = GCPhysReq;
+            PDMDevHlpPhysWrite(pDevIns,
+                               GCPhysRing + RT_OFFSETOF(VMMDevHGCMCompletionRing, aGCPhysReqs) + iEntry * sizeof(uint64_t),
+                               &u64Entry, sizeof(u64Entry));
+
+            pThis->idxHGCMRingProducer++;
+            PDMDevHlpPhysWrite(pDevIns, GCPhysRing + RT_OFFSETOF(VMMDevHGCMCompletionRing, idxProducer),
+                               &pThis->idxHGCMRingProducer, sizeof(pThis->idxHGCMRingProducer));
+        }
+        else
+        {
+            uint32_t const fOverflow = 1;
+            PDMDevHlpPhysWrite(pDevIns, GCPhysRing + RT_OFFSETOF(VMMDevHGCMCompletionRing, fOverflow),
+                               &fOverflow, sizeof(fOverflow));
+        }
+    }
+    PDMCritSectLeave(&pThis->CritSect);
+}
+
 static int vmmdevHGCMCmdVerify (PVBOXHGCMCMD pCmd, VMMDevHGCMRequestHeader *pHeader)
 {
     switch (pCmd->enmCmdType)
@@ -2187,6 +2274,9 @@ DECLCALLBACK(void) hgcmCompletedWorker (PPDMIHGCMPORT pInterface, int32_t result
         /* Write back the request */
         PDMDevHlpPhysWrite(pVMMDevState->pDevIns, pCmd->GCPhys, pHeader, pCmd->cbSize);
 
+        /* Tell the guest which request completed. */
+        vmmdevHGCMPostCompletion (pVMMDevState, pCmd->GCPhys);
+
         /* Now, when the command was removed from the internal list, notify the guest. */
         VMMDevNotifyGuest (pVMMDevState, VMMDEV_EVENT_HGCM);
 
@@ -2786,6 +2876,7 @@ int vmmdevHGCMLoadStateDone(VMMDevState *pVMMDevState, PSSMHANDLE pSSM)
                        pCmd = NULL;
                    }
 
+                   vmmdevHGCMPostCompletion (pVMMDevState, pIter->GCPhys);
                    VMMDevNotifyGuest (pVMMDevState, VMMDEV_EVENT_HGCM);
                 }
             }
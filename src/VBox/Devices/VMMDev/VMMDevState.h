@@ -281,6 +281,13 @@ typedef struct VMMDevState
     uint32_t u32HGCMEnabled;
     /** Alignment padding. */
     uint32_t u32Alignment7;
+    /** Guest physical address of the HGCM completion ring, NIL_RTGCPHYS if the
+     * guest did not register one. Protected by CritSect. */
+    RTGCPHYS GCPhysHGCMRing;
+    /** Number of entries in the HGCM completion ring, a power of two. */
+    uint32_t cHGCMRingEntries;
+    /** Index of the next HGCM completion ring entry we write. */
+    uint32_t idxHGCMRingProducer;
 #endif /* VBOX_WITH_HGCM */
 
     /** Status LUN: Shared folders LED */
@@ -56,6 +56,8 @@
 #define VNC_ADDRESSSIZE         60
 #define VNC_PORTSSIZE           20
 #define VNC_ADDRESS_OPTION_MAX  500
+/** Size of the tiles which are checked for changes on updates. */
+#define VNC_TILE_SIZE           64
 
 
 /*******************************************************************************
@@ -692,13 +694,66 @@ static inline void convert15To32bpp(uint8_t msb, uint8_t lsb, uint8_t &r, uint8_
     b = (px << 3) & 0xf8;
 }
 
-static inline void convert16To32bpp(uint8_t msb, uint8_t lsb, uint8_t &r, uint8_t &g, uint8_t &b)
+/**
+ * Converts a line of guest framebuffer pixels to the RGBA format of the VNC
+ * framebuffer.
+ *
+ * The loops work on whole pixels and don't branch, so the compiler can
+ * vectorize them. The old content of the destination is compared on the way.
+ *
+ * @returns true if any pixel changed, false if not.
+ * @param   pu32Dst         Where to store the RGBA pixels (little endian).
+ * @param   pu8Src          The guest pixels.
+ * @param   cPixels         The number of pixels.
+ * @param   cBitsPerPixel   The guest color depth (16, 24 or 32).
+ */
+static bool convertLineTo32bpp(uint32_t *pu32Dst, const uint8_t *pu8Src, uint32_t cPixels, uint32_t cBitsPerPixel)
 {
-    uint16_t px = lsb << 8 | msb;
-    // RGB 565 (all bits used, 1 extra bit for green)
-    r = (px >> 8) & 0xf8;
-    g = (px >> 3) & 0xfc;
-    b = (px << 3) & 0xf8;
+    uint32_t fChanged = 0;
+    uint32_t i;
+    switch (cBitsPerPixel)
+    {
+        case 32:
+        {
+            // BGRx to RGBx
+            const uint32_t *pu32Src = (const uint32_t *)pu8Src;
+            for (i = 0; i < cPixels; i++)
+            {
+                uint32_t u32Src = pu32Src[i];
+                uint32_t u32New = ((u32Src >> 16) & 0xff) | (u32Src & 0xff00) | ((u32Src & 0xff) << 16);
+                fChanged |= pu32Dst[i] ^ u32New;
+                pu32Dst[i] = u32New;
+            }
+            break;
+        }
+
+        case 24:
+            for (i = 0; i < cPixels; i++, pu8Src += 3)
+            {
+                uint32_t u32New = pu8Src[2] | (pu8Src[1] << 8) | (pu8Src[0] << 16);
+                fChanged |= pu32Dst[i] ^ u32New;
+                pu32Dst[i] = u32New;
+            }
+            break;
+
+        case 16:
+        {
+            // RGB 565 (all bits used, 1 extra bit for green)
+            const uint16_t *pu16Src = (const uint16_t *)pu8Src;
+            for (i = 0; i < cPixels; i++)
+            {
+                uint32_t px = pu16Src[i];
+                uint32_t u32New = ((px >> 8) & 0xf8) | (((px >> 3) & 0xfc) << 8) | (((px << 3) & 0xf8) << 16);
+                fChanged |= pu32Dst[i] ^ u32New;
+                pu32Dst[i] = u32New;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+    return fChanged != 0;
 }
 
 /**
@@ -721,35 +776,14 @@ DECLCALLBACK(void) VNCServerImpl::VRDEResize(HVRDESERVER hServer)
     LogRel(("VNCServerImpl::VRDEResize to %dx%dx%dbpp\n", info.cWidth, info.cHeight, info.cBitsPerPixel));
 
     // we always alloc an RGBA buffer
-    unsigned char *FrameBuffer = (unsigned char *)RTMemAlloc(info.cWidth * info.cHeight * VNC_SIZEOFRGBA); // RGBA
-    if (info.cBitsPerPixel == 32 || info.cBitsPerPixel == 24)
-    {
-        // Convert RGB (windows/vbox) to BGR(vnc)
-        uint32_t i, j;
-        for (i = 0, j = 0; i < info.cWidth * info.cHeight * VNC_SIZEOFRGBA; i += VNC_SIZEOFRGBA, j += info.cBitsPerPixel / 8)
-        {
-            unsigned char r = info.pu8Bits[j];
-            unsigned char g = info.pu8Bits[j + 1];
-            unsigned char b = info.pu8Bits[j + 2];
-            FrameBuffer[i]     = b;
-            FrameBuffer[i + 1] = g;
-            FrameBuffer[i + 2] = r;
-        }
-    }
-    else if (info.cBitsPerPixel == 16)
-    {
-        uint32_t i, j;
-        for (i = 0, j = 0;
-             i < info.cWidth * info.cHeight * VNC_SIZEOFRGBA;
-             i += VNC_SIZEOFRGBA, j += info.cBitsPerPixel / 8)
-        {
-            convert16To32bpp(info.pu8Bits[j],
-                             info.pu8Bits[j + 1],
-                             FrameBuffer[i],
-                             FrameBuffer[i + 1],
-                             FrameBuffer[i + 2]);
-        }
-    }
+    unsigned char *FrameBuffer = (unsigned char *)RTMemAllocZ(info.cWidth * info.cHeight * VNC_SIZEOFRGBA); // RGBA
+    if (!FrameBuffer)
+        return;
+    // Convert RGB (windows/vbox) to BGR(vnc)
+    uint32_t bpp = info.cBitsPerPixel / 8;
+    for (uint32_t y = 0; y < info.cHeight; y++)
+        convertLineTo32bpp((uint32_t *)FrameBuffer + y * info.cWidth, info.pu8Bits + y * info.cWidth * bpp,
+                           info.cWidth, info.cBitsPerPixel);
     rfbNewFramebuffer(instance->mVNCServer, (char *)FrameBuffer, info.cWidth, info.cHeight, 8, 3, VNC_SIZEOFRGBA);
 
     void *temp = instance->mFrameBuffer;
@@ -805,46 +839,41 @@ DECLCALLBACK(void) VNCServerImpl::VRDEUpdate(HVRDESERVER hServer, unsigned uScre
             }
         }
 
+        /*
+         * Convert the rectangle tile by tile and only report the tiles which
+         * really changed, guests often redraw a lot more than they modify.
+         * Changed tiles next to each other are reported as one rectangle.
+         */
         uint32_t width = instance->FrameInfo.cWidth;
         uint32_t bpp = instance->FrameInfo.cBitsPerPixel / 8;
-        uint32_t joff = order->y * width + order->x;
-        uint32_t srcx, srcy, destx, desty;
-        if (instance->FrameInfo.cBitsPerPixel == 32 || instance->FrameInfo.cBitsPerPixel == 24)
+        uint32_t xEnd = order->x + order->w;
+        uint32_t yEnd = order->y + order->h;
+        for (uint32_t yTile = order->y; yTile < yEnd; yTile += VNC_TILE_SIZE)
         {
-            for (srcy = joff * bpp, desty = joff * VNC_SIZEOFRGBA;
-                 desty < (joff + order->h * width) * VNC_SIZEOFRGBA;
-                 srcy += width * bpp, desty += width * VNC_SIZEOFRGBA)
+            uint32_t yTileEnd = RT_MIN(yTile + VNC_TILE_SIZE, yEnd);
+            uint32_t xChanged = xEnd; /* start of the current run of changed tiles */
+            for (uint32_t xTile = order->x; xTile < xEnd; xTile += VNC_TILE_SIZE)
             {
-                // RGB to BGR
-                for (srcx = srcy, destx = desty;
-                     destx < desty + order->w * VNC_SIZEOFRGBA;
-                     srcx += bpp, destx += VNC_SIZEOFRGBA)
+                uint32_t cxTile = RT_MIN(VNC_TILE_SIZE, xEnd - xTile);
+                bool fChanged = false;
+                for (uint32_t y = yTile; y < yTileEnd; y++)
+                    fChanged |= convertLineTo32bpp((uint32_t *)instance->mFrameBuffer + y * width + xTile,
+                                                   instance->mScreenBuffer + (y * width + xTile) * bpp,
+                                                   cxTile, instance->FrameInfo.cBitsPerPixel);
+                if (fChanged)
                 {
-                    instance->mFrameBuffer[destx]     = instance->mScreenBuffer[srcx + 2];
-                    instance->mFrameBuffer[destx + 1] = instance->mScreenBuffer[srcx + 1];
-                    instance->mFrameBuffer[destx + 2] = instance->mScreenBuffer[srcx];
+                    if (xChanged == xEnd)
+                        xChanged = xTile;
                 }
-            }
-        }
-        else if (instance->FrameInfo.cBitsPerPixel == 16)
-        {
-            for (srcy = joff * bpp, desty = joff * VNC_SIZEOFRGBA;
-                 desty < (joff + order->h * width) * VNC_SIZEOFRGBA;
-                 srcy += width * bpp, desty += width * VNC_SIZEOFRGBA)
-            {
-                for (srcx = srcy, destx = desty;
-                     destx < desty + order->w * VNC_SIZEOFRGBA;
-                     srcx += bpp, destx += VNC_SIZEOFRGBA)
+                else if (xChanged != xEnd)
                 {
-                    convert16To32bpp(instance->mScreenBuffer[srcx],
-                                     instance->mScreenBuffer[srcx + 1],
-                                     instance->mFrameBuffer[destx],
-                                     instance->mFrameBuffer[destx + 1],
-                                     instance->mFrameBuffer[destx + 2]);
+                    rfbMarkRectAsModified(instance->mVNCServer, xChanged, yTile, xTile, yTileEnd);
+                    xChanged = xEnd;
                 }
             }
+            if (xChanged != xEnd)
+                rfbMarkRectAsModified(instance->mVNCServer, xChanged, yTile, xEnd, yTileEnd);
         }
-        rfbMarkRectAsModified(instance->mVNCServer, order->x, order->y, order->x+order->w, order->y+order->h);
     }
 }
 
@@ -20,7 +20,9 @@
 
 #include "FFmpegFB.h"
 
+#include <iprt/asm.h>
 #include <iprt/file.h>
+#include <iprt/mem.h>
 #include <iprt/param.h>
 #include <iprt/assert.h>
 #include <VBox/log.h>
@@ -105,6 +107,21 @@ FFmpegFB::FFmpegFB(ULONG width, ULONG height, ULONG bitrate,
 {
     ULONG cPixels = width * height;
 
+    mEncodeRGBBuffer = NULL;
+    mEncodeThread = NIL_RTTHREAD;
+    mEncodeEvent = NIL_RTSEMEVENT;
+    mfEncodeShutdown = false;
+    mfFrameChanged = true;
+    mfSnapshotPending = false;
+    mfSnapshotChanged = false;
+    mSnapshotTime = 0;
+    /* Same as the fallback format chosen by RequestResize. */
+#ifdef VBOX_WITH_VPX
+    mEncodePixelFormat = VPX_IMG_FMT_RGB32;
+#else
+    mEncodePixelFormat = PIX_FMT_RGBA32;
+#endif
+
 #ifdef VBOX_WITH_VPX
     Assert(width % 2 == 0 && height % 2 == 0);
     /* For temporary RGB frame we allocate enough memory to deal with
@@ -169,10 +186,20 @@ nomem_temp_rgb_buffer:
 FFmpegFB::~FFmpegFB()
 {
     LogFlow(("Destroying FFmpegFB object %p\n", this));
+    if (mEncodeThread != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&mfEncodeShutdown, true);
+        RTSemEventSignal(mEncodeEvent);
+        RTThreadWait(mEncodeThread, RT_INDEFINITE_WAIT, NULL);
+        mEncodeThread = NIL_RTTHREAD;
+    }
+    if (mEncodeEvent != NIL_RTSEMEVENT)
+        RTSemEventDestroy(mEncodeEvent);
 #ifdef VBOX_WITH_VPX
-    /* Dummy update to make sure we get all the frame (timing). */
-    NotifyUpdate(0, 0, 0, 0);
+    /* Make sure we get all the frames (timing). */
+    encode_pending_frames();
     /* Write the last pending frame before exiting */
+    take_frame_snapshot(true /* fForce */);
     int rc = do_rgb_to_yuv_conversion();
     if (rc == S_OK)
         VideoRecEncodeAndWrite(pVideoRecContext, mFrameWidth, mFrameHeight, mYUVBuffer);
@@ -196,9 +223,10 @@ FFmpegFB::~FFmpegFB()
     {
         if (mfUrlOpen)
         {
-            /* Dummy update to make sure we get all the frame (timing). */
-            NotifyUpdate(0, 0, 0, 0);
+            /* Make sure we get all the frames (timing). */
+            encode_pending_frames();
             /* Write the last pending frame before exiting */
+            take_frame_snapshot(true /* fForce */);
             int rc = do_rgb_to_yuv_conversion();
             if (rc == S_OK)
                 do_encoding_and_write();
@@ -239,6 +267,7 @@ FFmpegFB::~FFmpegFB()
     if (mRGBBuffer)
         RTMemFree(mRGBBuffer);
 #endif
+    RTMemFree(mEncodeRGBBuffer);
 }
 
 // public methods only for internal purposes
@@ -296,8 +325,18 @@ HRESULT FFmpegFB::init()
     RequestResize(0, FramebufferPixelFormat_Opaque, NULL, 0, 0,
                   mFrameWidth, mFrameHeight, &finished);
     /* Start counting time */
-    mLastTime = RTTimeMilliTS();
-    mLastTime = mLastTime - mLastTime % 40;
+    int64_t iStartTime = RTTimeMilliTS();
+    mLastTime = iStartTime - iStartTime % 40;
+
+    /* Converting and encoding is done on a separate thread so that it does
+       not hold up the display updates. */
+    mEncodeRGBBuffer = reinterpret_cast<uint8_t *>(RTMemAlloc(mFrameWidth * mFrameHeight * 4));
+    AssertReturn(mEncodeRGBBuffer, E_OUTOFMEMORY);
+    int rc2 = RTSemEventCreate(&mEncodeEvent);
+    AssertRCReturn(rc2, E_UNEXPECTED);
+    rc2 = RTThreadCreate(&mEncodeThread, FFmpegFB::encoder_thread, this, 0,
+                         RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "VideoEnc");
+    AssertRCReturn(rc2, E_UNEXPECTED);
     return rc;
 }
 
@@ -505,82 +544,40 @@ STDMETHODIMP FFmpegFB::Unlock()
  */
 STDMETHODIMP FFmpegFB::NotifyUpdate(ULONG x, ULONG y, ULONG w, ULONG h)
 {
-    int rc;
-    int64_t iCurrentTime = RTTimeMilliTS();
-
     LogFlow(("FFmpeg::NotifyUpdate called: x=%lu, y=%lu, w=%lu, h=%lu\n",
               (unsigned long) x,  (unsigned long) y,  (unsigned long) w,
                (unsigned long) h));
 
-    /* We always leave at least one frame update pending, which we
-       process when the time until the next frame has elapsed. */
-    if (iCurrentTime - mLastTime >= 40)
+    /* We only copy the updated data to the intermediate buffer here and
+       leave the encoding to the encoder thread.  Frames which became due
+       before this update must still show the old picture, so we snapshot
+       it for the encoder first, unless the encoder still owns the snapshot
+       buffer.  In that case the update is merged into the next frame. */
+    RTCritSectEnter(&mCritSect);
+    int64_t iCurrentTime = RTTimeMilliTS();
+    bool fFrameDue = iCurrentTime - ASMAtomicReadS64(&mLastTime) >= 40;
+    if (fFrameDue && !mfSnapshotPending)
     {
-        rc = do_rgb_to_yuv_conversion();
-        if (rc != S_OK)
-        {
-#ifdef VBOX_WITH_VPX
-            VideoRecCopyToIntBuffer(pVideoRecContext, x, y, w, h, mPixelFormat,
-                                    mBitsPerPixel, mBytesPerLine, mFrameWidth,
-                                    mFrameHeight, mGuestHeight, mGuestWidth,
-                                    mBufferAddress, mTempRGBBuffer);
-#else
-           copy_to_intermediate_buffer(x, y, w, h);
-#endif
-            return rc;
-        }
-        rc = do_encoding_and_write();
-        if (rc != S_OK)
-        {
-#ifdef VBOX_WITH_VPX
-            VideoRecCopyToIntBuffer(pVideoRecContext, x, y, w, h, mPixelFormat,
-                                    mBitsPerPixel, mBytesPerLine, mFrameWidth,
-                                    mFrameHeight, mGuestHeight, mGuestWidth,
-                                    mBufferAddress, mTempRGBBuffer);
-#else
-            copy_to_intermediate_buffer(x, y, w, h);
-#endif
-
-            return rc;
-        }
-        mLastTime = mLastTime + 40;
-        /* Write frames for the time in-between.  Not a good way
-           to handle this. */
-        while (iCurrentTime - mLastTime >= 40)
-        {
-/*            rc = do_rgb_to_yuv_conversion();
-            if (rc != S_OK)
-            {
-                copy_to_intermediate_buffer(x, y, w, h);
-                return rc;
-            }
-*/          rc = do_encoding_and_write();
-            if (rc != S_OK)
-            {
-#ifdef VBOX_WITH_VPX
-                VideoRecCopyToIntBuffer(pVideoRecContext, x, y, w, h, mPixelFormat,
-                                        mBitsPerPixel, mBytesPerLine, mFrameWidth,
-                                        mFrameHeight, mGuestHeight, mGuestWidth,
-                                        mBufferAddress, mTempRGBBuffer);
-#else
-                copy_to_intermediate_buffer(x, y, w, h);
-#endif
-                return rc;
-            }
-            mLastTime = mLastTime + 40;
-        }
+        mfSnapshotChanged = mfFrameChanged;
+        if (mfFrameChanged)
+            snapshot_frame_locked();
+        mSnapshotTime = iCurrentTime;
+        mfSnapshotPending = true;
     }
-    /* Finally we copy the updated data to the intermediate buffer,
-       ready for the next update. */
 #ifdef VBOX_WITH_VPX
     VideoRecCopyToIntBuffer(pVideoRecContext, x, y, w, h, mPixelFormat,
                             mBitsPerPixel, mBytesPerLine, mFrameWidth,
                             mFrameHeight, mGuestHeight, mGuestWidth,
                             mBufferAddress, mTempRGBBuffer);
-
 #else
     copy_to_intermediate_buffer(x, y, w, h);
 #endif
+    if (w && h)
+        mfFrameChanged = true;
+    RTCritSectLeave(&mCritSect);
+
+    if (fFrameDue)
+        RTSemEventSignal(mEncodeEvent);
     return S_OK;
 }
 
@@ -627,6 +624,9 @@ STDMETHODIMP FFmpegFB::RequestResize(ULONG aScreenId, ULONG pixelFormat,
     /* For now, we are doing things synchronously */
     *finished = true;
 
+    /* The encoder thread takes snapshots of the intermediate buffer. */
+    RTCritSectEnter(&mCritSect);
+
     /* We always reallocate our buffer */
     if (mRGBBuffer)
         RTMemFree(mRGBBuffer);
@@ -704,7 +704,11 @@ STDMETHODIMP FFmpegFB::RequestResize(ULONG aScreenId, ULONG pixelFormat,
         mBytesPerLine = w * 4;
         mBitsPerPixel = 32;
         mRGBBuffer = reinterpret_cast<uint8_t *>(RTMemAlloc(mBytesPerLine * h));
-        AssertReturn(mRGBBuffer != 0, E_OUTOFMEMORY);
+        if (!mRGBBuffer)
+        {
+            RTCritSectLeave(&mCritSect);
+            AssertFailedReturn(E_OUTOFMEMORY);
+        }
         Log2(("FFmpeg::RequestResize: alloc'ing mBufferAddress and mRGBBuffer to %p and mBytesPerLine to %lu\n",
               mBufferAddress, (unsigned long) mBytesPerLine));
         mBufferAddress = mRGBBuffer;
@@ -712,6 +716,8 @@ STDMETHODIMP FFmpegFB::RequestResize(ULONG aScreenId, ULONG pixelFormat,
 
     /* Blank out the intermediate frame framebuffer */
     memset(mTempRGBBuffer, 0, mFrameWidth * mFrameHeight * 4);
+    mfFrameChanged = true;
+    RTCritSectLeave(&mCritSect);
     return S_OK;
 }
 
@@ -1010,45 +1016,167 @@ void FFmpegFB::copy_to_intermediate_buffer(ULONG x, ULONG y, ULONG w, ULONG h)
 
 
 /**
- * Copy the RGB data in the intermediate framebuffer to YUV data in
- * the YUV framebuffer.
+ * Copy the intermediate framebuffer to the encoder snapshot.  The caller
+ * must hold the framebuffer lock and own the snapshot buffer.
+ */
+void FFmpegFB::snapshot_frame_locked()
+{
+    memcpy(mEncodeRGBBuffer, mTempRGBBuffer, mFrameWidth * mFrameHeight * 4);
+    mEncodePixelFormat = mFFMPEGPixelFormat;
+    mfFrameChanged = false;
+}
+
+
+/**
+ * Take a snapshot of the intermediate framebuffer for the encoder.  This
+ * is only a copy, so the framebuffer lock is not held for long.  Must not
+ * be called while the encoder thread is running.
+ *
+ * @returns true if a snapshot was taken, false if nothing changed since
+ *          the last one.
+ * @param fForce   take a snapshot even if nothing changed
+ */
+bool FFmpegFB::take_frame_snapshot(bool fForce)
+{
+    AssertPtrReturn(mEncodeRGBBuffer, false);
+    RTCritSectEnter(&mCritSect);
+    bool fChanged = mfFrameChanged || fForce;
+    if (fChanged)
+        snapshot_frame_locked();
+    RTCritSectLeave(&mCritSect);
+    return fChanged;
+}
+
+
+/**
+ * Encode and write all frames which are due.  If NotifyUpdate saved the
+ * picture from before an update, that picture is used for the frames
+ * which were due at the time of the update.  The picture is only
+ * converted again if the guest screen changed since the previous frame,
+ * otherwise the last YUV frame is repeated.
+ */
+void FFmpegFB::encode_pending_frames()
+{
+    AssertPtrReturnVoid(mEncodeRGBBuffer);
+    for (;;)
+    {
+        int64_t iLastTime = ASMAtomicReadS64(&mLastTime);
+        int64_t iSlotsEnd;
+        bool fConvert;
+
+        /* While mfSnapshotPending is set the snapshot buffer belongs to us
+           and NotifyUpdate leaves it alone. */
+        RTCritSectEnter(&mCritSect);
+        if (mfSnapshotPending)
+        {
+            iSlotsEnd = mSnapshotTime;
+            fConvert = mfSnapshotChanged;
+        }
+        else
+        {
+            iSlotsEnd = RTTimeMilliTS();
+            if (iSlotsEnd - iLastTime < 40)
+            {
+                RTCritSectLeave(&mCritSect);
+                return;
+            }
+            fConvert = mfFrameChanged;
+            if (fConvert)
+                snapshot_frame_locked();
+            mfSnapshotPending = true;
+        }
+        RTCritSectLeave(&mCritSect);
+
+        HRESULT rc = S_OK;
+        if (fConvert)
+            rc = do_rgb_to_yuv_conversion();
+
+        /* Write frames for the time in-between.  Not a good way
+           to handle this. */
+        while (rc == S_OK && iSlotsEnd - iLastTime >= 40)
+        {
+            rc = do_encoding_and_write();
+            if (rc == S_OK)
+                iLastTime += 40;
+        }
+        ASMAtomicWriteS64(&mLastTime, iLastTime);
+
+        RTCritSectEnter(&mCritSect);
+        mfSnapshotPending = false;
+        RTCritSectLeave(&mCritSect);
+        if (rc != S_OK)
+            return;
+    }
+}
+
+
+/**
+ * The encoder thread, woken up by NotifyUpdate when a frame is due and
+ * otherwise once per frame interval.
+ *
+ * @returns IPRT status code.
+ * @param hThreadSelf  the thread handle
+ * @param pvUser       the FFmpegFB instance
+ */
+/* static */ DECLCALLBACK(int) FFmpegFB::encoder_thread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    FFmpegFB *pThis = reinterpret_cast<FFmpegFB *>(pvUser);
+    NOREF(hThreadSelf);
+
+    for (;;)
+    {
+        /* Also wake up once per frame so that frames keep being written
+           while the guest screen does not change. */
+        RTSemEventWait(pThis->mEncodeEvent, 40);
+        if (ASMAtomicReadBool(&pThis->mfEncodeShutdown))
+            break;
+        pThis->encode_pending_frames();
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Copy the RGB data in the encoder snapshot to YUV data in the YUV
+ * framebuffer.
  *
  * @returns COM status code
  */
 HRESULT FFmpegFB::do_rgb_to_yuv_conversion()
 {
-    switch (mFFMPEGPixelFormat)
+    AssertPtrReturn(mEncodeRGBBuffer, E_UNEXPECTED);
+    switch (mEncodePixelFormat)
     {
 #ifdef VBOX_WITH_VPX
         case VPX_IMG_FMT_RGB32:
             if (!FFmpegWriteYUV420p<FFmpegBGRA32Iter>(mFrameWidth, mFrameHeight,
-                                                      mYUVBuffer, mTempRGBBuffer))
+                                                      mYUVBuffer, mEncodeRGBBuffer))
                 return E_UNEXPECTED;
             break;
         case VPX_IMG_FMT_RGB24:
             if (!FFmpegWriteYUV420p<FFmpegBGR24Iter>(mFrameWidth, mFrameHeight,
-                                                     mYUVBuffer, mTempRGBBuffer))
+                                                     mYUVBuffer, mEncodeRGBBuffer))
                 return E_UNEXPECTED;
             break;
         case VPX_IMG_FMT_RGB565:
             if (!FFmpegWriteYUV420p<FFmpegBGR565Iter>(mFrameWidth, mFrameHeight,
-                                                      mYUVBuffer, mTempRGBBuffer))
+                                                      mYUVBuffer, mEncodeRGBBuffer))
                 return E_UNEXPECTED;
             break;
 #else
         case PIX_FMT_RGBA32:
             if (!FFmpegWriteYUV420p<FFmpegBGRA32Iter>(mFrameWidth, mFrameHeight,
-                                                      mYUVBuffer, mTempRGBBuffer))
+                                                      mYUVBuffer, mEncodeRGBBuffer))
                 return E_UNEXPECTED;
             break;
         case PIX_FMT_RGB24:
             if (!FFmpegWriteYUV420p<FFmpegBGR24Iter>(mFrameWidth, mFrameHeight,
-                                                     mYUVBuffer, mTempRGBBuffer))
+                                                     mYUVBuffer, mEncodeRGBBuffer))
                 return E_UNEXPECTED;
             break;
         case PIX_FMT_RGB565:
             if (!FFmpegWriteYUV420p<FFmpegBGR565Iter>(mFrameWidth, mFrameHeight,
-                                                      mYUVBuffer, mTempRGBBuffer))
+                                                      mYUVBuffer, mEncodeRGBBuffer))
                 return E_UNEXPECTED;
             break;
 
@@ -27,6 +27,8 @@
 
 #include <iprt/initterm.h>
 #include <iprt/critsect.h>
+#include <iprt/semaphore.h>
+#include <iprt/thread.h>
 
 #ifdef VBOX_WITH_VPX
 #include "EbmlWriter.h"
@@ -155,6 +157,9 @@ private:
     uint8_t *mBufferAddress;
     /** An intermediary RGB buffer with the same dimensions */
     uint8_t *mTempRGBBuffer;
+    /** Snapshot of mTempRGBBuffer the encoder thread converts from, so
+      * that the framebuffer lock is only held for a copy */
+    uint8_t *mEncodeRGBBuffer;
     /** Frame buffer translated into YUV420 for the mpeg codec */
     uint8_t *mYUVBuffer;
     /** Temporary buffer into which the codec writes frames to be
@@ -164,9 +169,30 @@ private:
     /** File where we store the mpeg stream */
     RTFILE mFile;
     /** time at which the last "real" frame was created */
-    int64_t mLastTime;
+    int64_t volatile mLastTime;
     /** ffmpeg pixel format of guest framebuffer */
     int mFFMPEGPixelFormat;
+    /** ffmpeg pixel format of mEncodeRGBBuffer */
+    int mEncodePixelFormat;
+    /** The thread converting and encoding the frames */
+    RTTHREAD mEncodeThread;
+    /** Event semaphore for waking up the encoder thread */
+    RTSEMEVENT mEncodeEvent;
+    /** Set when the encoder thread should terminate */
+    bool volatile mfEncodeShutdown;
+    /** Set if the intermediate buffer was updated since the last snapshot,
+      * protected by mCritSect */
+    bool mfFrameChanged;
+    /** Set while the snapshot buffer belongs to the encoder, either because
+      * NotifyUpdate saved the picture for the due frames in it or because the
+      * encoder is converting it, protected by mCritSect */
+    bool mfSnapshotPending;
+    /** Set if the pending snapshot differs from the previous one, protected
+      * by mCritSect */
+    bool mfSnapshotChanged;
+    /** Time up to which frames are written from the pending snapshot,
+      * protected by mCritSect */
+    int64_t mSnapshotTime;
     /** Since we are building without exception support, we use this
         to signal allocation failure in the constructor */
     bool mOutOfMemory;
@@ -179,6 +205,10 @@ private:
     HRESULT open_codec();
     HRESULT open_output_file();
     void copy_to_intermediate_buffer(ULONG x, ULONG y, ULONG w, ULONG h);
+    void snapshot_frame_locked();
+    bool take_frame_snapshot(bool fForce);
+    void encode_pending_frames();
+    static DECLCALLBACK(int) encoder_thread(RTTHREAD hThreadSelf, void *pvUser);
     HRESULT do_rgb_to_yuv_conversion();
     HRESULT do_encoding_and_write();
     HRESULT write_png();
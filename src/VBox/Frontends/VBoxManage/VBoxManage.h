@@ -206,6 +206,7 @@ HRESULT showVMInfo(ComPtr<IVirtualBox> virtualBox,
                    VMINFO_DETAILS details = VMINFO_NONE,
                    ComPtr <IConsole> console = ComPtr<IConsole>());
 const char *machineStateToName(MachineState_T machineState, bool fShort);
+void outputMachineReadableString(const char *pszName, com::Bstr const *pbstrValue);
 HRESULT showBandwidthGroups(ComPtr<IBandwidthControl> &bwCtrl,
                             VMINFO_DETAILS details);
 
@@ -214,7 +214,7 @@ const char *facilityStateToName(AdditionsFacilityStatus_T faStatus, bool fShort)
  * @param   pszName             The variable name.
  * @param   pbstrValue          The value.
  */
-static void outputMachineReadableString(const char *pszName, Bstr const *pbstrValue)
+void outputMachineReadableString(const char *pszName, Bstr const *pbstrValue)
 {
     Assert(strpbrk(pszName, "\"\\") == NULL);
 
@@ -451,14 +451,67 @@ HRESULT showVMInfo(ComPtr<IVirtualBox> virtualBox,
      * 3) numbers (containing just [0-9\-]) are written out unchanged.
      */
 
-    BOOL fAccessible;
-    CHECK_ERROR2_RET(machine, COMGETTER(Accessible)(&fAccessible), hrcCheck);
+    /*
+     * Fetch the general attributes in one go, this saves a lot of round
+     * trips when talking to VBoxSVC over XPCOM.
+     */
+    enum
+    {
+        kAccessible = 0, kName, kGroups, kOSTypeId, kId, kSettingsFilePath, kSnapshotFolder, kLogFolder,
+        kHardwareUUID, kMemorySize, kPageFusionEnabled, kVRAMSize, kCPUExecutionCap, kHPETEnabled,
+        kChipsetType, kFirmwareType, kCPUCount, kGeneralAttrs
+    };
+    static const char * const s_apszGeneralAttrs[kGeneralAttrs] =
+    {
+        "accessible", "name", "groups", "OSTypeId", "id", "settingsFilePath", "snapshotFolder", "logFolder",
+        "hardwareUUID", "memorySize", "pageFusionEnabled", "VRAMSize", "CPUExecutionCap", "HPETEnabled",
+        "chipsetType", "firmwareType", "CPUCount"
+    };
+    com::SafeArray<BSTR> generalAttrs(kGeneralAttrs);
+    for (size_t i = 0; i < kGeneralAttrs; ++i)
+        Bstr(s_apszGeneralAttrs[i]).detachTo(&generalAttrs[i]);
+    com::SafeArray<BSTR> generalValues;
+    CHECK_ERROR2_RET(virtualBox, QueryMachineInfo(machine, ComSafeArrayAsInParam(generalAttrs),
+                                                  ComSafeArrayAsOutParam(generalValues)), hrcCheck);
+    if (generalValues.size() != kGeneralAttrs)
+        return E_FAIL;
+
+#define SHOW_GENERAL_STRING(a_iAttr, a_szMachine, a_szHuman) \
+    do \
+    { \
+        Bstr bstr(generalValues[a_iAttr]); \
+        if (details == VMINFO_MACHINEREADABLE) \
+            outputMachineReadableString(a_szMachine, &bstr); \
+        else \
+            RTPrintf("%-16s %ls\n", a_szHuman ":", bstr.raw()); \
+    } while (0)
+
+#define SHOW_GENERAL_BOOLEAN(a_iAttr, a_szMachine, a_szHuman) \
+    do \
+    { \
+        bool f = Utf8Str(generalValues[a_iAttr]) == "1"; \
+        if (details == VMINFO_MACHINEREADABLE) \
+            RTPrintf( a_szMachine "=\"%s\"\n", f ? "on" : "off"); \
+        else \
+            RTPrintf("%-16s %s\n", a_szHuman ":", f ? "on" : "off"); \
+    } while (0)
+
+#define SHOW_GENERAL_ULONG(a_iAttr, a_szMachine, a_szHuman, a_szUnit) \
+    do \
+    { \
+        uint32_t u32 = Utf8Str(generalValues[a_iAttr]).toUInt32(); \
+        if (details == VMINFO_MACHINEREADABLE) \
+            RTPrintf(a_szMachine "=%u\n", u32); \
+        else \
+            RTPrintf("%-16s %u" a_szUnit "\n", a_szHuman ":", u32); \
+    } while (0)
+
+    bool fAccessible = Utf8Str(generalValues[kAccessible]) == "1";
     if (!fAccessible)
     {
-        Bstr uuid;
-        machine->COMGETTER(Id)(uuid.asOutParam());
+        Utf8Str uuid(generalValues[kId]);
         if (details == VMINFO_COMPACT)
-            RTPrintf("\"<inaccessible>\" {%s}\n", Utf8Str(uuid).c_str());
+            RTPrintf("\"<inaccessible>\" {%s}\n", uuid.c_str());
         else
         {
             if (details == VMINFO_MACHINEREADABLE)
@@ -466,14 +519,12 @@ HRESULT showVMInfo(ComPtr<IVirtualBox> virtualBox,
             else
                 RTPrintf("Name:            <inaccessible!>\n");
             if (details == VMINFO_MACHINEREADABLE)
-                RTPrintf("UUID=\"%s\"\n", Utf8Str(uuid).c_str());
+                RTPrintf("UUID=\"%s\"\n", uuid.c_str());
             else
-                RTPrintf("UUID:            %s\n", Utf8Str(uuid).c_str());
+                RTPrintf("UUID:            %s\n", uuid.c_str());
             if (details != VMINFO_MACHINEREADABLE)
             {
-                Bstr settingsFilePath;
-                rc = machine->COMGETTER(SettingsFilePath)(settingsFilePath.asOutParam());
-                RTPrintf("Config file:     %ls\n", settingsFilePath.raw());
+                RTPrintf("Config file:     %ls\n", generalValues[kSettingsFilePath]);
                 ComPtr<IVirtualBoxErrorInfo> accessError;
                 rc = machine->COMGETTER(AccessError)(accessError.asOutParam());
                 RTPrintf("Access error details:\n");
@@ -487,36 +538,28 @@ HRESULT showVMInfo(ComPtr<IVirtualBox> virtualBox,
 
     if (details == VMINFO_COMPACT)
     {
-        Bstr machineName;
-        machine->COMGETTER(Name)(machineName.asOutParam());
-        Bstr uuid;
-        machine->COMGETTER(Id)(uuid.asOutParam());
-
-        RTPrintf("\"%ls\" {%s}\n", machineName.raw(), Utf8Str(uuid).c_str());
+        RTPrintf("\"%ls\" {%s}\n", generalValues[kName], Utf8Str(generalValues[kId]).c_str());
         return S_OK;
     }
 
-    SHOW_STRING_PROP(      machine, Name,                       "name",                 "Name");
+    SHOW_GENERAL_STRING(kName,                                  "name",                 "Name");
 
-    Bstr osTypeId;
-    CHECK_ERROR2_RET(machine, COMGETTER(OSTypeId)(osTypeId.asOutParam()), hrcCheck);
     ComPtr<IGuestOSType> osType;
-    CHECK_ERROR2_RET(virtualBox, GetGuestOSType(osTypeId.raw(), osType.asOutParam()), hrcCheck);
-    SHOW_STRINGARRAY_PROP( machine, Groups,                     "groups",               "Groups");
+    CHECK_ERROR2_RET(virtualBox, GetGuestOSType(generalValues[kOSTypeId], osType.asOutParam()), hrcCheck);
+    SHOW_GENERAL_STRING(kGroups,                                "groups",               "Groups");
     SHOW_STRING_PROP(       osType, Description,                "ostype",               "Guest OS");
-    SHOW_UUID_PROP(        machine, Id,                         "UUID",                 "UUID");
-    SHOW_STRING_PROP(      machine, SettingsFilePath,           "CfgFile",              "Config file");
-    SHOW_STRING_PROP(      machine, SnapshotFolder,             "SnapFldr",             "Snapshot folder");
-    SHOW_STRING_PROP(      machine, LogFolder,                  "LogFldr",              "Log folder");
-    SHOW_UUID_PROP(        machine, HardwareUUID,               "hardwareuuid",         "Hardware UUID");
-    SHOW_ULONG_PROP(       machine, MemorySize,                 "memory",               "Memory size",      "MB");
-    SHOW_BOOLEAN_PROP(     machine, PageFusionEnabled,          "pagefusion",           "Page Fusion");
-    SHOW_ULONG_PROP(       machine, VRAMSize,                   "vram",                 "VRAM size",        "MB");
-    SHOW_ULONG_PROP(       machine, CPUExecutionCap,            "cpuexecutioncap",      "CPU exec cap",     "%%");
-    SHOW_BOOLEAN_PROP(     machine, HPETEnabled,                "hpet",                 "HPET");
-
-    ChipsetType_T chipsetType;
-    CHECK_ERROR2_RET(machine, COMGETTER(ChipsetType)(&chipsetType), hrcCheck);
+    SHOW_GENERAL_STRING(kId,                                    "UUID",                 "UUID");
+    SHOW_GENERAL_STRING(kSettingsFilePath,                      "CfgFile",              "Config file");
+    SHOW_GENERAL_STRING(kSnapshotFolder,                        "SnapFldr",             "Snapshot folder");
+    SHOW_GENERAL_STRING(kLogFolder,                             "LogFldr",              "Log folder");
+    SHOW_GENERAL_STRING(kHardwareUUID,                          "hardwareuuid",         "Hardware UUID");
+    SHOW_GENERAL_ULONG(kMemorySize,                             "memory",               "Memory size",      "MB");
+    SHOW_GENERAL_BOOLEAN(kPageFusionEnabled,                    "pagefusion",           "Page Fusion");
+    SHOW_GENERAL_ULONG(kVRAMSize,                               "vram",                 "VRAM size",        "MB");
+    SHOW_GENERAL_ULONG(kCPUExecutionCap,                        "cpuexecutioncap",      "CPU exec cap",     "%%");
+    SHOW_GENERAL_BOOLEAN(kHPETEnabled,                          "hpet",                 "HPET");
+
+    ChipsetType_T chipsetType = (ChipsetType_T)Utf8Str(generalValues[kChipsetType]).toInt32();
     const char *pszChipsetType;
     switch (chipsetType)
     {
@@ -530,8 +573,7 @@ HRESULT showVMInfo(ComPtr<IVirtualBox> virtualBox,
     else
         RTPrintf("Chipset:         %s\n", pszChipsetType);
 
-    FirmwareType_T firmwareType;
-    CHECK_ERROR2_RET(machine, COMGETTER(FirmwareType)(&firmwareType), hrcCheck);
+    FirmwareType_T firmwareType = (FirmwareType_T)Utf8Str(generalValues[kFirmwareType]).toInt32();
     const char *pszFirmwareType;
     switch (firmwareType)
     {
@@ -547,7 +589,7 @@ HRESULT showVMInfo(ComPtr<IVirtualBox> virtualBox,
     else
         RTPrintf("Firmware:        %s\n", pszFirmwareType);
 
-    SHOW_ULONG_PROP(       machine, CPUCount,                   "cpus",                 "Number of CPUs", "");
+    SHOW_GENERAL_ULONG(kCPUCount,                               "cpus",                 "Number of CPUs", "");
     SHOW_BOOLEAN_METHOD(   machine, GetCPUProperty(CPUPropertyType_Synthetic, &f), "synthcpu", "Synthetic Cpu");
 
     if (details != VMINFO_MACHINEREADABLE)
@@ -35,8 +35,13 @@
 #include <iprt/time.h>
 #include <iprt/getopt.h>
 #include <iprt/ctype.h>
+#include <iprt/cpp/list.h>
 
 #include "VBoxManage.h"
+
+#include <map>
+#include <vector>
+
 using namespace com;
 
 #ifdef VBOX_WITH_HOSTNETIF_API
@@ -209,31 +214,61 @@ static HRESULT listHostInfo(const ComPtr<IVirtualBox> pVirtualBox)
 /**
  * List media information.
  *
+ * This fetches the attributes of all media of the given type in one
+ * QueryMediaInfo call and the machine names in one QueryMachinesInfo call
+ * instead of querying everything medium by medium.
+ *
  * @returns See produceList.
  * @param   pVirtualBox         Reference to the IVirtualBox smart pointer.
+ * @param   enmDevType          The type of media to list.
  */
-static HRESULT listMedia(const ComPtr<IVirtualBox> pVirtualBox,
-                         const com::SafeIfaceArray<IMedium> &aMedia,
-                         const char *pszParentUUIDStr)
+static HRESULT listMedia(const ComPtr<IVirtualBox> pVirtualBox, DeviceType_T enmDevType)
 {
-    HRESULT rc = S_OK;
-    for (size_t i = 0; i < aMedia.size(); ++i)
+    enum { kId = 0, kParentId, kFormat, kLocation, kState, kType, kMachineIds, kSnapshotIds, kAttrs };
+    static const char * const s_apszAttrs[kAttrs] =
+        { "id", "parentId", "format", "location", "state", "type", "machineIds", "snapshotIds" };
+    com::SafeArray<BSTR> attributes(kAttrs);
+    for (size_t i = 0; i < kAttrs; ++i)
+        Bstr(s_apszAttrs[i]).detachTo(&attributes[i]);
+
+    HRESULT rc;
+    com::SafeIfaceArray<IMedium> media;
+    com::SafeArray<BSTR> values;
+    CHECK_ERROR_RET(pVirtualBox, QueryMediaInfo(enmDevType, ComSafeArrayAsInParam(attributes),
+                                                ComSafeArrayAsOutParam(media),
+                                                ComSafeArrayAsOutParam(values)), rc);
+
+    /* the names of the machines using the media, only when needed */
+    std::map<Utf8Str, size_t> mapMachines;
+    com::SafeIfaceArray<IMachine> machines;
+    com::SafeArray<BSTR> machineValues;
+    for (size_t i = 0; i < media.size(); ++i)
+        if (values[i * kAttrs + kMachineIds] && *values[i * kAttrs + kMachineIds])
+        {
+            com::SafeArray<BSTR> machineAttributes(2);
+            Bstr("id").detachTo(&machineAttributes[0]);
+            Bstr("name").detachTo(&machineAttributes[1]);
+            ULONG uGeneration;
+            CHECK_ERROR_RET(pVirtualBox, QueryMachinesInfo(ComSafeArrayAsInParam(machineAttributes), 0, 0, 0,
+                                                           ComSafeArrayAsOutParam(machines), &uGeneration,
+                                                           ComSafeArrayAsOutParam(machineValues)), rc);
+            for (size_t j = 0; j < machines.size(); ++j)
+                mapMachines[Utf8Str(machineValues[j * 2])] = j;
+            break;
+        }
+
+    for (size_t i = 0; i < media.size(); ++i)
     {
-        ComPtr<IMedium> pMedium = aMedia[i];
-        Bstr uuid;
-        pMedium->COMGETTER(Id)(uuid.asOutParam());
-        RTPrintf("UUID:        %s\n", Utf8Str(uuid).c_str());
-        if (pszParentUUIDStr)
-            RTPrintf("Parent UUID: %s\n", pszParentUUIDStr);
-        Bstr format;
-        pMedium->COMGETTER(Format)(format.asOutParam());
-        RTPrintf("Format:      %ls\n", format.raw());
-        Bstr filepath;
-        pMedium->COMGETTER(Location)(filepath.asOutParam());
-        RTPrintf("Location:    %ls\n", filepath.raw());
-
-        MediumState_T enmState;
-        pMedium->RefreshState(&enmState);
+        BSTR const *pValues = &values[i * kAttrs];
+        RTPrintf("UUID:        %ls\n", pValues[kId]);
+        if (pValues[kParentId] && *pValues[kParentId])
+            RTPrintf("Parent UUID: %ls\n", pValues[kParentId]);
+        else if (enmDevType == DeviceType_HardDisk)
+            RTPrintf("Parent UUID: base\n");
+        RTPrintf("Format:      %ls\n", pValues[kFormat]);
+        RTPrintf("Location:    %ls\n", pValues[kLocation]);
+
+        MediumState_T enmState = (MediumState_T)Utf8Str(pValues[kState]).toInt32();
         const char *stateStr = "unknown";
         switch (enmState)
         {
@@ -261,8 +296,7 @@ static HRESULT listMedia(const ComPtr<IVirtualBox> pVirtualBox,
         }
         RTPrintf("State:       %s\n", stateStr);
 
-        MediumType_T type;
-        pMedium->COMGETTER(Type)(&type);
+        MediumType_T type = (MediumType_T)Utf8Str(pValues[kType]).toInt32();
         const char *typeStr = "unknown";
         switch (type)
         {
@@ -287,43 +321,145 @@ static HRESULT listMedia(const ComPtr<IVirtualBox> pVirtualBox,
         }
         RTPrintf("Type:        %s\n", typeStr);
 
-        com::SafeArray<BSTR> machineIds;
-        pMedium->COMGETTER(MachineIds)(ComSafeArrayAsOutParam(machineIds));
+        RTCList<RTCString> machineIds = Utf8Str(pValues[kMachineIds]).split(",");
+        RTCList<RTCString> snapshotIdGroups = Utf8Str(pValues[kSnapshotIds]).split(";", RTCString::KeepEmptyParts);
         for (size_t j = 0; j < machineIds.size(); ++j)
         {
             ComPtr<IMachine> machine;
-            CHECK_ERROR(pVirtualBox, FindMachine(machineIds[j], machine.asOutParam()));
-            ASSERT(machine);
             Bstr name;
-            machine->COMGETTER(Name)(name.asOutParam());
-            RTPrintf("%s%ls (UUID: %ls)",
+            std::map<Utf8Str, size_t>::const_iterator it = mapMachines.find(machineIds[j]);
+            if (it != mapMachines.end())
+            {
+                machine = machines[it->second];
+                name = machineValues[it->second * 2 + 1];
+            }
+            RTPrintf("%s%ls (UUID: %s)",
                     j == 0 ? "Usage:       " : "             ",
-                    name.raw(), machineIds[j]);
-            com::SafeArray<BSTR> snapshotIds;
-            pMedium->GetSnapshotIds(machineIds[j],
-                                    ComSafeArrayAsOutParam(snapshotIds));
-            for (size_t k = 0; k < snapshotIds.size(); ++k)
+                    name.raw(), machineIds[j].c_str());
+            if (!machine.isNull() && j < snapshotIdGroups.size())
             {
-                ComPtr<ISnapshot> snapshot;
-                machine->FindSnapshot(snapshotIds[k], snapshot.asOutParam());
-                if (snapshot)
+                RTCList<RTCString> snapshotIds = snapshotIdGroups[j].split(",");
+                for (size_t k = 0; k < snapshotIds.size(); ++k)
                 {
-                    Bstr snapshotName;
-                    snapshot->COMGETTER(Name)(snapshotName.asOutParam());
-                    RTPrintf(" [%ls (UUID: %ls)]", snapshotName.raw(), snapshotIds[k]);
+                    ComPtr<ISnapshot> snapshot;
+                    machine->FindSnapshot(Bstr(snapshotIds[k]).raw(), snapshot.asOutParam());
+                    if (snapshot)
+                    {
+                        Bstr snapshotName;
+                        snapshot->COMGETTER(Name)(snapshotName.asOutParam());
+                        RTPrintf(" [%ls (UUID: %s)]", snapshotName.raw(), snapshotIds[k].c_str());
+                    }
                 }
             }
             RTPrintf("\n");
         }
         RTPrintf("\n");
+    }
+
+    return rc;
+}
+
+
+/** Number of machines fetched per QueryMachinesInfo call. */
+#define LIST_VMS_PAGE_SIZE      256
+/** How often to start over if the machine list keeps changing while paging. */
+#define LIST_VMS_MAX_RETRIES    8
+
+/**
+ * List the registered machines in the compact or machine readable format.
+ *
+ * This fetches everything in a few bulk calls instead of querying the
+ * attributes one by one, which matters a lot with many VMs over XPCOM.
+ *
+ * @returns See produceList.
+ * @param   pVirtualBox         Reference to the IVirtualBox smart pointer.
+ * @param   fRunningOnly        Whether to list only running VMs.
+ * @param   fMachineReadable    Machine readable (@c true) or compact output.
+ */
+static HRESULT listVMs(const ComPtr<IVirtualBox> &pVirtualBox, bool fRunningOnly, bool fMachineReadable)
+{
+    enum { kId = 0, kName, kAccessible, kState, kOSTypeId, kGroups, kSettingsFilePath, kAttrs };
+    static const char * const s_apszAttrs[kAttrs] =
+        { "id", "name", "accessible", "state", "OSTypeId", "groups", "settingsFilePath" };
+    com::SafeArray<BSTR> attributes(kAttrs);
+    for (size_t i = 0; i < kAttrs; ++i)
+        Bstr(s_apszAttrs[i]).detachTo(&attributes[i]);
+
+    /* fetch all pages before printing anything, starting over if machines
+     * get registered or unregistered meanwhile */
+    HRESULT rc = S_OK;
+    std::vector<Bstr> vecValues;
+    for (unsigned cTries = 0;; ++cTries)
+    {
+        vecValues.clear();
+        ULONG uGeneration = 0;
+        for (ULONG uFirst = 0;; uFirst += LIST_VMS_PAGE_SIZE)
+        {
+            com::SafeIfaceArray<IMachine> machines;
+            com::SafeArray<BSTR> values;
+            rc = pVirtualBox->QueryMachinesInfo(ComSafeArrayAsInParam(attributes), uFirst, LIST_VMS_PAGE_SIZE, uGeneration,
+                                                ComSafeArrayAsOutParam(machines), &uGeneration,
+                                                ComSafeArrayAsOutParam(values));
+            if (FAILED(rc))
+                break;
+            for (size_t i = 0; i < values.size(); ++i)
+                vecValues.push_back(values[i]);
+            if (machines.size() < LIST_VMS_PAGE_SIZE)
+                break;
+        }
+        if (rc != VBOX_E_INVALID_OBJECT_STATE || cTries >= LIST_VMS_MAX_RETRIES)
+            break;
+    }
+    if (FAILED(rc))
+    {
+        com::GlueHandleComError(pVirtualBox, "QueryMachinesInfo", rc, __FILE__, __LINE__);
+        return rc;
+    }
+
+    for (size_t i = 0; i < vecValues.size() / kAttrs; ++i)
+    {
+        Bstr const *pValues = &vecValues[i * kAttrs];
+        MachineState_T enmState = (MachineState_T)Utf8Str(pValues[kState]).toInt32();
+        if (fRunningOnly)
+        {
+            switch (enmState)
+            {
+                case MachineState_Running:
+                case MachineState_Teleporting:
+                case MachineState_LiveSnapshotting:
+                case MachineState_Paused:
+                case MachineState_TeleportingPausedVM:
+                    break;
+                default:
+                    continue;
+            }
+        }
+
+        bool fAccessible = Utf8Str(pValues[kAccessible]) == "1";
+        if (!fMachineReadable)
+        {
+            if (fAccessible)
+                RTPrintf("\"%ls\" {%ls}\n", pValues[kName].raw(), pValues[kId].raw());
+            else
+                RTPrintf("\"<inaccessible>\" {%ls}\n", pValues[kId].raw());
+            continue;
+        }
 
-        com::SafeIfaceArray<IMedium> children;
-        CHECK_ERROR(pMedium, COMGETTER(Children)(ComSafeArrayAsOutParam(children)));
-        if (children.size() > 0)
+        Bstr bstrValue = fAccessible ? pValues[kName] : Bstr("<inaccessible>");
+        outputMachineReadableString("name", &bstrValue);
+        bstrValue = pValues[kId];
+        outputMachineReadableString("UUID", &bstrValue);
+        if (fAccessible)
         {
-            // depth first listing of child media
-            rc = listMedia(pVirtualBox, children, Utf8Str(uuid).c_str());
+            bstrValue = pValues[kGroups];
+            outputMachineReadableString("groups", &bstrValue);
+            bstrValue = pValues[kOSTypeId];
+            outputMachineReadableString("ostype", &bstrValue);
+            RTPrintf("VMState=\"%s\"\n", machineStateToName(enmState, true /*fShort*/));
         }
+        bstrValue = pValues[kSettingsFilePath];
+        outputMachineReadableString("CfgFile", &bstrValue);
+        RTPrintf("\n");
     }
 
     return rc;
@@ -808,9 +944,11 @@ enum enmListType
  * @returns S_OK or some COM error code that has been reported in full.
  * @param   enmList             The list to produce.
  * @param   fOptLong            Long (@c true) or short list format.
+ * @param   fOptMachineReadable Machine readable format for the VM lists.
  * @param   pVirtualBox         Reference to the IVirtualBox smart pointer.
  */
-static HRESULT produceList(enum enmListType enmCommand, bool fOptLong, const ComPtr<IVirtualBox> &pVirtualBox)
+static HRESULT produceList(enum enmListType enmCommand, bool fOptLong, bool fOptMachineReadable,
+                           const ComPtr<IVirtualBox> &pVirtualBox)
 {
     HRESULT rc = S_OK;
     switch (enmCommand)
@@ -821,6 +959,12 @@ static HRESULT produceList(enum enmListType enmCommand, bool fOptLong, const Com
 
         case kListVMs:
         {
+            if (!fOptLong)
+            {
+                rc = listVMs(pVirtualBox, false /*fRunningOnly*/, fOptMachineReadable);
+                break;
+            }
+
             /*
              * Get the list of all registered VMs
              */
@@ -842,6 +986,12 @@ static HRESULT produceList(enum enmListType enmCommand, bool fOptLong, const Com
 
         case kListRunningVMs:
         {
+            if (!fOptLong)
+            {
+                rc = listVMs(pVirtualBox, true /*fRunningOnly*/, fOptMachineReadable);
+                break;
+            }
+
             /*
              * Get the list of all _running_ VMs
              */
@@ -999,28 +1149,16 @@ static HRESULT produceList(enum enmListType enmCommand, bool fOptLong, const Com
             break;
 
         case kListHdds:
-        {
-            com::SafeIfaceArray<IMedium> hdds;
-            CHECK_ERROR(pVirtualBox, COMGETTER(HardDisks)(ComSafeArrayAsOutParam(hdds)));
-            rc = listMedia(pVirtualBox, hdds, "base");
+            rc = listMedia(pVirtualBox, DeviceType_HardDisk);
             break;
-        }
 
         case kListDvds:
-        {
-            com::SafeIfaceArray<IMedium> dvds;
-            CHECK_ERROR(pVirtualBox, COMGETTER(DVDImages)(ComSafeArrayAsOutParam(dvds)));
-            rc = listMedia(pVirtualBox, dvds, NULL);
+            rc = listMedia(pVirtualBox, DeviceType_DVD);
             break;
-        }
 
         case kListFloppies:
-        {
-            com::SafeIfaceArray<IMedium> floppies;
-            CHECK_ERROR(pVirtualBox, COMGETTER(FloppyImages)(ComSafeArrayAsOutParam(floppies)));
-            rc = listMedia(pVirtualBox, floppies, NULL);
+            rc = listMedia(pVirtualBox, DeviceType_Floppy);
             break;
-        }
 
         case kListUsbHost:
             rc = listUsbHost(pVirtualBox);
@@ -1088,12 +1226,14 @@ static HRESULT produceList(enum enmListType enmCommand, bool fOptLong, const Com
 int handleList(HandlerArg *a)
 {
     bool                fOptLong      = false;
+    bool                fOptMachineReadable = false;
     bool                fOptMultiple  = false;
     enum enmListType    enmOptCommand = kListNotSpecified;
 
     static const RTGETOPTDEF s_aListOptions[] =
     {
         { "--long",             'l',                     RTGETOPT_REQ_NOTHING },
+        { "--machinereadable",  'M',                     RTGETOPT_REQ_NOTHING },
         { "--multiple",         'm',                     RTGETOPT_REQ_NOTHING }, /* not offical yet */
         { "vms",                kListVMs,                RTGETOPT_REQ_NOTHING },
         { "runningvms",         kListRunningVMs,         RTGETOPT_REQ_NOTHING },
@@ -1132,6 +1272,10 @@ int handleList(HandlerArg *a)
                 fOptLong = true;
                 break;
 
+            case 'M':  /* --machinereadable */
+                fOptMachineReadable = true;
+                break;
+
             case 'm':
                 fOptMultiple = true;
                 if (enmOptCommand == kListNotSpecified)
@@ -1163,7 +1307,7 @@ int handleList(HandlerArg *a)
                 enmOptCommand = (enum enmListType)ch;
                 if (fOptMultiple)
                 {
-                    HRESULT hrc = produceList((enum enmListType)ch, fOptLong, a->virtualBox);
+                    HRESULT hrc = produceList((enum enmListType)ch, fOptLong, fOptMachineReadable, a->virtualBox);
                     if (FAILED(hrc))
                         return 1;
                 }
@@ -1184,7 +1328,7 @@ int handleList(HandlerArg *a)
         return errorSyntax(USAGE_LIST, "Missing subcommand for \"list\" command.\n");
     if (!fOptMultiple)
     {
-        HRESULT hrc = produceList(enmOptCommand, fOptLong, a->virtualBox);
+        HRESULT hrc = produceList(enmOptCommand, fOptLong, fOptMachineReadable, a->virtualBox);
         if (FAILED(hrc))
             return 1;
     }
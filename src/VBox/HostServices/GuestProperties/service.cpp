@@ -56,6 +56,8 @@
 #include <memory>  /* for auto_ptr */
 #include <string>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace guestProp {
 
@@ -127,6 +129,8 @@ struct Property
 };
 /** The properties list type */
 typedef std::list <Property> PropertyList;
+/** The type of the name ordered index of the properties. */
+typedef std::map<std::string, Property *> PropertyIndex;
 
 /**
  * Structure for holding an uncompleted guest call
@@ -156,6 +160,8 @@ struct GuestCall
 /** The guest call list type */
 typedef std::list <GuestCall> CallList;
 
+struct ENUMDATA;
+
 /**
  * Class containing the shared information service functionality.
  */
@@ -170,6 +176,8 @@ private:
     ePropFlags meGlobalFlags;
     /** The property string space handle. */
     RTSTRSPACE mhProperties;
+    /** The properties ordered by name, for prefix pattern enumerations. */
+    PropertyIndex mPropertyIndex;
     /** The number of properties. */
     unsigned mcProperties;
     /** The list of property changes for guest notifications;
@@ -275,6 +283,55 @@ private:
         return (Property *)RTStrSpaceGet(&mhProperties, pszName);
     }
 
+    /**
+     * Adds a new property to the string space and the name index.
+     *
+     * @returns IPRT status code.
+     * @param   pProp       The property. Deleted on failure.
+     */
+    int insertPropertyInternal(Property *pProp)
+    {
+        /* Don't touch the index entry of an existing property of that name. */
+        bool fInserted;
+        try
+        {
+            fInserted = mPropertyIndex.insert(std::make_pair(pProp->mName, pProp)).second;
+        }
+        catch (std::bad_alloc)
+        {
+            delete pProp;
+            return VERR_NO_MEMORY;
+        }
+        if (!fInserted)
+        {
+            delete pProp;
+            AssertFailedReturn(VERR_ALREADY_EXISTS);
+        }
+        if (!RTStrSpaceInsert(&mhProperties, &pProp->mStrCore))
+        {
+            mPropertyIndex.erase(pProp->mName);
+            delete pProp;
+            AssertFailedReturn(VERR_ALREADY_EXISTS);
+        }
+        mcProperties++;
+        return VINF_SUCCESS;
+    }
+
+    /**
+     * Removes a property from the string space and the name index and
+     * deletes it.
+     *
+     * @param   pProp       The property.
+     */
+    void removePropertyInternal(Property *pProp)
+    {
+        PRTSTRSPACECORE pStrCore = RTStrSpaceRemove(&mhProperties, pProp->mStrCore.pszString);
+        AssertPtr(pStrCore); NOREF(pStrCore);
+        mPropertyIndex.erase(pProp->mName);
+        mcProperties--;
+        delete pProp;
+    }
+
 public:
     explicit Service(PVBOXHGCMSVCHELPERS pHelpers)
         : mpHelpers(pHelpers)
@@ -372,8 +429,10 @@ private:
     int setPropertyBlock(uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
     int getProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
     int setProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGuest);
+    int setProperties(uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
     int delProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGuest);
     int enumProps(uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
+    int enumPropsMatching(const char *pszPatterns, ENUMDATA *pEnum);
     int getNotification(uint32_t u32ClientId, VBOXHGCMCALLHANDLE callHandle, uint32_t cParms,
                         VBOXHGCMSVCPARM paParms[]);
     int getOldNotificationInternal(const char *pszPattern,
@@ -535,14 +594,9 @@ int Service::setPropertyBlock(uint32_t cParms, VBOXHGCMSVCPARM paParms[])
                     rc = VERR_NO_MEMORY;
                     break;
                 }
-                if (RTStrSpaceInsert(&mhProperties, &pProp->mStrCore))
-                    mcProperties++;
-                else
-                {
-                    delete pProp;
-                    rc = VERR_INTERNAL_ERROR_3;
-                    AssertFailedBreak();
-                }
+                rc = insertPropertyInternal(pProp);
+                if (RT_FAILURE(rc))
+                    break;
             }
         }
     }
@@ -710,15 +764,7 @@ int Service::setProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGues
                 pProp = new Property(pcszName, pcszValue, u64TimeNano, fFlags);
                 AssertPtr(pProp);
 
-                if (RTStrSpaceInsert(&mhProperties, &pProp->mStrCore))
-                    mcProperties++;
-                else
-                {
-                    AssertFailed();
-                    delete pProp;
-
-                    rc = VERR_ALREADY_EXISTS;
-                }
+                rc = insertPropertyInternal(pProp);
             }
             catch (std::bad_alloc)
             {
@@ -743,6 +789,174 @@ int Service::setProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGues
 }
 
 
+/**
+ * Get the next name, value and flags triple from a SET_PROPS string array.
+ *
+ * @returns iprt status value
+ * @returns VERR_NOT_FOUND at the empty string terminating the array
+ * @param   pchBuf  the string array, the last byte must be a '\0'
+ * @param   cbBuf   the size of the string array
+ * @param   poff    the offset of the triple, advanced past it on success
+ * @param   papsz   where to return the name, value and flags
+ * @param   pacb    where to return their sizes including the terminators
+ * @thread  HGCM
+ */
+static int getPropertyTriple(const char *pchBuf, uint32_t cbBuf, uint32_t *poff,
+                             const char *papsz[3], uint32_t pacb[3])
+{
+    uint32_t off = *poff;
+    if (off >= cbBuf)
+        return VERR_INVALID_PARAMETER;  /* not terminated */
+    if (pchBuf[off] == '\0')
+        return VERR_NOT_FOUND;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        if (off >= cbBuf)
+            return VERR_INVALID_PARAMETER;  /* incomplete triple */
+        papsz[i] = &pchBuf[off];
+        pacb[i]  = (uint32_t)RTStrNLen(papsz[i], cbBuf - off) + 1;
+        off     += pacb[i];
+    }
+    *poff = off;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Set several values in the property registry on behalf of the guest,
+ * checking the validity of the arguments passed.
+ *
+ * All the properties are validated and checked for permission before any of
+ * them is changed.  Properties whose value and flags stay the same are left
+ * alone and do not cause notifications.  The notifications for the others are
+ * only sent once all of them are set, so a guest waiter is released once with
+ * the first change it is interested in and picks up the rest from the queue of
+ * old notifications, and nobody sees a half applied set.
+ *
+ * @returns iprt status value
+ * @param   cParms  the number of HGCM parameters supplied
+ * @param   paParms the array of HGCM parameters
+ * @throws  std::bad_alloc  if an out of memory condition occurs
+ * @thread  HGCM
+ */
+int Service::setProperties(uint32_t cParms, VBOXHGCMSVCPARM paParms[])
+{
+    int rc = VINF_SUCCESS;
+    const char *pchBuf = NULL;          /* shut up gcc */
+    uint32_t cbBuf = 0;
+
+    LogFlowThisFunc(("\n"));
+
+    /*
+     * General parameter correctness checking.
+     */
+    if (   cParms != 1  /* Hardcoded value as the next lines depend on it. */
+        || RT_FAILURE(paParms[0].getBuffer((void **)&pchBuf, &cbBuf))  /* strings */
+        || cbBuf == 0
+        || pchBuf[cbBuf - 1] != '\0')
+        rc = VERR_INVALID_PARAMETER;
+
+    /*
+     * Check all the triples for correctness and permissions.
+     */
+    const char *apsz[3];
+    uint32_t acb[3];
+    uint32_t off = 0;
+    unsigned cTriples = 0;
+    unsigned cNew = 0;
+    while (rc == VINF_SUCCESS)
+    {
+        rc = getPropertyTriple(pchBuf, cbBuf, &off, apsz, acb);
+        if (rc == VERR_NOT_FOUND)
+        {
+            rc = VINF_SUCCESS;
+            break;
+        }
+        for (unsigned i = 0; i < 3 && RT_SUCCESS(rc); ++i)
+            rc = RTStrValidateEncodingEx(apsz[i], acb[i],
+                                         RTSTR_VALIDATE_ENCODING_ZERO_TERMINATED);
+        if (RT_SUCCESS(rc))
+            rc = validateName(apsz[0], acb[0]);
+        if (RT_SUCCESS(rc))
+            rc = validateValue(apsz[1], acb[1]);
+        uint32_t fFlags;
+        if (RT_SUCCESS(rc))
+            rc = validateFlags(apsz[2], &fFlags);
+        if (RT_SUCCESS(rc))
+        {
+            Property *pProp = getPropertyInternal(apsz[0]);
+            rc = checkPermission(pProp ? (ePropFlags)pProp->mFlags : NILFLAG, true /* isGuest */);
+            if (!pProp)
+                ++cNew;
+        }
+        ++cTriples;
+    }
+    if (   rc == VINF_SUCCESS
+        && (   cTriples > MAX_PROPS
+            || mcProperties + cNew > MAX_PROPS))
+        rc = VERR_TOO_MUCH_DATA;
+    if (rc != VINF_SUCCESS)
+    {
+        LogFlowThisFunc(("rc = %Rrc\n", rc));
+        return rc;
+    }
+
+    /*
+     * Set the actual values.  No way to roll back if we run out of memory
+     * half way through, the notifications are still sent for what was set.
+     */
+    std::vector<std::pair<const char *, uint64_t> > vecChanges;
+    vecChanges.reserve(cTriples);
+    off = 0;
+    while (getPropertyTriple(pchBuf, cbBuf, &off, apsz, acb) == VINF_SUCCESS)
+    {
+        uint32_t fFlags = NILFLAG;
+        validateFlags(apsz[2], &fFlags);
+        Property *pProp = getPropertyInternal(apsz[0]);
+        if (   pProp
+            && pProp->mFlags == fFlags
+            && pProp->mValue == apsz[1])
+            continue;
+
+        uint64_t u64TimeNano = getCurrentTimestamp();
+        if (pProp)
+        {
+            pProp->mValue = apsz[1];
+            pProp->mTimestamp = u64TimeNano;
+            pProp->mFlags = fFlags;
+        }
+        else
+        {
+            try
+            {
+                pProp = new Property(apsz[0], apsz[1], u64TimeNano, fFlags);
+                rc = insertPropertyInternal(pProp);
+            }
+            catch (std::bad_alloc)
+            {
+                rc = VERR_NO_MEMORY;
+            }
+            if (RT_FAILURE(rc))
+                break;
+        }
+        vecChanges.push_back(std::make_pair(apsz[0], u64TimeNano));
+    }
+
+    /*
+     * Send the notifications to the guest and host and return.
+     */
+    for (size_t i = 0; i < vecChanges.size(); ++i)
+    {
+        int rc2 = doNotifications(vecChanges[i].first, vecChanges[i].second);
+        if (RT_SUCCESS(rc))
+            rc = rc2;
+    }
+
+    LogFlowThisFunc(("%u properties, %u changed, rc=%Rrc\n", cTriples, (unsigned)vecChanges.size(), rc));
+    return rc;
+}
+
+
 /**
  * Remove a value in the property registry by name, checking the validity
  * of the arguments passed.
@@ -790,10 +1004,7 @@ int Service::delProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGues
     if (rc == VINF_SUCCESS && pProp)
     {
         uint64_t u64Timestamp = getCurrentTimestamp();
-        PRTSTRSPACECORE pStrCore = RTStrSpaceRemove(&mhProperties, pProp->mStrCore.pszString);
-        AssertPtr(pStrCore); NOREF(pStrCore);
-        mcProperties--;
-        delete pProp;
+        removePropertyInternal(pProp);
         // if (isGuest)  /* Notify the host even for properties that the host
         //                * changed.  Less efficient, but ensures consistency. */
         int rc2 = doNotifications(pcszName, u64Timestamp);
@@ -808,13 +1019,13 @@ int Service::delProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGues
 /**
  * Enumeration data shared between enumPropsCallback and Service::enumProps.
  */
-typedef struct ENUMDATA
+struct ENUMDATA
 {
     const char *pszPattern; /**< The pattern to match properties against. */
     char       *pchCur;     /**< The current buffer postion. */
     size_t      cbLeft;     /**< The amount of available buffer space. */
     size_t      cbNeeded;   /**< The amount of needed buffer space. */
-} ENUMDATA;
+};
 
 /**
  * @callback_method_impl{FNRTSTRSPACECALLBACK}
@@ -925,7 +1136,7 @@ int Service::enumProps(uint32_t cParms, VBOXHGCMSVCPARM paParms[])
         EnumData.pchCur     = pchBuf;
         EnumData.cbLeft     = cbBuf;
         EnumData.cbNeeded   = 0;
-        rc = RTStrSpaceEnumerate(&mhProperties, enumPropsCallback, &EnumData);
+        rc = enumPropsMatching(szPatterns, &EnumData);
         AssertRCSuccess(rc);
         if (RT_SUCCESS(rc))
         {
@@ -947,6 +1158,83 @@ int Service::enumProps(uint32_t cParms, VBOXHGCMSVCPARM paParms[])
 }
 
 
+/**
+ * Enumerates the properties matching a set of patterns into a buffer.
+ *
+ * Patterns which are plain names or of the form "prefix*" are resolved using
+ * the string space and the name index, so monitoring clients enumerating e.g.
+ * "/VirtualBox/GuestInfo/Net/*" don't cause a match against every property.
+ * Any other pattern makes us fall back on walking all properties.
+ *
+ * @returns iprt status value
+ * @param   pszPatterns the patterns, separated by '|'
+ * @param   pEnum       the enumeration data
+ * @thread  HGCM
+ */
+int Service::enumPropsMatching(const char *pszPatterns, ENUMDATA *pEnum)
+{
+    std::vector<std::string> vecPatterns;
+    bool fIndexed = *pszPatterns != '\0';  /* empty means match all */
+    try
+    {
+        for (const char *psz = pszPatterns; fIndexed; )
+        {
+            const char *pszEnd = strchr(psz, '|');
+            std::string strPattern(psz, pszEnd ? (size_t)(pszEnd - psz) : strlen(psz));
+            size_t offWild = strPattern.find_first_of("*?");
+            if (   offWild != std::string::npos
+                && offWild != strPattern.length() - 1)
+                fIndexed = false;
+            else if (   offWild != std::string::npos
+                     && strPattern[offWild] != '*')
+                fIndexed = false;
+            vecPatterns.push_back(strPattern);
+            if (!pszEnd)
+                break;
+            psz = pszEnd + 1;
+        }
+    }
+    catch (std::bad_alloc)
+    {
+        return VERR_NO_MEMORY;
+    }
+    if (!fIndexed)
+        return RTStrSpaceEnumerate(&mhProperties, enumPropsCallback, pEnum);
+
+    for (size_t i = 0; i < vecPatterns.size(); ++i)
+    {
+        const std::string &strPattern = vecPatterns[i];
+        PropertyIndex::const_iterator it;
+        PropertyIndex::const_iterator itEnd;
+        if (!strPattern.empty() && strPattern[strPattern.length() - 1] == '*')
+        {
+            std::string strPrefix(strPattern, 0, strPattern.length() - 1);
+            it = mPropertyIndex.lower_bound(strPrefix);
+            itEnd = mPropertyIndex.end();
+            for (; it != itEnd && it->first.compare(0, strPrefix.length(), strPrefix) == 0; ++it)
+            {
+                /* Skip properties already reported for one of the previous patterns. */
+                bool fDone = false;
+                for (size_t j = 0; j < i && !fDone; ++j)
+                    fDone = RTStrSimplePatternMatch(vecPatterns[j].c_str(), it->first.c_str());
+                if (!fDone)
+                    enumPropsCallback(&it->second->mStrCore, pEnum);
+            }
+        }
+        else
+        {
+            Property *pProp = getPropertyInternal(strPattern.c_str());
+            bool fDone = pProp == NULL;
+            for (size_t j = 0; j < i && !fDone; ++j)
+                fDone = RTStrSimplePatternMatch(vecPatterns[j].c_str(), pProp->mName.c_str());
+            if (!fDone)
+                enumPropsCallback(&pProp->mStrCore, pEnum);
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
 /** Helper query used by getOldNotification */
 int Service::getOldNotificationInternal(const char *pszPatterns,
                                         uint64_t u64Timestamp,
@@ -1290,6 +1578,12 @@ void Service::call (VBOXHGCMCALLHANDLE callHandle, uint32_t u32ClientID,
                 rc = getNotification(u32ClientID, callHandle, cParms, paParms);
                 break;
 
+            /* The guest wishes to set several properties */
+            case SET_PROPS:
+                LogFlowFunc(("SET_PROPS\n"));
+                rc = setProperties(cParms, paParms);
+                break;
+
             default:
                 rc = VERR_NOT_IMPLEMENTED;
         }
@@ -312,6 +312,20 @@ static const struct enumStringStruct
         g_apchEnumResult1,
         g_acbEnumResult1,
         g_cbEnumBuffer1
+    },
+    /* Prefix and plain name patterns, looked up in the index. */
+    {
+        "/t*\0TEST NAME", sizeof("/t*\0TEST NAME"),
+        g_apchEnumResult1,
+        g_acbEnumResult1,
+        g_cbEnumBuffer1
+    },
+    /* Overlapping patterns must not report properties twice. */
+    {
+        "/test/*\0/test/name\0TEST*", sizeof("/test/*\0/test/name\0TEST*"),
+        g_apchEnumResult1,
+        g_acbEnumResult1,
+        g_cbEnumBuffer1
     }
 };
 
@@ -1132,6 +1146,90 @@ static void test6(void)
 }
 
 
+/**
+ * Set several properties by calling the guest SET_PROPS function.
+ * @returns the status returned by the call to the service
+ *
+ * @param   pTable  the service instance handle
+ * @param   pchBuf  the name, value and flags triples
+ * @param   cbBuf   the size of @a pchBuf
+ */
+static int doSetProperties(VBOXHGCMSVCFNTABLE *pTable, const char *pchBuf, uint32_t cbBuf)
+{
+    VBOXHGCMCALLHANDLE_TYPEDEF callHandle = { VINF_SUCCESS };
+    char abBuf[256];
+    AssertReturn(cbBuf <= sizeof(abBuf), VERR_BUFFER_OVERFLOW);
+    memcpy(abBuf, pchBuf, cbBuf);
+    VBOXHGCMSVCPARM aParms[1];
+    aParms[0].setPointer(abBuf, cbBuf);
+    pTable->pfnCall(pTable->pvService, &callHandle, 0, NULL, SET_PROPS, 1, aParms);
+    return callHandle.rc;
+}
+
+/**
+ * Check the value and flags of a property using GET_PROP_HOST.
+ */
+static void checkProperty(VBOXHGCMSVCFNTABLE *pTable, const char *pcszName,
+                          const char *pchValue, uint32_t cchValue)
+{
+    VBOXHGCMSVCPARM aParms[4];
+    char szName[MAX_NAME_LEN];
+    char szBuffer[MAX_VALUE_LEN + MAX_FLAGS_LEN];
+    RTStrPrintf(szName, sizeof(szName), "%s", pcszName);
+    aParms[0].setString(szName);
+    aParms[1].setPointer(szBuffer, sizeof(szBuffer));
+    int rc = pTable->pfnHostCall(pTable->pvService, GET_PROP_HOST, 4, aParms);
+    uint32_t cbValue = 0;
+    if (   RT_FAILURE(rc)
+        || RT_FAILURE(aParms[3].getUInt32(&cbValue))
+        || cbValue != cchValue
+        || memcmp(szBuffer, pchValue, cchValue) != 0)
+        RTTestIFailed("Property '%s' does not have the expected value and flags (rc=%Rrc).", pcszName, rc);
+}
+
+static void test7(void)
+{
+    RTTestISub("SET_PROPS");
+
+    VBOXHGCMSVCFNTABLE  svcTable;
+    VBOXHGCMSVCHELPERS  svcHelpers;
+    initTable(&svcTable, &svcHelpers);
+    RTTESTI_CHECK_RC_OK_RETV(VBoxHGCMSvcLoad(&svcTable));
+    RTTESTI_CHECK_RC_OK(doSetProperty(&svcTable, "Green", "Go!", "readonly", true, true));
+
+    /* Set several properties. */
+    static const char s_achSet[] = "Red\0Stop!\0transient\0Amber\0Caution!\0\0";
+    RTTESTI_CHECK_RC(doSetProperties(&svcTable, s_achSet, sizeof(s_achSet)), VINF_SUCCESS);
+    checkProperty(&svcTable, "Red", "Stop!\0TRANSIENT", sizeof("Stop!\0TRANSIENT"));
+    checkProperty(&svcTable, "Amber", "Caution!\0", sizeof("Caution!\0"));
+
+    /* Nothing is changed if one of the properties may not be set... */
+    static const char s_achDenied[] = "Red\0Go!\0\0Green\0Stop!\0\0";
+    RTTESTI_CHECK_RC(doSetProperties(&svcTable, s_achDenied, sizeof(s_achDenied)), VERR_PERMISSION_DENIED);
+    checkProperty(&svcTable, "Red", "Stop!\0TRANSIENT", sizeof("Stop!\0TRANSIENT"));
+
+    /* ... or if the array is malformed. */
+    static const char s_achIncomplete[] = "Red\0Go!";
+    RTTESTI_CHECK_RC(doSetProperties(&svcTable, s_achIncomplete, sizeof(s_achIncomplete)), VERR_INVALID_PARAMETER);
+    static const char s_achUnterminated[] = "Red\0Go!\0";
+    RTTESTI_CHECK_RC(doSetProperties(&svcTable, s_achUnterminated, sizeof(s_achUnterminated)), VERR_INVALID_PARAMETER);
+    RTTESTI_CHECK_RC(doSetProperties(&svcTable, s_achSet, sizeof(s_achSet) - 1), VERR_INVALID_PARAMETER);
+    checkProperty(&svcTable, "Red", "Stop!\0TRANSIENT", sizeof("Stop!\0TRANSIENT"));
+
+    /* Unchanged properties must not cause notifications. */
+    setupAsyncNotification(&svcTable);
+    static const char s_achUpdate[] = "Red\0Stop!\0TRANSIENT\0Amber\0Go!\0\0";
+    RTTESTI_CHECK_RC(doSetProperties(&svcTable, s_achUpdate, sizeof(s_achUpdate)), VINF_SUCCESS);
+    uint32_t cbNotification = 0;
+    if (   g_AsyncNotification.callHandle.rc != VINF_SUCCESS
+        || RT_FAILURE(g_AsyncNotification.aParms[3].getUInt32(&cbNotification))
+        || cbNotification != sizeof("Amber\0Go!\0")
+        || memcmp(g_AsyncNotification.abBuffer, "Amber\0Go!\0", cbNotification) != 0)
+        RTTestIFailed("SET_PROPS did not notify the waiter of the changed property only, rc=%Rrc.",
+                      g_AsyncNotification.callHandle.rc);
+
+    RTTESTI_CHECK_RC_OK(svcTable.pfnUnload(svcTable.pvService));
+}
 
 
 int main(int argc, char **argv)
@@ -1147,6 +1245,7 @@ int main(int argc, char **argv)
     test4();
     test5();
     test6();
+    test7();
 
     return RTTestSummaryAndDestroy(g_hTest);
 }
@@ -37,6 +37,7 @@ typedef struct _VBOXCLIPBOARDCLIENTDATA
 
     bool fAsync;        /* Guest is waiting for a message. */
     bool fReadPending;  /* The guest is waiting for data from the host */
+    bool fReadChunk;    /* The pending read is the start of a chunked transfer */
 
     bool fMsgQuit;
     bool fMsgReadData;
@@ -58,6 +59,14 @@ typedef struct _VBOXCLIPBOARDCLIENTDATA
          uint32_t u32Format;
     } data;
 
+    /* Host data of a chunked transfer to the guest. */
+    struct {
+         void *pv;
+         uint32_t cb;
+         uint32_t u32Format;
+         bool fBusy;    /* The backend is still writing to pv */
+    } chunk;
+
     uint32_t u32AvailableFormats;
     uint32_t u32RequestedFormat;
 
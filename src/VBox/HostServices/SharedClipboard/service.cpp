@@ -59,10 +59,20 @@
  * second call is made before the first has returned, the first will be
  * aborted.
  *
- * The last guest message is VBOX_SHARED_CLIPBOARD_FN_WRITE_DATA, which is
+ * The next guest message is VBOX_SHARED_CLIPBOARD_FN_WRITE_DATA, which is
  * used to send the contents of the guest clipboard to the host.  This call
  * should be used after the host has requested data from the guest.
  *
+ * The last guest message is VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK, which
+ * reads the host clipboard data a chunk at a time, the guest choosing the
+ * chunk size with its buffer.  A call with offset 0 starts a transfer.  Data
+ * which fits is returned directly, otherwise the host fetches all of it into
+ * a buffer of its own and returns the first chunk.  The guest then asks for
+ * the following chunks by offset, and the host frees its buffer after the
+ * last one, when a new transfer is started, or when the guest passes
+ * VBOX_SHARED_CLIPBOARD_CHUNK_CANCEL as the offset.  The pending read rules
+ * of VBOX_SHARED_CLIPBOARD_FN_READ_DATA apply to the call with offset 0.
+ *
  * @section sec_hostclip_backend_proto  The communication protocol with the
  *                                      platform-specific backend
  *
@@ -321,6 +331,16 @@ static DECLCALLBACK(int) svcUnload (void *)
     return VINF_SUCCESS;
 }
 
+/**
+ * Free the host buffer of a chunked transfer.
+ */
+static void vboxSvcClipboardChunkFree (VBOXCLIPBOARDCLIENTDATA *pClient)
+{
+    RTMemFree (pClient->chunk.pv);
+    pClient->chunk.pv = NULL;
+    pClient->chunk.cb = 0;
+}
+
 /**
  * Disconnect the host side of the shared clipboard and send a "host disconnected" message
  * to the guest side.
@@ -333,6 +353,8 @@ static DECLCALLBACK(int) svcDisconnect (void *, uint32_t u32ClientID, void *pvCl
 
     vboxClipboardDisconnect (pClient);
 
+    vboxSvcClipboardChunkFree (pClient);
+
     memset (pClient, 0, sizeof (*pClient));
 
     g_pClient = NULL;
@@ -373,6 +395,273 @@ static DECLCALLBACK(int) svcConnect (void *, uint32_t u32ClientID, void *pvClien
     return rc;
 }
 
+/**
+ * Read the host clipboard data, through the service extension if there is
+ * one, otherwise from the platform backend.
+ *
+ * @returns VINF_HGCM_ASYNC_EXECUTE if the backend completes the read later
+ *          with vboxSvcClipboardCompleteReadData
+ * @param  pClient    the client
+ * @param  u32Format  the format requested
+ * @param  pv         where to write the data
+ * @param  cb         the size of the buffer pv points to
+ * @param  pcbActual  where to store the size of the data, which may be
+ *                    larger than cb
+ */
+static int vboxSvcClipboardReadBackend (VBOXCLIPBOARDCLIENTDATA *pClient, uint32_t u32Format,
+                                        void *pv, uint32_t cb, uint32_t *pcbActual)
+{
+    int rc;
+
+    if (g_pfnExtension)
+    {
+        VBOXCLIPBOARDEXTPARMS parms;
+
+        parms.u32Format = u32Format;
+        parms.u.pvData = pv;
+        parms.cbData = cb;
+
+        g_fReadingData = true;
+        rc = g_pfnExtension (g_pvExtension, VBOX_CLIPBOARD_EXT_FN_DATA_READ, &parms, sizeof (parms));
+        LogRelFlow(("DATA: g_fDelayedAnnouncement = %d, g_u32DelayedFormats = 0x%x\n", g_fDelayedAnnouncement, g_u32DelayedFormats));
+        if (g_fDelayedAnnouncement)
+        {
+            vboxSvcClipboardReportMsg (g_pClient, VBOX_SHARED_CLIPBOARD_HOST_MSG_FORMATS, g_u32DelayedFormats);
+            g_fDelayedAnnouncement = false;
+            g_u32DelayedFormats = 0;
+        }
+        g_fReadingData = false;
+
+        if (RT_SUCCESS (rc))
+        {
+            *pcbActual = parms.cbData;
+        }
+    }
+    else
+    {
+        rc = vboxClipboardReadData (pClient, u32Format, pv, cb, pcbActual);
+    }
+
+    return rc;
+}
+
+/**
+ * Read the data for the first chunk of a transfer, registering the guest
+ * call as the pending read in case the backend completes it later.
+ *
+ * @returns see vboxSvcClipboardReadBackend
+ */
+static int vboxSvcClipboardReadChunkBackend (VBOXCLIPBOARDCLIENTDATA *pClient,
+                                             VBOXHGCMCALLHANDLE callHandle,
+                                             VBOXHGCMSVCPARM *paParms,
+                                             void *pv, uint32_t cb,
+                                             uint32_t *pcbActual)
+{
+    if (!vboxSvcClipboardLock ())
+        return VERR_NOT_SUPPORTED;
+    pClient->asyncRead.callHandle = callHandle;
+    pClient->asyncRead.paParms    = paParms;
+    pClient->fReadPending         = true;
+    pClient->fReadChunk           = true;
+    vboxSvcClipboardUnlock ();
+
+    int rc = vboxSvcClipboardReadBackend (pClient, pClient->chunk.u32Format, pv, cb, pcbActual);
+
+    if (rc != VINF_HGCM_ASYNC_EXECUTE && vboxSvcClipboardLock ())
+    {
+        pClient->fReadPending = false;
+        pClient->fReadChunk   = false;
+        vboxSvcClipboardUnlock ();
+    }
+    return rc;
+}
+
+/**
+ * Finish the first chunk of a transfer once the backend has returned the
+ * data or the size it needs.  The first read goes straight to the guest's
+ * buffer.  If the data did not fit, all of it is read into the host buffer
+ * and the guest gets the first chunk from there.
+ *
+ * @returns VINF_HGCM_ASYNC_EXECUTE if the backend completes a read later,
+ *          the status for the guest otherwise
+ * @param  rc        the status of the last read
+ * @param  cbActual  the size of the data the last read returned
+ */
+static int vboxSvcClipboardReadChunkDone (VBOXCLIPBOARDCLIENTDATA *pClient,
+                                          VBOXHGCMCALLHANDLE callHandle,
+                                          VBOXHGCMSVCPARM *paParms,
+                                          int rc, uint32_t cbActual)
+{
+    void *pv = NULL;
+    uint32_t cb = 0;
+
+    if (RT_SUCCESS (rc))
+        rc = VBoxHGCMParmPtrGet (&paParms[2], &pv, &cb);
+
+    for (unsigned cTries = 0; RT_SUCCESS (rc) && rc != VINF_HGCM_ASYNC_EXECUTE; cTries++)
+    {
+        if (!pClient->chunk.pv ? cbActual <= cb : cbActual <= pClient->chunk.cb)
+        {
+            if (pClient->chunk.pv)
+            {
+                pClient->chunk.cb = cbActual;
+                memcpy (pv, pClient->chunk.pv, RT_MIN (cb, cbActual));
+                if (cbActual <= cb)
+                    vboxSvcClipboardChunkFree (pClient);
+            }
+            VBoxHGCMParmUInt32Set (&paParms[3], cbActual);
+            break;
+        }
+
+        /* The data grew in the meantime.  Don't chase it forever. */
+        if (cTries >= 3)
+        {
+            rc = VERR_TRY_AGAIN;
+            break;
+        }
+
+        void *pvNew = RTMemRealloc (pClient->chunk.pv, cbActual);
+        if (!pvNew)
+        {
+            rc = VERR_NO_MEMORY;
+            break;
+        }
+        pClient->chunk.pv = pvNew;
+        pClient->chunk.cb = cbActual;
+        rc = vboxSvcClipboardReadChunkBackend (pClient, callHandle, paParms, pvNew, cbActual, &cbActual);
+    }
+
+    if (rc != VINF_HGCM_ASYNC_EXECUTE)
+    {
+        if (RT_FAILURE (rc))
+            vboxSvcClipboardChunkFree (pClient);
+        if (vboxSvcClipboardLock ())
+        {
+            pClient->chunk.fBusy = false;
+            vboxSvcClipboardUnlock ();
+        }
+    }
+    return rc;
+}
+
+/**
+ * Start a chunked transfer, see VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK.
+ *
+ * @returns see vboxSvcClipboardReadChunkDone
+ */
+static int vboxSvcClipboardReadChunkStart (VBOXCLIPBOARDCLIENTDATA *pClient,
+                                           VBOXHGCMCALLHANDLE callHandle,
+                                           VBOXHGCMSVCPARM *paParms,
+                                           uint32_t u32Format, void *pv, uint32_t cb)
+{
+    bool fBusy = true;
+    if (vboxSvcClipboardLock ())
+    {
+        fBusy = pClient->chunk.fBusy;
+        pClient->chunk.fBusy = true;
+        vboxSvcClipboardUnlock ();
+    }
+    if (fBusy)
+        return VERR_RESOURCE_BUSY;
+
+    vboxSvcClipboardChunkFree (pClient);
+    pClient->chunk.u32Format = u32Format;
+
+    uint32_t cbActual = 0;
+    int rc = vboxSvcClipboardReadChunkBackend (pClient, callHandle, paParms, pv, cb, &cbActual);
+    if (rc != VINF_HGCM_ASYNC_EXECUTE)
+        rc = vboxSvcClipboardReadChunkDone (pClient, callHandle, paParms, rc, cbActual);
+    return rc;
+}
+
+/**
+ * Hand out the next chunk of a transfer, see
+ * VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK.
+ */
+static int vboxSvcClipboardReadChunkNext (VBOXCLIPBOARDCLIENTDATA *pClient,
+                                          VBOXHGCMSVCPARM *paParms,
+                                          uint32_t u32Format, uint32_t offChunk,
+                                          void *pv, uint32_t cb)
+{
+    bool fBusy = true;
+    if (vboxSvcClipboardLock ())
+    {
+        fBusy = pClient->chunk.fBusy;
+        vboxSvcClipboardUnlock ();
+    }
+    if (fBusy)
+        return VERR_RESOURCE_BUSY;
+
+    if (offChunk == VBOX_SHARED_CLIPBOARD_CHUNK_CANCEL)
+    {
+        vboxSvcClipboardChunkFree (pClient);
+        VBoxHGCMParmUInt32Set (&paParms[3], 0);
+        return VINF_SUCCESS;
+    }
+
+    /* The transfer is gone if it was cancelled or completed, or if the
+     * state was restored in between. */
+    if (!pClient->chunk.pv)
+        return VERR_NO_DATA;
+    if (   u32Format != pClient->chunk.u32Format
+        || offChunk >= pClient->chunk.cb)
+        return VERR_INVALID_PARAMETER;
+
+    uint32_t cbChunk = RT_MIN (cb, pClient->chunk.cb - offChunk);
+    memcpy (pv, (uint8_t *)pClient->chunk.pv + offChunk, cbChunk);
+    VBoxHGCMParmUInt32Set (&paParms[3], pClient->chunk.cb);
+    if (offChunk + cbChunk == pClient->chunk.cb)
+        vboxSvcClipboardChunkFree (pClient);
+    return VINF_SUCCESS;
+}
+
+/**
+ * Complete the pending read of the guest, if there is one.
+ *
+ * @param  fFromBackend  whether the backend completed the read or we are
+ *                       just releasing the guest
+ */
+static void vboxSvcClipboardCompleteRead (VBOXCLIPBOARDCLIENTDATA *pClient, int rc,
+                                          uint32_t cbActual, bool fFromBackend)
+{
+    VBOXHGCMCALLHANDLE callHandle = NULL;
+    VBOXHGCMSVCPARM *paParms = NULL;
+    bool fReadPending = false;
+    bool fReadChunk = false;
+    if (vboxSvcClipboardLock())  /* if not can we do anything useful? */
+    {
+        callHandle   = pClient->asyncRead.callHandle;
+        paParms      = pClient->asyncRead.paParms;
+        fReadPending = pClient->fReadPending;
+        fReadChunk   = pClient->fReadChunk;
+        pClient->fReadPending = false;
+        pClient->fReadChunk   = false;
+        if (fReadPending && fReadChunk && !fFromBackend)
+        {
+            /* The backend may still write to the host buffer, so leak it
+             * rather than free it. */
+            pClient->chunk.pv    = NULL;
+            pClient->chunk.cb    = 0;
+            pClient->chunk.fBusy = false;
+        }
+        vboxSvcClipboardUnlock();
+    }
+    if (fReadPending)
+    {
+        if (fReadChunk && fFromBackend)
+        {
+            rc = vboxSvcClipboardReadChunkDone (pClient, callHandle, paParms, rc, cbActual);
+            if (rc == VINF_HGCM_ASYNC_EXECUTE)
+                return;
+        }
+        else if (fReadChunk)
+            VBoxHGCMParmUInt32Set (&paParms[3], cbActual);
+        else
+            VBoxHGCMParmUInt32Set (&paParms[2], cbActual);
+        g_pHelpers->pfnCallComplete (callHandle, rc);
+    }
+}
+
 static DECLCALLBACK(void) svcCall (void *,
                                    VBOXHGCMCALLHANDLE callHandle,
                                    uint32_t u32ClientID,
@@ -534,37 +823,12 @@ static DECLCALLBACK(void) svcCall (void *,
 
                         uint32_t cbActual = 0;
 
-                        if (g_pfnExtension)
-                        {
-                            VBOXCLIPBOARDEXTPARMS parms;
-
-                            parms.u32Format = u32Format;
-                            parms.u.pvData = pv;
-                            parms.cbData = cb;
-
-                            g_fReadingData = true;
-                            rc = g_pfnExtension (g_pvExtension, VBOX_CLIPBOARD_EXT_FN_DATA_READ, &parms, sizeof (parms));
-                            LogRelFlow(("DATA: g_fDelayedAnnouncement = %d, g_u32DelayedFormats = 0x%x\n", g_fDelayedAnnouncement, g_u32DelayedFormats));
-                            if (g_fDelayedAnnouncement)
-                            {
-                                vboxSvcClipboardReportMsg (g_pClient, VBOX_SHARED_CLIPBOARD_HOST_MSG_FORMATS, g_u32DelayedFormats);
-                                g_fDelayedAnnouncement = false;
-                                g_u32DelayedFormats = 0;
-                            }
-                            g_fReadingData = false;
+                        /* Release any other pending read, as we only
+                         * support one pending read at one time. */
+                        if (!g_pfnExtension)
+                            vboxSvcClipboardCompleteRead (pClient, VERR_NO_DATA, 0, false /* fFromBackend */);
 
-                            if (RT_SUCCESS (rc))
-                            {
-                                cbActual = parms.cbData;
-                            }
-                        }
-                        else
-                        {
-                            /* Release any other pending read, as we only
-                             * support one pending read at one time. */
-                            vboxSvcClipboardCompleteReadData(pClient, VERR_NO_DATA, 0);
-                            rc = vboxClipboardReadData (pClient, u32Format, pv, cb, &cbActual);
-                        }
+                        rc = vboxSvcClipboardReadBackend (pClient, u32Format, pv, cb, &cbActual);
 
                         /* Remember our read request until it is completed.
                          * See the protocol description above for more
@@ -576,6 +840,7 @@ static DECLCALLBACK(void) svcCall (void *,
                                 pClient->asyncRead.callHandle = callHandle;
                                 pClient->asyncRead.paParms    = paParms;
                                 pClient->fReadPending         = true;
+                                pClient->fReadChunk           = false;
                                 fAsynchronousProcessing = true;
                                 vboxSvcClipboardUnlock();
                             }
@@ -646,6 +911,65 @@ static DECLCALLBACK(void) svcCall (void *,
             }
         } break;
 
+        case VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK:
+        {
+            /* The guest wants to read data in the given format a chunk at a time. */
+            LogRel2(("svcCall: VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK\n"));
+
+            if (cParms != VBOX_SHARED_CLIPBOARD_CPARMS_READ_DATA_CHUNK)
+            {
+                rc = VERR_INVALID_PARAMETER;
+            }
+            else if (   paParms[0].type != VBOX_HGCM_SVC_PARM_32BIT   /* format */
+                     || paParms[1].type != VBOX_HGCM_SVC_PARM_32BIT   /* offset */
+                     || paParms[2].type != VBOX_HGCM_SVC_PARM_PTR     /* ptr */
+                     || paParms[3].type != VBOX_HGCM_SVC_PARM_32BIT   /* size */
+                    )
+            {
+                rc = VERR_INVALID_PARAMETER;
+            }
+            else
+            {
+                uint32_t u32Format;
+                uint32_t offChunk;
+                void     *pv;
+                uint32_t cb;
+
+                rc = VBoxHGCMParmUInt32Get (&paParms[0], &u32Format);
+
+                if (RT_SUCCESS (rc))
+                    rc = VBoxHGCMParmUInt32Get (&paParms[1], &offChunk);
+
+                if (RT_SUCCESS (rc))
+                    rc = VBoxHGCMParmPtrGet (&paParms[2], &pv, &cb);
+
+                if (RT_SUCCESS (rc))
+                {
+                    if (   vboxSvcClipboardMode () != VBOX_SHARED_CLIPBOARD_MODE_HOST_TO_GUEST
+                        && vboxSvcClipboardMode () != VBOX_SHARED_CLIPBOARD_MODE_BIDIRECTIONAL)
+                    {
+                        rc = VERR_NOT_SUPPORTED;
+                        break;
+                    }
+
+                    if (offChunk != 0)
+                    {
+                        rc = vboxSvcClipboardReadChunkNext (pClient, paParms, u32Format, offChunk, pv, cb);
+                    }
+                    else
+                    {
+                        /* Release any other pending read, as we only
+                         * support one pending read at one time. */
+                        vboxSvcClipboardCompleteRead (pClient, VERR_NO_DATA, 0, false /* fFromBackend */);
+
+                        rc = vboxSvcClipboardReadChunkStart (pClient, callHandle, paParms, u32Format, pv, cb);
+                        if (rc == VINF_HGCM_ASYNC_EXECUTE)
+                            fAsynchronousProcessing = true;
+                    }
+                }
+            }
+        } break;
+
         default:
         {
             rc = VERR_NOT_IMPLEMENTED;
@@ -665,22 +989,7 @@ static DECLCALLBACK(void) svcCall (void *,
  * shared clipboard module description. */
 void vboxSvcClipboardCompleteReadData(VBOXCLIPBOARDCLIENTDATA *pClient, int rc, uint32_t cbActual)
 {
-    VBOXHGCMCALLHANDLE callHandle = NULL;
-    VBOXHGCMSVCPARM *paParms = NULL;
-    bool fReadPending = false;
-    if (vboxSvcClipboardLock())  /* if not can we do anything useful? */
-    {
-        callHandle   = pClient->asyncRead.callHandle;
-        paParms      = pClient->asyncRead.paParms;
-        fReadPending = pClient->fReadPending;
-        pClient->fReadPending = false;
-        vboxSvcClipboardUnlock();
-    }
-    if (fReadPending)
-    {
-        VBoxHGCMParmUInt32Set (&paParms[2], cbActual);
-        g_pHelpers->pfnCallComplete (callHandle, rc);
-    }
+    vboxSvcClipboardCompleteRead (pClient, rc, cbActual, true /* fFromBackend */);
 }
 
 /*
@@ -787,7 +1096,7 @@ static DECLCALLBACK(int) svcSaveState(void *, uint32_t u32ClientID, void *pvClie
         pClient->fAsync = false;
     }
 
-    vboxSvcClipboardCompleteReadData (pClient, VINF_SUCCESS, 0);
+    vboxSvcClipboardCompleteRead (pClient, VINF_SUCCESS, 0, false /* fFromBackend */);
 
 #endif /* !UNIT_TEST */
     return VINF_SUCCESS;
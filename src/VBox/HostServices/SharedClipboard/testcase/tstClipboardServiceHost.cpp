@@ -20,6 +20,7 @@
 #include <VBox/HostServices/VBoxClipboardSvc.h>
 
 #include <iprt/assert.h>
+#include <iprt/mem.h>
 #include <iprt/string.h>
 #include <iprt/test.h>
 
@@ -123,6 +124,103 @@ static void testHostCall(void)
     testSetHeadless();
 }
 
+/** The clipboard data returned by our vboxClipboardReadData. */
+static uint8_t g_abClipData[300];
+/** The status of the last completed guest call. */
+static int g_rcCallComplete;
+
+static DECLCALLBACK(void) tstCallComplete(VBOXHGCMCALLHANDLE callHandle, int32_t rc)
+{
+    NOREF(callHandle);
+    g_rcCallComplete = rc;
+}
+
+static int tstReadDataChunk(VBOXHGCMSVCFNTABLE *pTable, void *pvClient,
+                            uint32_t offChunk, void *pv, uint32_t cb,
+                            uint32_t *pcbTotal)
+{
+    struct VBOXHGCMSVCPARM parms[4];
+
+    parms[0].setUInt32(VBOX_SHARED_CLIPBOARD_FMT_BITMAP);
+    parms[1].setUInt32(offChunk);
+    parms[2].setPointer(pv, cb);
+    parms[3].setUInt32(0);
+    g_rcCallComplete = VERR_WRONG_ORDER;
+    pTable->pfnCall(NULL, NULL, 1, pvClient,
+                    VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK, 4, parms);
+    *pcbTotal = 0;
+    parms[3].getUInt32(pcbTotal);
+    return g_rcCallComplete;
+}
+
+static void testReadDataChunk(void)
+{
+    struct VBOXHGCMSVCPARM parms[1];
+    VBOXHGCMSVCHELPERS helpers;
+    VBOXHGCMSVCFNTABLE table;
+    uint8_t abChunk[128];
+    uint8_t abData[sizeof(g_abClipData)];
+    uint32_t cbTotal;
+    uint32_t off;
+    int rc;
+
+    RTTestISub("Testing FN_READ_DATA_CHUNK");
+    RT_ZERO(helpers);
+    helpers.pfnCallComplete = tstCallComplete;
+    table.pHelpers = &helpers;
+    rc = setupTable(&table);
+    RTTESTI_CHECK_MSG_RETV(RT_SUCCESS(rc), ("rc=%Rrc\n", rc));
+    parms[0].setUInt32(VBOX_SHARED_CLIPBOARD_MODE_BIDIRECTIONAL);
+    rc = table.pfnHostCall(NULL, VBOX_SHARED_CLIPBOARD_HOST_FN_SET_MODE,
+                           1, parms);
+    RTTESTI_CHECK_RC_OK(rc);
+    void *pvClient = RTMemAllocZ(table.cbClient);
+    RTTESTI_CHECK_RETV(pvClient);
+    rc = table.pfnConnect(NULL, 1, pvClient);
+    RTTESTI_CHECK_RC_OK(rc);
+    for (off = 0; off < sizeof(g_abClipData); ++off)
+        g_abClipData[off] = (uint8_t)off;
+
+    /* Data which does not fit is handed out chunk by chunk. */
+    RT_ZERO(abData);
+    for (off = 0; off < sizeof(abData); off += sizeof(abChunk))
+    {
+        rc = tstReadDataChunk(&table, pvClient, off, abChunk, sizeof(abChunk),
+                              &cbTotal);
+        RTTESTI_CHECK_RC_BREAK(rc, VINF_SUCCESS);
+        RTTESTI_CHECK_MSG(cbTotal == sizeof(g_abClipData),
+                          ("cbTotal=%u\n", cbTotal));
+        memcpy(&abData[off], abChunk, RT_MIN(sizeof(abChunk), sizeof(abData) - off));
+    }
+    RTTESTI_CHECK(!memcmp(abData, g_abClipData, sizeof(abData)));
+    /* The host dropped the data after the last chunk. */
+    rc = tstReadDataChunk(&table, pvClient, sizeof(abChunk), abChunk,
+                          sizeof(abChunk), &cbTotal);
+    RTTESTI_CHECK_RC(rc, VERR_NO_DATA);
+
+    /* A cancelled transfer is gone. */
+    rc = tstReadDataChunk(&table, pvClient, 0, abChunk, sizeof(abChunk),
+                          &cbTotal);
+    RTTESTI_CHECK_RC(rc, VINF_SUCCESS);
+    rc = tstReadDataChunk(&table, pvClient, VBOX_SHARED_CLIPBOARD_CHUNK_CANCEL,
+                          abChunk, sizeof(abChunk), &cbTotal);
+    RTTESTI_CHECK_RC(rc, VINF_SUCCESS);
+    rc = tstReadDataChunk(&table, pvClient, sizeof(abChunk), abChunk,
+                          sizeof(abChunk), &cbTotal);
+    RTTESTI_CHECK_RC(rc, VERR_NO_DATA);
+
+    /* Data which fits comes in one go. */
+    RT_ZERO(abData);
+    rc = tstReadDataChunk(&table, pvClient, 0, abData, sizeof(abData),
+                          &cbTotal);
+    RTTESTI_CHECK_RC(rc, VINF_SUCCESS);
+    RTTESTI_CHECK_MSG(cbTotal == sizeof(g_abClipData), ("cbTotal=%u\n", cbTotal));
+    RTTESTI_CHECK(!memcmp(abData, g_abClipData, sizeof(abData)));
+
+    table.pfnDisconnect(NULL, 1, pvClient);
+    RTMemFree(pvClient);
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -143,6 +241,7 @@ int main(int argc, char *argv[])
      * Run the tests.
      */
     testHostCall();
+    testReadDataChunk();
 
     /*
      * Summary
@@ -152,13 +251,18 @@ int main(int argc, char *argv[])
 
 int vboxClipboardInit() { return VINF_SUCCESS; }
 void vboxClipboardDestroy() { AssertFailed(); }
-void vboxClipboardDisconnect(_VBOXCLIPBOARDCLIENTDATA*) { AssertFailed(); }
+void vboxClipboardDisconnect(_VBOXCLIPBOARDCLIENTDATA*) { }
 int vboxClipboardConnect(_VBOXCLIPBOARDCLIENTDATA*, bool)
-{ AssertFailed(); return VERR_WRONG_ORDER; }
+{ return VINF_SUCCESS; }
 void vboxClipboardFormatAnnounce(_VBOXCLIPBOARDCLIENTDATA*, unsigned int)
 { AssertFailed(); }
-int vboxClipboardReadData(_VBOXCLIPBOARDCLIENTDATA*, unsigned int, void*, unsigned int, unsigned int*)
-{ AssertFailed(); return VERR_WRONG_ORDER; }
+int vboxClipboardReadData(_VBOXCLIPBOARDCLIENTDATA*, unsigned int, void *pv, unsigned int cb, unsigned int *pcbActual)
+{
+    *pcbActual = sizeof(g_abClipData);
+    if (sizeof(g_abClipData) <= cb)
+        memcpy(pv, g_abClipData, sizeof(g_abClipData));
+    return VINF_SUCCESS;
+}
 void vboxClipboardWriteData(_VBOXCLIPBOARDCLIENTDATA*, void*, unsigned int, unsigned int) { AssertFailed(); }
 int vboxClipboardSync(_VBOXCLIPBOARDCLIENTDATA*)
 { AssertFailed(); return VERR_WRONG_ORDER; }
@@ -31,6 +31,11 @@
 
 #include "VBoxClipboard.h"
 
+/** The largest amount of X11 clipboard data we keep for the guest's retry
+ * after its buffer turned out to be too small.  Anything larger is fetched
+ * from X11 again when the guest comes back. */
+#define VBOX_CLIPBOARD_CACHE_MAX (16 * _1M)
+
 struct _VBOXCLIPBOARDREQFROMVBOX;
 typedef struct _VBOXCLIPBOARDREQFROMVBOX VBOXCLIPBOARDREQFROMVBOX;
 
@@ -57,8 +62,38 @@ struct _VBOXCLIPBOARDCONTEXT
     /** We set this when we start shutting down as a hint not to post any new
      * requests. */
     bool fShuttingDown;
+    /** Incremented whenever the content of the clipboard changes hands, so
+     * that data arriving for an older request is not cached. */
+    uint32_t uGeneration;
+    /** X11 clipboard data which did not fit into the guest's buffer.  The
+     * guest retries with a buffer of the reported size, and we serve that
+     * retry from here instead of converting the X11 data all over again.
+     * Only the next read looks at this, whatever its format, and drops it.
+     * Protected by @a clipboardMutex. */
+    struct
+    {
+        void *pv;
+        uint32_t cb;
+        uint32_t u32Format;
+    } cache;
 };
 
+/**
+ * Drop the cached data from the last oversized read, if any.
+ * @param  pCtx  the host glue context
+ * @note  Host glue code
+ */
+static void clipCacheInvalidate(VBOXCLIPBOARDCONTEXT *pCtx)
+{
+    RTCritSectEnter(&pCtx->clipboardMutex);
+    ++pCtx->uGeneration;
+    RTMemFree(pCtx->cache.pv);
+    pCtx->cache.pv = NULL;
+    pCtx->cache.cb = 0;
+    pCtx->cache.u32Format = 0;
+    RTCritSectLeave(&pCtx->clipboardMutex);
+}
+
 /**
  * Report formats available in the X11 clipboard to VBox.
  * @param  pCtx        Opaque context pointer for the glue code
@@ -69,6 +104,7 @@ void ClipReportX11Formats(VBOXCLIPBOARDCONTEXT *pCtx,
                                       uint32_t u32Formats)
 {
     LogRelFlowFunc(("called.  pCtx=%p, u32Formats=%02X\n", pCtx, u32Formats));
+    clipCacheInvalidate(pCtx);
     vboxSvcClipboardReportMsg(pCtx->pClient,
                               VBOX_SHARED_CLIPBOARD_HOST_MSG_FORMATS,
                               u32Formats);
@@ -171,6 +207,7 @@ void vboxClipboardDisconnect (VBOXCLIPBOARDCLIENTDATA *pClient)
     if (RT_SUCCESS(rc))  /* And if not? */
     {
         ClipDestructX11(pCtx->pBackend);
+        RTMemFree(pCtx->cache.pv);
         RTCritSectDelete(&pCtx->clipboardMutex);
         RTMemFree(pCtx);
     }
@@ -188,6 +225,7 @@ void vboxClipboardFormatAnnounce (VBOXCLIPBOARDCLIENTDATA *pClient,
 {
     LogRelFlowFunc(("called.  pClient=%p, u32Formats=%02X\n", pClient,
                  u32Formats));
+    clipCacheInvalidate(pClient->pCtx);
     ClipAnnounceFormatToX11 (pClient->pCtx->pBackend, u32Formats);
 }
 
@@ -200,12 +238,18 @@ struct _CLIPREADCBREQ
     uint32_t cb;
     /** The actual size of the data written */
     uint32_t *pcbActual;
+    /** The format requested */
+    uint32_t u32Format;
+    /** The clipboard generation at the time of the request */
+    uint32_t uGeneration;
 };
 
 /**
  * Called when VBox wants to read the X11 clipboard.
  *
- * @returns VINF_SUCCESS on successful completion
+ * @returns VINF_SUCCESS on successful completion, including when the
+ *          request was served from the data cached by a previous request
+ *          whose buffer was too small
  * @returns VINF_HGCM_ASYNC_EXECUTE if the operation will complete
  *          asynchronously
  * @returns iprt status code on failure
@@ -227,7 +271,33 @@ int vboxClipboardReadData (VBOXCLIPBOARDCLIENTDATA *pClient,
     LogRelFlowFunc(("pClient=%p, u32Format=%02X, pv=%p, cb=%u, pcbActual=%p",
                  pClient, u32Format, pv, cb, pcbActual));
 
+    VBOXCLIPBOARDCONTEXT *pCtx = pClient->pCtx;
     int rc = VINF_SUCCESS;
+    uint32_t uGeneration;
+
+    /* Is this the guest coming back with a larger buffer for the data we
+     * could not give it last time?  The cached data is only good for this
+     * one read, so take it out in any case. */
+    RTCritSectEnter(&pCtx->clipboardMutex);
+    uGeneration = pCtx->uGeneration;
+    void *pvCache = pCtx->cache.pv;
+    uint32_t cbCache = pCtx->cache.cb;
+    bool fCacheHit = pvCache && pCtx->cache.u32Format == u32Format;
+    pCtx->cache.pv = NULL;
+    pCtx->cache.cb = 0;
+    pCtx->cache.u32Format = 0;
+    RTCritSectLeave(&pCtx->clipboardMutex);
+    if (fCacheHit)
+    {
+        *pcbActual = cbCache;
+        if (cbCache <= cb)
+            memcpy(pv, pvCache, cbCache);
+        RTMemFree(pvCache);
+        LogRelFlowFunc(("served %u bytes from the cache\n", cbCache));
+        return VINF_SUCCESS;
+    }
+    RTMemFree(pvCache);
+
     CLIPREADCBREQ *pReq = (CLIPREADCBREQ *) RTMemAlloc(sizeof(CLIPREADCBREQ));
     if (!pReq)
         rc = VERR_NO_MEMORY;
@@ -236,7 +306,9 @@ int vboxClipboardReadData (VBOXCLIPBOARDCLIENTDATA *pClient,
         pReq->pv = pv;
         pReq->cb = cb;
         pReq->pcbActual = pcbActual;
-        rc = ClipRequestDataFromX11(pClient->pCtx->pBackend, u32Format, pReq);
+        pReq->u32Format = u32Format;
+        pReq->uGeneration = uGeneration;
+        rc = ClipRequestDataFromX11(pCtx->pBackend, u32Format, pReq);
         if (RT_SUCCESS(rc))
             rc = VINF_HGCM_ASYNC_EXECUTE;
     }
@@ -246,14 +318,17 @@ int vboxClipboardReadData (VBOXCLIPBOARDCLIENTDATA *pClient,
 
 /**
  * Complete a request from VBox for the X11 clipboard data.  The data should
- * be written to the buffer provided in the initial request.
+ * be written to the buffer provided in the initial request.  If it does not
+ * fit, the caller is told the size needed and we keep a copy of the data so
+ * that the retry with a larger buffer does not have to go back to X11.
  * @param  pCtx  request context information
  * @param  rc    the completion status of the request
  * @param  cbActual  on successful completion, the number of bytes of data
  *                   actually written, on buffer overflow the size of the
  *                   buffer needed, ignored otherwise
- * @todo   change this to deal with the buffer issues rather than offloading
- *         them onto the caller
+ * @note   the cache also serves the service when it fetches all of the data
+ *         for a VBOX_SHARED_CLIPBOARD_FN_READ_DATA_CHUNK transfer after the
+ *         first chunk turned out to be too small.
  */
 void ClipCompleteDataRequestFromX11(VBOXCLIPBOARDCONTEXT *pCtx, int rc,
                                     CLIPREADCBREQ *pReq, void *pv,
@@ -261,6 +336,22 @@ void ClipCompleteDataRequestFromX11(VBOXCLIPBOARDCONTEXT *pCtx, int rc,
 {
     if (cb <= pReq->cb)
         memcpy(pReq->pv, pv, cb);
+    else if (RT_SUCCESS(rc) && pv && cb <= VBOX_CLIPBOARD_CACHE_MAX)
+    {
+        /* Drop the data if the clipboard changed in the meantime. */
+        void *pvCopy = RTMemDup(pv, cb);
+        RTCritSectEnter(&pCtx->clipboardMutex);
+        if (pvCopy && pReq->uGeneration == pCtx->uGeneration)
+        {
+            RTMemFree(pCtx->cache.pv);
+            pCtx->cache.pv = pvCopy;
+            pCtx->cache.cb = cb;
+            pCtx->cache.u32Format = pReq->u32Format;
+            pvCopy = NULL;
+        }
+        RTCritSectLeave(&pCtx->clipboardMutex);
+        RTMemFree(pvCopy);
+    }
     RTMemFree(pReq);
     vboxSvcClipboardCompleteReadData(pCtx->pClient, rc, cb);
 }
@@ -560,6 +651,95 @@ int main()
             }
         }
     }
+    /* Data which does not fit should be kept for the guest's retry. */
+    char achSmall[4];
+    char achLarge[16];
+    uint32_t cbActual = 0;
+    rc = vboxClipboardReadData(&client, VBOX_SHARED_CLIPBOARD_FMT_UNICODETEXT,
+                               achSmall, sizeof(achSmall), &cbActual);
+    if (rc != VINF_HGCM_ASYNC_EXECUTE)
+    {
+        RTPrintf(TEST_NAME ": vboxClipboardReadData returned %Rrc\n", rc);
+        ++cErrors;
+    }
+    else
+    {
+        ClipCompleteDataRequestFromX11(client.pCtx, VINF_SUCCESS,
+                                       pBackend->readData.pReq,
+                                       (void *)"testing", sizeof("testing"));
+        if (pBackend->completeRead.cbActual != sizeof("testing"))
+        {
+            RTPrintf(TEST_NAME ": cbActual=%u, expected %u\n",
+                     pBackend->completeRead.cbActual, (unsigned)sizeof("testing"));
+            ++cErrors;
+        }
+        pBackend->readData.pReq = NULL;
+        rc = vboxClipboardReadData(&client,
+                                   VBOX_SHARED_CLIPBOARD_FMT_UNICODETEXT,
+                                   achLarge, sizeof(achLarge), &cbActual);
+        if (   rc != VINF_SUCCESS
+            || pBackend->readData.pReq != NULL
+            || cbActual != sizeof("testing")
+            || strcmp(achLarge, "testing") != 0)
+        {
+            RTPrintf(TEST_NAME ": cached read: rc=%Rrc, cbActual=%u\n", rc,
+                     cbActual);
+            ++cErrors;
+        }
+        /* The cache is only good for one retry. */
+        rc = vboxClipboardReadData(&client,
+                                   VBOX_SHARED_CLIPBOARD_FMT_UNICODETEXT,
+                                   achLarge, sizeof(achLarge), &cbActual);
+        if (rc != VINF_HGCM_ASYNC_EXECUTE)
+        {
+            RTPrintf(TEST_NAME ": second read: rc=%Rrc, expected VINF_HGCM_ASYNC_EXECUTE\n",
+                     rc);
+            ++cErrors;
+        }
+        else
+            ClipCompleteDataRequestFromX11(client.pCtx, VERR_NO_DATA,
+                                           pBackend->readData.pReq, NULL, 0);
+    }
+    /* A read for another format drops the cached data. */
+    pBackend->readData.pReq = NULL;
+    rc = vboxClipboardReadData(&client, VBOX_SHARED_CLIPBOARD_FMT_UNICODETEXT,
+                               achSmall, sizeof(achSmall), &cbActual);
+    if (rc == VINF_HGCM_ASYNC_EXECUTE)
+    {
+        ClipCompleteDataRequestFromX11(client.pCtx, VINF_SUCCESS,
+                                       pBackend->readData.pReq,
+                                       (void *)"testing", sizeof("testing"));
+        pBackend->readData.pReq = NULL;
+        rc = vboxClipboardReadData(&client, VBOX_SHARED_CLIPBOARD_FMT_BITMAP,
+                                   achLarge, sizeof(achLarge), &cbActual);
+        if (rc != VINF_HGCM_ASYNC_EXECUTE)
+        {
+            RTPrintf(TEST_NAME ": other format read: rc=%Rrc, expected VINF_HGCM_ASYNC_EXECUTE\n",
+                     rc);
+            ++cErrors;
+        }
+        else
+            ClipCompleteDataRequestFromX11(client.pCtx, VERR_NO_DATA,
+                                           pBackend->readData.pReq, NULL, 0);
+        pBackend->readData.pReq = NULL;
+        rc = vboxClipboardReadData(&client,
+                                   VBOX_SHARED_CLIPBOARD_FMT_UNICODETEXT,
+                                   achLarge, sizeof(achLarge), &cbActual);
+        if (rc != VINF_HGCM_ASYNC_EXECUTE)
+        {
+            RTPrintf(TEST_NAME ": read after other format: rc=%Rrc, expected VINF_HGCM_ASYNC_EXECUTE\n",
+                     rc);
+            ++cErrors;
+        }
+        else
+            ClipCompleteDataRequestFromX11(client.pCtx, VERR_NO_DATA,
+                                           pBackend->readData.pReq, NULL, 0);
+    }
+    else
+    {
+        RTPrintf(TEST_NAME ": vboxClipboardReadData returned %Rrc\n", rc);
+        ++cErrors;
+    }
     void *pv;
     uint32_t cb;
     pBackend->writeData.pv = (void *)"testing";
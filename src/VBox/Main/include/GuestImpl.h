@@ -184,6 +184,12 @@ private:
     uint64_t          mNetStatRx;
     uint64_t          mNetStatTx;
     uint64_t          mNetStatLastTs;
+    /** The network counters of the VM, resolved once by staticEnumStatsCallback
+     * so updateStats doesn't have to walk the statistics tree every time. */
+    std::vector<PSTAMCOUNTER> mNetStatRxSamples;
+    std::vector<PSTAMCOUNTER> mNetStatTxSamples;
+    /** The VM the counters above belong to. */
+    PVM               mpNetStatVM;
     ULONG             mCurrentGuestStat[GUESTSTATTYPE_MAX];
     ULONG             mVmValidStats;
     BOOL              mCollectVMMStats;
@@ -75,6 +75,7 @@ public:
     inline bool callbackExists(uint32_t uContextID);
     inline int checkPID(uint32_t uPID);
     static Utf8Str guestErrorToString(int guestRc);
+    bool isInputQueueSupported(void);
     bool isReady(void);
     ULONG getProcessID(void) { return mData.mProcessID; }
     int readData(uint32_t uHandle, uint32_t uSize, uint32_t uTimeoutMS, void *pvData, size_t cbData, size_t *pcbRead, int *pGuestRc);
@@ -84,6 +85,8 @@ public:
     int terminateProcess(void);
     int waitFor(uint32_t fWaitFlags, ULONG uTimeoutMS, ProcessWaitResult_T &waitResult, int *pGuestRc);
     int writeData(uint32_t uHandle, uint32_t uFlags, void *pvData, size_t cbData, uint32_t uTimeoutMS, uint32_t *puWritten, int *pGuestRc);
+    int writeDataQueue(uint32_t uHandle, uint32_t uFlags, void *pvData, size_t cbData, uint32_t *puContextID);
+    int writeDataWait(uint32_t uContextID, uint32_t uTimeoutMS, uint32_t *puWritten, int *pGuestRc);
     /** @}  */
 
 protected:
@@ -102,6 +105,7 @@ protected:
     int setProcessStatus(ProcessStatus_T procStatus, int procRc);
     int signalWaiters(ProcessWaitResult_T enmWaitResult, int rc = VINF_SUCCESS);
     static DECLCALLBACK(int) startProcessThread(RTTHREAD Thread, void *pvUser);
+    int writeDataSend(uint32_t uHandle, uint32_t uFlags, void *pvData, size_t cbData, uint32_t *puContextID);
     /** @}  */
 
 private:
@@ -121,6 +125,9 @@ private:
         GuestProcessStartupInfo  mProcess;
         /** Exit code if process has been terminated. */
         LONG                     mExitCode;
+        /** Whether the guest queues input, i.e. reported
+         *  PROC_STS_STARTED_FLAG_INPUT_QUEUE. */
+        bool                     mInputQueue;
         /** PID reported from the guest. */
         ULONG                    mPID;
         /** Internal, host-side process ID. */
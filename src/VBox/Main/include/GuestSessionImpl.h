@@ -89,6 +89,9 @@ public:
 
 protected:
 
+    int copyToGuestSync(GuestProcess *pProcess, PRTFILE pFile, uint64_t *pcbWrittenTotal, BOOL *pfCanceled);
+    int copyToGuestQueued(GuestProcess *pProcess, PRTFILE pFile, uint64_t *pcbWrittenTotal, BOOL *pfCanceled);
+
     Utf8Str  mSource;
     PRTFILE  mSourceFile;
     size_t   mSourceOffset;
@@ -169,6 +169,13 @@ public:
 
         BOOL                mAccessible;
         com::ErrorInfo      mAccessError;
+        /** Set if registeredInit() was deferred until first access (lazy
+         *  machine loading, see VirtualBox::initMachines()). */
+        bool                mLazyInitPending;
+        /** Set if pMachineConfigFile has changes (currently only extra data)
+         *  which are waiting for the delayed write-back, see
+         *  VirtualBox::scheduleSettingsWrite(). */
+        bool                mSettingsWritePending;
 
         MachineState_T      mMachineState;
         RTTIMESPEC          mLastStateChange;
@@ -357,7 +364,9 @@ public:
     // initializer for loading existing machine XML (either registered or not)
     HRESULT initFromSettings(VirtualBox *aParent,
                              const Utf8Str &strConfigFile,
-                             const Guid *aId);
+                             const Guid *aId,
+                             settings::MachineConfigFile *pPreloadedConfig = NULL,
+                             bool fLazy = false);
 
     // initializer for machine config in memory (OVF import)
     HRESULT init(VirtualBox *aParent,
@@ -375,7 +384,8 @@ protected:
     HRESULT initImpl(VirtualBox *aParent,
                      const Utf8Str &strConfigFile);
     HRESULT initDataAndChildObjects();
-    HRESULT registeredInit();
+    HRESULT registeredInit(settings::MachineConfigFile *pPreloadedConfig = NULL);
+    HRESULT retryRegisteredInit(settings::MachineConfigFile *pPreloadedConfig);
     HRESULT tryCreateMachineConfigFile(bool fForceOverwrite);
     void uninitDataAndChildObjects();
 
@@ -630,6 +640,18 @@ public:
      */
     bool isAccessible() const { return !!mData->mAccessible; }
 
+    /**
+     * Checks if loading the settings of this machine has been deferred until
+     * it is first used.
+     *
+     * @note This method doesn't check this object's readiness.
+     */
+    bool isLazyInitPending();
+
+    HRESULT finishLazyInit(settings::MachineConfigFile *pPreloadedConfig = NULL);
+
+    HRESULT savePendingSettings();
+
     /**
      * Returns this machine ID.
      *
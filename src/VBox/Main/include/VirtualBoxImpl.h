@@ -55,6 +55,7 @@ struct VMClientWatcherData;
 namespace settings
 {
     class MainConfigFile;
+    class MachineConfigFile;
     struct MediaRegistry;
 }
 class ATL_NO_VTABLE VirtualBox :
@@ -138,6 +139,13 @@ public:
     STDMETHOD(FindMachine)(IN_BSTR aNameOrId, IMachine **aMachine);
     STDMETHOD(GetMachinesByGroups)(ComSafeArrayIn(IN_BSTR, aGroups), ComSafeArrayOut(IMachine *, aMachines));
     STDMETHOD(GetMachineStates)(ComSafeArrayIn(IMachine *, aMachines), ComSafeArrayOut(MachineState_T, aStates));
+    STDMETHOD(QueryMachinesInfo)(ComSafeArrayIn(IN_BSTR, aAttributes), ULONG aFirst, ULONG aCount,
+                                 ULONG aGeneration, ComSafeArrayOut(IMachine *, aMachines),
+                                 ULONG *aCurrentGeneration, ComSafeArrayOut(BSTR, aValues));
+    STDMETHOD(QueryMachineInfo)(IMachine *aMachine, ComSafeArrayIn(IN_BSTR, aAttributes),
+                                ComSafeArrayOut(BSTR, aValues));
+    STDMETHOD(QueryMediaInfo)(DeviceType_T aDeviceType, ComSafeArrayIn(IN_BSTR, aAttributes),
+                              ComSafeArrayOut(IMedium *, aMedia), ComSafeArrayOut(BSTR, aValues));
     STDMETHOD(CreateAppliance)(IAppliance **anAppliance);
 
     STDMETHOD(CreateHardDisk)(IN_BSTR aFormat,
@@ -282,7 +290,8 @@ public:
     void saveMediaRegistry(settings::MediaRegistry &mediaRegistry,
                            const Guid &uuidRegistry,
                            const Utf8Str &strMachineFolder);
-    HRESULT saveSettings();
+    HRESULT saveSettings(bool fFlushTmpDir = true);
+    void scheduleSettingsWrite(Machine *aMachine);
 
     void markRegistryModified(const Guid &uuid);
     void saveModifiedRegistries();
@@ -317,12 +326,16 @@ private:
                                    ComObjPtr<Medium> *pDupMedium);
 
     HRESULT registerMachine(Machine *aMachine);
+    HRESULT loadLazyMachines();
+    void loadLazyMachine(const ComObjPtr<Machine> &pMachine);
 
     HRESULT registerDHCPServer(DHCPServer *aDHCPServer,
                                bool aSaveRegistry = true);
     HRESULT unregisterDHCPServer(DHCPServer *aDHCPServer,
                                  bool aSaveRegistry = true);
 
+    void savePendingSettingsWrites();
+
     int  decryptSettings();
     int  decryptMediumSettings(Medium *pMedium);
     int  decryptSettingBytes(uint8_t *aPlaintext, const uint8_t *aCiphertext,
@@ -342,6 +355,7 @@ private:
 
     static DECLCALLBACK(int) ClientWatcher(RTTHREAD thread, void *pvUser);
     static DECLCALLBACK(int) AsyncEventHandler(RTTHREAD thread, void *pvUser);
+    static DECLCALLBACK(int) SettingsWriter(RTTHREAD thread, void *pvUser);
 
 #ifdef RT_OS_WINDOWS
     static DECLCALLBACK(int) SVCHelperClientThread(RTTHREAD aThread, void *aUser);
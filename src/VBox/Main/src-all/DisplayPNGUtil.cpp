@@ -43,7 +43,8 @@ static void PNGAPI png_write_data_fn(png_structp png_ptr, png_bytep p, png_size_
         {
             uint32_t cbNew = pCtx->cbPNG + (uint32_t)cb;
             AssertReturnVoidStmt(cbNew > pCtx->cbPNG && cbNew <= _1G, pCtx->rc = VERR_TOO_MUCH_DATA);
-            cbNew = RT_ALIGN_32(cbNew, 4096) + 4096;
+            /* Grow exponentially, libpng hands us the data in small chunks. */
+            cbNew = RT_MAX(RT_ALIGN_32(cbNew, 4096) + 4096, RT_MIN(pCtx->cbAllocated * 2, _1G));
 
             void *pNew = RTMemRealloc(pCtx->pu8PNG, cbNew);
             if (!pNew)
@@ -161,6 +162,12 @@ int DisplayMakePNG(uint8_t *pu8Data, uint32_t cx, uint32_t cy,
                                      8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
                                      PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 
+                        /* Screen contents compress well anyway, so favour speed: a single
+                         * cheap filter instead of trying all of them on every row, and
+                         * the fastest zlib level. */
+                        png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB);
+                        png_set_compression_level(png_ptr, Z_BEST_SPEED);
+
                         png_bytep row_pointer = (png_bytep)pu8Bitmap;
                         unsigned i = 0;
                         for (; i < cyBitmap; i++, row_pointer += cxBitmap * 4)
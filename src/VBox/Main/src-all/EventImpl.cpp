@@ -47,8 +47,17 @@
  * reach zero, element is removed from pending events map, and event is marked as processed.
  * Thus if passive listener's user forgets to call IEventSource's EventProcessed()
  * waiters may never know that event processing finished.
+ *
+ * Some events only report the latest state of something (a guest property
+ * value, the mouse pointer shape, ...). If a passive listener still has such
+ * an event for the same object in its queue, the old one is dropped when the
+ * new one is appended (see getCoalescingKey()), so slow consumers don't
+ * have to work through a backlog of outdated updates. Waitable events are never
+ * coalesced. The queues keep statistics about coalesced events and the
+ * delivery latency which get logged when the listener goes away.
  */
 
+#include <algorithm>
 #include <list>
 #include <map>
 #include <deque>
@@ -564,7 +573,35 @@ public:
 
 typedef EventMapList EventMap[NumEvents];
 typedef std::map<IEvent*, int32_t> PendingEventsMap;
-typedef std::deque<ComPtr<IEvent> > PassiveQueue;
+
+/** How many passive listeners get their queue statistics into the release
+ *  log, see ListenerRecord::logStats(). */
+#define VBOX_EVENT_STATS_MAX_LOGGED 64
+
+/** An event in the queue of a passive listener. */
+struct QueuedEvent
+{
+    QueuedEvent(IEvent *aEvent, const Utf8Str &aKey, uint64_t aSeq, uint64_t aQueuedTS)
+        : mEvent(aEvent), mKey(aKey), mSeq(aSeq), mQueuedTS(aQueuedTS)
+    {}
+
+    /** For finding an event by sequence number, the queue is sorted by it. */
+    bool operator<(uint64_t aSeq) const
+    {
+        return mSeq < aSeq;
+    }
+
+    ComPtr<IEvent>                mEvent;
+    /** The coalescing key, empty if the event can't be coalesced. */
+    Utf8Str                       mKey;
+    /** The sequence number of the event. */
+    uint64_t                      mSeq;
+    /** When the (first coalesced) event was queued, for the statistics. */
+    uint64_t                      mQueuedTS;
+};
+typedef std::deque<QueuedEvent> PassiveQueue;
+/** Maps coalescing keys to the sequence numbers of queued events. */
+typedef std::map<Utf8Str, uint64_t> CoalescingMap;
 
 class ListenerRecord
 {
@@ -576,9 +613,23 @@ private:
     RTSEMEVENT                    mQEvent;
     RTCRITSECT                    mcsQLock;
     PassiveQueue                  mQueue;
+    /** The sequence number for the next event added to mQueue. */
+    uint64_t                      mNextSeq;
+    CoalescingMap                 mCoalescing;
     int32_t volatile              mRefCnt;
     uint64_t                      mLastRead;
 
+    /* Statistics of the passive queue, protected by mcsQLock. */
+    uint64_t                      mcQueued;
+    uint64_t                      mcCoalesced;
+    uint64_t                      mcDelivered;
+    uint64_t                      mcNsLatencyTotal;
+    uint64_t                      mcNsLatencyMax;
+    size_t                        mcMaxQueued;
+
+    void popFront();
+    void logStats(const char *pszWhy);
+
 public:
     ListenerRecord(IEventListener*                    aListener,
                    com::SafeArray<VBoxEventType_T>&   aInterested,
@@ -586,8 +637,8 @@ public:
                    EventSource*                       aOwner);
     ~ListenerRecord();
 
-    HRESULT process(IEvent* aEvent, BOOL aWaitable, PendingEventsMap::iterator& pit, AutoLockBase& alock);
-    HRESULT enqueue(IEvent* aEvent);
+    HRESULT process(IEvent* aEvent, BOOL aWaitable, const Utf8Str &aKey, PendingEventsMap::iterator& pit, AutoLockBase& alock);
+    HRESULT enqueue(IEvent* aEvent, const Utf8Str &aKey);
     HRESULT dequeue(IEvent* *aEvent, LONG aTimeout, AutoLockBase& aAlock);
     HRESULT eventProcessed(IEvent * aEvent, PendingEventsMap::iterator& pit);
     void addRef()
@@ -710,6 +761,81 @@ static BOOL implies(VBoxEventType_T who, VBoxEventType_T what)
     }
 }
 
+/**
+ * Checks whether events of the given type can be coalesced in passive
+ * listener queues.  Must match the types handled by getCoalescingKey().
+ *
+ * @param   aType   The event type.
+ */
+static bool isCoalescableEventType(VBoxEventType_T aType)
+{
+    switch (aType)
+    {
+        case VBoxEventType_OnGuestPropertyChanged:
+        case VBoxEventType_OnMachineDataChanged:
+        case VBoxEventType_OnMousePointerShapeChanged:
+        case VBoxEventType_OnMouseCapabilityChanged:
+        case VBoxEventType_OnKeyboardLedsChanged:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Returns the key for coalescing the given event in passive listener queues.
+ *
+ * Events with the same key describe the latest state of the same thing, so
+ * a queued event can be replaced by a newer one with the same key.
+ *
+ * @returns The key, empty if the event must not be coalesced.
+ * @param   aEvent  The event.
+ * @param   aType   The event type.
+ */
+static Utf8Str getCoalescingKey(IEvent *aEvent, VBoxEventType_T aType)
+{
+    switch (aType)
+    {
+        case VBoxEventType_OnGuestPropertyChanged:
+        {
+            ComPtr<IGuestPropertyChangedEvent> pEvent = aEvent;
+            Bstr bstrMachineId, bstrName;
+            if (   pEvent.isNull()
+                || FAILED(pEvent->COMGETTER(MachineId)(bstrMachineId.asOutParam()))
+                || FAILED(pEvent->COMGETTER(Name)(bstrName.asOutParam())))
+                break;
+            return Utf8StrFmt("%d/%ls/%ls", aType, bstrMachineId.raw(), bstrName.raw());
+        }
+
+        case VBoxEventType_OnMachineDataChanged:
+        {
+            ComPtr<IMachineDataChangedEvent> pEvent = aEvent;
+            Bstr bstrMachineId;
+            BOOL fTemporary = FALSE;
+            if (   pEvent.isNull()
+                || FAILED(pEvent->COMGETTER(MachineId)(bstrMachineId.asOutParam()))
+                || FAILED(pEvent->COMGETTER(Temporary)(&fTemporary)))
+                break;
+            return Utf8StrFmt("%d/%ls/%d", aType, bstrMachineId.raw(), fTemporary);
+        }
+
+        case VBoxEventType_OnMousePointerShapeChanged:
+        case VBoxEventType_OnMouseCapabilityChanged:
+        case VBoxEventType_OnKeyboardLedsChanged:
+        {
+            // these are per console, and aggregators may have several of them
+            ComPtr<IEventSource> pSource;
+            if (FAILED(aEvent->COMGETTER(Source)(pSource.asOutParam())))
+                break;
+            return Utf8StrFmt("%d/%p", aType, (IEventSource *)pSource);
+        }
+
+        default:
+            break;
+    }
+    return Utf8Str::Empty;
+}
+
 ListenerRecord::ListenerRecord(IEventListener*                  aListener,
                                com::SafeArray<VBoxEventType_T>& aInterested,
                                BOOL                             aActive,
@@ -717,7 +843,14 @@ ListenerRecord::ListenerRecord(IEventListener*                  aListener,
     :
     mActive(aActive),
     mOwner(aOwner),
-    mRefCnt(0)
+    mNextSeq(0),
+    mRefCnt(0),
+    mcQueued(0),
+    mcCoalesced(0),
+    mcDelivered(0),
+    mcNsLatencyTotal(0),
+    mcNsLatencyMax(0),
+    mcMaxQueued(0)
 {
     mListener = aListener;
     EventMap* aEvMap = &aOwner->m->mEvMap;
@@ -762,6 +895,8 @@ ListenerRecord::~ListenerRecord()
     {
         // at this moment nobody could add elements to our queue, so we can safely
         // clean it up, otherwise there will be pending events map elements
+        logStats("unregistered");
+
         PendingEventsMap* aPem = &mOwner->m->mPendingMap;
         while (true)
         {
@@ -770,8 +905,8 @@ ListenerRecord::~ListenerRecord()
             if (mQueue.empty())
                 break;
 
-            mQueue.front().queryInterfaceTo(aEvent.asOutParam());
-            mQueue.pop_front();
+            mQueue.front().mEvent.queryInterfaceTo(aEvent.asOutParam());
+            popFront();
 
             BOOL aWaitable = FALSE;
             aEvent->COMGETTER(Waitable)(&aWaitable);
@@ -790,6 +925,7 @@ ListenerRecord::~ListenerRecord()
 
 HRESULT ListenerRecord::process(IEvent*                     aEvent,
                                 BOOL                        aWaitable,
+                                const Utf8Str&              aKey,
                                 PendingEventsMap::iterator& pit,
                                 AutoLockBase&               aAlock)
 {
@@ -812,11 +948,53 @@ HRESULT ListenerRecord::process(IEvent*                     aEvent,
             eventProcessed(aEvent, pit);
         return rc;
     }
-    return enqueue(aEvent);
+    return enqueue(aEvent, aKey);
+}
+
+/**
+ * Removes the event at the head of the passive queue.
+ *
+ * @note Caller must own mcsQLock.
+ */
+void ListenerRecord::popFront()
+{
+    const Utf8Str &strKey = mQueue.front().mKey;
+    if (!strKey.isEmpty())
+    {
+        CoalescingMap::iterator cit = mCoalescing.find(strKey);
+        if (cit != mCoalescing.end() && cit->second == mQueue.front().mSeq)
+            mCoalescing.erase(cit);
+    }
+    mQueue.pop_front();
 }
 
+/**
+ * Logs the passive queue statistics to the release log.
+ *
+ * Only listeners which got events are logged, and only the first
+ * VBOX_EVENT_STATS_MAX_LOGGED of them, as clients may register and unregister
+ * listeners all the time.
+ *
+ * @param pszWhy    Why this listener goes away.
+ */
+void ListenerRecord::logStats(const char *pszWhy)
+{
+    static uint32_t volatile s_cLogged = 0;
+
+    if (!mcQueued)
+        return;
+    uint32_t cLogged = ASMAtomicIncU32(&s_cLogged);
+    if (cLogged > VBOX_EVENT_STATS_MAX_LOGGED)
+        return;
+
+    LogRel(("Event listener %p %s: %RU64 queued, %RU64 coalesced, %RU64 delivered, max queue %zu, latency avg %RU64 max %RU64 ns\n",
+            (IEventListener *)mListener, pszWhy, mcQueued, mcCoalesced, mcDelivered, mcMaxQueued,
+            mcDelivered ? mcNsLatencyTotal / mcDelivered : 0, mcNsLatencyMax));
+    if (cLogged == VBOX_EVENT_STATS_MAX_LOGGED)
+        LogRel(("Event listener statistics: not logging any more listeners\n"));
+}
 
-HRESULT ListenerRecord::enqueue (IEvent* aEvent)
+HRESULT ListenerRecord::enqueue (IEvent* aEvent, const Utf8Str &aKey)
 {
     AssertMsg(!mActive, ("must be passive\n"));
 
@@ -829,17 +1007,42 @@ HRESULT ListenerRecord::enqueue (IEvent* aEvent)
     size_t queueSize = mQueue.size();
     if ( (queueSize > 1000) || ((queueSize > 500) && (sinceRead > 60 * 1000)))
     {
+        LogRel(("Event listener %p dropped after not fetching events for %RU64 ms (%zu queued, %RU64 delivered, %RU64 coalesced)\n",
+                (IEventListener *)mListener, sinceRead, queueSize, mcDelivered, mcCoalesced));
         ::RTCritSectLeave(&mcsQLock);
         return E_ABORT;
     }
 
+    // drop an older event for the same thing if it is still queued; the new
+    // one goes to the tail like any other, listeners rely on the order
+    uint64_t queuedTS = RTTimeNanoTS();
+    if (!aKey.isEmpty())
+    {
+        CoalescingMap::iterator cit = mCoalescing.find(aKey);
+        if (cit != mCoalescing.end())
+        {
+            PassiveQueue::iterator qit = std::lower_bound(mQueue.begin(), mQueue.end(), cit->second);
+            AssertReturnStmt(qit != mQueue.end() && qit->mSeq == cit->second, ::RTCritSectLeave(&mcsQLock), E_FAIL);
+            queuedTS = qit->mQueuedTS;
+            mQueue.erase(qit);
+            mCoalescing.erase(cit);
+            queueSize--;
+            mcCoalesced++;
+        }
+    }
 
-    if (queueSize != 0 && mQueue.back() == aEvent)
+    if (queueSize != 0 && mQueue.back().mEvent == aEvent)
         /* if same event is being pushed multiple times - it's reusable event and
            we don't really need multiple instances of it in the queue */
         (void)aEvent;
     else
-        mQueue.push_back(aEvent);
+    {
+        if (!aKey.isEmpty())
+            mCoalescing[aKey] = mNextSeq;
+        mQueue.push_back(QueuedEvent(aEvent, aKey, mNextSeq++, queuedTS));
+        mcQueued++;
+        mcMaxQueued = RT_MAX(mcMaxQueued, queueSize + 1);
+    }
 
     ::RTCritSectLeave(&mcsQLock);
 
@@ -884,8 +1087,13 @@ HRESULT ListenerRecord::dequeue (IEvent*       *aEvent,
     }
     else
     {
-        mQueue.front().queryInterfaceTo(aEvent);
-        mQueue.pop_front();
+        uint64_t cNsLatency = RTTimeNanoTS() - mQueue.front().mQueuedTS;
+        mcDelivered++;
+        mcNsLatencyTotal += cNsLatency;
+        mcNsLatencyMax = RT_MAX(mcNsLatencyMax, cNsLatency);
+
+        mQueue.front().mEvent.queryInterfaceTo(aEvent);
+        popFront();
     }
     ::RTCritSectLeave(&mcsQLock);
     return S_OK;
@@ -1023,13 +1231,19 @@ STDMETHODIMP EventSource::FireEvent(IEvent * aEvent,
     BOOL aWaitable = FALSE;
     aEvent->COMGETTER(Waitable)(&aWaitable);
 
+    VBoxEventType_T evType;
+    hrc = aEvent->COMGETTER(Type)(&evType);
+    AssertComRCReturn(hrc, hrc);
+
+    // waitable events are counted per delivery, they can't be coalesced; the
+    // key needs calls into the event, so get it before taking the lock
+    Utf8Str strKey;
+    if (!aWaitable && isCoalescableEventType(evType))
+        strKey = getCoalescingKey(aEvent, evType);
+
     do {
         AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
 
-        VBoxEventType_T evType;
-        hrc = aEvent->COMGETTER(Type)(&evType);
-        AssertComRCReturn(hrc, hrc);
-
         EventMapList &listeners = m->mEvMap[(int)evType - FirstEvent];
 
         /* Anyone interested in this event? */
@@ -1062,7 +1276,7 @@ STDMETHODIMP EventSource::FireEvent(IEvent * aEvent,
              * in active mode. Note that we expect list iterator stability as 'alock'
              * could be temporary released when calling event handler.
              */
-            cbRc = record.obj()->process(aEvent, aWaitable, pit, alock);
+            cbRc = record.obj()->process(aEvent, aWaitable, strKey, pit, alock);
 
             /* Note that E_ABORT is used above to signal that a passive
              * listener was unregistered due to not picking up its event.
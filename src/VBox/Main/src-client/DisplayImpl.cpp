@@ -2576,8 +2576,10 @@ STDMETHODIMP Display::TakeScreenShotToArray(ULONG aScreenId, ULONG width, ULONG
      */
     alock.release();
 
+    /* Take the screenshot straight into the result array, saving an allocation and a copy. */
     size_t cbData = width * 4 * height;
-    uint8_t *pu8Data = (uint8_t *)RTMemAlloc(cbData);
+    com::SafeArray<BYTE> screenData(cbData);
+    uint8_t *pu8Data = screenData.raw();
 
     if (!pu8Data)
         return E_OUTOFMEMORY;
@@ -2586,21 +2588,16 @@ STDMETHODIMP Display::TakeScreenShotToArray(ULONG aScreenId, ULONG width, ULONG
 
     if (RT_SUCCESS(vrc))
     {
-        /* Convert pixels to format expected by the API caller: [0] R, [1] G, [2] B, [3] A. */
-        uint8_t *pu8 = pu8Data;
-        unsigned cPixels = width * height;
-        while (cPixels)
+        /* Convert pixels to format expected by the API caller: [0] R, [1] G, [2] B, [3] A.
+         * The pixels are 0xAARRGGBB words in host (little endian) byte order. */
+        uint32_t *pu32 = (uint32_t *)pu8Data;
+        size_t const cPixels = (size_t)width * height;
+        for (size_t i = 0; i < cPixels; i++)
         {
-            uint8_t u8 = pu8[0];
-            pu8[0] = pu8[2];
-            pu8[2] = u8;
-            pu8[3] = 0xff;
-            cPixels--;
-            pu8 += 4;
+            uint32_t const u32 = pu32[i];
+            pu32[i] = UINT32_C(0xff000000) | ((u32 & 0xff) << 16) | (u32 & 0xff00) | ((u32 >> 16) & 0xff);
         }
 
-        com::SafeArray<BYTE> screenData(cbData);
-        screenData.initFrom(pu8Data, cbData);
         screenData.detachTo(ComSafeArrayOutArg(aScreenData));
     }
     else if (vrc == VERR_NOT_IMPLEMENTED)
@@ -2610,8 +2607,6 @@ STDMETHODIMP Display::TakeScreenShotToArray(ULONG aScreenId, ULONG width, ULONG
         rc = setError(VBOX_E_IPRT_ERROR,
                       tr("Could not take a screenshot (%Rrc)"), vrc);
 
-    RTMemFree(pu8Data);
-
     LogRelFlowFunc(("rc=%08X\n", rc));
     return rc;
 }
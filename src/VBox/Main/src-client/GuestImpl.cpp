@@ -98,6 +98,7 @@ HRESULT Guest::init(Console *aParent)
     /* Clear statistics. */
     mNetStatRx = mNetStatTx = 0;
     mNetStatLastTs = RTTimeNanoTS();
+    mpNetStatVM = NULL;
     for (unsigned i = 0 ; i < GUESTSTATTYPE_MAX; i++)
         mCurrentGuestStat[i] = 0;
     mVmValidStats = pm::VMSTATMASK_NONE;
@@ -215,9 +216,9 @@ int Guest::staticEnumStatsCallback(const char *pszName, STAMTYPE enmType, void *
             LogFlowFunc(("%s i=%u d=%s %llu %s\n", pszName, uInstance, fRx ? "RX" : "TX",
                          pCnt->c, STAMR3GetUnit(enmUnit)));
             if (fRx)
-                pGuest->mNetStatRx += pCnt->c;
+                pGuest->mNetStatRxSamples.push_back(pCnt);
             else
-                pGuest->mNetStatTx += pCnt->c;
+                pGuest->mNetStatTxSamples.push_back(pCnt);
         }
         else
             LogRel(("Failed to extract the device instance from the name of network stat counter: %s\n", pszEnd));
@@ -287,11 +288,26 @@ void Guest::updateStats(uint64_t iTick)
                            |  pm::VMSTATMASK_VMM_BALOON | pm::VMSTATMASK_VMM_SHARED;
         }
 
+        /*
+         * The network counters live in the device instance data and stay put
+         * for the lifetime of the VM, so look them up only once.
+         */
+        if (mpNetStatVM != pVM.raw())
+        {
+            mNetStatRxSamples.clear();
+            mNetStatTxSamples.clear();
+            rc = STAMR3Enum(pVM, "*/ReceiveBytes|*/TransmitBytes", staticEnumStatsCallback, this);
+            AssertRC(rc);
+            mpNetStatVM = pVM.raw();
+        }
+
         uint64_t uRxPrev = mNetStatRx;
         uint64_t uTxPrev = mNetStatTx;
         mNetStatRx = mNetStatTx = 0;
-        rc = STAMR3Enum(pVM, "*/ReceiveBytes|*/TransmitBytes", staticEnumStatsCallback, this);
-        AssertRC(rc);
+        for (size_t i = 0; i < mNetStatRxSamples.size(); i++)
+            mNetStatRx += mNetStatRxSamples[i]->c;
+        for (size_t i = 0; i < mNetStatTxSamples.size(); i++)
+            mNetStatTx += mNetStatTxSamples[i]->c;
 
         uint64_t uTsNow = RTTimeNanoTS();
         uint64_t cNsPassed = uTsNow - mNetStatLastTs;
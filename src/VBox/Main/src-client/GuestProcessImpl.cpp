@@ -90,6 +90,7 @@ HRESULT GuestProcess::FinalConstruct(void)
     LogFlowThisFuncEnter();
 
     mData.mExitCode = 0;
+    mData.mInputQueue = false;
     mData.mNextContextID = 0;
     mData.mPID = 0;
     mData.mProcessID = 0;
@@ -744,6 +745,8 @@ int GuestProcess::onProcessStatusChange(GuestCtrlCallback *pCallback, PCALLBACKD
 
             procStatus = ProcessStatus_Started;
             mData.mPID = pData->u32PID; /* Set the process PID. */
+            /* Older guests always report 0 here. */
+            mData.mInputQueue = RT_BOOL(pData->u32Flags & PROC_STS_STARTED_FLAG_INPUT_QUEUE);
             break;
         }
 
@@ -1500,16 +1503,71 @@ int GuestProcess::writeData(uint32_t uHandle, uint32_t uFlags,
                      mData.mPID, uHandle, uFlags, pvData, cbData, uTimeoutMS, puWritten, pGuestRc));
     /* All is optional. There can be 0 byte writes. */
 
+    /* Queued input is only for writeDataQueue(). */
+    uint32_t uContextID;
+    int vrc = writeDataSend(uHandle, uFlags & ~INPUT_FLAG_QUEUE, pvData, cbData, &uContextID);
+    if (RT_SUCCESS(vrc))
+        vrc = writeDataWait(uContextID, uTimeoutMS, puWritten, pGuestRc);
+
+    LogFlowFuncLeaveRC(vrc);
+    return vrc;
+}
+
+/**
+ * Tells whether the guest queues input, see writeDataQueue().
+ */
+bool GuestProcess::isInputQueueSupported(void)
+{
+    AutoReadLock alock(this COMMA_LOCKVAL_SRC_POS);
+    return mData.mInputQueue;
+}
+
+/**
+ * Sends a block of input to the guest without waiting for the guest to
+ * process it, so several blocks can be in flight. The guest queues the
+ * input and reports its status once the block was written completely, so
+ * the blocks keep their order.
+ *
+ * Only to be used when isInputQueueSupported() says so, with blocks of up to
+ * GUESTPROCESS_MAX_INPUT_QUEUE_BLOCK bytes and at most
+ * GUESTPROCESS_MAX_INPUT_QUEUE_BLOCKS blocks in flight. Each block must be
+ * completed with writeDataWait().
+ *
+ * @return  IPRT status code.
+ * @param   uHandle             The handle to write to, 0 for stdin.
+ * @param   uFlags              ProcessInputFlag_XXX.
+ * @param   pvData              The input, copied before returning.
+ * @param   cbData              The input size (in bytes).
+ * @param   puContextID         Where to return the context ID for writeDataWait().
+ */
+int GuestProcess::writeDataQueue(uint32_t uHandle, uint32_t uFlags, void *pvData, size_t cbData, uint32_t *puContextID)
+{
+    AssertReturn(cbData <= GUESTPROCESS_MAX_INPUT_QUEUE_BLOCK, VERR_INVALID_PARAMETER);
+    return writeDataSend(uHandle, uFlags | INPUT_FLAG_QUEUE, pvData, cbData, puContextID);
+}
+
+/**
+ * Sends a block of input to the guest, worker for writeData() and
+ * writeDataQueue().
+ *
+ * @return  IPRT status code.
+ * @param   uHandle             The handle to write to, 0 for stdin.
+ * @param   uFlags              INPUT_FLAG_XXX.
+ * @param   pvData              The input, copied before returning.
+ * @param   cbData              The input size (in bytes).
+ * @param   puContextID         Where to return the context ID for writeDataWait(),
+ *                              0 if the process isn't available for writing.
+ */
+int GuestProcess::writeDataSend(uint32_t uHandle, uint32_t uFlags, void *pvData, size_t cbData, uint32_t *puContextID)
+{
+    NOREF(uHandle);
+    AssertPtrReturn(puContextID, VERR_INVALID_POINTER);
+    *puContextID = 0;
+
     AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
 
     if (mData.mStatus != ProcessStatus_Started)
-    {
-        if (puWritten)
-            *puWritten = 0;
-        if (pGuestRc)
-            *pGuestRc = VINF_SUCCESS;
         return VINF_SUCCESS; /* Not available for writing (anymore). */
-    }
 
     int vrc = VINF_SUCCESS;
 
@@ -1530,6 +1588,8 @@ int GuestProcess::writeData(uint32_t uHandle, uint32_t uFlags,
         vrc = pCallbackWrite->Init(VBOXGUESTCTRLCALLBACKTYPE_EXEC_INPUT_STATUS);
         if (RT_SUCCESS(vrc))
             vrc = callbackAdd(pCallbackWrite, &uContextID);
+        if (RT_FAILURE(vrc))
+            delete pCallbackWrite;
     }
 
     alock.release(); /* Drop the write lock again. */
@@ -1546,62 +1606,97 @@ int GuestProcess::writeData(uint32_t uHandle, uint32_t uFlags,
         paParms[i++].setUInt32(cbData);
 
         vrc = sendCommand(HOST_EXEC_SET_INPUT, i, paParms);
+        if (RT_FAILURE(vrc))
+        {
+            alock.acquire();
+            callbackRemove(uContextID);
+        }
+        else
+            *puContextID = uContextID;
     }
 
-    if (RT_SUCCESS(vrc))
+    return vrc;
+}
+
+/**
+ * Waits for the guest to report the status of a block of input sent by
+ * writeData() or writeDataQueue().
+ *
+ * @return  IPRT status code.
+ * @param   uContextID          The context ID of the block, 0 if none was sent.
+ * @param   uTimeoutMS          Timeout (in ms) to wait.
+ * @param   puWritten           Where to return the number of bytes written. Optional.
+ * @param   pGuestRc            Where to return the guest side status. Optional.
+ */
+int GuestProcess::writeDataWait(uint32_t uContextID, uint32_t uTimeoutMS, uint32_t *puWritten, int *pGuestRc)
+{
+    if (puWritten)
+        *puWritten = 0;
+    if (pGuestRc)
+        *pGuestRc = VINF_SUCCESS;
+    if (!uContextID)
+        return VINF_SUCCESS; /* Process wasn't available for writing. */
+
+    AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
+
+    GuestCtrlCallbacks::const_iterator it =
+        mData.mCallbacks.find(VBOX_GUESTCTRL_CONTEXTID_GET_COUNT(uContextID));
+    AssertReturn(it != mData.mCallbacks.end(), VERR_NOT_FOUND);
+    GuestCtrlCallback *pCallbackWrite = it->second;
+
+    alock.release(); /* Drop the write lock again. */
+
+    /*
+     * Let's wait for the guest to process the input.
+     * Note: Be sure not keeping a AutoRead/WriteLock here.
+     */
+    LogFlowThisFunc(("Waiting for callback (%RU32ms) ...\n", uTimeoutMS));
+    int vrc = pCallbackWrite->Wait(uTimeoutMS);
+    if (RT_SUCCESS(vrc)) /* Wait was successful, check for supplied information. */
     {
-        /*
-         * Let's wait for the process being started.
-         * Note: Be sure not keeping a AutoRead/WriteLock here.
-         */
-        LogFlowThisFunc(("Waiting for callback (%RU32ms) ...\n", uTimeoutMS));
-        vrc = pCallbackWrite->Wait(uTimeoutMS);
-        if (RT_SUCCESS(vrc)) /* Wait was successful, check for supplied information. */
+        int guestRc = pCallbackWrite->GetResultCode();
+        LogFlowThisFunc(("Callback returned rc=%Rrc, cbData=%RU32\n", guestRc, pCallbackWrite->GetDataSize()));
+
+        if (RT_SUCCESS(guestRc))
         {
-            int guestRc = pCallbackWrite->GetResultCode();
-            LogFlowThisFunc(("Callback returned rc=%Rrc, cbData=%RU32\n", guestRc, pCallbackWrite->GetDataSize()));
+            Assert(pCallbackWrite->GetDataSize() == sizeof(CALLBACKDATAEXECINSTATUS));
+            PCALLBACKDATAEXECINSTATUS pData = (PCALLBACKDATAEXECINSTATUS)pCallbackWrite->GetDataRaw();
+            AssertPtr(pData);
 
-            if (RT_SUCCESS(guestRc))
+            uint32_t cbWritten = 0;
+            switch (pData->u32Status)
             {
-                Assert(pCallbackWrite->GetDataSize() == sizeof(CALLBACKDATAEXECINSTATUS));
-                PCALLBACKDATAEXECINSTATUS pData = (PCALLBACKDATAEXECINSTATUS)pCallbackWrite->GetDataRaw();
-                AssertPtr(pData);
-
-                uint32_t cbWritten = 0;
-                switch (pData->u32Status)
-                {
-                    case INPUT_STS_WRITTEN:
-                        cbWritten = pData->cbProcessed;
-                        break;
+                case INPUT_STS_WRITTEN:
+                    cbWritten = pData->cbProcessed;
+                    break;
 
-                    case INPUT_STS_ERROR:
-                        vrc = pData->u32Flags; /** @todo Fix int vs. uint32_t! */
-                        break;
+                case INPUT_STS_ERROR:
+                    vrc = pData->u32Flags; /** @todo Fix int vs. uint32_t! */
+                    break;
 
-                    case INPUT_STS_TERMINATED:
-                        vrc = VERR_CANCELLED;
-                        break;
+                case INPUT_STS_TERMINATED:
+                    vrc = VERR_CANCELLED;
+                    break;
 
-                    case INPUT_STS_OVERFLOW:
-                        vrc = VERR_BUFFER_OVERFLOW;
-                        break;
+                case INPUT_STS_OVERFLOW:
+                    vrc = VERR_BUFFER_OVERFLOW;
+                    break;
 
-                    default:
-                        /* Silently skip unknown errors. */
-                        break;
-                }
+                default:
+                    /* Silently skip unknown errors. */
+                    break;
+            }
 
-                LogFlowThisFunc(("cbWritten=%RU32\n", cbWritten));
+            LogFlowThisFunc(("cbWritten=%RU32\n", cbWritten));
 
-                if (pGuestRc)
-                    *pGuestRc = guestRc;
+            if (pGuestRc)
+                *pGuestRc = guestRc;
 
-                if (puWritten)
-                    *puWritten = cbWritten;
+            if (puWritten)
+                *puWritten = cbWritten;
 
-                if (RT_FAILURE(guestRc))
-                    vrc = VERR_GENERAL_FAILURE; /** @todo Special guest control rc needed! */
-            }
+            if (RT_FAILURE(guestRc))
+                vrc = VERR_GENERAL_FAILURE; /** @todo Special guest control rc needed! */
         }
     }
 
@@ -278,130 +278,28 @@ int SessionTaskCopyTo::Run(void)
         }
     }
 
+    /* Position the source at the start offset, it's read sequentially from there. */
+    if (   RT_SUCCESS(rc)
+        && mSourceSize)
+    {
+        rc = RTFileSeek(*pFile, mSourceOffset, RTFILE_SEEK_BEGIN, NULL /* poffActual */);
+        if (RT_FAILURE(rc))
+            setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                Utf8StrFmt(GuestSession::tr("Seeking file \"%s\" to offset %RU64 failed: %Rrc"),
+                                           mSource.c_str(), mSourceOffset, rc));
+    }
+
     if (RT_SUCCESS(rc))
     {
         ProcessWaitResult_T waitRes;
-        BYTE byBuf[_64K];
 
         BOOL fCanceled = FALSE;
         uint64_t cbWrittenTotal = 0;
-        uint64_t cbToRead = mSourceSize;
-
-        for (;;)
-        {
-            rc = pProcess->waitFor(ProcessWaitForFlag_StdIn,
-                                   30 * 1000 /* Timeout */, waitRes, &guestRc);
-            if (   RT_FAILURE(rc)
-                || (   waitRes != ProcessWaitResult_StdIn
-                    && waitRes != ProcessWaitResult_WaitFlagNotSupported))
-            {
-                break;
-            }
-
-            /* If the guest does not support waiting for stdin, we now yield in
-             * order to reduce the CPU load due to busy waiting. */
-            if (waitRes == ProcessWaitResult_WaitFlagNotSupported)
-                RTThreadSleep(1); /* Optional, don't check rc. */
-
-            size_t cbRead = 0;
-            if (mSourceSize) /* If we have nothing to write, take a shortcut. */
-            {
-                /** @todo Not very efficient, but works for now. */
-                rc = RTFileSeek(*pFile, mSourceOffset + cbWrittenTotal,
-                                RTFILE_SEEK_BEGIN, NULL /* poffActual */);
-                if (RT_SUCCESS(rc))
-                {
-                    rc = RTFileRead(*pFile, (uint8_t*)byBuf,
-                                    RT_MIN(cbToRead, sizeof(byBuf)), &cbRead);
-                    /*
-                     * Some other error occured? There might be a chance that RTFileRead
-                     * could not resolve/map the native error code to an IPRT code, so just
-                     * print a generic error.
-                     */
-                    if (RT_FAILURE(rc))
-                    {
-                        setProgressErrorMsg(VBOX_E_IPRT_ERROR,
-                                            Utf8StrFmt(GuestSession::tr("Could not read from file \"%s\" (%Rrc)"),
-                                                       mSource.c_str(), rc));
-                        break;
-                    }
-                }
-                else
-                {
-                    setProgressErrorMsg(VBOX_E_IPRT_ERROR,
-                                        Utf8StrFmt(GuestSession::tr("Seeking file \"%s\" to offset %RU64 failed: %Rrc"),
-                                                   mSource.c_str(), cbWrittenTotal, rc));
-                    break;
-                }
-            }
-
-            uint32_t fFlags = ProcessInputFlag_None;
-
-            /* Did we reach the end of the content we want to transfer (last chunk)? */
-            if (   (cbRead < sizeof(byBuf))
-                /* Did we reach the last block which is exactly _64K? */
-                || (cbToRead - cbRead == 0)
-                /* ... or does the user want to cancel? */
-                || (   !mProgress.isNull()
-                    && SUCCEEDED(mProgress->COMGETTER(Canceled(&fCanceled)))
-                    && fCanceled)
-               )
-            {
-                LogFlowThisFunc(("Writing last chunk cbRead=%RU64\n", cbRead));
-                fFlags |= ProcessInputFlag_EndOfFile;
-            }
-
-            uint32_t cbWritten;
-            Assert(sizeof(byBuf) >= cbRead);
-            rc = pProcess->writeData(0 /* StdIn */, fFlags,
-                                     byBuf, cbRead,
-                                     30 * 1000 /* Timeout */, &cbWritten, &guestRc);
-            if (RT_FAILURE(rc))
-            {
-                switch (rc)
-                {
-                    case VERR_GENERAL_FAILURE: /** @todo Special guest control rc needed! */
-                        setProgressErrorMsg(VBOX_E_IPRT_ERROR,
-                                            GuestProcess::guestErrorToString(guestRc));
-                        break;
 
-                    default:
-                        setProgressErrorMsg(VBOX_E_IPRT_ERROR,
-                                            Utf8StrFmt(GuestSession::tr("Writing to file \"%s\" (offset %RU64) failed: %Rrc"),
-                                            mDest.c_str(), cbWrittenTotal, rc));
-                        break;
-                }
-
-                break;
-            }
-
-            /* Only subtract bytes reported written by the guest. */
-            Assert(cbToRead >= cbWritten);
-            cbToRead -= cbWritten;
-
-            /* Update total bytes written to the guest. */
-            cbWrittenTotal += cbWritten;
-            Assert(cbWrittenTotal <= mSourceSize);
-
-            LogFlowThisFunc(("rc=%Rrc, cbWritten=%RU32, cbToRead=%RU64, cbWrittenTotal=%RU64, cbFileSize=%RU64\n",
-                             rc, cbWritten, cbToRead, cbWrittenTotal, mSourceSize));
-
-            /* Did the user cancel the operation above? */
-            if (fCanceled)
-                break;
-
-            /* Update the progress.
-             * Watch out for division by zero. */
-            mSourceSize > 0
-                ? rc = setProgress((ULONG)(cbWrittenTotal * 100 / mSourceSize))
-                : rc = setProgress(100);
-            if (RT_FAILURE(rc))
-                break;
-
-            /* End of file reached? */
-            if (!cbToRead)
-                break;
-        } /* for */
+        if (pProcess->isInputQueueSupported())
+            rc = copyToGuestQueued(pProcess, pFile, &cbWrittenTotal, &fCanceled);
+        else
+            rc = copyToGuestSync(pProcess, pFile, &cbWrittenTotal, &fCanceled);
 
         LogFlowThisFunc(("Copy loop ended with rc=%Rrc\n" ,rc));
 
@@ -471,11 +369,11 @@ int SessionTaskCopyTo::Run(void)
                     rc = setProgressSuccess();
             }
         }
-
-        if (!pProcess.isNull())
-            pProcess->uninit();
     } /* processCreateExInteral */
 
+    if (!pProcess.isNull())
+        pProcess->uninit();
+
     if (!mSourceFile) /* Only close locally opened files. */
         RTFileClose(*pFile);
 
@@ -483,6 +381,314 @@ int SessionTaskCopyTo::Run(void)
     return rc;
 }
 
+/**
+ * Copies the source to the guest process' stdin one block at a time, for
+ * guests which don't queue input.
+ *
+ * @return  IPRT status code, the progress error info is set on failure.
+ * @param   pProcess            The guest process ("vbox_cat").
+ * @param   pFile               The source file, positioned at the start offset.
+ * @param   pcbWrittenTotal     Where to return the number of bytes the guest took.
+ * @param   pfCanceled          Where to return whether the user canceled.
+ */
+int SessionTaskCopyTo::copyToGuestSync(GuestProcess *pProcess, PRTFILE pFile, uint64_t *pcbWrittenTotal, BOOL *pfCanceled)
+{
+    /* The guest takes at most GUESTPROCESS_MAX_INPUT_BLOCK bytes of input per
+     * message, so that's our chunk size. The buffer keeps what the guest
+     * didn't take in the last round, so partially written chunks don't have
+     * to be read again. */
+    size_t const cbBuf = GUESTPROCESS_MAX_INPUT_BLOCK;
+    uint8_t *pbBuf = (uint8_t *)RTMemAlloc(cbBuf);
+    if (!pbBuf)
+    {
+        setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                            Utf8StrFmt(GuestSession::tr("Could not allocate the buffer for copying file \"%s\""),
+                                       mSource.c_str()));
+        return VERR_NO_MEMORY;
+    }
+
+    int rc = VINF_SUCCESS;
+    int guestRc;
+    ProcessWaitResult_T waitRes;
+
+    BOOL &fCanceled = *pfCanceled;
+    uint64_t &cbWrittenTotal = *pcbWrittenTotal;
+    uint64_t cbToRead = mSourceSize;
+    size_t cbBuffered = 0;
+    bool fEndOfFile = false;
+
+    for (;;)
+    {
+        rc = pProcess->waitFor(ProcessWaitForFlag_StdIn,
+                               30 * 1000 /* Timeout */, waitRes, &guestRc);
+        if (   RT_FAILURE(rc)
+            || (   waitRes != ProcessWaitResult_StdIn
+                && waitRes != ProcessWaitResult_WaitFlagNotSupported))
+        {
+            break;
+        }
+
+        /* If the guest does not support waiting for stdin, we now yield in
+         * order to reduce the CPU load due to busy waiting. */
+        if (waitRes == ProcessWaitResult_WaitFlagNotSupported)
+            RTThreadSleep(1); /* Optional, don't check rc. */
+
+        /* Top up the buffer, unless we have nothing to write (shortcut). */
+        if (   !fEndOfFile
+            && cbBuffered < cbBuf
+            && cbBuffered < cbToRead)
+        {
+            size_t cbWanted = (size_t)RT_MIN(cbToRead - cbBuffered, cbBuf - cbBuffered);
+            size_t cbRead = 0;
+            rc = RTFileRead(*pFile, pbBuf + cbBuffered, cbWanted, &cbRead);
+            /*
+             * Some other error occured? There might be a chance that RTFileRead
+             * could not resolve/map the native error code to an IPRT code, so just
+             * print a generic error.
+             */
+            if (RT_FAILURE(rc))
+            {
+                setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                    Utf8StrFmt(GuestSession::tr("Could not read from file \"%s\" (%Rrc)"),
+                                               mSource.c_str(), rc));
+                break;
+            }
+            if (cbRead < cbWanted)
+                fEndOfFile = true;
+            cbBuffered += cbRead;
+        }
+
+        uint32_t fFlags = ProcessInputFlag_None;
+
+        /* Did we reach the end of the content we want to transfer (last chunk)? */
+        if (   fEndOfFile
+            /* Does the buffer hold everything left? */
+            || (cbToRead - cbBuffered == 0)
+            /* ... or does the user want to cancel? */
+            || (   !mProgress.isNull()
+                && SUCCEEDED(mProgress->COMGETTER(Canceled(&fCanceled)))
+                && fCanceled)
+           )
+        {
+            LogFlowThisFunc(("Writing last chunk cbBuffered=%zu\n", cbBuffered));
+            fFlags |= ProcessInputFlag_EndOfFile;
+        }
+
+        uint32_t cbWritten;
+        Assert(cbBuf >= cbBuffered);
+        rc = pProcess->writeData(0 /* StdIn */, fFlags,
+                                 pbBuf, (uint32_t)cbBuffered,
+                                 30 * 1000 /* Timeout */, &cbWritten, &guestRc);
+        if (RT_FAILURE(rc))
+        {
+            switch (rc)
+            {
+                case VERR_GENERAL_FAILURE: /** @todo Special guest control rc needed! */
+                    setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                        GuestProcess::guestErrorToString(guestRc));
+                    break;
+
+                default:
+                    setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                        Utf8StrFmt(GuestSession::tr("Writing to file \"%s\" (offset %RU64) failed: %Rrc"),
+                                        mDest.c_str(), cbWrittenTotal, rc));
+                    break;
+            }
+
+            break;
+        }
+
+        /* Only subtract bytes reported written by the guest. */
+        Assert(cbToRead >= cbWritten);
+        cbToRead -= cbWritten;
+
+        /* Keep what the guest didn't take for the next round. */
+        Assert(cbBuffered >= cbWritten);
+        cbBuffered -= cbWritten;
+        if (cbBuffered)
+            memmove(pbBuf, pbBuf + cbWritten, cbBuffered);
+
+        /* Update total bytes written to the guest. */
+        cbWrittenTotal += cbWritten;
+        Assert(cbWrittenTotal <= mSourceSize);
+
+        LogFlowThisFunc(("rc=%Rrc, cbWritten=%RU32, cbToRead=%RU64, cbWrittenTotal=%RU64, cbFileSize=%RU64\n",
+                         rc, cbWritten, cbToRead, cbWrittenTotal, mSourceSize));
+
+        /* Did the user cancel the operation above? */
+        if (fCanceled)
+            break;
+
+        /* Update the progress.
+         * Watch out for division by zero. */
+        mSourceSize > 0
+            ? rc = setProgress((ULONG)(cbWrittenTotal * 100 / mSourceSize))
+            : rc = setProgress(100);
+        if (RT_FAILURE(rc))
+            break;
+
+        /* End of file reached? */
+        if (!cbToRead)
+            break;
+    } /* for */
+
+    RTMemFree(pbBuf);
+    return rc;
+}
+
+/**
+ * Copies the source to the guest process' stdin with several large blocks of
+ * input in flight, for guests which queue input (see
+ * GuestProcess::writeDataQueue()). This keeps the guest busy writing while
+ * the next blocks are read from the source and passed through HGCM.
+ *
+ * @return  IPRT status code, the progress error info is set on failure.
+ * @param   pProcess            The guest process ("vbox_cat").
+ * @param   pFile               The source file, positioned at the start offset.
+ * @param   pcbWrittenTotal     Where to return the number of bytes the guest took.
+ * @param   pfCanceled          Where to return whether the user canceled.
+ */
+int SessionTaskCopyTo::copyToGuestQueued(GuestProcess *pProcess, PRTFILE pFile, uint64_t *pcbWrittenTotal, BOOL *pfCanceled)
+{
+    size_t const   cbBlock = GUESTPROCESS_MAX_INPUT_QUEUE_BLOCK;
+    unsigned const cBlocks = GUESTPROCESS_MAX_INPUT_QUEUE_BLOCKS;
+    uint8_t *pbBuf = (uint8_t *)RTMemAlloc(cbBlock * cBlocks);
+    if (!pbBuf)
+    {
+        setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                            Utf8StrFmt(GuestSession::tr("Could not allocate the buffer for copying file \"%s\""),
+                                       mSource.c_str()));
+        return VERR_NO_MEMORY;
+    }
+
+    /* The blocks in flight, a ring of cBlocks entries from iTail to iHead. */
+    uint32_t auContextIDs[GUESTPROCESS_MAX_INPUT_QUEUE_BLOCKS];
+    uint32_t acbBlocks[GUESTPROCESS_MAX_INPUT_QUEUE_BLOCKS];
+    unsigned iHead = 0;
+    unsigned iTail = 0;
+    unsigned cInFlight = 0;
+
+    int rc = VINF_SUCCESS;
+    int guestRc;
+    uint64_t cbToRead = mSourceSize;
+    bool fEndOfFileSent = false;
+
+    for (;;)
+    {
+        /*
+         * Fill the window. When the user cancels, an empty last block makes
+         * the guest close the process' stdin.
+         */
+        while (   RT_SUCCESS(rc)
+               && cInFlight < cBlocks
+               && !fEndOfFileSent)
+        {
+            if (   !mProgress.isNull()
+                && SUCCEEDED(mProgress->COMGETTER(Canceled(pfCanceled)))
+                && *pfCanceled)
+                cbToRead = 0;
+
+            uint8_t *pbBlock = pbBuf + iHead * cbBlock;
+            size_t cbRead = 0;
+            if (cbToRead)
+            {
+                size_t cbWanted = (size_t)RT_MIN(cbToRead, cbBlock);
+                rc = RTFileRead(*pFile, pbBlock, cbWanted, &cbRead);
+                if (RT_FAILURE(rc))
+                {
+                    setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                        Utf8StrFmt(GuestSession::tr("Could not read from file \"%s\" (%Rrc)"),
+                                                   mSource.c_str(), rc));
+                    break;
+                }
+                /* A short read means the file shrunk, the size check of the caller complains. */
+                cbToRead = cbRead < cbWanted ? 0 : cbToRead - cbRead;
+            }
+
+            uint32_t fFlags = ProcessInputFlag_None;
+            if (!cbToRead)
+            {
+                LogFlowThisFunc(("Writing last block cbRead=%zu\n", cbRead));
+                fFlags |= ProcessInputFlag_EndOfFile;
+                fEndOfFileSent = true;
+            }
+
+            rc = pProcess->writeDataQueue(0 /* StdIn */, fFlags, pbBlock, cbRead, &auContextIDs[iHead]);
+            if (RT_FAILURE(rc))
+            {
+                setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                    Utf8StrFmt(GuestSession::tr("Writing to file \"%s\" (offset %RU64) failed: %Rrc"),
+                                               mDest.c_str(), *pcbWrittenTotal, rc));
+                break;
+            }
+            acbBlocks[iHead] = (uint32_t)cbRead;
+            iHead = (iHead + 1) % cBlocks;
+            cInFlight++;
+        }
+
+        if (!cInFlight)
+            break;
+
+        /*
+         * Wait for the oldest block. After a failure only collect the
+         * outstanding blocks without waiting for the guest.
+         */
+        uint32_t cbWritten;
+        int rc2 = pProcess->writeDataWait(auContextIDs[iTail], RT_SUCCESS(rc) ? 30 * 1000 : 0 /* Timeout */,
+                                          &cbWritten, &guestRc);
+        uint32_t const cbBlockSent = acbBlocks[iTail];
+        iTail = (iTail + 1) % cBlocks;
+        cInFlight--;
+        if (RT_FAILURE(rc))
+            continue;
+
+        if (RT_FAILURE(rc2))
+        {
+            switch (rc2)
+            {
+                case VERR_GENERAL_FAILURE: /** @todo Special guest control rc needed! */
+                    setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                        GuestProcess::guestErrorToString(guestRc));
+                    break;
+
+                default:
+                    setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                        Utf8StrFmt(GuestSession::tr("Writing to file \"%s\" (offset %RU64) failed: %Rrc"),
+                                                   mDest.c_str(), *pcbWrittenTotal, rc2));
+                    break;
+            }
+            rc = rc2;
+            continue;
+        }
+
+        /* Update total bytes written to the guest. */
+        *pcbWrittenTotal += cbWritten;
+        Assert(*pcbWrittenTotal <= mSourceSize);
+
+        LogFlowThisFunc(("cbWritten=%RU32/%RU32, cbToRead=%RU64, cbWrittenTotal=%RU64, cbFileSize=%RU64, cInFlight=%u\n",
+                         cbWritten, cbBlockSent, cbToRead, *pcbWrittenTotal, mSourceSize, cInFlight));
+
+        /* The guest takes queued blocks completely, unless the process went away. */
+        if (cbWritten < cbBlockSent)
+        {
+            rc = VERR_BROKEN_PIPE;
+            setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                                Utf8StrFmt(GuestSession::tr("Writing to file \"%s\" (offset %RU64) failed: %Rrc"),
+                                           mDest.c_str(), *pcbWrittenTotal, rc));
+            continue;
+        }
+
+        /* Update the progress.
+         * Watch out for division by zero. */
+        mSourceSize > 0
+            ? rc = setProgress((ULONG)(*pcbWrittenTotal * 100 / mSourceSize))
+            : rc = setProgress(100);
+    }
+
+    RTMemFree(pbBuf);
+    return rc;
+}
+
 int SessionTaskCopyTo::RunAsync(const Utf8Str &strDesc, ComObjPtr<Progress> &pProgress)
 {
     LogFlowThisFunc(("strDesc=%s, strSource=%s, strDest=%s, mCopyFileFlags=%x\n",
@@ -76,7 +76,22 @@ typedef struct SHASTORAGEINTERNAL
     RTSEMEVENT newStatusEvent;
     /** Event for signaling a finished task of the worker thread. */
     RTSEMEVENT workFinishedEvent;
-    /** SHA1/SHA256 calculation context. */
+    /** Circular buffer used for handing data from the worker thread to the
+     * digest thread, so I/O and SHA1/SHA256 calculation run in parallel. */
+    PRTCIRCBUF pDigestCircBuf;
+    /** Handle of the digest thread. */
+    RTTHREAD pDigestThread;
+    /** Set when the digest thread should terminate once its buffer is drained. */
+    volatile bool fDigestEnd;
+    /** Set by the digest thread when it has terminated. */
+    volatile bool fDigestDone;
+    /** The exit status of the digest thread, valid once fDigestDone is set. */
+    volatile int32_t rcDigest;
+    /** Event for signaling new data for the digest thread. */
+    RTSEMEVENT digestDataEvent;
+    /** Event for signaling free space in the digest buffer. */
+    RTSEMEVENT digestSpaceEvent;
+    /** SHA1/SHA256 calculation context (owned by the digest thread). */
     union
     {
         RTSHA1CONTEXT    Sha1;
@@ -103,6 +118,11 @@ typedef struct SHASTORAGEINTERNAL
 #define STATUS_READING UINT32_C(4)
 #define STATUS_END     UINT32_C(5)
 
+/** Size of the circular buffer between the caller and the I/O worker thread. */
+#define SHA_IO_BUFFER_SIZE      (_1M * 2)
+/** Size of the circular buffer between the I/O worker and the digest thread. */
+#define SHA_DIGEST_BUFFER_SIZE  (_1M * 4)
+
 /* Enable for getting some flow history. */
 #if 0
 # define DEBUG_PRINT_FLOW() RTPrintf("%s\n", __FUNCTION__)
@@ -465,6 +485,115 @@ static int tarFlushSyncCallback(void *pvUser, void *pvStorage)
  *   Internal: RTSha interface
  ******************************************************************************/
 
+DECLCALLBACK(int) shaDigestWorkerThread(RTTHREAD /* aThread */, void *pvUser)
+{
+    /* Validate input. */
+    AssertPtrReturn(pvUser, VERR_INVALID_POINTER);
+
+    PSHASTORAGEINTERNAL pInt = (PSHASTORAGEINTERNAL)pvUser;
+
+    int rc = VINF_SUCCESS;
+    for (;;)
+    {
+        size_t cbAvail = RTCircBufUsed(pInt->pDigestCircBuf);
+        if (cbAvail == 0)
+        {
+            /* Only quit when there is nothing left after the end was
+             * signaled, the worker may have queued a last block before. */
+            if (ASMAtomicReadBool(&pInt->fDigestEnd))
+            {
+                if (RTCircBufUsed(pInt->pDigestCircBuf) == 0)
+                    break;
+                continue;
+            }
+            rc = RTSemEventWait(pInt->digestDataEvent, 100);
+            if (   RT_FAILURE(rc)
+                && rc != VERR_TIMEOUT)
+                break;
+            rc = VINF_SUCCESS;
+            continue;
+        }
+
+        char *pcBuf;
+        size_t cbRead = 0;
+        RTCircBufAcquireReadBlock(pInt->pDigestCircBuf, cbAvail, (void**)&pcBuf, &cbRead);
+        /* Update the SHA1/SHA256 context with the next data block. */
+        if (pInt->pShaStorage->fSha256)
+            RTSha256Update(&pInt->ctx.Sha256, pcBuf, cbRead);
+        else
+            RTSha1Update(&pInt->ctx.Sha1, pcBuf, cbRead);
+        RTCircBufReleaseReadBlock(pInt->pDigestCircBuf, cbRead);
+        RTSemEventSignal(pInt->digestSpaceEvent);
+    }
+
+    /* Tell a producer waiting for buffer space that nobody will make any. */
+    ASMAtomicWriteS32(&pInt->rcDigest, rc);
+    ASMAtomicWriteBool(&pInt->fDigestDone, true);
+    RTSemEventSignal(pInt->digestSpaceEvent);
+
+    return rc;
+}
+
+/**
+ * Copies a data block into the digest buffer, waiting for the digest thread to
+ * make room if necessary.  Called on the I/O worker thread only.
+ */
+static int shaQueueDigestData(PSHASTORAGEINTERNAL pInt, const char *pcBuf, size_t cbBuf)
+{
+    int rc = VINF_SUCCESS;
+    size_t cbAllQueued = 0;
+    while (cbAllQueued < cbBuf)
+    {
+        size_t cbFree = RTCircBufFree(pInt->pDigestCircBuf);
+        if (cbFree == 0)
+        {
+            /* The buffer will never drain if the digest thread is gone. */
+            if (ASMAtomicReadBool(&pInt->fDigestDone))
+            {
+                rc = ASMAtomicReadS32(&pInt->rcDigest);
+                if (RT_SUCCESS(rc))
+                    rc = VERR_INTERNAL_ERROR;
+                break;
+            }
+            /* The digest thread is lagging behind, wait for it. */
+            rc = RTSemEventWait(pInt->digestSpaceEvent, 100);
+            if (   RT_FAILURE(rc)
+                && rc != VERR_TIMEOUT)
+                break;
+            rc = VINF_SUCCESS;
+            continue;
+        }
+        char *pcDst;
+        size_t cbWritten = 0;
+        RTCircBufAcquireWriteBlock(pInt->pDigestCircBuf, RT_MIN(cbFree, cbBuf - cbAllQueued), (void**)&pcDst, &cbWritten);
+        memcpy(pcDst, &pcBuf[cbAllQueued], cbWritten);
+        RTCircBufReleaseWriteBlock(pInt->pDigestCircBuf, cbWritten);
+        cbAllQueued += cbWritten;
+        RTSemEventSignal(pInt->digestDataEvent);
+    }
+    return rc;
+}
+
+/**
+ * Tells the digest thread to quit after it processed all queued data and
+ * waits for it.
+ */
+static int shaStopDigestThread(PSHASTORAGEINTERNAL pInt)
+{
+    int rc = VINF_SUCCESS;
+    if (pInt->pDigestThread != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&pInt->fDigestEnd, true);
+        RTSemEventSignal(pInt->digestDataEvent);
+        int rcThread = VINF_SUCCESS;
+        rc = RTThreadWait(pInt->pDigestThread, RT_INDEFINITE_WAIT, &rcThread);
+        if (RT_SUCCESS(rc))
+            rc = rcThread;
+        pInt->pDigestThread = NIL_RTTHREAD;
+    }
+    return rc;
+}
+
 DECLCALLBACK(int) shaCalcWorkerThread(RTTHREAD /* aThread */, void *pvUser)
 {
     /* Validate input. */
@@ -530,14 +659,13 @@ DECLCALLBACK(int) shaCalcWorkerThread(RTTHREAD /* aThread */, void *pvUser)
                         cbAllWritten += cbWritten;
                         pInt->cbCurFile += cbWritten;
                     }
-                    /* Update the SHA1/SHA256 context with the next data block. */
+                    /* Hand the next data block to the digest thread. */
                     if (   RT_SUCCESS(rc)
-                        && pInt->pShaStorage->fCreateDigest)
+                        && pInt->pDigestThread != NIL_RTTHREAD)
                     {
-                        if (pInt->pShaStorage->fSha256)
-                            RTSha256Update(&pInt->ctx.Sha256, pcBuf, cbAllWritten);
-                        else
-                            RTSha1Update(&pInt->ctx.Sha1, pcBuf, cbAllWritten);
+                        rc = shaQueueDigestData(pInt, pcBuf, cbAllWritten);
+                        if (RT_FAILURE(rc))
+                            fLoop = false;
                     }
                     /* Mark the block as empty. */
                     RTCircBufReleaseReadBlock(pInt->pCircBuf, cbAllWritten);
@@ -594,14 +722,13 @@ DECLCALLBACK(int) shaCalcWorkerThread(RTTHREAD /* aThread */, void *pvUser)
                         cbAllRead += cbRead;
                         pInt->cbCurFile += cbRead;
                     }
-                    /* Update the SHA1/SHA256 context with the next data block. */
+                    /* Hand the next data block to the digest thread. */
                     if (   RT_SUCCESS(rc)
-                        && pInt->pShaStorage->fCreateDigest)
+                        && pInt->pDigestThread != NIL_RTTHREAD)
                     {
-                        if (pInt->pShaStorage->fSha256)
-                            RTSha256Update(&pInt->ctx.Sha256, pcBuf, cbAllRead);
-                        else
-                            RTSha1Update(&pInt->ctx.Sha1, pcBuf, cbAllRead);
+                        rc = shaQueueDigestData(pInt, pcBuf, cbAllRead);
+                        if (RT_FAILURE(rc))
+                            fLoop = false;
                     }
                     /* Mark the block as full. */
                     RTCircBufReleaseWriteBlock(pInt->pCircBuf, cbAllRead);
@@ -700,8 +827,10 @@ static int shaOpenCallback(void *pvUser, const char *pszLocation, uint32_t fOpen
         pInt->fOpenMode    = fOpen;
         pInt->u32Status    = STATUS_WAIT;
 
+        pInt->pDigestThread = NIL_RTTHREAD;
+
         /* Circular buffer in the read case. */
-        rc = RTCircBufCreate(&pInt->pCircBuf, _1M * 2);
+        rc = RTCircBufCreate(&pInt->pCircBuf, SHA_IO_BUFFER_SIZE);
         if (RT_FAILURE(rc))
             break;
 
@@ -736,11 +865,29 @@ static int shaOpenCallback(void *pvUser, const char *pszLocation, uint32_t fOpen
 
         if (pShaStorage->fCreateDigest)
         {
-            /* Create a SHA1/SHA256 context the worker thread will work with. */
+            /* Create a SHA1/SHA256 context the digest thread will work with. */
             if (pShaStorage->fSha256)
                 RTSha256Init(&pInt->ctx.Sha256);
             else
                 RTSha1Init(&pInt->ctx.Sha1);
+
+            /* The digest is calculated on a separate thread, so the I/O
+             * worker can already fetch/store the next block meanwhile. */
+            rc = RTCircBufCreate(&pInt->pDigestCircBuf, SHA_DIGEST_BUFFER_SIZE);
+            if (RT_FAILURE(rc))
+                break;
+            rc = RTSemEventCreate(&pInt->digestDataEvent);
+            if (RT_FAILURE(rc))
+                break;
+            rc = RTSemEventCreate(&pInt->digestSpaceEvent);
+            if (RT_FAILURE(rc))
+                break;
+            rc = RTThreadCreate(&pInt->pDigestThread, shaDigestWorkerThread, pInt, 0, RTTHREADTYPE_MAIN_HEAVY_WORKER, RTTHREADFLAGS_WAITABLE, "SHA-Digest");
+            if (RT_FAILURE(rc))
+            {
+                pInt->pDigestThread = NIL_RTTHREAD;
+                break;
+            }
         }
 
         /* Open the file. */
@@ -764,6 +911,13 @@ static int shaOpenCallback(void *pvUser, const char *pszLocation, uint32_t fOpen
             shaSignalManifestThread(pInt, STATUS_END);
             RTThreadWait(pInt->pWorkerThread, RT_INDEFINITE_WAIT, 0);
         }
+        shaStopDigestThread(pInt);
+        if (pInt->digestSpaceEvent)
+            RTSemEventDestroy(pInt->digestSpaceEvent);
+        if (pInt->digestDataEvent)
+            RTSemEventDestroy(pInt->digestDataEvent);
+        if (pInt->pDigestCircBuf)
+            RTCircBufDestroy(pInt->pDigestCircBuf);
         if (pInt->workFinishedEvent)
             RTSemEventDestroy(pInt->workFinishedEvent);
         if (pInt->newStatusEvent)
@@ -807,6 +961,11 @@ static int shaCloseCallback(void *pvUser, void *pvStorage)
         rc = RTThreadWait(pInt->pWorkerThread, RT_INDEFINITE_WAIT, 0);
     }
 
+    /* Let the digest thread process everything the worker handed over. */
+    int rc2 = shaStopDigestThread(pInt);
+    if (RT_SUCCESS(rc))
+        rc = rc2;
+
     if (   RT_SUCCESS(rc)
         && pShaStorage->fCreateDigest)
     {
@@ -843,6 +1002,12 @@ static int shaCloseCallback(void *pvUser, void *pvStorage)
 //    RTPrintf("%lu %lu\n", pInt->calls, pInt->waits);
 
     /* Cleanup */
+    if (pInt->digestSpaceEvent)
+        RTSemEventDestroy(pInt->digestSpaceEvent);
+    if (pInt->digestDataEvent)
+        RTSemEventDestroy(pInt->digestDataEvent);
+    if (pInt->pDigestCircBuf)
+        RTCircBufDestroy(pInt->pDigestCircBuf);
     if (pInt->workFinishedEvent)
         RTSemEventDestroy(pInt->workFinishedEvent);
     if (pInt->newStatusEvent)
@@ -90,6 +90,7 @@
 #include "VBox/com/MultiResult.h"
 
 #include <algorithm>
+#include <memory> // for auto_ptr
 
 #if defined(RT_OS_WINDOWS) || defined(RT_OS_OS2)
 # define HOSTSUFF_EXE ".exe"
@@ -118,6 +119,7 @@ Machine::Data::Data()
      * actually behavior is controlled by the following flag. */
     m_fAllowStateModification  = false;
     mAccessible                = FALSE;
+    mLazyInitPending           = false;
     /* mUuid is initialized in Machine::init() */
 
     mMachineState              = MachineState_PoweredOff;
@@ -394,12 +396,19 @@ HRESULT Machine::init(VirtualBox *aParent,
  *  @param aConfigFile  Local file system path to the VM settings file (can
  *                      be relative to the VirtualBox config directory).
  *  @param aId          UUID of the machine or NULL (see above).
+ *  @param pPreloadedConfig  Optional, the already parsed settings file of a
+ *                      registered machine (see VirtualBox::initMachines()).
+ *                      Ownership is taken over in any case.
+ *  @param fLazy        If true, a registered machine is not loaded until it
+ *                      is first used, see #finishLazyInit().
  *
  *  @return  Success indicator. if not S_OK, the machine object is invalid
  */
 HRESULT Machine::initFromSettings(VirtualBox *aParent,
                                   const Utf8Str &strConfigFile,
-                                  const Guid *aId)
+                                  const Guid *aId,
+                                  settings::MachineConfigFile *pPreloadedConfig /* = NULL */,
+                                  bool fLazy /* = false */)
 {
     LogFlowThisFuncEnter();
     LogFlowThisFunc(("(Init_Registered) aConfigFile='%s\n", strConfigFile.c_str()));
@@ -408,6 +417,9 @@ HRESULT Machine::initFromSettings(VirtualBox *aParent,
     AutoInitSpan autoInitSpan(this);
     AssertReturn(autoInitSpan.isOk(), E_FAIL);
 
+    std::auto_ptr<settings::MachineConfigFile> apPreloadedConfig(pPreloadedConfig);
+    Assert(aId || (!pPreloadedConfig && !fLazy));
+
     HRESULT rc = initImpl(aParent, strConfigFile);
     if (FAILED(rc)) return rc;
 
@@ -416,9 +428,13 @@ HRESULT Machine::initFromSettings(VirtualBox *aParent,
         // loading a registered VM:
         unconst(mData->mUuid) = *aId;
         mData->mRegistered = TRUE;
-        // now load the settings from XML:
-        rc = registeredInit();
-            // this calls initDataAndChildObjects() and loadSettings()
+        if (fLazy)
+            // leave it inaccessible until someone needs it
+            mData->mLazyInitPending = true;
+        else
+            // now load the settings from XML:
+            rc = registeredInit(apPreloadedConfig.release());
+                // this calls initDataAndChildObjects() and loadSettings()
     }
     else
     {
@@ -483,7 +499,8 @@ HRESULT Machine::initFromSettings(VirtualBox *aParent,
 
             // uninit media from this machine's media registry, or else
             // reloading the settings will fail
-            mParent->unregisterMachineMedia(getId());
+            if (!mData->mLazyInitPending)
+                mParent->unregisterMachineMedia(getId());
         }
     }
 
@@ -676,17 +693,23 @@ HRESULT Machine::tryCreateMachineConfigFile(bool fForceOverwrite)
  *  startup the whole VirtualBox server in case if the settings file of some
  *  registered VM is invalid or inaccessible.
  *
+ *  @param pPreloadedConfig  Optional, the already parsed settings file.  When
+ *                      NULL, the file is parsed here.  Ownership is taken over
+ *                      in any case.
+ *
  *  @note Must be always called from this object's write lock
  *        (unless called from #init() that doesn't need any locking).
  *  @note Locks the mUSBController method for writing.
  *  @note Subclasses must not call this method.
  */
-HRESULT Machine::registeredInit()
+HRESULT Machine::registeredInit(settings::MachineConfigFile *pPreloadedConfig /* = NULL */)
 {
+    std::auto_ptr<settings::MachineConfigFile> apPreloadedConfig(pPreloadedConfig);
     AssertReturn(!isSessionMachine(), E_FAIL);
     AssertReturn(!isSnapshotMachine(), E_FAIL);
     AssertReturn(!mData->mUuid.isEmpty(), E_FAIL);
     AssertReturn(!mData->mAccessible, E_FAIL);
+    Assert(!mData->pMachineConfigFile);
 
     HRESULT rc = initDataAndChildObjects();
 
@@ -700,8 +723,12 @@ HRESULT Machine::registeredInit()
 
         try
         {
-            // load and parse machine XML; this will throw on XML or logic errors
-            mData->pMachineConfigFile = new settings::MachineConfigFile(&mData->m_strConfigFileFull);
+            // load and parse machine XML unless the caller already did;
+            // this will throw on XML or logic errors
+            if (apPreloadedConfig.get())
+                mData->pMachineConfigFile = apPreloadedConfig.release();
+            else
+                mData->pMachineConfigFile = new settings::MachineConfigFile(&mData->m_strConfigFileFull);
 
             if (mData->mUuid != mData->pMachineConfigFile->uuid)
                 throw setError(E_FAIL,
@@ -906,40 +933,99 @@ STDMETHODIMP Machine::COMGETTER(Accessible)(BOOL *aAccessible)
     if (!mData->mAccessible)
     {
         /* try to initialize the VM once more if not accessible */
+        rc = retryRegisteredInit(NULL);
+    }
 
-        AutoReinitSpan autoReinitSpan(this);
-        AssertReturn(autoReinitSpan.isOk(), E_FAIL);
+    if (SUCCEEDED(rc))
+        *aAccessible = mData->mAccessible;
 
-#ifdef DEBUG
-        LogFlowThisFunc(("Dumping media backreferences\n"));
-        mParent->dumpAllBackRefs();
-#endif
+    LogFlowThisFuncLeave();
 
-        if (mData->pMachineConfigFile)
-        {
-            // reset the XML file to force loadSettings() (called from registeredInit())
-            // to parse it again; the file might have changed
-            delete mData->pMachineConfigFile;
-            mData->pMachineConfigFile = NULL;
-        }
+    return rc;
+}
 
-        rc = registeredInit();
+/**
+ * Checks if loading the settings of this machine has been deferred until it
+ * is first used (see #finishLazyInit()).
+ *
+ * @note Locks this object for reading.
+ */
+bool Machine::isLazyInitPending()
+{
+    AutoReadLock alock(this COMMA_LOCKVAL_SRC_POS);
+    return mData->mLazyInitPending;
+}
 
-        if (SUCCEEDED(rc) && mData->mAccessible)
-        {
-            autoReinitSpan.setSucceeded();
+/**
+ * Loads a machine whose initialization was deferred by lazy machine loading
+ * (see VirtualBox::initMachines()).  Does nothing if the machine has already
+ * been loaded.
+ *
+ * @param pPreloadedConfig  Optional, the already parsed settings file.
+ *                          Ownership is taken over in any case.
+ *
+ * @note Locks this object for writing.
+ */
+HRESULT Machine::finishLazyInit(settings::MachineConfigFile *pPreloadedConfig /* = NULL */)
+{
+    std::auto_ptr<settings::MachineConfigFile> apPreloadedConfig(pPreloadedConfig);
 
-            /* make sure interesting parties will notice the accessibility
-             * state change */
-            mParent->onMachineStateChange(mData->mUuid, mData->mMachineState);
-            mParent->onMachineDataChange(mData->mUuid);
-        }
+    AutoLimitedCaller autoCaller(this);
+    if (FAILED(autoCaller.rc())) return autoCaller.rc();
+
+    AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
+
+    if (!mData->mLazyInitPending)
+        return S_OK;
+
+    return retryRegisteredInit(apPreloadedConfig.release());
+}
+
+/**
+ * Helper for COMGETTER(Accessible) and #finishLazyInit() which calls
+ * #registeredInit() for an inaccessible machine and notifies interested
+ * parties if it became accessible.
+ *
+ * @param pPreloadedConfig  Optional, the already parsed settings file.
+ *                          Ownership is taken over in any case.
+ *
+ * @note Must be called from this object's write lock.
+ */
+HRESULT Machine::retryRegisteredInit(settings::MachineConfigFile *pPreloadedConfig)
+{
+    std::auto_ptr<settings::MachineConfigFile> apPreloadedConfig(pPreloadedConfig);
+    Assert(isWriteLockOnCurrentThread());
+
+    AutoReinitSpan autoReinitSpan(this);
+    AssertReturn(autoReinitSpan.isOk(), E_FAIL);
+
+    mData->mLazyInitPending = false;
+    mData->mSettingsWritePending = false;
+
+#ifdef DEBUG
+    LogFlowThisFunc(("Dumping media backreferences\n"));
+    mParent->dumpAllBackRefs();
+#endif
+
+    if (mData->pMachineConfigFile)
+    {
+        // reset the XML file to force loadSettings() (called from registeredInit())
+        // to parse it again; the file might have changed
+        delete mData->pMachineConfigFile;
+        mData->pMachineConfigFile = NULL;
     }
 
-    if (SUCCEEDED(rc))
-        *aAccessible = mData->mAccessible;
+    HRESULT rc = registeredInit(apPreloadedConfig.release());
 
-    LogFlowThisFuncLeave();
+    if (SUCCEEDED(rc) && mData->mAccessible)
+    {
+        autoReinitSpan.setSucceeded();
+
+        /* make sure interesting parties will notice the accessibility
+         * state change */
+        mParent->onMachineStateChange(mData->mUuid, mData->mMachineState);
+        mParent->onMachineDataChange(mData->mUuid);
+    }
 
     return rc;
 }
@@ -4976,15 +5062,28 @@ STDMETHODIMP Machine::SetExtraData(IN_BSTR aKey, IN_BSTR aValue)
             mData->pMachineConfigFile->mapExtraDataItems[strKey] = strValue;
                 // creates a new key if needed
 
-        bool fNeedsGlobalSaveSettings = false;
-        saveSettings(&fNeedsGlobalSaveSettings);
-
-        if (fNeedsGlobalSaveSettings)
+        if (   !isSnapshotMachine()
+            && mData->pMachineConfigFile->fileExists())
         {
-            // save the global settings; for that we should hold only the VirtualBox lock
+            // Only the extra data in the settings file changed, so there is no
+            // need to go through saveSettings(). The write is delayed a bit so
+            // that a series of changes ends up in a single write.
+            mData->mSettingsWritePending = true;
             alock.release();
-            AutoWriteLock vboxlock(mParent COMMA_LOCKVAL_SRC_POS);
-            mParent->saveSettings();
+            mParent->scheduleSettingsWrite(isSessionMachine() ? mPeer : this);
+        }
+        else
+        {
+            bool fNeedsGlobalSaveSettings = false;
+            saveSettings(&fNeedsGlobalSaveSettings);
+
+            if (fNeedsGlobalSaveSettings)
+            {
+                // save the global settings; for that we should hold only the VirtualBox lock
+                alock.release();
+                AutoWriteLock vboxlock(mParent COMMA_LOCKVAL_SRC_POS);
+                mParent->saveSettings();
+            }
         }
     }
 
@@ -5064,6 +5163,9 @@ STDMETHODIMP Machine::Unregister(CleanupMode_T cleanupMode,
     // wait for state dependents to drop to zero
     ensureNoStateDependencies();
 
+    // the settings file stays, so write out any changes not written yet
+    savePendingSettings();
+
     if (!mData->mAccessible)
     {
         // inaccessible maschines can only be unregistered; uninitialize ourselves
@@ -9632,9 +9734,17 @@ HRESULT Machine::saveSettings(bool *pfNeedsGlobalSaveSettings,
 
         pNewConfig->fCurrentStateModified = !!mData->mCurrentStateModified;
 
+        // the deep compare above doesn't see extra data changes which were
+        // made to the old config and are still waiting to be written
+        if (mData->mSettingsWritePending)
+            fNeedsWrite = true;
+
         if (fNeedsWrite)
+        {
             // now spit it all out!
             pNewConfig->write(mData->m_strConfigFileFull);
+            mData->mSettingsWritePending = false;
+        }
 
         mData->pMachineConfigFile = pNewConfig;
         delete pOldConfig;
@@ -10221,6 +10331,7 @@ HRESULT Machine::saveStateSettings(int aFlags)
         }
 
         mData->pMachineConfigFile->write(mData->m_strConfigFileFull);
+        mData->mSettingsWritePending = false;
     }
     catch (...)
     {
@@ -10230,6 +10341,44 @@ HRESULT Machine::saveStateSettings(int aFlags)
     return rc;
 }
 
+/**
+ * Writes the settings file if there are changes waiting for the delayed
+ * write-back (see VirtualBox::scheduleSettingsWrite()).
+ *
+ * Only the current settings structure is written, this doesn't commit any
+ * changes of the machine data like saveSettings() does.  If the write fails
+ * the changes stay pending, so that the next saveSettings() (e.g. from
+ * IMachine::SaveSettings()) tries again and reports the error to its caller.
+ *
+ * @note Locks this object for writing.
+ */
+HRESULT Machine::savePendingSettings()
+{
+    AutoCaller autoCaller(this);
+    if (FAILED(autoCaller.rc())) return autoCaller.rc();
+
+    AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
+
+    if (!mData->mSettingsWritePending)
+        return S_OK;
+    mData->mSettingsWritePending = false;
+
+    HRESULT rc = S_OK;
+    try
+    {
+        // the directory is flushed after the rename anyway, skip the extra
+        // sync for these frequent writes
+        mData->pMachineConfigFile->write(mData->m_strConfigFileFull, false /* fFlushTmpDir */);
+    }
+    catch (...)
+    {
+        rc = VirtualBoxBase::handleUnexpectedExceptions(this, RT_SRC_POS);
+        mData->mSettingsWritePending = true;
+    }
+
+    return rc;
+}
+
 /**
  * Ensures that the given medium is added to a media registry. If this machine
  * was created with 4.0 or later, then the machine registry is used. Otherwise
@@ -12196,6 +12345,23 @@ void SessionMachine::uninit(Uninit::Reason aReason)
         rollback(false /* aNotify */);
     }
 
+    // unlocking the machine is a flush point for delayed settings writes
+    if (mData->mSettingsWritePending)
+    {
+        mData->mSettingsWritePending = false;
+        try
+        {
+            mData->pMachineConfigFile->write(mData->m_strConfigFileFull);
+        }
+        catch (...)
+        {
+            /* keep them pending for the next saveSettings() */
+            mData->mSettingsWritePending = true;
+            LogRel(("Failed to write the pending settings changes of machine '%s' to '%s'\n",
+                    mUserData->s.strName.c_str(), mData->m_strConfigFileFull.c_str()));
+        }
+    }
+
     Assert(    mConsoleTaskData.strStateFilePath.isEmpty()
             || !mConsoleTaskData.mSnapshot);
     if (!mConsoleTaskData.strStateFilePath.isEmpty())
@@ -22,9 +22,11 @@
 #include <iprt/dir.h>
 #include <iprt/env.h>
 #include <iprt/file.h>
+#include <iprt/mp.h>
 #include <iprt/path.h>
 #include <iprt/process.h>
 #include <iprt/rand.h>
+#include <iprt/semaphore.h>
 #include <iprt/sha.h>
 #include <iprt/string.h>
 #include <iprt/stream.h>
@@ -184,6 +186,32 @@ typedef ObjectsList<DHCPServer> DHCPServersOList;
 
 typedef std::map<Guid, ComPtr<IProgress> > ProgressMap;
 typedef std::map<Guid, ComObjPtr<Medium> > HardDiskMap;
+typedef std::map<Utf8Str, ComObjPtr<Medium> > MediaLocationMap;
+typedef std::map<Guid, ComObjPtr<Machine> > MachinesMap;
+
+/** How long to wait for more changes before writing settings files whose
+ *  writes are delayed, see VirtualBox::scheduleSettingsWrite(). */
+#define VBOX_SETTINGS_WRITE_DELAY_MS    250
+
+/**
+ * Returns the key for the media location maps, which has the same notion of
+ * equal paths as RTPathCompare().
+ *
+ * @param   strLocation     Full location of the medium.
+ */
+static Utf8Str getMediumLocationKey(const Utf8Str &strLocation)
+{
+#if defined(RT_OS_WINDOWS) || defined(RT_OS_OS2)
+    Utf8Str strKey(strLocation);
+    strKey.toUpper();
+    for (char *psz = strKey.mutableRaw(); psz && *psz; psz++)
+        if (*psz == '\\')
+            *psz = '/';
+    return strKey;
+#else
+    return strLocation;
+#endif
+}
 
 /**
  *  Main VirtualBox data structure.
@@ -198,6 +226,7 @@ struct VirtualBox::Data
           uRegistryNeedsSaving(0),
           lockMachines(LOCKCLASS_LISTOFMACHINES),
           allMachines(lockMachines),
+          uMachinesGeneration(1),
           lockGuestOSTypes(LOCKCLASS_LISTOFOTHEROBJECTS),
           allGuestOSTypes(lockGuestOSTypes),
           lockMedia(LOCKCLASS_LISTOFMEDIA),
@@ -213,7 +242,13 @@ struct VirtualBox::Data
           threadClientWatcher(NIL_RTTHREAD),
           threadAsyncEvent(NIL_RTTHREAD),
           pAsyncEventQ(NULL),
+          lockPendingSettingsWrites(LOCKCLASS_LISTOFOTHEROBJECTS),
+          fGlobalSettingsWritePending(false),
+          threadSettingsWriter(NIL_RTTHREAD),
+          hEvtSettingsWriter(NIL_RTSEMEVENT),
+          fSettingsWriterShutdown(false),
           pAutostartDb(NULL),
+          fLazyMachineLoading(false),
           fSettingsCipherKeySet(false)
     {
     }
@@ -256,6 +291,13 @@ struct VirtualBox::Data
     // in AutoLock.h; e.g. LOCKCLASS_LISTOFMACHINES before LOCKCLASS_MACHINEOBJECT).
     RWLockHandle                        lockMachines;
     MachinesOList                       allMachines;
+    // the machines map is an additional map sorted by UUID for quick lookup,
+    // it is protected by the machines list lock
+    MachinesMap                         mapMachines;
+    // incremented whenever allMachines changes, lets QueryMachinesInfo
+    // callers detect that the list changed between two pages; protected
+    // by the machines list lock
+    ULONG                               uMachinesGeneration;
 
     RWLockHandle                        lockGuestOSTypes;
     GuestOSTypesOList                   allGuestOSTypes;
@@ -269,6 +311,16 @@ struct VirtualBox::Data
     // and contains ALL hard disks (base and differencing); it is protected by
     // the same lock as the other media lists above
     HardDiskMap                         mapHardDisks;
+    // the same for DVD and floppy images (there are no differencing images
+    // of these types, so they contain the same objects as the lists)
+    HardDiskMap                         mapDVDImages,
+                                        mapFloppyImages;
+    // additional maps sorted by location key (see getMediumLocationKey())
+    // for quick lookup by path, again containing ALL media; they are updated
+    // when media locations change because of machine renames
+    MediaLocationMap                    mapHardDiskLocations,
+                                        mapDVDImageLocations,
+                                        mapFloppyImageLocations;
 
     // list of pending machine renames (also protected by media tree lock;
     // see VirtualBox::rememberMachineNameChangeForMedia())
@@ -303,6 +355,17 @@ struct VirtualBox::Data
     EventQueue * const                  pAsyncEventQ;
     const ComObjPtr<EventSource>        pEventSource;
 
+    // the following are data for the delayed settings writes, see
+    // VirtualBox::scheduleSettingsWrite(); the machines map and the event
+    // semaphore handle are protected by their own lock, the global flag by the
+    // VirtualBox object lock
+    RWLockHandle                        lockPendingSettingsWrites;
+    MachinesMap                         mapPendingSettingsWrites;
+    bool                                fGlobalSettingsWritePending;
+    const RTTHREAD                      threadSettingsWriter;
+    RTSEMEVENT                          hEvtSettingsWriter;
+    bool volatile                       fSettingsWriterShutdown;
+
 #ifdef VBOX_WITH_EXTPACK
     /** The extension pack manager object lives here. */
     const ComObjPtr<ExtPackManager>     ptrExtPackManager;
@@ -311,6 +374,10 @@ struct VirtualBox::Data
     /** The global autostart database for the user. */
     AutostartDb * const                 pAutostartDb;
 
+    /** Whether registered machines are only loaded on first use, see
+     *  initMachines(). */
+    bool                                fLazyMachineLoading;
+
     /** Settings secret */
     bool                                fSettingsCipherKeySet;
     uint8_t                             SettingsCipherKey[RTSHA512_HASH_SIZE];
@@ -567,6 +634,18 @@ HRESULT VirtualBox::init()
             /* wait until the thread sets m->pAsyncEventQ */
             RTThreadUserWait(m->threadAsyncEvent, RT_INDEFINITE_WAIT);
             ComAssertThrow(m->pAsyncEventQ, E_FAIL);
+
+            /* start the thread for the delayed settings writes */
+            vrc = RTSemEventCreate(&m->hEvtSettingsWriter);
+            ComAssertRCThrow(vrc, E_FAIL);
+            vrc = RTThreadCreate(&unconst(m->threadSettingsWriter),
+                                 SettingsWriter,
+                                 (void *)this,
+                                 0,
+                                 RTTHREADTYPE_MAIN_WORKER,
+                                 RTTHREADFLAGS_WAITABLE,
+                                 "SettingsWriter");
+            ComAssertRCThrow(vrc, E_FAIL);
         }
         catch (HRESULT aRC)
         {
@@ -593,32 +672,249 @@ HRESULT VirtualBox::init()
     return rc;
 }
 
+/** The max number of threads for parsing machine settings files. */
+#define VBOX_MACHINE_PARSER_THREADS     8
+
+/**
+ * State shared by the machine settings parser threads, see
+ * parseMachineSettingsFiles().
+ */
+struct MachineSettingsParserState
+{
+    /** The full paths of the settings files to parse. */
+    const std::vector<Utf8Str>                 *pvecFiles;
+    /** The parsed settings, NULL entries for files that failed to parse. */
+    std::vector<settings::MachineConfigFile *> *pvecConfigs;
+    /** Index of the next file to parse. */
+    uint32_t volatile                           iNext;
+};
+
+/**
+ * Machine settings parser thread, see parseMachineSettingsFiles().
+ */
+static DECLCALLBACK(int) machineSettingsParserThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    MachineSettingsParserState *pState = (MachineSettingsParserState *)pvUser;
+    NOREF(hThreadSelf);
+
+    uint32_t i;
+    while ((i = ASMAtomicIncU32(&pState->iNext) - 1) < pState->pvecFiles->size())
+    {
+        try
+        {
+            (*pState->pvecConfigs)[i] = new settings::MachineConfigFile(&(*pState->pvecFiles)[i]);
+        }
+        catch (...)
+        {
+            /* Leave it NULL, Machine::registeredInit() will parse the file
+               again and report the error properly. */
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * Parses a number of machine settings files in parallel.
+ *
+ * The settings files are independent of each other, so this is a safe
+ * optimization for the otherwise serial machine loading when there are lots
+ * of registered machines.  Everything which needs the VirtualBox object
+ * state (media registries, machine objects) is left to the caller.
+ *
+ * @param   vecFiles        The full paths of the files to parse.
+ * @param   vecConfigs      Where to return the parsed files (same order).  The
+ *                          entry is NULL if the file could not be parsed.
+ */
+static void parseMachineSettingsFiles(const std::vector<Utf8Str> &vecFiles,
+                                      std::vector<settings::MachineConfigFile *> &vecConfigs)
+{
+    vecConfigs.assign(vecFiles.size(), NULL);
+
+    MachineSettingsParserState State;
+    State.pvecFiles   = &vecFiles;
+    State.pvecConfigs = &vecConfigs;
+    State.iNext       = 0;
+
+    /* The calling thread does its share of the work too. */
+    size_t cThreads = RT_MIN(RT_MIN(RTMpGetOnlineCount(), VBOX_MACHINE_PARSER_THREADS), vecFiles.size() / 4);
+    std::vector<RTTHREAD> vecThreads;
+    for (size_t i = 1; i < cThreads; ++i)
+    {
+        RTTHREAD hThread;
+        int vrc = RTThreadCreateF(&hThread, machineSettingsParserThread, &State, 0,
+                                  RTTHREADTYPE_MAIN_WORKER, RTTHREADFLAGS_WAITABLE, "MachineParse%zu", i);
+        if (RT_FAILURE(vrc))
+            break;
+        vecThreads.push_back(hThread);
+    }
+
+    machineSettingsParserThread(NIL_RTTHREAD, &State);
+
+    for (size_t i = 0; i < vecThreads.size(); ++i)
+        RTThreadWait(vecThreads[i], RT_INDEFINITE_WAIT, NULL);
+}
+
+/**
+ * Creates and registers the machine objects for the machines listed in
+ * VirtualBox.xml.
+ *
+ * The machine settings files are parsed in parallel up front, the machines are
+ * then created one by one in registry order, which also merges the per-machine
+ * media registries into the global media lists.
+ *
+ * If the global extra data item "VBoxInternal2/LazyMachineLoading" is set to
+ * "1", the settings files are not loaded at all.  The machines are registered
+ * in the inaccessible state and loaded when they are first looked up or
+ * asked for their accessibility (see Machine::finishLazyInit()).  Since the
+ * names and the media registries of machines which are not loaded yet are
+ * unknown, lookups by name and all media lookups load the pending machines
+ * first (see loadLazyMachines()).
+ */
 HRESULT VirtualBox::initMachines()
 {
+    settings::StringsMap::const_iterator itLazy = m->pMainConfigFile->mapExtraDataItems.find("VBoxInternal2/LazyMachineLoading");
+    m->fLazyMachineLoading =    itLazy != m->pMainConfigFile->mapExtraDataItems.end()
+                             && itLazy->second == "1";
+
+    std::vector<settings::MachineConfigFile *> vecConfigs;
+    if (!m->fLazyMachineLoading)
+    {
+        std::vector<Utf8Str> vecFiles;
+        vecFiles.reserve(m->pMainConfigFile->llMachines.size());
+        for (settings::MachinesRegistry::const_iterator it = m->pMainConfigFile->llMachines.begin();
+             it != m->pMainConfigFile->llMachines.end();
+             ++it)
+        {
+            Utf8Str strFull;
+            int vrc = calculateFullPath(it->strSettingsFile, strFull);
+            if (RT_FAILURE(vrc))
+                strFull.setNull(); /* Machine::initImpl() complains */
+            vecFiles.push_back(strFull);
+        }
+        parseMachineSettingsFiles(vecFiles, vecConfigs);
+    }
+
+    size_t i = 0;
     for (settings::MachinesRegistry::const_iterator it = m->pMainConfigFile->llMachines.begin();
          it != m->pMainConfigFile->llMachines.end();
-         ++it)
+         ++it, ++i)
     {
         HRESULT rc = S_OK;
         const settings::MachineRegistryEntry &xmlMachine = *it;
         Guid uuid = xmlMachine.uuid;
 
+        /* hand over the parsed file, initFromSettings() takes ownership */
+        settings::MachineConfigFile *pConfig = NULL;
+        if (i < vecConfigs.size())
+            std::swap(pConfig, vecConfigs[i]);
+
         ComObjPtr<Machine> pMachine;
         if (SUCCEEDED(rc = pMachine.createObject()))
         {
             rc = pMachine->initFromSettings(this,
                                             xmlMachine.strSettingsFile,
-                                            &uuid);
+                                            &uuid,
+                                            pConfig,
+                                            m->fLazyMachineLoading);
+            pConfig = NULL;
             if (SUCCEEDED(rc))
                 rc = registerMachine(pMachine);
-            if (FAILED(rc))
-                return rc;
+        }
+        delete pConfig;
+        if (FAILED(rc))
+        {
+            for (; i < vecConfigs.size(); ++i)
+                delete vecConfigs[i];
+            return rc;
+        }
+    }
+
+    return S_OK;
+}
+
+/**
+ * Loads all machines which are still pending lazy initialization (see
+ * initMachines()), parsing their settings files in parallel.
+ *
+ * @note Locks the machines list for reading and the machines for writing,
+ *       the caller must not hold any locks.
+ */
+HRESULT VirtualBox::loadLazyMachines()
+{
+    if (!m->fLazyMachineLoading)
+        return S_OK;
+
+    std::vector<ComObjPtr<Machine> > vecMachines;
+    std::vector<Utf8Str> vecFiles;
+    {
+        AutoReadLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
+        for (MachinesOList::iterator it = m->allMachines.begin();
+             it != m->allMachines.end();
+             ++it)
+        {
+            AutoLimitedCaller machCaller(*it);
+            if (FAILED(machCaller.rc()))
+                continue;
+            if ((*it)->isLazyInitPending())
+            {
+                vecMachines.push_back(*it);
+                vecFiles.push_back((*it)->getSettingsFileFull());
+            }
         }
     }
+    if (vecMachines.empty())
+        return S_OK;
+
+    std::vector<settings::MachineConfigFile *> vecConfigs;
+    parseMachineSettingsFiles(vecFiles, vecConfigs);
+
+    /* Failures leave the machine inaccessible, just like at startup. */
+    for (size_t i = 0; i < vecMachines.size(); ++i)
+        vecMachines[i]->finishLazyInit(vecConfigs[i]);
 
     return S_OK;
 }
 
+/**
+ * Loads a single machine which is still pending lazy initialization (see
+ * initMachines()).
+ *
+ * If the machine can't be loaded on its own, it probably uses media from the
+ * registry of another machine which isn't loaded yet.  All pending machines
+ * are loaded then and the machine is given a second chance.
+ *
+ * @param pMachine  The machine.
+ *
+ * @note Locks the machines list for reading and machines for writing, the
+ *       caller must not hold the machines list or media tree locks.
+ */
+void VirtualBox::loadLazyMachine(const ComObjPtr<Machine> &pMachine)
+{
+    if (!m->fLazyMachineLoading)
+        return;
+
+    AutoLimitedCaller machCaller(pMachine);
+    if (FAILED(machCaller.rc()))
+        return;
+    if (!pMachine->isLazyInitPending())
+        return;
+
+    pMachine->finishLazyInit();
+
+    bool fAccessible;
+    {
+        AutoReadLock machLock(pMachine COMMA_LOCKVAL_SRC_POS);
+        fAccessible = pMachine->isAccessible();
+    }
+    if (!fAccessible)
+    {
+        loadLazyMachines();
+
+        BOOL fRetried;
+        pMachine->COMGETTER(Accessible)(&fRetried);
+    }
+}
+
 /**
  * Loads a media registry from XML and adds the media contained therein to
  * the global lists of known media.
@@ -720,6 +1016,27 @@ HRESULT VirtualBox::initMedia(const Guid &uuidRegistry,
 
 void VirtualBox::uninit()
 {
+    /* stop the settings writer thread and do the pending writes right away */
+    if (m->threadSettingsWriter != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&m->fSettingsWriterShutdown, true);
+        RTSemEventSignal(m->hEvtSettingsWriter);
+        int vrc = RTThreadWait(m->threadSettingsWriter, 60000, NULL);
+        if (RT_FAILURE(vrc))
+            LogWarningFunc(("RTThreadWait(%RTthrd) -> %Rrc\n", m->threadSettingsWriter, vrc));
+        unconst(m->threadSettingsWriter) = NIL_RTTHREAD;
+    }
+    {
+        /* late scheduleSettingsWrite() callers write synchronously from now on */
+        AutoWriteLock alock(m->lockPendingSettingsWrites COMMA_LOCKVAL_SRC_POS);
+        if (m->hEvtSettingsWriter != NIL_RTSEMEVENT)
+        {
+            RTSemEventDestroy(m->hEvtSettingsWriter);
+            m->hEvtSettingsWriter = NIL_RTSEMEVENT;
+        }
+    }
+    savePendingSettingsWrites();
+
     Assert(!m->uRegistryNeedsSaving);
     if (m->uRegistryNeedsSaving)
         saveSettings();
@@ -745,9 +1062,16 @@ void VirtualBox::uninit()
     }
     else
         m->allMachines.uninitAll();
+    m->mapMachines.clear();
     m->allFloppyImages.uninitAll();
     m->allDVDImages.uninitAll();
     m->allHardDisks.uninitAll();
+    m->mapHardDisks.clear();
+    m->mapDVDImages.clear();
+    m->mapFloppyImages.clear();
+    m->mapHardDiskLocations.clear();
+    m->mapDVDImageLocations.clear();
+    m->mapFloppyImageLocations.clear();
     m->allDHCPServers.uninitAll();
 
     m->mapProgressOperations.clear();
@@ -970,6 +1294,8 @@ VirtualBox::COMGETTER(Machines)(ComSafeArrayOut(IMachine *, aMachines))
     AutoCaller autoCaller(this);
     if (FAILED(autoCaller.rc())) return autoCaller.rc();
 
+    loadLazyMachines();
+
     AutoReadLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
     SafeIfaceArray<IMachine> machines(m->allMachines.getList());
     machines.detachTo(ComSafeArrayOutArg(aMachines));
@@ -987,6 +1313,8 @@ VirtualBox::COMGETTER(MachineGroups)(ComSafeArrayOut(BSTR, aMachineGroups))
 
     std::list<Bstr> allGroups;
 
+    loadLazyMachines();
+
     /* get copy of all machine references, to avoid holding the list lock */
     MachinesOList::MyList allMachines;
     {
@@ -1037,6 +1365,8 @@ STDMETHODIMP VirtualBox::COMGETTER(HardDisks)(ComSafeArrayOut(IMedium *, aHardDi
     AutoCaller autoCaller(this);
     if (FAILED(autoCaller.rc())) return autoCaller.rc();
 
+    loadLazyMachines();
+
     AutoReadLock al(m->allHardDisks.getLockHandle() COMMA_LOCKVAL_SRC_POS);
     SafeIfaceArray<IMedium> hardDisks(m->allHardDisks.getList());
     hardDisks.detachTo(ComSafeArrayOutArg(aHardDisks));
@@ -1051,6 +1381,8 @@ STDMETHODIMP VirtualBox::COMGETTER(DVDImages)(ComSafeArrayOut(IMedium *, aDVDIma
     AutoCaller autoCaller(this);
     if (FAILED(autoCaller.rc())) return autoCaller.rc();
 
+    loadLazyMachines();
+
     AutoReadLock al(m->allDVDImages.getLockHandle() COMMA_LOCKVAL_SRC_POS);
     SafeIfaceArray<IMedium> images(m->allDVDImages.getList());
     images.detachTo(ComSafeArrayOutArg(aDVDImages));
@@ -1065,6 +1397,8 @@ STDMETHODIMP VirtualBox::COMGETTER(FloppyImages)(ComSafeArrayOut(IMedium *, aFlo
     AutoCaller autoCaller(this);
     if (FAILED(autoCaller.rc())) return autoCaller.rc();
 
+    loadLazyMachines();
+
     AutoReadLock al(m->allFloppyImages.getLockHandle() COMMA_LOCKVAL_SRC_POS);
     SafeIfaceArray<IMedium> images(m->allFloppyImages.getList());
     images.detachTo(ComSafeArrayOutArg(aFloppyImages));
@@ -1780,11 +2114,13 @@ STDMETHODIMP VirtualBox::FindMachine(IN_BSTR aNameOrId, IMachine **aMachine)
 
     Guid id(aNameOrId);
     if (!id.isEmpty())
+    {
         rc = findMachine(id,
                          true /* fPermitInaccessible */,
                          true /* setError */,
                          &pMachineFound);
                 // returns VBOX_E_OBJECT_NOT_FOUND if not found and sets error
+    }
     else
     {
         Utf8Str strName(aNameOrId);
@@ -1818,6 +2154,8 @@ STDMETHODIMP VirtualBox::GetMachinesByGroups(ComSafeArrayIn(IN_BSTR, aGroups), C
     /* we want to rely on sorted groups during compare, to save time */
     llGroups.sort();
 
+    loadLazyMachines();
+
     /* get copy of all machine references, to avoid holding the list lock */
     MachinesOList::MyList allMachines;
     {
@@ -1898,6 +2236,575 @@ STDMETHODIMP VirtualBox::GetMachineStates(ComSafeArrayIn(IMachine *, aMachines),
     return S_OK;
 }
 
+/**
+ * Machine attributes which can be queried with QueryMachinesInfo.
+ */
+enum MachineInfoAttr
+{
+    MachineInfoAttr_Invalid = 0,
+    MachineInfoAttr_Id,
+    MachineInfoAttr_Name,
+    MachineInfoAttr_Accessible,
+    MachineInfoAttr_SettingsFilePath,
+    MachineInfoAttr_Groups,
+    MachineInfoAttr_OSTypeId,
+    MachineInfoAttr_CPUCount,
+    MachineInfoAttr_MemorySize,
+    MachineInfoAttr_State,
+    MachineInfoAttr_SessionState,
+    MachineInfoAttr_LastStateChange,
+    MachineInfoAttr_SnapshotFolder,
+    MachineInfoAttr_LogFolder,
+    MachineInfoAttr_HardwareUUID,
+    MachineInfoAttr_VRAMSize,
+    MachineInfoAttr_CPUExecutionCap,
+    MachineInfoAttr_PageFusionEnabled,
+    MachineInfoAttr_HPETEnabled,
+    MachineInfoAttr_ChipsetType,
+    MachineInfoAttr_FirmwareType
+};
+
+static const struct
+{
+    const char      *pszName;
+    MachineInfoAttr  enmAttr;
+} g_aMachineInfoAttrs[] =
+{
+    { "id",                 MachineInfoAttr_Id },
+    { "name",               MachineInfoAttr_Name },
+    { "accessible",         MachineInfoAttr_Accessible },
+    { "settingsFilePath",   MachineInfoAttr_SettingsFilePath },
+    { "groups",             MachineInfoAttr_Groups },
+    { "OSTypeId",           MachineInfoAttr_OSTypeId },
+    { "CPUCount",           MachineInfoAttr_CPUCount },
+    { "memorySize",         MachineInfoAttr_MemorySize },
+    { "state",              MachineInfoAttr_State },
+    { "sessionState",       MachineInfoAttr_SessionState },
+    { "lastStateChange",    MachineInfoAttr_LastStateChange },
+    { "snapshotFolder",     MachineInfoAttr_SnapshotFolder },
+    { "logFolder",          MachineInfoAttr_LogFolder },
+    { "hardwareUUID",       MachineInfoAttr_HardwareUUID },
+    { "VRAMSize",           MachineInfoAttr_VRAMSize },
+    { "CPUExecutionCap",    MachineInfoAttr_CPUExecutionCap },
+    { "pageFusionEnabled",  MachineInfoAttr_PageFusionEnabled },
+    { "HPETEnabled",        MachineInfoAttr_HPETEnabled },
+    { "chipsetType",        MachineInfoAttr_ChipsetType },
+    { "firmwareType",       MachineInfoAttr_FirmwareType },
+};
+
+/**
+ * Formats one attribute of a machine for QueryMachinesInfo.
+ *
+ * @returns The value, empty if not available.
+ * @param   pMachine    The machine, caller must hold a reference.
+ * @param   enmAttr     The attribute.
+ *
+ * @note Locks the machine for reading, but not while calling its public getters.
+ */
+static Utf8Str getMachineInfoAttr(Machine *pMachine, MachineInfoAttr enmAttr)
+{
+    AutoReadLock mlock(pMachine COMMA_LOCKVAL_SRC_POS);
+    /* the public getters fail for inaccessible machines, so don't bother */
+    bool fAccessible = pMachine->isAccessible();
+    HRESULT rc = S_OK;
+    switch (enmAttr)
+    {
+        /* internal accessors, need the lock */
+        case MachineInfoAttr_Id:
+            return pMachine->getId().toString();
+        case MachineInfoAttr_Accessible:
+            return fAccessible ? "1" : "0";
+        case MachineInfoAttr_SettingsFilePath:
+            return pMachine->getSettingsFileFull();
+        case MachineInfoAttr_Name:
+            if (fAccessible)
+                return pMachine->getName();
+            break;
+        case MachineInfoAttr_Groups:
+            if (fAccessible)
+            {
+                Utf8Str strGroups;
+                const StringsList &llGroups = pMachine->getGroups();
+                for (StringsList::const_iterator it = llGroups.begin(); it != llGroups.end(); ++it)
+                {
+                    if (!strGroups.isEmpty())
+                        strGroups.append(',');
+                    strGroups.append(*it);
+                }
+                return strGroups;
+            }
+            break;
+        default:
+            break;
+    }
+    mlock.release();
+
+    switch (enmAttr)
+    {
+        /* public getters, do their own locking */
+        case MachineInfoAttr_OSTypeId:
+        case MachineInfoAttr_SnapshotFolder:
+        case MachineInfoAttr_LogFolder:
+        case MachineInfoAttr_HardwareUUID:
+            if (fAccessible)
+            {
+                Bstr bstrValue;
+                if (enmAttr == MachineInfoAttr_OSTypeId)
+                    rc = pMachine->COMGETTER(OSTypeId)(bstrValue.asOutParam());
+                else if (enmAttr == MachineInfoAttr_SnapshotFolder)
+                    rc = pMachine->COMGETTER(SnapshotFolder)(bstrValue.asOutParam());
+                else if (enmAttr == MachineInfoAttr_LogFolder)
+                    rc = pMachine->COMGETTER(LogFolder)(bstrValue.asOutParam());
+                else
+                    rc = pMachine->COMGETTER(HardwareUUID)(bstrValue.asOutParam());
+                if (SUCCEEDED(rc))
+                    return bstrValue;
+            }
+            break;
+        case MachineInfoAttr_CPUCount:
+        case MachineInfoAttr_MemorySize:
+        case MachineInfoAttr_VRAMSize:
+        case MachineInfoAttr_CPUExecutionCap:
+            if (fAccessible)
+            {
+                ULONG uValue;
+                if (enmAttr == MachineInfoAttr_CPUCount)
+                    rc = pMachine->COMGETTER(CPUCount)(&uValue);
+                else if (enmAttr == MachineInfoAttr_MemorySize)
+                    rc = pMachine->COMGETTER(MemorySize)(&uValue);
+                else if (enmAttr == MachineInfoAttr_VRAMSize)
+                    rc = pMachine->COMGETTER(VRAMSize)(&uValue);
+                else
+                    rc = pMachine->COMGETTER(CPUExecutionCap)(&uValue);
+                if (SUCCEEDED(rc))
+                    return Utf8StrFmt("%u", uValue);
+            }
+            break;
+        case MachineInfoAttr_PageFusionEnabled:
+        case MachineInfoAttr_HPETEnabled:
+            if (fAccessible)
+            {
+                BOOL fValue;
+                if (enmAttr == MachineInfoAttr_PageFusionEnabled)
+                    rc = pMachine->COMGETTER(PageFusionEnabled)(&fValue);
+                else
+                    rc = pMachine->COMGETTER(HPETEnabled)(&fValue);
+                if (SUCCEEDED(rc))
+                    return fValue ? "1" : "0";
+            }
+            break;
+        case MachineInfoAttr_ChipsetType:
+            if (fAccessible)
+            {
+                ChipsetType_T enmType;
+                rc = pMachine->COMGETTER(ChipsetType)(&enmType);
+                if (SUCCEEDED(rc))
+                    return Utf8StrFmt("%d", enmType);
+            }
+            break;
+        case MachineInfoAttr_FirmwareType:
+            if (fAccessible)
+            {
+                FirmwareType_T enmType;
+                rc = pMachine->COMGETTER(FirmwareType)(&enmType);
+                if (SUCCEEDED(rc))
+                    return Utf8StrFmt("%d", enmType);
+            }
+            break;
+        case MachineInfoAttr_State:
+        {
+            MachineState_T enmState;
+            rc = pMachine->COMGETTER(State)(&enmState);
+            if (SUCCEEDED(rc))
+                return Utf8StrFmt("%d", enmState);
+            break;
+        }
+        case MachineInfoAttr_SessionState:
+        {
+            SessionState_T enmState;
+            rc = pMachine->COMGETTER(SessionState)(&enmState);
+            if (SUCCEEDED(rc))
+                return Utf8StrFmt("%d", enmState);
+            break;
+        }
+        case MachineInfoAttr_LastStateChange:
+        {
+            LONG64 i64Value;
+            rc = pMachine->COMGETTER(LastStateChange)(&i64Value);
+            if (SUCCEEDED(rc))
+                return Utf8StrFmt("%lld", i64Value);
+            break;
+        }
+        default:
+            break;
+    }
+    return Utf8Str::Empty;
+}
+
+/**
+ * Translates the attribute names passed to QueryMachinesInfo and QueryMachineInfo.
+ *
+ * @returns NULL on success, otherwise the first unknown attribute name.
+ * @param   saAttributes    The attribute names.
+ * @param   vecAttrs        Where to return the attributes.
+ */
+static const IN_BSTR *parseMachineInfoAttrs(const com::SafeArray<IN_BSTR> &saAttributes,
+                                            std::vector<MachineInfoAttr> &vecAttrs)
+{
+    for (size_t i = 0; i < saAttributes.size(); ++i)
+    {
+        Utf8Str strAttr(saAttributes[i]);
+        MachineInfoAttr enmAttr = MachineInfoAttr_Invalid;
+        for (size_t j = 0; j < RT_ELEMENTS(g_aMachineInfoAttrs); ++j)
+            if (strAttr == g_aMachineInfoAttrs[j].pszName)
+            {
+                enmAttr = g_aMachineInfoAttrs[j].enmAttr;
+                break;
+            }
+        if (enmAttr == MachineInfoAttr_Invalid)
+            return &saAttributes[i];
+        vecAttrs.push_back(enmAttr);
+    }
+    return NULL;
+}
+
+/**
+ * Formats one row of QueryMachinesInfo / QueryMachineInfo values.
+ *
+ * @param   pMachine    The machine, caller must hold a reference.
+ * @param   vecAttrs    The attributes to return.
+ * @param   paValues    Where to store the values, vecAttrs.size() entries.
+ */
+static void getMachineInfoRow(Machine *pMachine, const std::vector<MachineInfoAttr> &vecAttrs, BSTR *paValues)
+{
+    /* inaccessible machines are in the limited state, they still have
+     * their id and settings file path */
+    AutoLimitedCaller autoMachineCaller(pMachine);
+    if (FAILED(autoMachineCaller.rc()))
+    {
+        /* uninitialized meanwhile, leave the row empty */
+        for (size_t i = 0; i < vecAttrs.size(); ++i)
+            Bstr().detachTo(&paValues[i]);
+        return;
+    }
+    for (size_t i = 0; i < vecAttrs.size(); ++i)
+        Bstr(getMachineInfoAttr(pMachine, vecAttrs[i])).detachTo(&paValues[i]);
+}
+
+STDMETHODIMP VirtualBox::QueryMachinesInfo(ComSafeArrayIn(IN_BSTR, aAttributes), ULONG aFirst, ULONG aCount,
+                                           ULONG aGeneration, ComSafeArrayOut(IMachine *, aMachines),
+                                           ULONG *aCurrentGeneration, ComSafeArrayOut(BSTR, aValues))
+{
+    CheckComArgSafeArrayNotNull(aAttributes);
+    CheckComArgOutSafeArrayPointerValid(aMachines);
+    CheckComArgOutPointerValid(aCurrentGeneration);
+    CheckComArgOutSafeArrayPointerValid(aValues);
+
+    AutoCaller autoCaller(this);
+    if (FAILED(autoCaller.rc())) return autoCaller.rc();
+
+    com::SafeArray<IN_BSTR> saAttributes(ComSafeArrayInArg(aAttributes));
+    std::vector<MachineInfoAttr> vecAttrs;
+    const IN_BSTR *pbstrBadAttr = parseMachineInfoAttrs(saAttributes, vecAttrs);
+    if (pbstrBadAttr)
+        return setError(E_INVALIDARG,
+                        tr("Unknown machine attribute '%ls'"),
+                        *pbstrBadAttr);
+
+    loadLazyMachines();
+
+    /* get copy of the requested machine references, to avoid holding the list
+     * lock, and check that the list didn't change since the previous page */
+    MachinesOList::MyList llMachines;
+    {
+        AutoReadLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
+        if (aGeneration != 0 && aGeneration != m->uMachinesGeneration)
+            return setError(VBOX_E_INVALID_OBJECT_STATE,
+                            tr("The list of registered machines has changed, start over with generation 0"));
+        *aCurrentGeneration = m->uMachinesGeneration;
+
+        const MachinesOList::MyList &allMachines = m->allMachines.getList();
+        MachinesOList::MyList::const_iterator it = allMachines.begin();
+        for (ULONG i = 0; i < aFirst && it != allMachines.end(); ++i)
+            ++it;
+        for (ULONG i = 0; (aCount == 0 || i < aCount) && it != allMachines.end(); ++i, ++it)
+            llMachines.push_back(*it);
+    }
+
+    com::SafeIfaceArray<IMachine> saMachines(llMachines.size());
+    com::SafeArray<BSTR> saValues(llMachines.size() * vecAttrs.size());
+    size_t iMachine = 0;
+    for (MachinesOList::MyList::const_iterator it = llMachines.begin();
+         it != llMachines.end();
+         ++it, ++iMachine)
+    {
+        const ComObjPtr<Machine> &pMachine = *it;
+        pMachine.queryInterfaceTo(&saMachines[iMachine]);
+        if (!vecAttrs.empty())
+            getMachineInfoRow(pMachine, vecAttrs, &saValues[iMachine * vecAttrs.size()]);
+    }
+
+    saMachines.detachTo(ComSafeArrayOutArg(aMachines));
+    saValues.detachTo(ComSafeArrayOutArg(aValues));
+
+    return S_OK;
+}
+
+STDMETHODIMP VirtualBox::QueryMachineInfo(IMachine *aMachine, ComSafeArrayIn(IN_BSTR, aAttributes),
+                                          ComSafeArrayOut(BSTR, aValues))
+{
+    CheckComArgNotNull(aMachine);
+    CheckComArgSafeArrayNotNull(aAttributes);
+    CheckComArgOutSafeArrayPointerValid(aValues);
+
+    AutoCaller autoCaller(this);
+    if (FAILED(autoCaller.rc())) return autoCaller.rc();
+
+    com::SafeArray<IN_BSTR> saAttributes(ComSafeArrayInArg(aAttributes));
+    std::vector<MachineInfoAttr> vecAttrs;
+    const IN_BSTR *pbstrBadAttr = parseMachineInfoAttrs(saAttributes, vecAttrs);
+    if (pbstrBadAttr)
+        return setError(E_INVALIDARG,
+                        tr("Unknown machine attribute '%ls'"),
+                        *pbstrBadAttr);
+
+    ComObjPtr<Machine> pMachine = static_cast<Machine *>(aMachine);
+
+    com::SafeArray<BSTR> saValues(vecAttrs.size());
+    getMachineInfoRow(pMachine, vecAttrs, saValues.raw());
+    saValues.detachTo(ComSafeArrayOutArg(aValues));
+
+    return S_OK;
+}
+
+/**
+ * Medium attributes which can be queried with QueryMediaInfo.
+ */
+enum MediumInfoAttr
+{
+    MediumInfoAttr_Invalid = 0,
+    MediumInfoAttr_Id,
+    MediumInfoAttr_ParentId,
+    MediumInfoAttr_Format,
+    MediumInfoAttr_Location,
+    MediumInfoAttr_State,
+    MediumInfoAttr_Type,
+    MediumInfoAttr_MachineIds,
+    MediumInfoAttr_SnapshotIds
+};
+
+static const struct
+{
+    const char      *pszName;
+    MediumInfoAttr   enmAttr;
+} g_aMediumInfoAttrs[] =
+{
+    { "id",                 MediumInfoAttr_Id },
+    { "parentId",           MediumInfoAttr_ParentId },
+    { "format",             MediumInfoAttr_Format },
+    { "location",           MediumInfoAttr_Location },
+    { "state",              MediumInfoAttr_State },
+    { "type",               MediumInfoAttr_Type },
+    { "machineIds",         MediumInfoAttr_MachineIds },
+    { "snapshotIds",        MediumInfoAttr_SnapshotIds },
+};
+
+/**
+ * Joins a string array, used for the list attributes of QueryMediaInfo.
+ */
+static void joinMediumInfoList(Utf8Str &strDst, const com::SafeArray<BSTR> &saValues)
+{
+    for (size_t i = 0; i < saValues.size(); ++i)
+    {
+        if (i != 0)
+            strDst.append(',');
+        strDst.append(Utf8Str(saValues[i]));
+    }
+}
+
+/**
+ * Formats one attribute of a medium for QueryMediaInfo.
+ *
+ * @returns The value, empty if not available.
+ * @param   pMedium     The medium, caller must hold a reference.
+ * @param   enmAttr     The attribute.
+ *
+ * @note Uses the public getters which do their own locking, so the caller
+ *       must not hold the media tree lock.
+ */
+static Utf8Str getMediumInfoAttr(Medium *pMedium, MediumInfoAttr enmAttr)
+{
+    HRESULT rc = S_OK;
+    switch (enmAttr)
+    {
+        case MediumInfoAttr_Id:
+        case MediumInfoAttr_Format:
+        case MediumInfoAttr_Location:
+        {
+            Bstr bstrValue;
+            if (enmAttr == MediumInfoAttr_Id)
+                rc = pMedium->COMGETTER(Id)(bstrValue.asOutParam());
+            else if (enmAttr == MediumInfoAttr_Format)
+                rc = pMedium->COMGETTER(Format)(bstrValue.asOutParam());
+            else
+                rc = pMedium->COMGETTER(Location)(bstrValue.asOutParam());
+            if (SUCCEEDED(rc))
+                return bstrValue;
+            break;
+        }
+        case MediumInfoAttr_ParentId:
+        {
+            ComPtr<IMedium> pParent;
+            rc = pMedium->COMGETTER(Parent)(pParent.asOutParam());
+            if (SUCCEEDED(rc) && !pParent.isNull())
+            {
+                Bstr bstrValue;
+                rc = pParent->COMGETTER(Id)(bstrValue.asOutParam());
+                if (SUCCEEDED(rc))
+                    return bstrValue;
+            }
+            break;
+        }
+        case MediumInfoAttr_State:
+        {
+            MediumState_T enmState;
+            rc = pMedium->RefreshState(&enmState);
+            if (SUCCEEDED(rc))
+                return Utf8StrFmt("%d", enmState);
+            break;
+        }
+        case MediumInfoAttr_Type:
+        {
+            MediumType_T enmType;
+            rc = pMedium->COMGETTER(Type)(&enmType);
+            if (SUCCEEDED(rc))
+                return Utf8StrFmt("%d", enmType);
+            break;
+        }
+        case MediumInfoAttr_MachineIds:
+        case MediumInfoAttr_SnapshotIds:
+        {
+            com::SafeArray<BSTR> saMachineIds;
+            rc = pMedium->COMGETTER(MachineIds)(ComSafeArrayAsOutParam(saMachineIds));
+            if (FAILED(rc))
+                break;
+            Utf8Str strValue;
+            if (enmAttr == MediumInfoAttr_MachineIds)
+                joinMediumInfoList(strValue, saMachineIds);
+            else
+                for (size_t i = 0; i < saMachineIds.size(); ++i)
+                {
+                    if (i != 0)
+                        strValue.append(';');
+                    com::SafeArray<BSTR> saSnapshotIds;
+                    rc = pMedium->GetSnapshotIds(saMachineIds[i], ComSafeArrayAsOutParam(saSnapshotIds));
+                    if (SUCCEEDED(rc))
+                        joinMediumInfoList(strValue, saSnapshotIds);
+                }
+            return strValue;
+        }
+        default:
+            break;
+    }
+    return Utf8Str::Empty;
+}
+
+/**
+ * Appends a list of media and all their children to a list, depth first.
+ *
+ * @param   llMedia     The media to add.
+ * @param   llDst       The list to append to.
+ *
+ * @note Caller must hold the media tree lock.
+ */
+static void collectMediaTree(const MediaList &llMedia, MediaList &llDst)
+{
+    for (MediaList::const_iterator it = llMedia.begin();
+         it != llMedia.end();
+         ++it)
+    {
+        llDst.push_back(*it);
+        collectMediaTree((*it)->getChildren(), llDst);
+    }
+}
+
+STDMETHODIMP VirtualBox::QueryMediaInfo(DeviceType_T aDeviceType, ComSafeArrayIn(IN_BSTR, aAttributes),
+                                        ComSafeArrayOut(IMedium *, aMedia), ComSafeArrayOut(BSTR, aValues))
+{
+    CheckComArgSafeArrayNotNull(aAttributes);
+    CheckComArgOutSafeArrayPointerValid(aMedia);
+    CheckComArgOutSafeArrayPointerValid(aValues);
+
+    AutoCaller autoCaller(this);
+    if (FAILED(autoCaller.rc())) return autoCaller.rc();
+
+    MediaOList *pMediaList;
+    switch (aDeviceType)
+    {
+        case DeviceType_HardDisk:
+            pMediaList = &m->allHardDisks;
+            break;
+        case DeviceType_DVD:
+            pMediaList = &m->allDVDImages;
+            break;
+        case DeviceType_Floppy:
+            pMediaList = &m->allFloppyImages;
+            break;
+        default:
+            return setError(E_INVALIDARG,
+                            tr("Invalid device type %d"),
+                            aDeviceType);
+    }
+
+    com::SafeArray<IN_BSTR> saAttributes(ComSafeArrayInArg(aAttributes));
+    std::vector<MediumInfoAttr> vecAttrs;
+    for (size_t i = 0; i < saAttributes.size(); ++i)
+    {
+        Utf8Str strAttr(saAttributes[i]);
+        MediumInfoAttr enmAttr = MediumInfoAttr_Invalid;
+        for (size_t j = 0; j < RT_ELEMENTS(g_aMediumInfoAttrs); ++j)
+            if (strAttr == g_aMediumInfoAttrs[j].pszName)
+            {
+                enmAttr = g_aMediumInfoAttrs[j].enmAttr;
+                break;
+            }
+        if (enmAttr == MediumInfoAttr_Invalid)
+            return setError(E_INVALIDARG,
+                            tr("Unknown medium attribute '%s'"),
+                            strAttr.c_str());
+        vecAttrs.push_back(enmAttr);
+    }
+
+    loadLazyMachines();
+
+    /* take a consistent snapshot of the media trees, the attributes are
+     * fetched afterwards as they need the medium locks and may do I/O */
+    MediaList llMedia;
+    {
+        AutoReadLock treeLock(getMediaTreeLockHandle() COMMA_LOCKVAL_SRC_POS);
+        collectMediaTree(pMediaList->getList(), llMedia);
+    }
+
+    com::SafeIfaceArray<IMedium> saMedia(llMedia.size());
+    com::SafeArray<BSTR> saValues(llMedia.size() * vecAttrs.size());
+    size_t iMedium = 0;
+    size_t iValue = 0;
+    for (MediaList::const_iterator it = llMedia.begin();
+         it != llMedia.end();
+         ++it, ++iMedium)
+    {
+        const ComObjPtr<Medium> &pMedium = *it;
+        pMedium.queryInterfaceTo(&saMedia[iMedium]);
+        for (size_t i = 0; i < vecAttrs.size(); ++i, ++iValue)
+            Bstr(getMediumInfoAttr(pMedium, vecAttrs[i])).detachTo(&saValues[iValue]);
+    }
+
+    saMedia.detachTo(ComSafeArrayOutArg(aMedia));
+    saValues.detachTo(ComSafeArrayOutArg(aValues));
+
+    return S_OK;
+}
+
 STDMETHODIMP VirtualBox::CreateHardDisk(IN_BSTR aFormat,
                                         IN_BSTR aLocation,
                                         IMedium **aHardDisk)
@@ -1907,6 +2814,9 @@ STDMETHODIMP VirtualBox::CreateHardDisk(IN_BSTR aFormat,
     AutoCaller autoCaller(this);
     if (FAILED(autoCaller.rc())) return autoCaller.rc();
 
+    /* the new medium is checked against all known media */
+    loadLazyMachines();
+
     /* we don't access non-const data members so no need to lock */
 
     Utf8Str format(aFormat);
@@ -1942,6 +2852,9 @@ STDMETHODIMP VirtualBox::OpenMedium(IN_BSTR aLocation,
     Guid id(aLocation);
     ComObjPtr<Medium> pMedium;
 
+    // media from the registries of machines not loaded yet are unknown
+    loadLazyMachines();
+
     // have to get write lock as the whole find/update sequence must be done
     // in one critical section, otherwise there are races which can lead to
     // multiple Medium objects with the same content
@@ -2186,9 +3099,10 @@ STDMETHODIMP VirtualBox::SetExtraData(IN_BSTR aKey,
             m->pMainConfigFile->mapExtraDataItems[strKey] = strValue;
                 // creates a new key if needed
 
-        /* save settings on success */
-        HRESULT rc = saveSettings();
-        if (FAILED(rc)) return rc;
+        /* save settings a little later, together with further changes */
+        m->fGlobalSettingsWritePending = true;
+        alock.release();
+        scheduleSettingsWrite(NULL);
     }
 
     // fire notification outside the lock
@@ -3174,6 +4088,11 @@ void VirtualBox::getOpenedMachines(SessionMachinesList &aMachines,
  * @param aSetError If true, set errorinfo if the machine is not found.
  * @param aMachine Returned machine, if found.
  * @return
+ *
+ * @note A machine which is still pending lazy initialization is loaded (see
+ *       loadLazyMachine()).  Machines which aren't loaded yet can't be in the
+ *       media registries of known media, so this never happens for lookups
+ *       done while holding the media tree lock.
  */
 HRESULT VirtualBox::findMachine(const Guid &aId,
                                 bool fPermitInaccessible,
@@ -3185,30 +4104,32 @@ HRESULT VirtualBox::findMachine(const Guid &aId,
     AutoCaller autoCaller(this);
     AssertComRCReturn(autoCaller.rc(), autoCaller.rc());
 
+    ComObjPtr<Machine> pMachine;
     {
         AutoReadLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
 
-        for (MachinesOList::iterator it = m->allMachines.begin();
-             it != m->allMachines.end();
-             ++it)
-        {
-            ComObjPtr<Machine> pMachine = *it;
+        MachinesMap::const_iterator it = m->mapMachines.find(aId);
+        if (it != m->mapMachines.end())
+            pMachine = it->second;
+    }
 
-            if (!fPermitInaccessible)
-            {
-                // skip inaccessible machines
-                AutoCaller machCaller(pMachine);
-                if (FAILED(machCaller.rc()))
-                    continue;
-            }
+    if (!pMachine.isNull())
+    {
+        loadLazyMachine(pMachine);
 
-            if (pMachine->getId() == aId)
-            {
-                rc = S_OK;
-                if (aMachine)
-                    *aMachine = pMachine;
-                break;
-            }
+        bool fFound = true;
+        if (!fPermitInaccessible)
+        {
+            // skip inaccessible machines
+            AutoCaller machCaller(pMachine);
+            fFound = SUCCEEDED(machCaller.rc());
+        }
+
+        if (fFound)
+        {
+            rc = S_OK;
+            if (aMachine)
+                *aMachine = pMachine;
         }
     }
 
@@ -3228,12 +4149,18 @@ HRESULT VirtualBox::findMachine(const Guid &aId,
  * @param aSetError If true, set errorinfo if the machine is not found.
  * @param aMachine Returned machine, if found.
  * @return
+ *
+ * @note Loads all machines still pending lazy initialization first, since
+ *       their names are unknown.  The caller must not hold the machines list
+ *       or media tree locks.
  */
 HRESULT VirtualBox::findMachineByName(const Utf8Str &aName, bool aSetError,
                                       ComObjPtr<Machine> *aMachine /* = NULL */)
 {
     HRESULT rc = VBOX_E_OBJECT_NOT_FOUND;
 
+    loadLazyMachines();
+
     AutoReadLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
     for (MachinesOList::iterator it = m->allMachines.begin();
          it != m->allMachines.end();
@@ -3452,24 +4379,17 @@ HRESULT VirtualBox::findHardDiskByLocation(const Utf8Str &strLocation,
     // hard disk _list_ lock handle
     AutoReadLock alock(m->allHardDisks.getLockHandle() COMMA_LOCKVAL_SRC_POS);
 
-    for (HardDiskMap::const_iterator it = m->mapHardDisks.begin();
-         it != m->mapHardDisks.end();
-         ++it)
+    MediaLocationMap::const_iterator it = m->mapHardDiskLocations.find(getMediumLocationKey(strLocation));
+    if (it != m->mapHardDiskLocations.end())
     {
         const ComObjPtr<Medium> &pHD = (*it).second;
 
         AutoCaller autoCaller(pHD);
         if (FAILED(autoCaller.rc())) return autoCaller.rc();
-        AutoWriteLock mlock(pHD COMMA_LOCKVAL_SRC_POS);
-
-        Utf8Str strLocationFull = pHD->getLocationFull();
 
-        if (0 == RTPathCompare(strLocationFull.c_str(), strLocation.c_str()))
-        {
-            if (aHardDisk)
-                *aHardDisk = pHD;
-            return S_OK;
-        }
+        if (aHardDisk)
+            *aHardDisk = pHD;
+        return S_OK;
     }
 
     if (aSetError)
@@ -3517,15 +4437,21 @@ HRESULT VirtualBox::findDVDOrFloppyImage(DeviceType_T mediumType,
     }
 
     MediaOList *pMediaList;
+    HardDiskMap *pMediaMap;
+    MediaLocationMap *pLocationMap;
 
     switch (mediumType)
     {
         case DeviceType_DVD:
             pMediaList = &m->allDVDImages;
+            pMediaMap = &m->mapDVDImages;
+            pLocationMap = &m->mapDVDImageLocations;
         break;
 
         case DeviceType_Floppy:
             pMediaList = &m->allFloppyImages;
+            pMediaMap = &m->mapFloppyImages;
+            pLocationMap = &m->mapFloppyImageLocations;
         break;
 
         default:
@@ -3536,36 +4462,39 @@ HRESULT VirtualBox::findDVDOrFloppyImage(DeviceType_T mediumType,
 
     bool found = false;
 
-    for (MediaList::const_iterator it = pMediaList->begin();
-         it != pMediaList->end();
-         ++it)
+    // no AutoCaller, registered image life time is bound to this
+    Medium *pMedium = NULL;
+    if (aId)
+    {
+        HardDiskMap::const_iterator it = pMediaMap->find(*aId);
+        if (it != pMediaMap->end())
+            pMedium = it->second;
+    }
+    if (!pMedium && !aLocation.isEmpty())
+    {
+        MediaLocationMap::const_iterator it = pLocationMap->find(getMediumLocationKey(location));
+        if (it != pLocationMap->end())
+            pMedium = it->second;
+    }
+
+    if (pMedium)
     {
-        // no AutoCaller, registered image life time is bound to this
-        Medium *pMedium = *it;
         AutoReadLock imageLock(pMedium COMMA_LOCKVAL_SRC_POS);
         const Utf8Str &strLocationFull = pMedium->getLocationFull();
 
-        found =     (    aId
-                      && pMedium->getId() == *aId)
-                 || (    !aLocation.isEmpty()
-                      && RTPathCompare(location.c_str(),
-                                       strLocationFull.c_str()) == 0);
-        if (found)
+        if (pMedium->getDeviceType() != mediumType)
         {
-            if (pMedium->getDeviceType() != mediumType)
-            {
-                if (mediumType == DeviceType_DVD)
-                    return setError(E_INVALIDARG,
-                                    "Cannot mount DVD medium '%s' as floppy", strLocationFull.c_str());
-                else
-                    return setError(E_INVALIDARG,
-                                    "Cannot mount floppy medium '%s' as DVD", strLocationFull.c_str());
-            }
-
-            if (aImage)
-                *aImage = pMedium;
-            break;
+            if (mediumType == DeviceType_DVD)
+                return setError(E_INVALIDARG,
+                                "Cannot mount DVD medium '%s' as floppy", strLocationFull.c_str());
+            else
+                return setError(E_INVALIDARG,
+                                "Cannot mount floppy medium '%s' as DVD", strLocationFull.c_str());
         }
+
+        found = true;
+        if (aImage)
+            *aImage = pMedium;
     }
 
     HRESULT rc = found ? S_OK : VBOX_E_OBJECT_NOT_FOUND;
@@ -4037,6 +4966,13 @@ void VirtualBox::saveMediaRegistry(settings::MediaRegistry &mediaRegistry,
                  ++it2)
             {
                 const Data::PendingMachineRename &pmr = *it2;
+                Utf8Str strLocationOld;
+                DeviceType_T devType;
+                {
+                    AutoReadLock mlock(pMedium COMMA_LOCKVAL_SRC_POS);
+                    strLocationOld = pMedium->getLocationFull();
+                    devType = pMedium->getDeviceType();
+                }
                 HRESULT rc = pMedium->updatePath(pmr.strConfigDirOld,
                                                  pmr.strConfigDirNew);
                 if (SUCCEEDED(rc))
@@ -4044,6 +4980,14 @@ void VirtualBox::saveMediaRegistry(settings::MediaRegistry &mediaRegistry,
                     // Remember which medium objects has been changed,
                     // to trigger saving their registries later.
                     pDesc->llMedia.push_back(pMedium);
+
+                    // and move it to the new key in the location map
+                    MediaLocationMap *pLocationMap =   devType == DeviceType_HardDisk ? &m->mapHardDiskLocations
+                                                     : devType == DeviceType_DVD      ? &m->mapDVDImageLocations
+                                                     :                                  &m->mapFloppyImageLocations;
+                    pLocationMap->erase(getMediumLocationKey(strLocationOld));
+                    AutoReadLock mlock(pMedium COMMA_LOCKVAL_SRC_POS);
+                    (*pLocationMap)[getMediumLocationKey(pMedium->getLocationFull())] = pMedium;
                 } else if (rc == VBOX_E_FILE_ERROR)
                     /* nothing */;
                 else
@@ -4125,11 +5069,14 @@ void VirtualBox::saveMediaRegistry(settings::MediaRegistry &mediaRegistry,
  *  Gets called from the public VirtualBox::SaveSettings() as well as from various other
  *  places internally when settings need saving.
  *
+ *  @param fFlushTmpDir  Whether to flush the directory when closing the temporary
+ *    file, see xml::XmlFileWriter::write().
+ *
  *  @note Caller must have locked the VirtualBox object for writing and must not hold any
  *    other locks since this locks all kinds of member objects and trees temporarily,
  *    which could cause conflicts.
  */
-HRESULT VirtualBox::saveSettings()
+HRESULT VirtualBox::saveSettings(bool fFlushTmpDir /* = true */)
 {
     AutoCaller autoCaller(this);
     AssertComRCReturn(autoCaller.rc(), autoCaller.rc());
@@ -4185,7 +5132,8 @@ HRESULT VirtualBox::saveSettings()
         if (FAILED(rc)) throw rc;
 
         // and write out the XML, still under the lock
-        m->pMainConfigFile->write(m->strSettingsFilePath);
+        m->pMainConfigFile->write(m->strSettingsFilePath, fFlushTmpDir);
+        m->fGlobalSettingsWritePending = false;
     }
     catch (HRESULT err)
     {
@@ -4200,6 +5148,86 @@ HRESULT VirtualBox::saveSettings()
     return rc;
 }
 
+/**
+ * Schedules a delayed write of the settings of the given machine, or of the
+ * global settings if @a aMachine is NULL.
+ *
+ * This is used for changes which only touch the settings structures (like
+ * extra data) and may come in bursts: a script setting many extra data items
+ * should not cause a full settings file write each time.  The settings
+ * writer thread waits VBOX_SETTINGS_WRITE_DELAY_MS for more changes and then
+ * writes each affected file once.  The caller must have set the respective
+ * pending flag (Machine::Data::mSettingsWritePending or
+ * fGlobalSettingsWritePending).  Regular settings saves clear the flag, and
+ * unlocking or unregistering a machine as well as VirtualBox::uninit() write
+ * pending changes right away.
+ *
+ * @param aMachine      The machine whose settings changed, NULL for the
+ *                      global settings.
+ *
+ * @note Locks the list of pending writes, the caller must not hold any
+ *       object locks.
+ */
+void VirtualBox::scheduleSettingsWrite(Machine *aMachine)
+{
+    {
+        /* the lock also keeps uninit() from destroying the semaphore under
+         * our feet */
+        AutoWriteLock alock(m->lockPendingSettingsWrites COMMA_LOCKVAL_SRC_POS);
+        if (aMachine)
+            m->mapPendingSettingsWrites[aMachine->getId()] = aMachine;
+
+        if (m->hEvtSettingsWriter != NIL_RTSEMEVENT)
+        {
+            RTSemEventSignal(m->hEvtSettingsWriter);
+            return;
+        }
+    }
+
+    /* no writer thread (anymore), write right away */
+    savePendingSettingsWrites();
+}
+
+/**
+ * Does the settings writes scheduled by scheduleSettingsWrite().
+ *
+ * @note Locks the list of pending writes, this object and the machines for
+ *       writing, the caller must not hold any locks.
+ */
+void VirtualBox::savePendingSettingsWrites()
+{
+    MachinesMap mapMachines;
+    {
+        AutoWriteLock alock(m->lockPendingSettingsWrites COMMA_LOCKVAL_SRC_POS);
+        mapMachines.swap(m->mapPendingSettingsWrites);
+    }
+
+    for (MachinesMap::iterator it = mapMachines.begin();
+         it != mapMachines.end();
+         ++it)
+    {
+        // errors are set on the machine, there is nobody to report them to
+        HRESULT rc = it->second->savePendingSettings();
+        if (FAILED(rc))
+            LogRel(("Failed to write the settings of machine {%RTuuid}, rc=%Rhrc\n", it->first.raw(), rc));
+    }
+
+    AutoCaller autoCaller(this);
+    if (SUCCEEDED(autoCaller.rc()))
+    {
+        AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
+        if (m->fGlobalSettingsWritePending)
+        {
+            // on failure the changes stay pending for the next saveSettings();
+            // the directory is flushed after the rename anyway, skip the extra
+            // sync for these frequent writes
+            HRESULT rc = saveSettings(false /* fFlushTmpDir */);
+            if (FAILED(rc))
+                LogRel(("Failed to write the global settings to '%s', rc=%Rhrc\n", m->strSettingsFilePath.c_str(), rc));
+        }
+    }
+}
+
 /**
  *  Helper to register the machine.
  *
@@ -4255,7 +5283,13 @@ HRESULT VirtualBox::registerMachine(Machine *aMachine)
     }
 
     /* add to the collection of registered machines */
-    m->allMachines.addChild(aMachine);
+    {
+        AutoWriteLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
+        m->allMachines.getList().push_back(aMachine);
+        m->mapMachines[aMachine->getId()] = aMachine;
+        if (++m->uMachinesGeneration == 0)
+            m->uMachinesGeneration = 1;
+    }
 
     if (autoCaller.state() != InInit)
         rc = saveSettings();
@@ -4292,19 +5326,27 @@ HRESULT VirtualBox::registerMedium(const ComObjPtr<Medium> &pMedium,
 
     const char *pszDevType = NULL;
     ObjectsList<Medium> *pall = NULL;
+    HardDiskMap *pMediaMap = NULL;
+    MediaLocationMap *pLocationMap = NULL;
     switch (argType)
     {
         case DeviceType_HardDisk:
             pall = &m->allHardDisks;
+            pMediaMap = &m->mapHardDisks;
+            pLocationMap = &m->mapHardDiskLocations;
             pszDevType = tr("hard disk");
             break;
         case DeviceType_DVD:
             pszDevType = tr("DVD image");
             pall = &m->allDVDImages;
+            pMediaMap = &m->mapDVDImages;
+            pLocationMap = &m->mapDVDImageLocations;
             break;
         case DeviceType_Floppy:
             pszDevType = tr("floppy image");
             pall = &m->allFloppyImages;
+            pMediaMap = &m->mapFloppyImages;
+            pLocationMap = &m->mapFloppyImageLocations;
             break;
         default:
             AssertMsgFailedReturn(("invalid device type %d", argType), E_INVALIDARG);
@@ -4348,9 +5390,9 @@ HRESULT VirtualBox::registerMedium(const ComObjPtr<Medium> &pMedium,
         if (pParent.isNull())
             pall->getList().push_back(pMedium);
 
-        // store all hard disks (even differencing images) in the map
-        if (argType == DeviceType_HardDisk)
-            m->mapHardDisks[id] = pMedium;
+        // store all media (even differencing images) in the maps
+        (*pMediaMap)[id] = pMedium;
+        (*pLocationMap)[getMediumLocationKey(strLocationFull)] = pMedium;
 
         *ppMedium = pMedium;
     }
@@ -4388,26 +5430,36 @@ HRESULT VirtualBox::unregisterMedium(Medium *pMedium)
     Assert(getMediaTreeLockHandle().isWriteLockOnCurrentThread());
 
     Guid id;
+    Utf8Str strLocationFull;
     ComObjPtr<Medium> pParent;
     DeviceType_T devType;
     {
         AutoReadLock mediumLock(pMedium COMMA_LOCKVAL_SRC_POS);
         id = pMedium->getId();
+        strLocationFull = pMedium->getLocationFull();
         pParent = pMedium->getParent();
         devType = pMedium->getDeviceType();
     }
 
     ObjectsList<Medium> *pall = NULL;
+    HardDiskMap *pMediaMap = NULL;
+    MediaLocationMap *pLocationMap = NULL;
     switch (devType)
     {
         case DeviceType_HardDisk:
             pall = &m->allHardDisks;
+            pMediaMap = &m->mapHardDisks;
+            pLocationMap = &m->mapHardDiskLocations;
             break;
         case DeviceType_DVD:
             pall = &m->allDVDImages;
+            pMediaMap = &m->mapDVDImages;
+            pLocationMap = &m->mapDVDImageLocations;
             break;
         case DeviceType_Floppy:
             pall = &m->allFloppyImages;
+            pMediaMap = &m->mapFloppyImages;
+            pLocationMap = &m->mapFloppyImageLocations;
             break;
         default:
             AssertMsgFailedReturn(("invalid device type %d", devType), E_INVALIDARG);
@@ -4417,13 +5469,16 @@ HRESULT VirtualBox::unregisterMedium(Medium *pMedium)
     if (pParent.isNull())
         pall->getList().remove(pMedium);
 
-    // remove all hard disks (even differencing images) from map
-    if (devType == DeviceType_HardDisk)
-    {
-        size_t cnt = m->mapHardDisks.erase(id);
-        Assert(cnt == 1);
-        NOREF(cnt);
-    }
+    // remove all media (even differencing images) from the maps
+    size_t cnt = pMediaMap->erase(id);
+    Assert(cnt == 1);
+    NOREF(cnt);
+
+    MediaLocationMap::iterator it = pLocationMap->find(getMediumLocationKey(strLocationFull));
+    if (it != pLocationMap->end() && it->second == pMedium)
+        pLocationMap->erase(it);
+    else
+        AssertMsgFailed(("Medium '%s' missing in the location map\n", strLocationFull.c_str()));
 
     return S_OK;
 }
@@ -4518,7 +5573,13 @@ HRESULT VirtualBox::unregisterMachine(Machine *pMachine,
 {
     // remove from the collection of registered machines
     AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
-    m->allMachines.removeChild(pMachine);
+    {
+        AutoWriteLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
+        m->allMachines.getList().remove(pMachine);
+        m->mapMachines.erase(id);
+        if (++m->uMachinesGeneration == 0)
+            m->uMachinesGeneration = 1;
+    }
     // save the global registry
     HRESULT rc = saveSettings();
     alock.release();
@@ -5266,6 +6327,36 @@ DECLCALLBACK(int) VirtualBox::AsyncEventHandler(RTTHREAD thread, void *pvUser)
     return 0;
 }
 
+/**
+ *  Thread function doing the delayed settings writes, see
+ *  #scheduleSettingsWrite().
+ */
+// static
+DECLCALLBACK(int) VirtualBox::SettingsWriter(RTTHREAD thread, void *pvUser)
+{
+    LogFlowFuncEnter();
+    NOREF(thread);
+
+    VirtualBox *that = (VirtualBox *)pvUser;
+    Assert(that);
+
+    while (!ASMAtomicReadBool(&that->m->fSettingsWriterShutdown))
+    {
+        RTSemEventWait(that->m->hEvtSettingsWriter, RT_INDEFINITE_WAIT);
+        if (ASMAtomicReadBool(&that->m->fSettingsWriterShutdown))
+            break;
+
+        /* give the caller the chance to make more changes; these will signal
+         * the semaphore again and cause another (usually empty) round */
+        RTThreadSleep(VBOX_SETTINGS_WRITE_DELAY_MS);
+
+        that->savePendingSettingsWrites();
+    }
+
+    LogFlowFuncLeave();
+    return 0;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 
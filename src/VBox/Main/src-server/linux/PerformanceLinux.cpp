@@ -31,6 +31,9 @@
 #include <iprt/string.h>
 #include <iprt/system.h>
 #include <iprt/mp.h>
+#include <iprt/asm.h>
+#include <iprt/semaphore.h>
+#include <iprt/thread.h>
 
 #include <map>
 #include <vector>
@@ -40,12 +43,19 @@
 
 #define VBOXVOLINFO_NAME "VBoxVolInfo"
 
+/** Number of VM processes from which on their stats are read by several threads. */
+#define VBOX_PROCSTAT_PARALLEL_MIN      32
+/** The maximum number of threads reading VM process stats, including the
+ *  sampler thread. */
+#define VBOX_PROCSTAT_MAX_THREADS       4
+
 namespace pm {
 
 class CollectorLinux : public CollectorHAL
 {
 public:
     CollectorLinux();
+    virtual ~CollectorLinux();
     virtual int preCollect(const CollectorHints& hints, uint64_t /* iTick */);
     virtual int getHostMemoryUsage(ULONG *total, ULONG *used, ULONG *available);
     virtual int getHostFilesystemUsage(const char *name, ULONG *total, ULONG *used, ULONG *available);
@@ -74,6 +84,39 @@ private:
         ULONG    pagesUsed;
     };
 
+    /** The VM process stats to read in one sample. */
+    struct ProcessStatsReader
+    {
+        CollectorLinux                *pThis;
+        const std::vector<RTPROCESS>  *pProcesses;
+        std::vector<VMProcessStats>    aStats;
+        std::vector<int>               aRcs;
+        uint32_t volatile              iNext;
+    };
+    /** A thread helping the sampler thread with reading VM process stats.
+     * The workers are started when first needed and stay around until the
+     * collector is destroyed, they get work through hEvtGo. */
+    struct ProcessStatsWorker
+    {
+        CollectorLinux                *pThis;
+        RTTHREAD                       hThread;
+        RTSEMEVENT                     hEvtGo;
+    };
+    static DECLCALLBACK(int) processStatsThread(RTTHREAD hThreadSelf, void *pvUser);
+    static void readProcessStats(ProcessStatsReader *pReader);
+    void startProcessStatsWorkers();
+
+    /** The workers, empty if not started (yet). */
+    std::vector<ProcessStatsWorker> mWorkers;
+    /** The reader of the current sample, NULL if none. */
+    ProcessStatsReader * volatile   mpReader;
+    /** Number of workers still busy with the current sample. */
+    uint32_t volatile               mcWorkersBusy;
+    /** Signalled by the last worker done with the current sample. */
+    RTSEMEVENT                      mEvtWorkersDone;
+    /** Tells the workers to quit. */
+    bool volatile                   mfWorkersShutdown;
+
     typedef std::map<RTPROCESS, VMProcessStats> VMProcessMap;
 
     VMProcessMap mProcessStats;
@@ -91,6 +134,7 @@ CollectorHAL *createHAL()
 // Collector HAL for Linux
 
 CollectorLinux::CollectorLinux()
+    : mpReader(NULL), mcWorkersBusy(0), mEvtWorkersDone(NIL_RTSEMEVENT), mfWorkersShutdown(false)
 {
     long hz = sysconf(_SC_CLK_TCK);
     if (hz == -1)
@@ -110,22 +154,93 @@ CollectorLinux::CollectorLinux()
         totalRAM = (ULONG)(cb / 1024);
 }
 
+CollectorLinux::~CollectorLinux()
+{
+    ASMAtomicWriteBool(&mfWorkersShutdown, true);
+    for (size_t i = 0; i < mWorkers.size(); i++)
+        RTSemEventSignal(mWorkers[i].hEvtGo);
+    for (size_t i = 0; i < mWorkers.size(); i++)
+    {
+        RTThreadWait(mWorkers[i].hThread, RT_INDEFINITE_WAIT, NULL);
+        RTSemEventDestroy(mWorkers[i].hEvtGo);
+    }
+    if (mEvtWorkersDone != NIL_RTSEMEVENT)
+        RTSemEventDestroy(mEvtWorkersDone);
+}
+
+/**
+ * Starts the threads which help reading the VM process stats.  Failures just
+ * leave fewer (or no) helpers.
+ */
+void CollectorLinux::startProcessStatsWorkers()
+{
+    int rc = RTSemEventCreate(&mEvtWorkersDone);
+    if (RT_FAILURE(rc))
+        return;
+
+    uint32_t cThreads = RT_MIN(RTMpGetOnlineCount(), VBOX_PROCSTAT_MAX_THREADS);
+    mWorkers.reserve(cThreads);
+    for (uint32_t i = 1; i < cThreads; i++)
+    {
+        ProcessStatsWorker Worker;
+        Worker.pThis = this;
+        Worker.hThread = NIL_RTTHREAD;
+        rc = RTSemEventCreate(&Worker.hEvtGo);
+        if (RT_FAILURE(rc))
+            break;
+        mWorkers.push_back(Worker);
+        rc = RTThreadCreate(&mWorkers.back().hThread, processStatsThread, &mWorkers.back(), 0,
+                            RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "ProcStat");
+        if (RT_FAILURE(rc))
+        {
+            RTSemEventDestroy(mWorkers.back().hEvtGo);
+            mWorkers.pop_back();
+            break;
+        }
+    }
+}
+
 int CollectorLinux::preCollect(const CollectorHints& hints, uint64_t /* iTick */)
 {
     std::vector<RTPROCESS> processes;
     hints.getProcesses(processes);
 
-    std::vector<RTPROCESS>::iterator it;
-    for (it = processes.begin(); it != processes.end(); it++)
+    /*
+     * Read the stats of all processes, with the help of a few more threads if
+     * there are lots of VMs so that the sample doesn't lag behind.
+     */
+    ProcessStatsReader reader;
+    reader.pThis      = this;
+    reader.pProcesses = &processes;
+    reader.aStats.resize(processes.size());
+    reader.aRcs.resize(processes.size(), VERR_NOT_AVAILABLE);
+    reader.iNext      = 0;
+
+    bool fParallel = processes.size() >= VBOX_PROCSTAT_PARALLEL_MIN;
+    if (fParallel && mEvtWorkersDone == NIL_RTSEMEVENT)
+        startProcessStatsWorkers();
+    fParallel = fParallel && !mWorkers.empty();
+    if (fParallel)
+    {
+        ASMAtomicWritePtr(&mpReader, &reader);
+        ASMAtomicWriteU32(&mcWorkersBusy, (uint32_t)mWorkers.size());
+        for (size_t i = 0; i < mWorkers.size(); i++)
+            RTSemEventSignal(mWorkers[i].hEvtGo);
+    }
+    readProcessStats(&reader);
+    if (fParallel)
     {
-        VMProcessStats vmStats;
-        int rc = getRawProcessStats(*it, &vmStats.cpuUser, &vmStats.cpuKernel, &vmStats.pagesUsed);
+        while (ASMAtomicReadU32(&mcWorkersBusy))
+            RTSemEventWait(mEvtWorkersDone, RT_INDEFINITE_WAIT);
+        ASMAtomicWriteNullPtr(&mpReader);
+    }
+
+    for (size_t i = 0; i < processes.size(); i++)
         /* On failure, do NOT stop. Just skip the entry. Having the stats for
          * one (probably broken) process frozen/zero is a minor issue compared
          * to not updating many process stats and the host cpu stats. */
-        if (RT_SUCCESS(rc))
-            mProcessStats[*it] = vmStats;
-    }
+        if (RT_SUCCESS(reader.aRcs[i]))
+            mProcessStats[processes[i]] = reader.aStats[i];
     if (hints.isHostCpuLoadCollected() || mProcessStats.size())
     {
         _getRawHostCpuLoad();
@@ -133,6 +248,45 @@ int CollectorLinux::preCollect(const CollectorHints& hints, uint64_t /* iTick */
     return VINF_SUCCESS;
 }
 
+/**
+ * Reads the stats of the processes not yet taken by another thread.
+ *
+ * @param   pReader     The reader of the current sample.
+ */
+/* static */
+void CollectorLinux::readProcessStats(ProcessStatsReader *pReader)
+{
+    uint32_t i;
+    while ((i = ASMAtomicIncU32(&pReader->iNext) - 1) < pReader->pProcesses->size())
+    {
+        VMProcessStats *pStats = &pReader->aStats[i];
+        pReader->aRcs[i] = pReader->pThis->getRawProcessStats((*pReader->pProcesses)[i], &pStats->cpuUser,
+                                                              &pStats->cpuKernel, &pStats->pagesUsed);
+    }
+}
+
+/* static */
+DECLCALLBACK(int) CollectorLinux::processStatsThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    NOREF(hThreadSelf);
+    ProcessStatsWorker *pWorker = (ProcessStatsWorker *)pvUser;
+    CollectorLinux     *pThis   = pWorker->pThis;
+
+    for (;;)
+    {
+        RTSemEventWait(pWorker->hEvtGo, RT_INDEFINITE_WAIT);
+        if (ASMAtomicReadBool(&pThis->mfWorkersShutdown))
+            break;
+
+        ProcessStatsReader *pReader = ASMAtomicReadPtrT(&pThis->mpReader, ProcessStatsReader *);
+        if (pReader)
+            readProcessStats(pReader);
+        if (ASMAtomicDecU32(&pThis->mcWorkersBusy) == 0)
+            RTSemEventSignal(pThis->mEvtWorkersDone);
+    }
+    return VINF_SUCCESS;
+}
+
 int CollectorLinux::_getRawHostCpuLoad()
 {
     int rc = VINF_SUCCESS;
@@ -0,0 +1,268 @@
+/* $Id: tstMediumLookup.cpp $ */
+/** @file
+ *
+ * tstMediumLookup - Benchmark for registering lots of media and looking
+ *                   them up by UUID and location.
+ *
+ * The test points VBOX_USER_HOME to a temporary directory so the media end
+ * up in a throw-away registry, and refuses to run if it finds itself talking
+ * to an already running VBoxSVC which uses another home folder.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ */
+
+#include <VBox/com/VirtualBox.h>
+
+#include <VBox/com/com.h>
+#include <VBox/com/array.h>
+#include <VBox/com/string.h>
+#include <VBox/com/Guid.h>
+
+#include <iprt/dir.h>
+#include <iprt/env.h>
+#include <iprt/file.h>
+#include <iprt/path.h>
+#include <iprt/stream.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+#include <iprt/time.h>
+
+#include <vector>
+
+using namespace com;
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** The default number of media to register. */
+static uint32_t g_cMedia = 10000;
+/** The number of lookup rounds over all media. */
+static uint32_t g_cRounds = 4;
+
+
+/**
+ * Creates the dummy ISO images to register.
+ *
+ * @returns IPRT status code.
+ * @param   pszDir      The directory to create them in.
+ * @param   vecPaths    Where to store the full paths of the images.
+ */
+static int tstCreateImages(const char *pszDir, std::vector<Utf8Str> &vecPaths)
+{
+    static uint8_t const s_abSector[2048] = { 0 };
+
+    for (uint32_t i = 0; i < g_cMedia; i++)
+    {
+        Utf8Str strPath = Utf8StrFmt("%s%cimage-%05u.iso", pszDir, RTPATH_DELIMITER, i);
+        RTFILE hFile;
+        int rc = RTFileOpen(&hFile, strPath.c_str(), RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_NONE);
+        if (RT_FAILURE(rc))
+            return rc;
+        rc = RTFileWrite(hFile, s_abSector, sizeof(s_abSector), NULL);
+        RTFileClose(hFile);
+        if (RT_FAILURE(rc))
+            return rc;
+        vecPaths.push_back(strPath);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Reports the throughput of an API call sequence.
+ *
+ * @param   pszName     The value name.
+ * @param   cCalls      The number of calls made.
+ * @param   cNsElapsed  The time they took.
+ */
+static void tstReportRate(const char *pszName, uint64_t cCalls, uint64_t cNsElapsed)
+{
+    RTTestValue(NIL_RTTEST, pszName, cCalls * RT_NS_1SEC / RT_MAX(cNsElapsed, 1), RTTESTUNIT_CALLS_PER_SEC);
+}
+
+
+/**
+ * Registers all images and measures the lookups.
+ *
+ * @param   pVirtualBox     The VirtualBox object.
+ * @param   vecPaths        The images to register.
+ * @param   vecMedia        Where to store the registered media for cleanup.
+ */
+static void tstBenchmark(IVirtualBox *pVirtualBox, const std::vector<Utf8Str> &vecPaths,
+                         std::vector<ComPtr<IMedium> > &vecMedia)
+{
+    HRESULT hrc;
+
+    /*
+     * Register them.  Each registration checks for conflicts with the
+     * already registered media, so this is quadratic with linear lookups.
+     */
+    RTTestSub(NIL_RTTEST, "Register");
+    uint64_t nsStart = RTTimeNanoTS();
+    for (size_t i = 0; i < vecPaths.size(); i++)
+    {
+        ComPtr<IMedium> pMedium;
+        hrc = pVirtualBox->OpenMedium(Bstr(vecPaths[i]).raw(), DeviceType_DVD, AccessMode_ReadOnly,
+                                      false /* fForceNewUuid */, pMedium.asOutParam());
+        if (FAILED(hrc))
+        {
+            RTTestFailed(NIL_RTTEST, "OpenMedium(%s) failed: %Rhrc", vecPaths[i].c_str(), hrc);
+            return;
+        }
+        vecMedia.push_back(pMedium);
+    }
+    tstReportRate("Register", vecPaths.size(), RTTimeNanoTS() - nsStart);
+
+    std::vector<Bstr> vecIds;
+    for (size_t i = 0; i < vecMedia.size(); i++)
+    {
+        Bstr bstrId;
+        vecMedia[i]->COMGETTER(Id)(bstrId.asOutParam());
+        vecIds.push_back(bstrId);
+    }
+
+    /*
+     * Look them up by location and UUID; OpenMedium returns the already
+     * registered object without touching the image.
+     */
+    RTTestSub(NIL_RTTEST, "Lookup by location");
+    nsStart = RTTimeNanoTS();
+    for (uint32_t iRound = 0; iRound < g_cRounds; iRound++)
+        for (size_t i = 0; i < vecPaths.size(); i++)
+        {
+            ComPtr<IMedium> pMedium;
+            hrc = pVirtualBox->OpenMedium(Bstr(vecPaths[i]).raw(), DeviceType_DVD, AccessMode_ReadOnly,
+                                          false /* fForceNewUuid */, pMedium.asOutParam());
+            if (FAILED(hrc) || !(pMedium == (IMedium *)vecMedia[i]))
+            {
+                RTTestFailed(NIL_RTTEST, "Lookup of %s failed: %Rhrc", vecPaths[i].c_str(), hrc);
+                return;
+            }
+        }
+    tstReportRate("Lookup by location", (uint64_t)vecPaths.size() * g_cRounds, RTTimeNanoTS() - nsStart);
+
+    RTTestSub(NIL_RTTEST, "Lookup by UUID");
+    nsStart = RTTimeNanoTS();
+    for (uint32_t iRound = 0; iRound < g_cRounds; iRound++)
+        for (size_t i = 0; i < vecIds.size(); i++)
+        {
+            ComPtr<IMedium> pMedium;
+            hrc = pVirtualBox->OpenMedium(vecIds[i].raw(), DeviceType_DVD, AccessMode_ReadOnly,
+                                          false /* fForceNewUuid */, pMedium.asOutParam());
+            if (FAILED(hrc) || !(pMedium == (IMedium *)vecMedia[i]))
+            {
+                RTTestFailed(NIL_RTTEST, "Lookup of {%ls} failed: %Rhrc", vecIds[i].raw(), hrc);
+                return;
+            }
+        }
+    tstReportRate("Lookup by UUID", (uint64_t)vecIds.size() * g_cRounds, RTTimeNanoTS() - nsStart);
+
+    /*
+     * Machine lookups of unknown UUIDs, the worst case for a linear search.
+     */
+    RTTestSub(NIL_RTTEST, "FindMachine miss");
+    nsStart = RTTimeNanoTS();
+    for (size_t i = 0; i < vecPaths.size(); i++)
+    {
+        Guid uuid;
+        uuid.create();
+        ComPtr<IMachine> pMachine;
+        hrc = pVirtualBox->FindMachine(Bstr(uuid.toString()).raw(), pMachine.asOutParam());
+        if (SUCCEEDED(hrc))
+        {
+            RTTestFailed(NIL_RTTEST, "FindMachine({%RTuuid}) succeeded", uuid.raw());
+            return;
+        }
+    }
+    tstReportRate("FindMachine miss", vecPaths.size(), RTTimeNanoTS() - nsStart);
+}
+
+
+int main(int argc, char *argv[])
+{
+    RTTEST hTest;
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstMediumLookup", &hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(hTest);
+
+    if (argc > 1)
+        g_cMedia = RT_MAX(RTStrToUInt32(argv[1]), 1);
+    if (argc > 2)
+        g_cRounds = RT_MAX(RTStrToUInt32(argv[2]), 1);
+    RTTestPrintf(hTest, RTTESTLVL_ALWAYS, "%u media, %u lookup rounds\n", g_cMedia, g_cRounds);
+
+    /*
+     * Create a private home folder for the VirtualBox settings and the images.
+     */
+    char szDir[RTPATH_MAX];
+    int rc = RTPathTemp(szDir, sizeof(szDir));
+    if (RT_SUCCESS(rc))
+        rc = RTPathAppend(szDir, sizeof(szDir), "tstMediumLookup-XXXXXX");
+    if (RT_SUCCESS(rc))
+        rc = RTDirCreateTemp(szDir, 0700);
+    if (RT_SUCCESS(rc))
+        rc = RTEnvSet("VBOX_USER_HOME", szDir);
+    if (RT_FAILURE(rc))
+    {
+        RTTestFailed(hTest, "Failed to set up a private VirtualBox home folder: %Rrc", rc);
+        return RTTestSummaryAndDestroy(hTest);
+    }
+
+    HRESULT hrc = com::Initialize();
+    if (FAILED(hrc))
+    {
+        RTTestFailed(hTest, "Failed to initialize COM: %Rhrc", hrc);
+        RTDirRemoveRecursive(szDir, RTDIRRMREC_F_CONTENT_AND_DIR);
+        return RTTestSummaryAndDestroy(hTest);
+    }
+
+    Utf8Str strSkipped;
+    {
+        ComPtr<IVirtualBox> pVirtualBox;
+        hrc = pVirtualBox.createLocalObject(CLSID_VirtualBox);
+        if (FAILED(hrc))
+            RTTestFailed(hTest, "Failed to create the VirtualBox object: %Rhrc", hrc);
+        else
+        {
+            /* Never touch the registry of a VBoxSVC which was already running. */
+            Bstr bstrHome;
+            pVirtualBox->COMGETTER(HomeFolder)(bstrHome.asOutParam());
+            if (RTPathCompare(Utf8Str(bstrHome).c_str(), szDir) != 0)
+                strSkipped = Utf8StrFmt("VBoxSVC is using '%ls' instead of '%s', terminate it first",
+                                        bstrHome.raw(), szDir);
+            else
+            {
+                std::vector<Utf8Str> vecPaths;
+                std::vector<ComPtr<IMedium> > vecMedia;
+                rc = tstCreateImages(szDir, vecPaths);
+                if (RT_SUCCESS(rc))
+                    tstBenchmark(pVirtualBox, vecPaths, vecMedia);
+                else
+                    RTTestFailed(hTest, "Failed to create the images in '%s': %Rrc", szDir, rc);
+
+                /* cleanup */
+                for (size_t i = 0; i < vecMedia.size(); i++)
+                    vecMedia[i]->Close();
+                vecMedia.clear();
+            }
+        }
+    }
+
+    com::Shutdown();
+    RTDirRemoveRecursive(szDir, RTDIRRMREC_F_CONTENT_AND_DIR);
+    if (strSkipped.isNotEmpty())
+        return RTTestSkipAndDestroy(hTest, "%s", strSkipped.c_str());
+    return RTTestSummaryAndDestroy(hTest);
+}
@@ -1352,8 +1352,11 @@ MainConfigFile::MainConfigFile(const Utf8Str *pstrFilename)
 /**
  * Called from the IVirtualBox interface to write out VirtualBox.xml. This
  * builds an XML DOM tree and writes it out to disk.
+ *
+ * @param fFlushTmpDir  Whether to flush the directory when closing the
+ *                      temporary file, see xml::XmlFileWriter::write().
  */
-void MainConfigFile::write(const com::Utf8Str strFilename)
+void MainConfigFile::write(const com::Utf8Str strFilename, bool fFlushTmpDir /* = true */)
 {
     m->strFilename = strFilename;
     createStubDocument();
@@ -1413,7 +1416,7 @@ void MainConfigFile::write(const com::Utf8Str strFilename)
 
     // now go write the XML
     xml::XmlFileWriter writer(*m->pDoc);
-    writer.write(m->strFilename.c_str(), true /*fSafe*/);
+    writer.write(m->strFilename.c_str(), true /*fSafe*/, fFlushTmpDir);
 
     m->fFileExists = true;
 
@@ -5231,8 +5234,11 @@ void MachineConfigFile::bumpSettingsVersionIfNeeded()
  * Called from Main code to write a machine config file to disk. This builds a DOM tree from
  * the member variables and then writes the XML file; it throws xml::Error instances on errors,
  * in particular if the file cannot be written.
+ *
+ * @param fFlushTmpDir  Whether to flush the directory when closing the
+ *                      temporary file, see xml::XmlFileWriter::write().
  */
-void MachineConfigFile::write(const com::Utf8Str &strFilename)
+void MachineConfigFile::write(const com::Utf8Str &strFilename, bool fFlushTmpDir /* = true */)
 {
     try
     {
@@ -5253,7 +5259,7 @@ void MachineConfigFile::write(const com::Utf8Str &strFilename)
 
         // now go write the XML
         xml::XmlFileWriter writer(*m->pDoc);
-        writer.write(m->strFilename.c_str(), true /*fSafe*/);
+        writer.write(m->strFilename.c_str(), true /*fSafe*/, fFlushTmpDir);
 
         m->fFileExists = true;
         clearDocument();
@@ -33,107 +33,287 @@
 
 #include <iprt/asm.h>
 #include <iprt/assert.h>
+#include <iprt/critsect.h>
 #include <iprt/err.h>
-#include <iprt/mempool.h>
-#include <iprt/string.h>
+#include <iprt/mem.h>
 #include <iprt/once.h>
+#include <iprt/string.h>
+
+#include "internal/magics.h"
+#include "internal/strhash.h"
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The number of insertion stripes (power of two).
+ * Each stripe owns every RTSTRCACHE_STRIPES'th hash bucket together with the
+ * string memory of the entries hashed to it. */
+#define RTSTRCACHE_STRIPES              16
+/** The initial hash table size (power of two, >= RTSTRCACHE_STRIPES). */
+#define RTSTRCACHE_INITIAL_BUCKETS      512
+/** The hash table is grown when the entry count exceeds this many entries per
+ * bucket on average. */
+#define RTSTRCACHE_MAX_LOAD             2
+/** The hash table growth factor (shift). */
+#define RTSTRCACHE_GROW_SHIFT           2
+/** The max hash table size (power of two), the table isn't grown beyond it. */
+#define RTSTRCACHE_MAX_BUCKETS          _4M
+/** The size of the string allocation chunks. */
+#define RTSTRCACHE_CHUNK_SIZE           _32K
+/** Entries larger than this gets a chunk of their own. */
+#define RTSTRCACHE_MAX_CHUNKED_ENTRY    _1K
+/** Entry alignment. */
+#define RTSTRCACHE_ENTRY_ALIGN          8
+
+/** Validates a string cache handle, translating RTSTRCACHE_DEFAULT when found,
+ * and returns rc if not valid. */
+#define RTSTRCACHE_VALID_RETURN_RC(pStrCache, rc) \
+    do { \
+        if ((pStrCache) == RTSTRCACHE_DEFAULT) \
+        { \
+            int rcOnce = RTOnce(&g_rtStrCacheOnce, rtStrCacheInitDefault, NULL); \
+            if (RT_FAILURE(rcOnce)) \
+                return (rc); \
+            (pStrCache) = g_hrtStrCacheDefault; \
+        } \
+        else \
+        { \
+            AssertPtrReturn((pStrCache), (rc)); \
+            AssertReturn((pStrCache)->u32Magic == RTSTRCACHE_MAGIC, (rc)); \
+        } \
+    } while (0)
+
+/** Validates a string cache entry and returns rc if not valid. */
+#define RTSTRCACHE_VALID_ENTRY_RETURN_RC(pEntry, rc) \
+    do { \
+        AssertPtrReturn(pEntry, (rc)); \
+        AssertReturn((pEntry)->cRefs < UINT32_MAX / 2, (rc)); \
+    } while (0)
 
 
 /*******************************************************************************
 *   Structures and Typedefs                                                    *
 *******************************************************************************/
+/** Pointer to a string cache entry. */
+typedef struct RTSTRCACHEENTRY *PRTSTRCACHEENTRY;
+
 /**
  * String cache entry.
  *
- * Each entry is
+ * Entries are never moved or freed before the cache is destroyed, so readers
+ * may walk the hash chains without taking any locks.  An entry whose reference
+ * count has dropped to zero is kept around and revived by the next lookup of
+ * the same string.
  */
 typedef struct RTSTRCACHEENTRY
 {
+    /** The next entry in the hash chain. */
+    PRTSTRCACHEENTRY volatile   pNext;
     /** The number of references. */
-    uint32_t volatile   cRefs;
-    /** Offset into the chunk (bytes). */
-    uint32_t            offChunk;
+    uint32_t volatile           cRefs;
+    /** The full hash value. */
+    uint32_t                    uHash;
     /** The string length. */
-    uint32_t            cch;
-    /** The primary hash value. */
-    uint32_t            uHash1;
-    /** The string. */
-    char                szString[16];
+    uint32_t                    cch;
+    /** The string (variable length). */
+    char                        szString[4];
 } RTSTRCACHEENTRY;
-AssertCompileSize(RTSTRCACHEENTRY, 32);
-/** Pointer to a string cache entry. */
-typedef RTSTRCACHEENTRY *PRTSTRCACHEENTRY;
 /** Pointer to a const string cache entry. */
-typedef RTSTRCACHEENTRY *PCRTSTRCACHEENTRY;
+typedef RTSTRCACHEENTRY const *PCRTSTRCACHEENTRY;
 
 /**
- * Allocation chunk.
+ * String allocation chunk.
  */
 typedef struct RTSTRCACHECHUNK
 {
-    /** Pointer to the main string cache structure. */
-    struct RTSTRCACHEINT   *pCache;
-    /** Padding to align the entries on a 32-byte boundary. */
-    uint32_t                au32Padding[8 - (ARCH_BITS == 64) - 4];
-    /** The index of the first unused entry. */
-    uint32_t                iUnused;
-    /** The number of used entries. */
-    uint32_t                cUsed;
-    /** The number of entries in this chunk. */
-    uint32_t                cEntries;
-    /** The string cache entries, variable size. */
-    RTSTRCACHEENTRY         aEntries[1];
+    /** The next chunk in the stripe. */
+    struct RTSTRCACHECHUNK     *pNext;
+    /** The size of the chunk, including this header. */
+    size_t                      cb;
 } RTSTRCACHECHUNK;
+/** Pointer to a string allocation chunk. */
+typedef RTSTRCACHECHUNK *PRTSTRCACHECHUNK;
 
+/**
+ * Hash table.
+ *
+ * Replaced tables are kept in a list until the cache is destroyed since there
+ * may still be lock-free readers looking at them.
+ */
+typedef struct RTSTRCACHEHASHTAB
+{
+    /** The previous (smaller) hash table. */
+    struct RTSTRCACHEHASHTAB   *pPrev;
+    /** The number of buckets (power of two). */
+    uint32_t                    cBuckets;
+    /** The bucket array (variable size). */
+    PRTSTRCACHEENTRY volatile   apBuckets[1];
+} RTSTRCACHEHASHTAB;
+/** Pointer to a hash table. */
+typedef RTSTRCACHEHASHTAB *PRTSTRCACHEHASHTAB;
+
+/**
+ * Insertion stripe.
+ */
+typedef struct RTSTRCACHESTRIPE
+{
+    /** Serializes insertions into the buckets owned by this stripe. */
+    RTCRITSECT                  CritSect;
+    /** The chunk list (head is the one being carved up). */
+    PRTSTRCACHECHUNK            pChunkHead;
+    /** The next free byte in the head chunk. */
+    uint8_t                    *pbFree;
+    /** The number of free bytes in the head chunk. */
+    size_t                      cbFree;
+    /** Padding to keep the stripes on separate cache lines. */
+    uint8_t                     abPadding[64];
+} RTSTRCACHESTRIPE;
+/** Pointer to an insertion stripe. */
+typedef RTSTRCACHESTRIPE *PRTSTRCACHESTRIPE;
 
+/**
+ * String cache instance data.
+ */
 typedef struct RTSTRCACHEINT
 {
     /** The string cache magic (RTSTRCACHE_MAGIC). */
-    uint32_t        u32Magic;
-
+    uint32_t                    u32Magic;
+    /** The total number of entries. */
+    uint32_t volatile           cEntries;
+    /** The current hash table. */
+    PRTSTRCACHEHASHTAB volatile pHashTab;
+    /** Set when the hash table has reached RTSTRCACHE_MAX_BUCKETS and won't
+     * be grown any further. */
+    bool volatile               fHashTabMaxed;
+    /** The insertion stripes. */
+    RTSTRCACHESTRIPE            aStripes[RTSTRCACHE_STRIPES];
+    /** The cache name (variable length). */
+    char                        szName[8];
 } RTSTRCACHEINT;
-
-
+/** Pointer to string cache instance data. */
+typedef RTSTRCACHEINT *PRTSTRCACHEINT;
 
 
 /*******************************************************************************
-*   Defined Constants And Macros                                               *
+*   Global Variables                                                           *
 *******************************************************************************/
-/** Validates a string cache handle, translating RTSTRCACHE_DEFAULT when found,
- * and returns rc if not valid. */
-#define RTSTRCACHE_VALID_RETURN_RC(pStrCache, rc) \
-    do { \
-        if ((pStrCache) == RTMEMPOOL_DEFAULT) \
-            (pStrCache) = &g_rtMemPoolDefault; \
-        else \
-        { \
-            AssertPtrReturn((pStrCache), (rc)); \
-            AssertReturn((pStrCache)->u32Magic == RTSTRCACHE_MAGIC, (rc)); \
-        } \
-    } while (0)
+/** Init once for the default string cache. */
+static RTONCE           g_rtStrCacheOnce     = RTONCE_INITIALIZER;
+/** The default string cache. */
+static RTSTRCACHE       g_hrtStrCacheDefault = NIL_RTSTRCACHE;
 
-/** Validates a memory pool entry and returns rc if not valid. */
-#define RTSTRCACHE_VALID_ENTRY_RETURN_RC(pEntry, rc) \
-    do { \
-        AssertPtrReturn(pEntry, (rc)); \
-        AssertPtrNullReturn((pEntry)->pMemPool, (rc)); \
-        Assert((pEntry)->cRefs < UINT32_MAX / 2); \
-        AssertReturn((pEntry)->pMemPool->u32Magic == RTMEMPOOL_MAGIC, (rc)); \
-    } while (0)
+
+/**
+ * Allocates a hash table.
+ *
+ * @returns Pointer to the hash table, NULL if out of memory.
+ * @param   cBuckets            The number of buckets (power of two).
+ */
+static PRTSTRCACHEHASHTAB rtStrCacheAllocHashTab(uint32_t cBuckets)
+{
+    Assert(RT_IS_POWER_OF_TWO(cBuckets) && cBuckets >= RTSTRCACHE_STRIPES);
+    PRTSTRCACHEHASHTAB pHashTab = (PRTSTRCACHEHASHTAB)RTMemAllocZ(RT_OFFSETOF(RTSTRCACHEHASHTAB, apBuckets[cBuckets]));
+    if (pHashTab)
+        pHashTab->cBuckets = cBuckets;
+    return pHashTab;
+}
 
 
-/*******************************************************************************
-*   Global Variables                                                           *
-*******************************************************************************/
+/**
+ * Frees all the resources associated with a string cache.
+ *
+ * @param   pThis               The string cache.
+ * @param   cStripes            The number of stripes with initialized critical
+ *                              sections.
+ */
+static void rtStrCacheFree(PRTSTRCACHEINT pThis, uint32_t cStripes)
+{
+    for (uint32_t i = 0; i < RTSTRCACHE_STRIPES; i++)
+    {
+        PRTSTRCACHESTRIPE pStripe = &pThis->aStripes[i];
+        if (i < cStripes)
+            RTCritSectDelete(&pStripe->CritSect);
+
+        PRTSTRCACHECHUNK pChunk = pStripe->pChunkHead;
+        pStripe->pChunkHead = NULL;
+        while (pChunk)
+        {
+            PRTSTRCACHECHUNK pFree = pChunk;
+            pChunk = pChunk->pNext;
+            RTMemFree(pFree);
+        }
+    }
+
+    PRTSTRCACHEHASHTAB pHashTab = pThis->pHashTab;
+    pThis->pHashTab = NULL;
+    while (pHashTab)
+    {
+        PRTSTRCACHEHASHTAB pFree = pHashTab;
+        pHashTab = pHashTab->pPrev;
+        RTMemFree(pFree);
+    }
+
+    RTMemFree(pThis);
+}
+
+
+/**
+ * Creates a string cache instance.
+ *
+ * @returns IPRT status code.
+ * @param   ppThis              Where to return the instance.
+ * @param   pszName             The cache name.
+ */
+static int rtStrCacheCreate(PRTSTRCACHEINT *ppThis, const char *pszName)
+{
+    size_t          cchName = strlen(pszName);
+    PRTSTRCACHEINT  pThis   = (PRTSTRCACHEINT)RTMemAllocZ(RT_OFFSETOF(RTSTRCACHEINT, szName[cchName + 1]));
+    if (!pThis)
+        return VERR_NO_MEMORY;
+    memcpy(pThis->szName, pszName, cchName + 1);
+
+    int rc = VINF_SUCCESS;
+    uint32_t i;
+    for (i = 0; i < RTSTRCACHE_STRIPES; i++)
+    {
+        rc = RTCritSectInitEx(&pThis->aStripes[i].CritSect, RTCRITSECT_FLAGS_NO_NESTING | RTCRITSECT_FLAGS_NO_LOCK_VAL,
+                              NIL_RTLOCKVALCLASS, RTLOCKVAL_SUB_CLASS_NONE, "RTStrCache");
+        if (RT_FAILURE(rc))
+            break;
+    }
+    if (RT_SUCCESS(rc))
+    {
+        pThis->pHashTab = rtStrCacheAllocHashTab(RTSTRCACHE_INITIAL_BUCKETS);
+        if (pThis->pHashTab)
+        {
+            pThis->u32Magic = RTSTRCACHE_MAGIC;
+            *ppThis = pThis;
+            return VINF_SUCCESS;
+        }
+        rc = VERR_NO_MEMORY;
+    }
+
+    rtStrCacheFree(pThis, i);
+    return rc;
+}
 
 
+/**
+ * @callback_method_impl{FNRTONCE, Creates the default string cache.}
+ */
+static DECLCALLBACK(int32_t) rtStrCacheInitDefault(void *pvUser)
+{
+    NOREF(pvUser);
+    return rtStrCacheCreate(&g_hrtStrCacheDefault, "default");
+}
+
 
 RTDECL(int) RTStrCacheCreate(PRTSTRCACHE phStrCache, const char *pszName)
 {
-    AssertCompile(sizeof(RTSTRCACHE) == sizeof(RTMEMPOOL));
-    AssertCompile(NIL_RTSTRCACHE == (RTSTRCACHE)NIL_RTMEMPOOL);
-    AssertCompile(RTSTRCACHE_DEFAULT == (RTSTRCACHE)RTMEMPOOL_DEFAULT);
-    return RTMemPoolCreate((PRTMEMPOOL)phStrCache, pszName);
+    AssertPtrReturn(phStrCache, VERR_INVALID_POINTER);
+    AssertPtrReturn(pszName, VERR_INVALID_POINTER);
+    return rtStrCacheCreate(phStrCache, pszName);
 }
 RT_EXPORT_SYMBOL(RTStrCacheCreate);
 
@@ -143,18 +323,211 @@ RTDECL(int) RTStrCacheDestroy(RTSTRCACHE hStrCache)
     if (    hStrCache == NIL_RTSTRCACHE
         ||  hStrCache == RTSTRCACHE_DEFAULT)
         return VINF_SUCCESS;
-    return RTMemPoolDestroy((RTMEMPOOL)hStrCache);
+
+    PRTSTRCACHEINT pThis = hStrCache;
+    RTSTRCACHE_VALID_RETURN_RC(pThis, VERR_INVALID_HANDLE);
+
+    /*
+     * Invalidate the handle and free all associated resources.
+     */
+    ASMAtomicWriteU32(&pThis->u32Magic, RTSTRCACHE_MAGIC_DEAD);
+    rtStrCacheFree(pThis, RTSTRCACHE_STRIPES);
+    return VINF_SUCCESS;
 }
 RT_EXPORT_SYMBOL(RTStrCacheDestroy);
 
 
+/**
+ * Looks up a string in the hash table and retains it if found.
+ *
+ * This does not take any locks.
+ *
+ * @returns Pointer to the entry if found, NULL if not.
+ * @param   pHashTab            The hash table.
+ * @param   pchString           The string.
+ * @param   cchString           The string length.
+ * @param   uHash               The string hash.
+ */
+DECLINLINE(PRTSTRCACHEENTRY) rtStrCacheLookupAndRetain(PRTSTRCACHEHASHTAB pHashTab, const char *pchString,
+                                                       uint32_t cchString, uint32_t uHash)
+{
+    PRTSTRCACHEENTRY pEntry = ASMAtomicReadPtrT(&pHashTab->apBuckets[uHash & (pHashTab->cBuckets - 1)], PRTSTRCACHEENTRY);
+    while (pEntry)
+    {
+        if (    pEntry->uHash == uHash
+            &&  pEntry->cch   == cchString
+            &&  !memcmp(pEntry->szString, pchString, cchString))
+        {
+            uint32_t cRefs = ASMAtomicIncU32(&pEntry->cRefs);
+            Assert(cRefs < UINT32_MAX / 2); NOREF(cRefs);
+            return pEntry;
+        }
+        pEntry = ASMAtomicReadPtrT(&pEntry->pNext, PRTSTRCACHEENTRY);
+    }
+    return NULL;
+}
+
+
+/**
+ * Allocates memory for a new entry.
+ *
+ * @returns Pointer to the entry memory, NULL if out of memory.
+ * @param   pStripe             The stripe, owner must be the caller.
+ * @param   cbEntry             The entry size (aligned).
+ */
+static PRTSTRCACHEENTRY rtStrCacheAllocEntry(PRTSTRCACHESTRIPE pStripe, size_t cbEntry)
+{
+    size_t const cbHdr = RT_ALIGN_Z(sizeof(RTSTRCACHECHUNK), RTSTRCACHE_ENTRY_ALIGN);
+
+    /* Large entries get a chunk of their own which is linked in behind the
+       head so the current chunk can still be carved up. */
+    if (cbEntry > RTSTRCACHE_MAX_CHUNKED_ENTRY)
+    {
+        PRTSTRCACHECHUNK pChunk = (PRTSTRCACHECHUNK)RTMemAlloc(cbHdr + cbEntry);
+        if (!pChunk)
+            return NULL;
+        pChunk->cb = cbHdr + cbEntry;
+        if (pStripe->pChunkHead)
+        {
+            pChunk->pNext = pStripe->pChunkHead->pNext;
+            pStripe->pChunkHead->pNext = pChunk;
+        }
+        else
+        {
+            pChunk->pNext = NULL;
+            pStripe->pChunkHead = pChunk;
+        }
+        return (PRTSTRCACHEENTRY)((uint8_t *)pChunk + cbHdr);
+    }
+
+    if (pStripe->cbFree < cbEntry)
+    {
+        PRTSTRCACHECHUNK pChunk = (PRTSTRCACHECHUNK)RTMemAlloc(RTSTRCACHE_CHUNK_SIZE);
+        if (!pChunk)
+            return NULL;
+        pChunk->cb          = RTSTRCACHE_CHUNK_SIZE;
+        pChunk->pNext       = pStripe->pChunkHead;
+        pStripe->pChunkHead = pChunk;
+        pStripe->pbFree     = (uint8_t *)pChunk + cbHdr;
+        pStripe->cbFree     = RTSTRCACHE_CHUNK_SIZE - cbHdr;
+    }
+
+    PRTSTRCACHEENTRY pEntry = (PRTSTRCACHEENTRY)pStripe->pbFree;
+    pStripe->pbFree += cbEntry;
+    pStripe->cbFree -= cbEntry;
+    return pEntry;
+}
+
+
+/**
+ * Grows the hash table if the load factor is exceeded.
+ *
+ * All stripes are entered (in order) while the chains are rebuilt.  Lock-free
+ * readers racing the rehashing may miss an entry, in which case they fall back
+ * on the locked lookup in RTStrCacheEnterN.  The chains stay acyclic at all
+ * times, so the readers always terminate.
+ *
+ * @param   pThis               The string cache.  The caller must not own any
+ *                              of the stripes.
+ */
+static void rtStrCacheGrow(PRTSTRCACHEINT pThis)
+{
+    uint32_t i;
+    for (i = 0; i < RTSTRCACHE_STRIPES; i++)
+        RTCritSectEnter(&pThis->aStripes[i].CritSect);
+
+    PRTSTRCACHEHASHTAB pOld = pThis->pHashTab;
+    if (    pThis->cEntries > pOld->cBuckets * RTSTRCACHE_MAX_LOAD
+        &&  pOld->cBuckets < RTSTRCACHE_MAX_BUCKETS)
+    {
+        PRTSTRCACHEHASHTAB pNew = rtStrCacheAllocHashTab(pOld->cBuckets << RTSTRCACHE_GROW_SHIFT);
+        if (pNew)
+        {
+            uint32_t const fMask = pNew->cBuckets - 1;
+            for (uint32_t iBucket = 0; iBucket < pOld->cBuckets; iBucket++)
+            {
+                PRTSTRCACHEENTRY pEntry = pOld->apBuckets[iBucket];
+                while (pEntry)
+                {
+                    PRTSTRCACHEENTRY pNext = pEntry->pNext;
+                    ASMAtomicWritePtr(&pEntry->pNext, pNew->apBuckets[pEntry->uHash & fMask]);
+                    pNew->apBuckets[pEntry->uHash & fMask] = pEntry;
+                    pEntry = pNext;
+                }
+            }
+
+            pNew->pPrev = pOld;
+            ASMAtomicWritePtr(&pThis->pHashTab, pNew);
+            if (pNew->cBuckets >= RTSTRCACHE_MAX_BUCKETS)
+                ASMAtomicWriteBool(&pThis->fHashTabMaxed, true);
+        }
+    }
+
+    while (i-- > 0)
+        RTCritSectLeave(&pThis->aStripes[i].CritSect);
+}
+
+
 RTDECL(const char *) RTStrCacheEnterN(RTSTRCACHE hStrCache, const char *pchString, size_t cchString)
 {
+    PRTSTRCACHEINT pThis = hStrCache;
+    RTSTRCACHE_VALID_RETURN_RC(pThis, NULL);
     AssertPtr(pchString);
     AssertReturn(cchString < _1G, NULL);
     Assert(!RTStrEnd(pchString, cchString));
 
-    return (const char *)RTMemPoolDupEx((RTMEMPOOL)hStrCache, pchString, cchString, 1);
+    /*
+     * Lock-free lookup first, this is the common case.
+     */
+    size_t   cchHashed;
+    uint32_t uHash = sdbmN(pchString, cchString, &cchHashed);
+    Assert(cchHashed == cchString);
+    PRTSTRCACHEENTRY pEntry = rtStrCacheLookupAndRetain(ASMAtomicReadPtrT(&pThis->pHashTab, PRTSTRCACHEHASHTAB),
+                                                        pchString, (uint32_t)cchString, uHash);
+    if (pEntry)
+        return pEntry->szString;
+
+    /*
+     * Enter the stripe owning the bucket and retry the lookup before
+     * inserting a new entry.  The bucket to stripe mapping does not change
+     * when the table grows, so holding the stripe is sufficient for keeping
+     * the chain stable.
+     */
+    PRTSTRCACHESTRIPE pStripe = &pThis->aStripes[uHash & (RTSTRCACHE_STRIPES - 1)];
+    RTCritSectEnter(&pStripe->CritSect);
+
+    PRTSTRCACHEHASHTAB pHashTab = pThis->pHashTab;
+    pEntry = rtStrCacheLookupAndRetain(pHashTab, pchString, (uint32_t)cchString, uHash);
+    if (!pEntry)
+    {
+        pEntry = rtStrCacheAllocEntry(pStripe, RT_ALIGN_Z(RT_OFFSETOF(RTSTRCACHEENTRY, szString[cchString + 1]),
+                                                          RTSTRCACHE_ENTRY_ALIGN));
+        if (pEntry)
+        {
+            pEntry->cRefs = 1;
+            pEntry->uHash = uHash;
+            pEntry->cch   = (uint32_t)cchString;
+            memcpy(pEntry->szString, pchString, cchString);
+            pEntry->szString[cchString] = '\0';
+
+            /* Publish it. The write barrier makes sure the entry is fully
+               initialized before lock-free readers can see it. */
+            PRTSTRCACHEENTRY volatile *ppBucket = &pHashTab->apBuckets[uHash & (pHashTab->cBuckets - 1)];
+            pEntry->pNext = *ppBucket;
+            ASMAtomicWritePtr(ppBucket, pEntry);
+
+            uint32_t cEntries = ASMAtomicIncU32(&pThis->cEntries);
+            RTCritSectLeave(&pStripe->CritSect);
+
+            if (    cEntries > pHashTab->cBuckets * RTSTRCACHE_MAX_LOAD
+                &&  !ASMAtomicUoReadBool(&pThis->fHashTabMaxed))
+                rtStrCacheGrow(pThis);
+            return pEntry->szString;
+        }
+    }
+
+    RTCritSectLeave(&pStripe->CritSect);
+    return pEntry ? pEntry->szString : NULL;
 }
 RT_EXPORT_SYMBOL(RTStrCacheEnterN);
 
@@ -169,7 +542,12 @@ RT_EXPORT_SYMBOL(RTStrCacheEnter);
 RTDECL(uint32_t) RTStrCacheRetain(const char *psz)
 {
     AssertPtr(psz);
-    return RTMemPoolRetain((void *)psz);
+    PRTSTRCACHEENTRY pEntry = RT_FROM_MEMBER(psz, RTSTRCACHEENTRY, szString);
+    RTSTRCACHE_VALID_ENTRY_RETURN_RC(pEntry, UINT32_MAX);
+
+    uint32_t cRefs = ASMAtomicIncU32(&pEntry->cRefs);
+    Assert(cRefs > 1 && cRefs < UINT32_MAX / 2);
+    return cRefs;
 }
 RT_EXPORT_SYMBOL(RTStrCacheRetain);
 
@@ -178,7 +556,17 @@ RTDECL(uint32_t) RTStrCacheRelease(RTSTRCACHE hStrCache, const char *psz)
 {
     if (!psz)
         return 0;
-    return RTMemPoolRelease((RTMEMPOOL)hStrCache, (void *)psz);
+    NOREF(hStrCache);
+
+    PRTSTRCACHEENTRY pEntry = RT_FROM_MEMBER(psz, RTSTRCACHEENTRY, szString);
+    RTSTRCACHE_VALID_ENTRY_RETURN_RC(pEntry, UINT32_MAX);
+    AssertReturn(pEntry->cRefs > 0, UINT32_MAX);
+
+    /* The entry stays in the cache when the last reference goes away, it is
+       only freed when the cache is destroyed. */
+    uint32_t cRefs = ASMAtomicDecU32(&pEntry->cRefs);
+    Assert(cRefs < UINT32_MAX / 2);
+    return cRefs;
 }
 RT_EXPORT_SYMBOL(RTStrCacheRelease);
 
@@ -187,7 +575,10 @@ RTDECL(size_t) RTStrCacheLength(const char *psz)
 {
     if (!psz)
         return 0;
-    return strlen(psz);
+    PCRTSTRCACHEENTRY pEntry = RT_FROM_MEMBER(psz, RTSTRCACHEENTRY const, szString);
+    AssertPtrReturn(pEntry, 0);
+    Assert(pEntry->cRefs < UINT32_MAX / 2);
+    return pEntry->cch;
 }
 RT_EXPORT_SYMBOL(RTStrCacheLength);
 
@@ -0,0 +1,358 @@
+/* $Id: lz4.cpp $ */
+/** @file
+ * IPRT - Compression, LZ4 Block Format Codec.
+ */
+
+/*
+ * Copyright (C) 2012 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/zip.h>
+#include "internal/iprt.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/string.h>
+
+#include "lz4.h"
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The minimum match length. */
+#define LZ4_MIN_MATCH           4
+/** The number of literals that must end a block. */
+#define LZ4_LAST_LITERALS       5
+/** No match may start this close to the end of the block. */
+#define LZ4_MF_LIMIT            12
+/** The maximum match distance. */
+#define LZ4_MAX_DISTANCE        UINT16_MAX
+/** The hash table size (log2). */
+#define LZ4_HASH_LOG            12
+/** The number of unsuccessful probes before the search step is increased. */
+#define LZ4_SKIP_TRIGGER        6
+
+/** @def LZ4_READ_U32
+ * Reads an unaligned 32-bit value. */
+/** @def LZ4_READ_U64
+ * Reads an unaligned 64-bit value. */
+#if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
+# define LZ4_READ_U32(pb)       ( *(uint32_t const *)(void const *)(pb) )
+# define LZ4_READ_U64(pb)       ( *(uint64_t const *)(void const *)(pb) )
+#else
+# define LZ4_READ_U32(pb)       rtZipLz4ReadU32(pb)
+# define LZ4_READ_U64(pb)       rtZipLz4ReadU64(pb)
+DECLINLINE(uint32_t) rtZipLz4ReadU32(uint8_t const *pb)
+{
+    uint32_t u32;
+    memcpy(&u32, pb, sizeof(u32));
+    return u32;
+}
+DECLINLINE(uint64_t) rtZipLz4ReadU64(uint8_t const *pb)
+{
+    uint64_t u64;
+    memcpy(&u64, pb, sizeof(u64));
+    return u64;
+}
+#endif
+
+
+/**
+ * Hashes the four bytes at the given position.
+ */
+DECLINLINE(uint32_t) rtZipLz4Hash(uint32_t u32)
+{
+    return (u32 * UINT32_C(2654435761)) >> (32 - LZ4_HASH_LOG);
+}
+
+
+/**
+ * Encodes a length of 15 or more following a token.
+ *
+ * @returns Updated output pointer.
+ */
+DECLINLINE(uint8_t *) rtZipLz4EncodeLength(uint8_t *pbDst, size_t cb)
+{
+    while (cb >= 255)
+    {
+        *pbDst++ = 255;
+        cb -= 255;
+    }
+    *pbDst++ = (uint8_t)cb;
+    return pbDst;
+}
+
+
+DECLHIDDEN(size_t) rtZipLz4CompressBlock(uint8_t const *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst)
+{
+    uint8_t * const pbDstStart = pbDst;
+    uint8_t * const pbDstEnd   = pbDst + cbDst;
+    uint8_t const  *pbAnchor   = pbSrc;
+
+    if (cbSrc > LZ4_MF_LIMIT)
+    {
+        /* Note! The table holds offsets relative to pbSrc, stale or zero
+                 entries are caught by the content comparison below. */
+        uint32_t            aoffTable[1 << LZ4_HASH_LOG];
+        RT_ZERO(aoffTable);
+
+        uint8_t const      *pbCur        = pbSrc;
+        uint8_t const * const pbLimit    = pbSrc + cbSrc - LZ4_MF_LIMIT;
+        uint8_t const * const pbMatchEnd = pbSrc + cbSrc - LZ4_LAST_LITERALS;
+        uint32_t            cProbes      = 1 << LZ4_SKIP_TRIGGER;
+
+        while (pbCur < pbLimit)
+        {
+            /*
+             * Look for a match.
+             */
+            uint32_t const  u32Cur = LZ4_READ_U32(pbCur);
+            uint32_t const  iHash  = rtZipLz4Hash(u32Cur);
+            uint8_t const  *pbRef  = pbSrc + aoffTable[iHash];
+            aoffTable[iHash] = (uint32_t)(pbCur - pbSrc);
+            if (   pbRef >= pbCur
+                || (size_t)(pbCur - pbRef) > LZ4_MAX_DISTANCE
+                || LZ4_READ_U32(pbRef) != u32Cur)
+            {
+                /* Speed up when the data doesn't compress well. */
+                pbCur += cProbes++ >> LZ4_SKIP_TRIGGER;
+                continue;
+            }
+            cProbes = 1 << LZ4_SKIP_TRIGGER;
+
+            /* Extend it backwards. */
+            while (   pbCur > pbAnchor
+                   && pbRef > pbSrc
+                   && pbCur[-1] == pbRef[-1])
+            {
+                pbCur--;
+                pbRef--;
+            }
+
+            /* And forwards. */
+            size_t cbMatch = LZ4_MIN_MATCH;
+            while (   pbCur + cbMatch + sizeof(uint64_t) <= pbMatchEnd
+                   && LZ4_READ_U64(pbCur + cbMatch) == LZ4_READ_U64(pbRef + cbMatch))
+                cbMatch += sizeof(uint64_t);
+            while (   pbCur + cbMatch < pbMatchEnd
+                   && pbCur[cbMatch] == pbRef[cbMatch])
+                cbMatch++;
+
+            /*
+             * Emit the sequence: token, literal length, literals, offset,
+             * match length.
+             */
+            size_t const cLiterals = pbCur - pbAnchor;
+            if ((size_t)(pbDstEnd - pbDst) < 1 + cLiterals + cLiterals / 255 + 1 + 2 + (cbMatch - LZ4_MIN_MATCH) / 255 + 1)
+                return 0;
+            uint8_t *pbToken = pbDst++;
+            if (cLiterals >= 15)
+            {
+                *pbToken = 15 << 4;
+                pbDst = rtZipLz4EncodeLength(pbDst, cLiterals - 15);
+            }
+            else
+                *pbToken = (uint8_t)(cLiterals << 4);
+            memcpy(pbDst, pbAnchor, cLiterals);
+            pbDst += cLiterals;
+
+            uint16_t const offMatch = (uint16_t)(pbCur - pbRef);
+            *pbDst++ = (uint8_t)offMatch;
+            *pbDst++ = (uint8_t)(offMatch >> 8);
+
+            size_t const cbMatchCode = cbMatch - LZ4_MIN_MATCH;
+            if (cbMatchCode >= 15)
+            {
+                *pbToken |= 15;
+                pbDst = rtZipLz4EncodeLength(pbDst, cbMatchCode - 15);
+            }
+            else
+                *pbToken |= (uint8_t)cbMatchCode;
+
+            pbCur   += cbMatch;
+            pbAnchor = pbCur;
+
+            /* Seed the table with a position inside the match. */
+            if (pbCur < pbLimit)
+                aoffTable[rtZipLz4Hash(LZ4_READ_U32(pbCur - 2))] = (uint32_t)(pbCur - 2 - pbSrc);
+        }
+    }
+
+    /*
+     * The trailing literals.
+     */
+    size_t const cLiterals = pbSrc + cbSrc - pbAnchor;
+    if ((size_t)(pbDstEnd - pbDst) < 1 + cLiterals + cLiterals / 255 + 1)
+        return 0;
+    if (cLiterals >= 15)
+    {
+        *pbDst++ = 15 << 4;
+        pbDst = rtZipLz4EncodeLength(pbDst, cLiterals - 15);
+    }
+    else
+        *pbDst++ = (uint8_t)(cLiterals << 4);
+    memcpy(pbDst, pbAnchor, cLiterals);
+    pbDst += cLiterals;
+
+    return pbDst - pbDstStart;
+}
+
+
+DECLHIDDEN(int) rtZipLz4DecompressBlock(uint8_t const *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst,
+                                        size_t *pcbDstActual)
+{
+    uint8_t const * const pbSrcEnd   = pbSrc + cbSrc;
+    uint8_t * const       pbDstStart = pbDst;
+    uint8_t * const       pbDstEnd   = pbDst + cbDst;
+
+    for (;;)
+    {
+        if (RT_UNLIKELY(pbSrc >= pbSrcEnd))
+            return VERR_INVALID_MAGIC;
+        uint8_t const bToken = *pbSrc++;
+
+        /*
+         * Literals.
+         */
+        size_t cLiterals = bToken >> 4;
+        if (cLiterals == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (RT_UNLIKELY(pbSrc >= pbSrcEnd))
+                    return VERR_INVALID_MAGIC;
+                b = *pbSrc++;
+                cLiterals += b;
+            } while (b == 255);
+        }
+        if (RT_UNLIKELY(cLiterals > (size_t)(pbSrcEnd - pbSrc)))
+            return VERR_INVALID_MAGIC;
+        if (RT_UNLIKELY(cLiterals > (size_t)(pbDstEnd - pbDst)))
+            return VERR_BUFFER_OVERFLOW;
+        memcpy(pbDst, pbSrc, cLiterals);
+        pbDst += cLiterals;
+        pbSrc += cLiterals;
+
+        /* The last sequence has no match part. */
+        if (pbSrc == pbSrcEnd)
+            break;
+
+        /*
+         * Match.
+         */
+        if (RT_UNLIKELY(pbSrcEnd - pbSrc < 2))
+            return VERR_INVALID_MAGIC;
+        size_t const offMatch = pbSrc[0] | ((size_t)pbSrc[1] << 8);
+        pbSrc += 2;
+        if (RT_UNLIKELY(offMatch == 0 || offMatch > (size_t)(pbDst - pbDstStart)))
+            return VERR_INVALID_MAGIC;
+
+        size_t cbMatch = bToken & 15;
+        if (cbMatch == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (RT_UNLIKELY(pbSrc >= pbSrcEnd))
+                    return VERR_INVALID_MAGIC;
+                b = *pbSrc++;
+                cbMatch += b;
+            } while (b == 255);
+        }
+        cbMatch += LZ4_MIN_MATCH;
+        if (RT_UNLIKELY(cbMatch > (size_t)(pbDstEnd - pbDst)))
+            return VERR_BUFFER_OVERFLOW;
+
+        uint8_t const *pbRef = pbDst - offMatch;
+        if (offMatch >= cbMatch)
+            memcpy(pbDst, pbRef, cbMatch);
+        else
+            for (size_t i = 0; i < cbMatch; i++) /* overlapping, repeats the pattern */
+                pbDst[i] = pbRef[i];
+        pbDst += cbMatch;
+    }
+
+    if (pcbDstActual)
+        *pcbDstActual = pbDst - pbDstStart;
+    return VINF_SUCCESS;
+}
+
+
+DECLHIDDEN(int) rtZipLz4CompressStreamBlocks(uint8_t const *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst,
+                                             size_t *pcbDstActual)
+{
+    size_t offDst = 0;
+    while (cbSrc > 0)
+    {
+        size_t const cbInput = RT_MIN(cbSrc, RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE);
+        if (cbDst - offDst < sizeof(RTZIPLZ4HDR) + RTZIPLZ4_COMPRESS_BOUND(cbInput))
+            return VERR_BUFFER_OVERFLOW;
+
+        RTZIPLZ4HDR Hdr;
+        Hdr.u16Magic       = RTZIPLZ4HDR_MAGIC;
+        Hdr.fFlags         = 0;
+        Hdr.cbUncompressed = (uint32_t)cbInput;
+
+        uint8_t *pbData = &pbDst[offDst + sizeof(Hdr)];
+        size_t   cbData = rtZipLz4CompressBlock(pbSrc, cbInput, pbData, cbInput);
+        if (!cbData)
+        {
+            /* Didn't compress, store it instead. */
+            memcpy(pbData, pbSrc, cbInput);
+            cbData = cbInput;
+            Hdr.fFlags = RTZIPLZ4HDR_F_STORED;
+        }
+        Hdr.cbData = (uint32_t)cbData;
+        memcpy(&pbDst[offDst], &Hdr, sizeof(Hdr));
+
+        offDst += sizeof(Hdr) + cbData;
+        pbSrc  += cbInput;
+        cbSrc  -= cbInput;
+    }
+
+    *pcbDstActual = offDst;
+    return VINF_SUCCESS;
+}
+
+
+DECLHIDDEN(bool) rtZipLz4ValidHeader(PCRTZIPLZ4HDR pHdr)
+{
+    if (    pHdr->u16Magic != RTZIPLZ4HDR_MAGIC
+        ||  (pHdr->fFlags & ~RTZIPLZ4HDR_F_VALID_MASK)
+        ||  !pHdr->cbUncompressed
+        ||  pHdr->cbUncompressed > RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE
+        ||  !pHdr->cbData
+        ||  pHdr->cbData > RTZIPLZ4_COMPRESS_BOUND(RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE)
+        ||  (   (pHdr->fFlags & RTZIPLZ4HDR_F_STORED)
+             && pHdr->cbData != pHdr->cbUncompressed)
+       )
+    {
+        AssertMsgFailed(("Invalid LZ4 header! %.*Rhxs\n", sizeof(*pHdr), pHdr));
+        return false;
+    }
+    return true;
+}
+
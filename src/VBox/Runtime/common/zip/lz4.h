@@ -0,0 +1,135 @@
+/* $Id: lz4.h $ */
+/** @file
+ * IPRT - Compression, LZ4 Block Format Codec.
+ */
+
+/*
+ * Copyright (C) 2012 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+#ifndef ___zip_lz4_h
+#define ___zip_lz4_h
+
+#include <iprt/types.h>
+#include <iprt/assert.h>
+
+RT_C_DECLS_BEGIN
+
+/**
+ * LZ4 stream block header.
+ *
+ * RTZIPTYPE_LZ4 streams consist of the type byte followed by a sequence of
+ * these headers, each followed by cbData bytes of block data.  Blocks are
+ * independent of each other, which is what makes it possible to compress them
+ * in parallel (see RTZipParCompCreate).
+ */
+#pragma pack(1)
+typedef struct RTZIPLZ4HDR
+{
+    /** Magic word (RTZIPLZ4HDR_MAGIC). */
+    uint16_t    u16Magic;
+    /** Flags, RTZIPLZ4HDR_F_XXX. */
+    uint16_t    fFlags;
+    /** The number of bytes of data following this header. */
+    uint32_t    cbData;
+    /** The size of the uncompressed data in bytes. */
+    uint32_t    cbUncompressed;
+} RTZIPLZ4HDR;
+#pragma pack()
+AssertCompileSize(RTZIPLZ4HDR, 12);
+/** Pointer to a LZ4 block header. */
+typedef RTZIPLZ4HDR *PRTZIPLZ4HDR;
+/** Pointer to a const LZ4 block header. */
+typedef const RTZIPLZ4HDR *PCRTZIPLZ4HDR;
+
+/** The magic of a LZ4 block header. */
+#define RTZIPLZ4HDR_MAGIC                   ('Z' | ('4' << 8))
+/** The block data is stored uncompressed. */
+#define RTZIPLZ4HDR_F_STORED                UINT16_C(0x0001)
+/** Mask of valid flags. */
+#define RTZIPLZ4HDR_F_VALID_MASK            UINT16_C(0x0001)
+
+/** The max uncompressed data size of a stream block.
+ * This limits the size of the spill buffer in the decompressor. */
+#define RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE _64K
+
+/** The worst case compressed size of @a cbSrc bytes of input. */
+#define RTZIPLZ4_COMPRESS_BOUND(cbSrc)      ((cbSrc) + (cbSrc) / 255 + 16)
+
+/** The max stream block size (header + data). */
+#define RTZIPLZ4_MAX_BLOCK_SIZE             (sizeof(RTZIPLZ4HDR) + RTZIPLZ4_COMPRESS_BOUND(RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE))
+
+
+/**
+ * Compresses a buffer into a raw LZ4 block.
+ *
+ * @returns The size of the compressed data, 0 if it didn't fit into the
+ *          output buffer.
+ * @param   pbSrc           The input.
+ * @param   cbSrc           The input size.
+ * @param   pbDst           The output buffer.
+ * @param   cbDst           The size of the output buffer.
+ */
+DECLHIDDEN(size_t) rtZipLz4CompressBlock(uint8_t const *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst);
+
+/**
+ * Decompresses a raw LZ4 block.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_BUFFER_OVERFLOW if the output buffer is too small.
+ * @retval  VERR_INVALID_MAGIC if the input is corrupt.
+ * @param   pbSrc           The compressed data.
+ * @param   cbSrc           The size of the compressed data.
+ * @param   pbDst           The output buffer.
+ * @param   cbDst           The size of the output buffer.
+ * @param   pcbDstActual    Where to return the decompressed size.
+ */
+DECLHIDDEN(int) rtZipLz4DecompressBlock(uint8_t const *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst,
+                                        size_t *pcbDstActual);
+
+/**
+ * Compresses a buffer into a series of LZ4 stream blocks (header + data).
+ *
+ * Incompressible blocks are stored.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_BUFFER_OVERFLOW if the output buffer is too small.  The
+ *          output buffer must have room for RTZIPLZ4_MAX_BLOCK_SIZE per
+ *          RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE bytes of input (or part).
+ * @param   pbSrc           The input.
+ * @param   cbSrc           The input size.
+ * @param   pbDst           The output buffer.
+ * @param   cbDst           The size of the output buffer.
+ * @param   pcbDstActual    Where to return the number of bytes produced.
+ */
+DECLHIDDEN(int) rtZipLz4CompressStreamBlocks(uint8_t const *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst,
+                                             size_t *pcbDstActual);
+
+/**
+ * Validates a LZ4 stream block header.
+ *
+ * @returns true if valid, false if not.
+ * @param   pHdr            The header.
+ */
+DECLHIDDEN(bool) rtZipLz4ValidHeader(PCRTZIPLZ4HDR pHdr);
+
+RT_C_DECLS_END
+
+#endif
@@ -33,6 +33,7 @@
 //#define RTZIP_USE_BZLIB 1
 #define RTZIP_USE_LZF 1
 #define RTZIP_LZF_BLOCK_BY_BLOCK
+#define RTZIP_USE_LZ4 1
 //#define RTZIP_USE_LZJB 1
 //#define RTZIP_USE_LZO 1
 
@@ -52,6 +53,9 @@
 # include <lzf.h>
 # include <iprt/crc.h>
 #endif
+#ifdef RTZIP_USE_LZ4
+# include "lz4.h"
+#endif
 #ifdef RTZIP_USE_LZJB
 # include "lzjb.h"
 #endif
@@ -176,6 +180,18 @@ typedef struct RTZIPCOMP
             uint8_t     abInput[RTZIPLZF_MAX_UNCOMPRESSED_DATA_SIZE];
         } LZF;
 #endif
+#ifdef RTZIP_USE_LZ4
+        /** LZ4 stream. */
+        struct
+        {
+            /** Current output buffer position. */
+            uint8_t    *pbOutput;
+            /** The number of bytes in the input buffer. */
+            size_t      cbInput;
+            /** The input buffer. */
+            uint8_t     abInput[RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE];
+        } LZ4;
+#endif
 
     } u;
 } RTZIPCOMP;
@@ -248,6 +264,18 @@ typedef struct RTZIPDECOMP
             uint8_t    *pbSpill;
         } LZF;
 #endif
+#ifdef RTZIP_USE_LZ4
+        /** LZ4 'stream'. */
+        struct
+        {
+            /** The spill buffer, see LZF. */
+            uint8_t     abSpill[RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE];
+            /** The number of bytes left spill buffer. */
+            size_t      cbSpill;
+            /** The current spill buffer position. */
+            uint8_t    *pbSpill;
+        } LZ4;
+#endif
 
     } u;
 } RTZIPDECOM;
@@ -1336,6 +1364,243 @@ static DECLCALLBACK(int) rtZipLZFDecompInit(PRTZIPDECOMP pZip)
 #endif /* RTZIP_USE_LZF */
 
 
+#ifdef RTZIP_USE_LZ4
+
+/**
+ * Flushes the output buffer.
+ * @returns iprt status code.
+ * @param   pZip        The compressor instance.
+ */
+static int rtZipLz4CompFlushOutput(PRTZIPCOMP pZip)
+{
+    size_t      cb = pZip->u.LZ4.pbOutput - &pZip->abBuffer[0];
+    pZip->u.LZ4.pbOutput = &pZip->abBuffer[0];
+    return pZip->pfnOut(pZip->pvUser, &pZip->abBuffer[0], cb);
+}
+
+
+/**
+ * Compresses a buffer using LZ4, emitting one or more stream blocks.
+ *
+ * @returns VBox status code.
+ * @param   pZip        The compressor instance.
+ * @param   pbBuf       What to compress.
+ * @param   cbBuf       How much to compress.
+ */
+static int rtZipLz4CompressBuffer(PRTZIPCOMP pZip, const uint8_t *pbBuf, size_t cbBuf)
+{
+    while (cbBuf > 0)
+    {
+        size_t cbFree = sizeof(pZip->abBuffer) - (size_t)(pZip->u.LZ4.pbOutput - &pZip->abBuffer[0]);
+        if (cbFree < RTZIPLZ4_MAX_BLOCK_SIZE)
+        {
+            int rc = rtZipLz4CompFlushOutput(pZip);
+            if (RT_FAILURE(rc))
+                return rc;
+            cbFree = sizeof(pZip->abBuffer);
+        }
+
+        size_t const cbInput = RT_MIN(cbBuf, RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE);
+        size_t       cbOutput;
+        int rc = rtZipLz4CompressStreamBlocks(pbBuf, cbInput, pZip->u.LZ4.pbOutput, cbFree, &cbOutput);
+        AssertRCReturn(rc, rc);
+        pZip->u.LZ4.pbOutput += cbOutput;
+        pbBuf += cbInput;
+        cbBuf -= cbInput;
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @copydoc RTZipCompress
+ */
+static DECLCALLBACK(int) rtZipLz4Compress(PRTZIPCOMP pZip, const void *pvBuf, size_t cbBuf)
+{
+    const uint8_t *pbBuf = (const uint8_t *)pvBuf;
+
+    /*
+     * Top up a partially filled input buffer first, then compress full
+     * blocks directly from the caller's buffer and keep the tail for later.
+     */
+    if (pZip->u.LZ4.cbInput)
+    {
+        size_t cb = RT_MIN(cbBuf, sizeof(pZip->u.LZ4.abInput) - pZip->u.LZ4.cbInput);
+        memcpy(&pZip->u.LZ4.abInput[pZip->u.LZ4.cbInput], pbBuf, cb);
+        pZip->u.LZ4.cbInput += cb;
+        pbBuf += cb;
+        cbBuf -= cb;
+        if (pZip->u.LZ4.cbInput < sizeof(pZip->u.LZ4.abInput))
+            return VINF_SUCCESS;
+
+        pZip->u.LZ4.cbInput = 0;
+        int rc = rtZipLz4CompressBuffer(pZip, pZip->u.LZ4.abInput, sizeof(pZip->u.LZ4.abInput));
+        if (RT_FAILURE(rc))
+            return rc;
+    }
+
+    size_t const cbFull = cbBuf & ~(size_t)(sizeof(pZip->u.LZ4.abInput) - 1);
+    if (cbFull)
+    {
+        int rc = rtZipLz4CompressBuffer(pZip, pbBuf, cbFull);
+        if (RT_FAILURE(rc))
+            return rc;
+        pbBuf += cbFull;
+        cbBuf -= cbFull;
+    }
+
+    memcpy(pZip->u.LZ4.abInput, pbBuf, cbBuf);
+    pZip->u.LZ4.cbInput = cbBuf;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @copydoc RTZipCompFinish
+ */
+static DECLCALLBACK(int) rtZipLz4CompFinish(PRTZIPCOMP pZip)
+{
+    int rc = VINF_SUCCESS;
+    if (pZip->u.LZ4.cbInput)
+    {
+        rc = rtZipLz4CompressBuffer(pZip, pZip->u.LZ4.abInput, pZip->u.LZ4.cbInput);
+        pZip->u.LZ4.cbInput = 0;
+    }
+    if (RT_SUCCESS(rc))
+        rc = rtZipLz4CompFlushOutput(pZip);
+    return rc;
+}
+
+
+/**
+ * @copydoc RTZipCompDestroy
+ */
+static DECLCALLBACK(int) rtZipLz4CompDestroy(PRTZIPCOMP pZip)
+{
+    NOREF(pZip);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Initializes the compressor instance.
+ * @returns iprt status code.
+ * @param   pZip        The compressor instance.
+ * @param   enmLevel    The desired compression level.
+ */
+static DECLCALLBACK(int) rtZipLz4CompInit(PRTZIPCOMP pZip, RTZIPLEVEL enmLevel)
+{
+    NOREF(enmLevel);
+    AssertCompile(RT_IS_POWER_OF_TWO(RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE));
+    pZip->pfnCompress = rtZipLz4Compress;
+    pZip->pfnFinish   = rtZipLz4CompFinish;
+    pZip->pfnDestroy  = rtZipLz4CompDestroy;
+
+    pZip->u.LZ4.pbOutput = &pZip->abBuffer[1];
+    pZip->u.LZ4.cbInput  = 0;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @copydoc RTZipDecompress
+ */
+static DECLCALLBACK(int) rtZipLz4Decompress(PRTZIPDECOMP pZip, void *pvBuf, size_t cbBuf, size_t *pcbWritten)
+{
+    /*
+     * Same block by block approach as LZF: decompress straight into the
+     * caller's buffer when the whole block fits, otherwise into the spill.
+     */
+    size_t cbWritten = 0;
+    while (cbBuf > 0)
+    {
+        if (pZip->u.LZ4.cbSpill > 0)
+        {
+            size_t cb = RT_MIN(pZip->u.LZ4.cbSpill, cbBuf);
+            memcpy(pvBuf, pZip->u.LZ4.pbSpill, cb);
+            pZip->u.LZ4.pbSpill += cb;
+            pZip->u.LZ4.cbSpill -= cb;
+            cbWritten += cb;
+            cbBuf -= cb;
+            if (!cbBuf)
+                break;
+            pvBuf = (uint8_t *)pvBuf + cb;
+        }
+
+        RTZIPLZ4HDR Hdr;
+        int rc = pZip->pfnIn(pZip->pvUser, &Hdr, sizeof(Hdr), NULL);
+        if (RT_FAILURE(rc))
+            return rc;
+        if (!rtZipLz4ValidHeader(&Hdr))
+            return VERR_GENERAL_FAILURE; /** @todo Get better error codes for RTZip! */
+        AssertCompile(sizeof(pZip->abBuffer) >= RTZIPLZ4_COMPRESS_BOUND(RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE));
+        rc = pZip->pfnIn(pZip->pvUser, &pZip->abBuffer[0], Hdr.cbData, NULL);
+        if (RT_FAILURE(rc))
+            return rc;
+
+        size_t const cbUncompressed = Hdr.cbUncompressed;
+        uint8_t     *pbDst = cbUncompressed <= cbBuf ? (uint8_t *)pvBuf : &pZip->u.LZ4.abSpill[0];
+        if (Hdr.fFlags & RTZIPLZ4HDR_F_STORED)
+            memcpy(pbDst, &pZip->abBuffer[0], cbUncompressed);
+        else
+        {
+            size_t cbOutput = 0;
+            rc = rtZipLz4DecompressBlock(&pZip->abBuffer[0], Hdr.cbData, pbDst, cbUncompressed, &cbOutput);
+            if (RT_FAILURE(rc) || cbOutput != cbUncompressed)
+            {
+                AssertMsgFailed(("Decompression error, rc=%Rrc cbOutput=%#zx cbUncompressed=%#zx\n",
+                                 rc, cbOutput, cbUncompressed));
+                return VERR_GENERAL_FAILURE; /** @todo Get better error codes for RTZip! */
+            }
+        }
+
+        if (pbDst == pvBuf)
+        {
+            cbBuf -= cbUncompressed;
+            pvBuf = (uint8_t *)pvBuf + cbUncompressed;
+            cbWritten += cbUncompressed;
+        }
+        else
+        {
+            pZip->u.LZ4.pbSpill = &pZip->u.LZ4.abSpill[0];
+            pZip->u.LZ4.cbSpill = cbUncompressed;
+        }
+    }
+
+    if (pcbWritten)
+        *pcbWritten = cbWritten;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @copydoc RTZipDecompDestroy
+ */
+static DECLCALLBACK(int) rtZipLz4DecompDestroy(PRTZIPDECOMP pZip)
+{
+    NOREF(pZip);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Initialize the decompressor instance.
+ * @returns iprt status code.
+ * @param   pZip        The decompressor instance.
+ */
+static DECLCALLBACK(int) rtZipLz4DecompInit(PRTZIPDECOMP pZip)
+{
+    pZip->pfnDecompress = rtZipLz4Decompress;
+    pZip->pfnDestroy    = rtZipLz4DecompDestroy;
+
+    pZip->u.LZ4.cbSpill = 0;
+    pZip->u.LZ4.pbSpill = NULL;
+    return VINF_SUCCESS;
+}
+
+#endif /* RTZIP_USE_LZ4 */
+
+
 /**
  * Create a compressor instance.
  *
@@ -1421,6 +1686,12 @@ RTDECL(int)     RTZipCompCreate(PRTZIPCOMP *ppZip, void *pvUser, PFNRTZIPOUT pfn
 #endif
             break;
 
+        case RTZIPTYPE_LZ4:
+#ifdef RTZIP_USE_LZ4
+            rc = rtZipLz4CompInit(pZip, enmLevel);
+#endif
+            break;
+
         case RTZIPTYPE_LZJB:
         case RTZIPTYPE_LZO:
             break;
@@ -1605,6 +1876,14 @@ static int rtzipDecompInit(PRTZIPDECOMP pZip)
 #endif
             break;
 
+        case RTZIPTYPE_LZ4:
+#ifdef RTZIP_USE_LZ4
+            rc = rtZipLz4DecompInit(pZip);
+#else
+            AssertMsgFailed(("LZ4 is not include in this build!\n"));
+#endif
+            break;
+
         case RTZIPTYPE_LZJB:
 #ifdef RTZIP_USE_LZJB
             AssertMsgFailed(("LZJB streaming support is not implemented yet!\n"));
@@ -1751,6 +2030,19 @@ RTDECL(int) RTZipBlockCompress(RTZIPTYPE enmType, RTZIPLEVEL enmLevel, uint32_t
 #endif
         }
 
+        case RTZIPTYPE_LZ4:
+        {
+#ifdef RTZIP_USE_LZ4
+            size_t cbDstActual = rtZipLz4CompressBlock((uint8_t const *)pvSrc, cbSrc, (uint8_t *)pvDst, cbDst);
+            if (RT_UNLIKELY(cbDstActual < 1))
+                return VERR_BUFFER_OVERFLOW;
+            *pcbDstActual = cbDstActual;
+            break;
+#else
+            return VERR_NOT_SUPPORTED;
+#endif
+        }
+
         case RTZIPTYPE_STORE:
         {
             if (cbDst < cbSrc)
@@ -1851,6 +2143,23 @@ RTDECL(int) RTZipBlockDecompress(RTZIPTYPE enmType, uint32_t fFlags,
 #endif
         }
 
+        case RTZIPTYPE_LZ4:
+        {
+#ifdef RTZIP_USE_LZ4
+            size_t cbDstActual = 0;
+            int rc = rtZipLz4DecompressBlock((uint8_t const *)pvSrc, cbSrc, (uint8_t *)pvDst, cbDst, &cbDstActual);
+            if (RT_UNLIKELY(RT_FAILURE(rc)))
+                return rc == VERR_BUFFER_OVERFLOW ? rc : VERR_GENERAL_FAILURE;
+            if (pcbDstActual)
+                *pcbDstActual = cbDstActual;
+            if (pcbSrcActual)
+                *pcbSrcActual = cbSrc;
+            break;
+#else
+            return VERR_NOT_SUPPORTED;
+#endif
+        }
+
         case RTZIPTYPE_STORE:
         {
             if (cbDst < cbSrc)
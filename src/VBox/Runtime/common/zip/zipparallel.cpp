@@ -0,0 +1,443 @@
+/* $Id: zipparallel.cpp $ */
+/** @file
+ * IPRT - Parallel Block Compression.
+ */
+
+/*
+ * Copyright (C) 2012 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/zip.h>
+#include "internal/iprt.h"
+
+#include <iprt/asm.h>
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/mp.h>
+#include <iprt/semaphore.h>
+#include <iprt/string.h>
+#include <iprt/thread.h>
+
+#include "internal/magics.h"
+#include "lz4.h"
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The default frame size. */
+#define RTZIPPAR_DEFAULT_FRAME_SIZE     _1M
+/** The max frame size. */
+#define RTZIPPAR_MAX_FRAME_SIZE         _4M
+/** The max number of worker threads. */
+#define RTZIPPAR_MAX_THREADS            64
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/**
+ * Frame states.
+ */
+typedef enum RTZIPPARFRAMESTATE
+{
+    /** Free, or being filled by the caller. */
+    RTZIPPARFRAMESTATE_FREE = 0,
+    /** Full and waiting for a worker. */
+    RTZIPPARFRAMESTATE_QUEUED,
+    /** A worker is compressing it. */
+    RTZIPPARFRAMESTATE_BUSY,
+    /** Compressed and waiting to be written. */
+    RTZIPPARFRAMESTATE_DONE
+} RTZIPPARFRAMESTATE;
+
+/**
+ * A frame of input that is compressed independently of the others.
+ */
+typedef struct RTZIPPARFRAME
+{
+    /** The frame state (RTZIPPARFRAMESTATE). */
+    uint32_t volatile   enmState;
+    /** The status of the compression. */
+    int32_t             rc;
+    /** The number of input bytes. */
+    size_t              cbInput;
+    /** The number of output bytes. */
+    size_t              cbOutput;
+    /** The input buffer (cbFrame). */
+    uint8_t            *pbInput;
+    /** The output buffer (cbMaxOutput). */
+    uint8_t            *pbOutput;
+} RTZIPPARFRAME;
+/** Pointer to a frame. */
+typedef RTZIPPARFRAME *PRTZIPPARFRAME;
+
+/**
+ * Parallel compressor instance data.
+ */
+typedef struct RTZIPPARCOMP
+{
+    /** Magic value (RTZIPPARCOMP_MAGIC). */
+    uint32_t            u32Magic;
+    /** Compression type. */
+    RTZIPTYPE           enmType;
+    /** Compression output consumer. */
+    PFNRTZIPOUT         pfnOut;
+    /** User argument for the callback. */
+    void               *pvUser;
+    /** The frame size. */
+    size_t              cbFrame;
+    /** The size of a frame output buffer. */
+    size_t              cbMaxOutput;
+    /** Set when the type byte has been written. */
+    bool                fTypeWritten;
+    /** Set when the workers should terminate. */
+    bool volatile       fShutdown;
+    /** The frame being filled by the caller.
+     * The frames are filled and written in ring order, so this is also the
+     * oldest one that may still be pending output. */
+    uint32_t            iFrame;
+    /** Sticky error status. */
+    int                 rcSticky;
+    /** Event the workers wait on for queued frames. */
+    RTSEMEVENT          hEvtWork;
+    /** Event the caller waits on for completed frames. */
+    RTSEMEVENT          hEvtDone;
+    /** The number of worker threads. */
+    uint32_t            cThreads;
+    /** The worker threads. */
+    PRTTHREAD           pahThreads;
+    /** The number of frames. */
+    uint32_t            cFrames;
+    /** The frames. */
+    PRTZIPPARFRAME      paFrames;
+} RTZIPPARCOMP;
+
+
+/**
+ * Tries to claim a queued frame.
+ *
+ * @returns Pointer to the claimed frame, NULL if none is queued.
+ * @param   pThis       The parallel compressor instance.
+ */
+static PRTZIPPARFRAME rtZipParClaimFrame(PRTZIPPARCOMP pThis)
+{
+    uint32_t const cFrames = pThis->cFrames;
+    uint32_t       i       = ASMAtomicUoReadU32(&pThis->iFrame);
+    for (uint32_t cLeft = cFrames; cLeft > 0; cLeft--, i = (i + 1) % cFrames)
+    {
+        PRTZIPPARFRAME pFrame = &pThis->paFrames[i];
+        if (ASMAtomicCmpXchgU32(&pFrame->enmState, RTZIPPARFRAMESTATE_BUSY, RTZIPPARFRAMESTATE_QUEUED))
+            return pFrame;
+    }
+    return NULL;
+}
+
+
+/**
+ * Compression worker thread.
+ *
+ * @returns VINF_SUCCESS.
+ * @param   hThreadSelf The thread handle.
+ * @param   pvUser      The parallel compressor instance.
+ */
+static DECLCALLBACK(int) rtZipParWorker(RTTHREAD hThreadSelf, void *pvUser)
+{
+    PRTZIPPARCOMP pThis = (PRTZIPPARCOMP)pvUser;
+    NOREF(hThreadSelf);
+
+    while (!ASMAtomicReadBool(&pThis->fShutdown))
+    {
+        PRTZIPPARFRAME pFrame = rtZipParClaimFrame(pThis);
+        if (!pFrame)
+        {
+            RTSemEventWait(pThis->hEvtWork, RT_INDEFINITE_WAIT);
+            continue;
+        }
+
+        /* The event only wakes one thread, pass it on if there is more work. */
+        for (uint32_t i = 0; i < pThis->cFrames; i++)
+            if (ASMAtomicReadU32(&pThis->paFrames[i].enmState) == RTZIPPARFRAMESTATE_QUEUED)
+            {
+                RTSemEventSignal(pThis->hEvtWork);
+                break;
+            }
+
+        pFrame->rc = rtZipLz4CompressStreamBlocks(pFrame->pbInput, pFrame->cbInput,
+                                                  pFrame->pbOutput, pThis->cbMaxOutput, &pFrame->cbOutput);
+        ASMAtomicWriteU32(&pFrame->enmState, RTZIPPARFRAMESTATE_DONE);
+        RTSemEventSignal(pThis->hEvtDone);
+    }
+
+    /* Wake up the next worker so it can notice the shutdown too. */
+    RTSemEventSignal(pThis->hEvtWork);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Writes the stream type byte if not already done.
+ *
+ * @returns iprt status code.
+ * @param   pThis       The parallel compressor instance.
+ */
+static int rtZipParWriteType(PRTZIPPARCOMP pThis)
+{
+    if (pThis->fTypeWritten)
+        return VINF_SUCCESS;
+    uint8_t const bType = (uint8_t)pThis->enmType;
+    int rc = pThis->pfnOut(pThis->pvUser, &bType, sizeof(bType));
+    if (RT_SUCCESS(rc))
+        pThis->fTypeWritten = true;
+    return rc;
+}
+
+
+/**
+ * Waits for a frame to complete and writes it out, leaving it free.
+ *
+ * @returns iprt status code.
+ * @param   pThis       The parallel compressor instance.
+ * @param   pFrame      The frame, must be queued, busy or done.
+ */
+static int rtZipParFlushFrame(PRTZIPPARCOMP pThis, PRTZIPPARFRAME pFrame)
+{
+    while (ASMAtomicReadU32(&pFrame->enmState) != RTZIPPARFRAMESTATE_DONE)
+        RTSemEventWait(pThis->hEvtDone, RT_INDEFINITE_WAIT);
+
+    int rc = pFrame->rc;
+    if (RT_SUCCESS(rc))
+        rc = rtZipParWriteType(pThis);
+    if (RT_SUCCESS(rc))
+        rc = pThis->pfnOut(pThis->pvUser, pFrame->pbOutput, pFrame->cbOutput);
+
+    pFrame->cbInput = 0;
+    ASMAtomicWriteU32(&pFrame->enmState, RTZIPPARFRAMESTATE_FREE);
+    return rc;
+}
+
+
+/**
+ * Hands the current frame to the workers and moves on to the next one,
+ * writing it out first if it is still pending.
+ *
+ * @returns iprt status code.
+ * @param   pThis       The parallel compressor instance.
+ */
+static int rtZipParQueueFrame(PRTZIPPARCOMP pThis)
+{
+    PRTZIPPARFRAME pFrame = &pThis->paFrames[pThis->iFrame];
+    Assert(pFrame->cbInput > 0);
+    ASMAtomicWriteU32(&pFrame->enmState, RTZIPPARFRAMESTATE_QUEUED);
+    RTSemEventSignal(pThis->hEvtWork);
+
+    uint32_t const iFrame = (pThis->iFrame + 1) % pThis->cFrames;
+    ASMAtomicWriteU32(&pThis->iFrame, iFrame);
+
+    pFrame = &pThis->paFrames[iFrame];
+    if (ASMAtomicReadU32(&pFrame->enmState) != RTZIPPARFRAMESTATE_FREE)
+        return rtZipParFlushFrame(pThis, pFrame);
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(int) RTZipParCompCreate(PRTZIPPARCOMP *ppZip, void *pvUser, PFNRTZIPOUT pfnOut, RTZIPTYPE enmType,
+                               RTZIPLEVEL enmLevel, uint32_t cThreads, size_t cbFrame)
+{
+    /*
+     * Validate input.
+     */
+    AssertPtrReturn(ppZip, VERR_INVALID_POINTER);
+    AssertPtrReturn(pfnOut, VERR_INVALID_POINTER);
+    AssertReturn(enmType > RTZIPTYPE_INVALID && enmType < RTZIPTYPE_END, VERR_INVALID_PARAMETER);
+    AssertReturn(enmLevel >= RTZIPLEVEL_STORE && enmLevel <= RTZIPLEVEL_MAX, VERR_INVALID_PARAMETER);
+    AssertReturn(cbFrame <= RTZIPPAR_MAX_FRAME_SIZE, VERR_INVALID_PARAMETER);
+    AssertReturn(cThreads <= RTZIPPAR_MAX_THREADS, VERR_INVALID_PARAMETER);
+    *ppZip = NULL;
+
+    /* Only block based codecs with independent blocks make sense here. */
+    if (enmType == RTZIPTYPE_AUTO)
+        enmType = RTZIPTYPE_LZ4;
+    if (enmType != RTZIPTYPE_LZ4)
+        return VERR_NOT_SUPPORTED;
+
+    if (!cThreads)
+        cThreads = RT_MIN(RT_MAX(RTMpGetOnlineCount(), 1), RTZIPPAR_MAX_THREADS);
+    if (!cbFrame)
+        cbFrame = RTZIPPAR_DEFAULT_FRAME_SIZE;
+    cbFrame = RT_ALIGN_Z(cbFrame, RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE);
+
+    /*
+     * Allocate the instance, the frames and their buffers.
+     */
+    uint32_t const cFrames     = cThreads * 2;
+    size_t const   cbMaxOutput = cbFrame / RTZIPLZ4_MAX_UNCOMPRESSED_DATA_SIZE * RTZIPLZ4_MAX_BLOCK_SIZE;
+    PRTZIPPARCOMP pThis = (PRTZIPPARCOMP)RTMemAllocZ(  sizeof(*pThis)
+                                                     + sizeof(pThis->paFrames[0]) * cFrames
+                                                     + sizeof(pThis->pahThreads[0]) * cThreads);
+    if (!pThis)
+        return VERR_NO_MEMORY;
+    pThis->u32Magic     = RTZIPPARCOMP_MAGIC;
+    pThis->enmType      = enmType;
+    pThis->pfnOut       = pfnOut;
+    pThis->pvUser       = pvUser;
+    pThis->cbFrame      = cbFrame;
+    pThis->cbMaxOutput  = cbMaxOutput;
+    pThis->fTypeWritten = false;
+    pThis->fShutdown    = false;
+    pThis->iFrame       = 0;
+    pThis->rcSticky     = VINF_SUCCESS;
+    pThis->hEvtWork     = NIL_RTSEMEVENT;
+    pThis->hEvtDone     = NIL_RTSEMEVENT;
+    pThis->cThreads     = 0;
+    pThis->cFrames      = cFrames;
+    pThis->paFrames     = (PRTZIPPARFRAME)(pThis + 1);
+    pThis->pahThreads   = (PRTTHREAD)&pThis->paFrames[cFrames];
+
+    int rc = VINF_SUCCESS;
+    for (uint32_t i = 0; i < cFrames && RT_SUCCESS(rc); i++)
+    {
+        pThis->paFrames[i].enmState = RTZIPPARFRAMESTATE_FREE;
+        pThis->paFrames[i].pbInput  = (uint8_t *)RTMemAlloc(cbFrame + cbMaxOutput);
+        if (pThis->paFrames[i].pbInput)
+            pThis->paFrames[i].pbOutput = pThis->paFrames[i].pbInput + cbFrame;
+        else
+            rc = VERR_NO_MEMORY;
+    }
+    if (RT_SUCCESS(rc))
+        rc = RTSemEventCreate(&pThis->hEvtWork);
+    if (RT_SUCCESS(rc))
+        rc = RTSemEventCreate(&pThis->hEvtDone);
+
+    /*
+     * Start the workers.
+     */
+    for (uint32_t i = 0; i < cThreads && RT_SUCCESS(rc); i++)
+    {
+        rc = RTThreadCreateF(&pThis->pahThreads[i], rtZipParWorker, pThis, 0 /*cbStack*/, RTTHREADTYPE_DEFAULT,
+                             RTTHREADFLAGS_WAITABLE, "RTZipPar%u", i);
+        if (RT_SUCCESS(rc))
+            pThis->cThreads++;
+    }
+
+    if (RT_SUCCESS(rc))
+        *ppZip = pThis;
+    else
+        RTZipParCompDestroy(pThis);
+    return rc;
+}
+RT_EXPORT_SYMBOL(RTZipParCompCreate);
+
+
+RTDECL(int) RTZipParCompress(PRTZIPPARCOMP pZip, const void *pvBuf, size_t cbBuf)
+{
+    AssertPtrReturn(pZip, VERR_INVALID_HANDLE);
+    AssertReturn(pZip->u32Magic == RTZIPPARCOMP_MAGIC, VERR_INVALID_HANDLE);
+    if (RT_FAILURE(pZip->rcSticky))
+        return pZip->rcSticky;
+
+    const uint8_t *pbBuf = (const uint8_t *)pvBuf;
+    while (cbBuf > 0)
+    {
+        PRTZIPPARFRAME pFrame = &pZip->paFrames[pZip->iFrame];
+        Assert(pFrame->enmState == RTZIPPARFRAMESTATE_FREE);
+        size_t const cb = RT_MIN(cbBuf, pZip->cbFrame - pFrame->cbInput);
+        memcpy(&pFrame->pbInput[pFrame->cbInput], pbBuf, cb);
+        pFrame->cbInput += cb;
+        pbBuf += cb;
+        cbBuf -= cb;
+
+        if (pFrame->cbInput == pZip->cbFrame)
+        {
+            int rc = rtZipParQueueFrame(pZip);
+            if (RT_FAILURE(rc))
+                return pZip->rcSticky = rc;
+        }
+    }
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTZipParCompress);
+
+
+RTDECL(int) RTZipParCompFinish(PRTZIPPARCOMP pZip)
+{
+    AssertPtrReturn(pZip, VERR_INVALID_HANDLE);
+    AssertReturn(pZip->u32Magic == RTZIPPARCOMP_MAGIC, VERR_INVALID_HANDLE);
+    if (RT_FAILURE(pZip->rcSticky))
+        return pZip->rcSticky;
+
+    /*
+     * Queue the partial frame, then write out everything in ring order
+     * starting with the oldest.
+     */
+    int rc = VINF_SUCCESS;
+    if (pZip->paFrames[pZip->iFrame].cbInput > 0)
+        rc = rtZipParQueueFrame(pZip);
+    for (uint32_t cLeft = pZip->cFrames; cLeft > 0 && RT_SUCCESS(rc); cLeft--)
+    {
+        PRTZIPPARFRAME pFrame = &pZip->paFrames[pZip->iFrame];
+        if (ASMAtomicReadU32(&pFrame->enmState) != RTZIPPARFRAMESTATE_FREE)
+            rc = rtZipParFlushFrame(pZip, pFrame);
+        ASMAtomicWriteU32(&pZip->iFrame, (pZip->iFrame + 1) % pZip->cFrames);
+    }
+    if (RT_SUCCESS(rc))
+        rc = rtZipParWriteType(pZip);
+    if (RT_FAILURE(rc))
+        pZip->rcSticky = rc;
+    return rc;
+}
+RT_EXPORT_SYMBOL(RTZipParCompFinish);
+
+
+RTDECL(int) RTZipParCompDestroy(PRTZIPPARCOMP pZip)
+{
+    if (!pZip)
+        return VINF_SUCCESS;
+    AssertPtrReturn(pZip, VERR_INVALID_HANDLE);
+    AssertReturn(pZip->u32Magic == RTZIPPARCOMP_MAGIC, VERR_INVALID_HANDLE);
+
+    /*
+     * Stop the workers.  Each of them passes the wakeup on to the next.
+     */
+    ASMAtomicWriteBool(&pZip->fShutdown, true);
+    if (pZip->hEvtWork != NIL_RTSEMEVENT)
+        RTSemEventSignal(pZip->hEvtWork);
+    for (uint32_t i = 0; i < pZip->cThreads; i++)
+    {
+        int rc = RTThreadWait(pZip->pahThreads[i], RT_INDEFINITE_WAIT, NULL);
+        AssertRC(rc);
+    }
+
+    RTSemEventDestroy(pZip->hEvtWork);
+    RTSemEventDestroy(pZip->hEvtDone);
+    for (uint32_t i = 0; i < pZip->cFrames; i++)
+        RTMemFree(pZip->paFrames[i].pbInput);
+
+    pZip->u32Magic = RTZIPPARCOMP_MAGIC_DEAD;
+    RTMemFree(pZip);
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTZipParCompDestroy);
+
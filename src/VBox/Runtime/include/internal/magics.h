@@ -218,6 +218,10 @@
 #define RTVFSSYMLINK_MAGIC              UINT32_C(0x18960924)
 /** The value of RTVFSSYMLINKINTERNAL::u32Magic after close. */
 #define RTVFSSYMLINK_MAGIC_DEAD         UINT32_C(0x19401221)
+/** The value of RTZIPPARCOMP::u32Magic. (Italo Calvino) */
+#define RTZIPPARCOMP_MAGIC              UINT32_C(0x19231015)
+/** The value of RTZIPPARCOMP::u32Magic after destruction. */
+#define RTZIPPARCOMP_MAGIC_DEAD         UINT32_C(0x19850919)
 
 /** @} */
 
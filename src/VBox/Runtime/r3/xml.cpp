@@ -178,13 +178,15 @@ struct File::Data
     RTFILE handle;
     bool opened : 1;
     bool flushOnClose : 1;
+    bool flushParentOnClose : 1;
 };
 
-File::File(Mode aMode, const char *aFileName, bool aFlushIt /* = false */)
+File::File(Mode aMode, const char *aFileName, bool aFlushIt /* = false */, bool aFlushParent /* = true */)
     : m(new Data())
 {
     m->strFileName = aFileName;
     m->flushOnClose = aFlushIt;
+    m->flushParentOnClose = aFlushParent;
 
     uint32_t flags = 0;
     switch (aMode)
@@ -223,6 +225,7 @@ File::File(RTFILE aHandle, const char *aFileName /* = NULL */, bool aFlushIt /*
         m->strFileName = aFileName;
 
     m->flushOnClose = aFlushIt;
+    m->flushParentOnClose = true;
 
     setPos(0);
 }
@@ -232,7 +235,7 @@ File::~File()
     if (m->flushOnClose)
     {
         RTFileFlush(m->handle);
-        if (!m->strFileName.isEmpty())
+        if (m->flushParentOnClose && !m->strFileName.isEmpty())
             RTDirFlushParent(m->strFileName.c_str());
     }
 
@@ -1582,8 +1585,8 @@ struct IOContext
     File file;
     RTCString error;
 
-    IOContext(const char *pcszFilename, File::Mode mode, bool fFlush = false)
-        : file(mode, pcszFilename, fFlush)
+    IOContext(const char *pcszFilename, File::Mode mode, bool fFlush = false, bool fFlushParent = true)
+        : file(mode, pcszFilename, fFlush, fFlushParent)
     {
     }
 
@@ -1608,8 +1611,8 @@ struct ReadContext : IOContext
 
 struct WriteContext : IOContext
 {
-    WriteContext(const char *pcszFilename, bool fFlush)
-        : IOContext(pcszFilename, File::Mode_Overwrite, fFlush)
+    WriteContext(const char *pcszFilename, bool fFlush, bool fFlushParent)
+        : IOContext(pcszFilename, File::Mode_Overwrite, fFlush, fFlushParent)
     {
     }
 };
@@ -1696,9 +1699,9 @@ XmlFileWriter::~XmlFileWriter()
     delete m;
 }
 
-void XmlFileWriter::writeInternal(const char *pcszFilename, bool fSafe)
+void XmlFileWriter::writeInternal(const char *pcszFilename, bool fSafe, bool fFlushDir)
 {
-    WriteContext context(pcszFilename, fSafe);
+    WriteContext context(pcszFilename, fSafe, fFlushDir);
 
     GlobalLock lock;
 
@@ -1731,9 +1734,14 @@ void XmlFileWriter::writeInternal(const char *pcszFilename, bool fSafe)
 }
 
 void XmlFileWriter::write(const char *pcszFilename, bool fSafe)
+{
+    write(pcszFilename, fSafe, true /*fFlushTmpDir*/);
+}
+
+void XmlFileWriter::write(const char *pcszFilename, bool fSafe, bool fFlushTmpDir)
 {
     if (!fSafe)
-        writeInternal(pcszFilename, fSafe);
+        writeInternal(pcszFilename, fSafe, true /*fFlushDir*/);
     else
     {
         /* Empty string and directory spec must be avoid. */
@@ -1754,7 +1762,7 @@ void XmlFileWriter::write(const char *pcszFilename, bool fSafe)
         strcat(szPrevFilename, s_pszPrevSuff);
 
         /* Write the XML document to the temporary file.  */
-        writeInternal(szTmpFilename, fSafe);
+        writeInternal(szTmpFilename, fSafe, fFlushTmpDir);
 
         /* Make a backup of any existing file (ignore failure). */
         uint64_t cbPrevFile;
@@ -31,11 +31,14 @@
 
 #include <iprt/asm.h>
 #include <iprt/err.h>
+#include <iprt/getopt.h>
 #include <iprt/initterm.h>
+#include <iprt/mempool.h>
 #include <iprt/string.h>
 #include <iprt/test.h>
 #include <iprt/thread.h>
 #include <iprt/rand.h>
+#include <iprt/time.h>
 
 
 /**
@@ -57,6 +60,14 @@ static void tst1(RTSTRCACHE hStrCache)
     RTTESTI_CHECK_RETV(RTStrCacheLength(psz) == strlen("abcdefghijklmnopqrstuvwxyz"));
     RTTESTI_CHECK_RETV(RTStrCacheRelease(hStrCache, psz) == 0);
 
+    /* Entering the same string twice yields the same copy. */
+    const char *psz2;
+    RTTESTI_CHECK_RETV(psz = RTStrCacheEnter(hStrCache, "abcdefgh"));
+    RTTESTI_CHECK_RETV(psz2 = RTStrCacheEnterN(hStrCache, "abcdefghijkl", 8));
+    RTTESTI_CHECK(psz2 == psz);
+    RTTESTI_CHECK(RTStrCacheRelease(hStrCache, psz2) == 1);
+    RTTESTI_CHECK_RETV(RTStrCacheRelease(hStrCache, psz) == 0);
+
     /* Unterminated strings. */
     RTTESTI_CHECK_RETV(psz = RTStrCacheEnterN(hStrCache, "0123456789", 3));
     RTTESTI_CHECK_RETV(strcmp(psz, "012") == 0);
@@ -110,7 +121,109 @@ static void tst1(RTSTRCACHE hStrCache)
 }
 
 
-int main()
+/** The number of distinct strings used by the benchmark. */
+#define TST2_STRINGS    4096
+/** The number of enter+release iterations per thread. */
+#define TST2_ITERATIONS _1M
+
+/** Benchmark strings. */
+static char g_aszTst2Strings[TST2_STRINGS][32];
+/** Set when the benchmark should use RTMemPoolDupEx instead of the cache. */
+static bool volatile g_fTst2MemPool;
+/** The string cache or memory pool used by the benchmark. */
+static void *g_pvTst2Handle;
+
+
+/**
+ * Benchmark worker thread.
+ */
+static DECLCALLBACK(int) tst2Thread(RTTHREAD hThread, void *pvUser)
+{
+    uint32_t iString = (uint32_t)(uintptr_t)pvUser * 7919;
+    for (uint32_t i = 0; i < TST2_ITERATIONS; i++, iString += 31)
+    {
+        const char *pszSrc = g_aszTst2Strings[iString % TST2_STRINGS];
+        size_t      cchSrc = strlen(pszSrc);
+        if (g_fTst2MemPool)
+        {
+            void *pv = RTMemPoolDupEx((RTMEMPOOL)g_pvTst2Handle, pszSrc, cchSrc, 1);
+            if (!pv)
+                return VERR_NO_MEMORY;
+            RTMemPoolRelease((RTMEMPOOL)g_pvTst2Handle, pv);
+        }
+        else
+        {
+            const char *psz = RTStrCacheEnterN((RTSTRCACHE)g_pvTst2Handle, pszSrc, cchSrc);
+            if (!psz)
+                return VERR_NO_MEMORY;
+            RTStrCacheRelease((RTSTRCACHE)g_pvTst2Handle, psz);
+        }
+    }
+    NOREF(hThread);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Runs the benchmark with the given number of threads.
+ *
+ * @returns Nanoseconds per enter+release.
+ */
+static uint64_t tst2Run(uint32_t cThreads)
+{
+    RTTHREAD ahThreads[16];
+    RTTESTI_CHECK_RET(cThreads <= RT_ELEMENTS(ahThreads), 0);
+
+    uint64_t const nsStart = RTTimeNanoTS();
+    uint32_t i;
+    for (i = 0; i < cThreads; i++)
+        RTTESTI_CHECK_RC_BREAK(RTThreadCreateF(&ahThreads[i], tst2Thread, (void *)(uintptr_t)i, 0,
+                                               RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "tst2-%u", i),
+                                VINF_SUCCESS);
+    while (i-- > 0)
+    {
+        int rcThread = VERR_INTERNAL_ERROR;
+        RTTESTI_CHECK_RC(RTThreadWait(ahThreads[i], RT_INDEFINITE_WAIT, &rcThread), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(rcThread, VINF_SUCCESS);
+    }
+    uint64_t const cNsElapsed = RTTimeNanoTS() - nsStart;
+
+    return cNsElapsed / ((uint64_t)TST2_ITERATIONS * cThreads);
+}
+
+
+/**
+ * Multi-threaded intern throughput, compared against plain memory pool
+ * duplication (which is what the cache used to do).
+ */
+static void tst2(RTTEST hTest)
+{
+    for (uint32_t i = 0; i < TST2_STRINGS; i++)
+        RTStrPrintf(g_aszTst2Strings[i], sizeof(g_aszTst2Strings[i]), "/VirtualBox/Machine/%u/Name", i * 2654435761U);
+
+    static uint32_t const s_acThreads[] = { 1, 2, 4, 8, 16 };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_acThreads); i++)
+    {
+        uint32_t const cThreads = s_acThreads[i];
+
+        RTMEMPOOL hMemPool;
+        RTTESTI_CHECK_RC_RETV(RTMemPoolCreate(&hMemPool, "tst2"), VINF_SUCCESS);
+        g_pvTst2Handle = hMemPool;
+        g_fTst2MemPool = true;
+        RTTestValueF(hTest, tst2Run(cThreads), RTTESTUNIT_NS_PER_CALL, "RTMemPoolDupEx, %u threads", cThreads);
+        RTTESTI_CHECK_RC(RTMemPoolDestroy(hMemPool), VINF_SUCCESS);
+
+        RTSTRCACHE hStrCache;
+        RTTESTI_CHECK_RC_RETV(RTStrCacheCreate(&hStrCache, "tst2"), VINF_SUCCESS);
+        g_pvTst2Handle = hStrCache;
+        g_fTst2MemPool = false;
+        RTTestValueF(hTest, tst2Run(cThreads), RTTESTUNIT_NS_PER_CALL, "RTStrCacheEnterN, %u threads", cThreads);
+        RTTESTI_CHECK_RC(RTStrCacheDestroy(hStrCache), VINF_SUCCESS);
+    }
+}
+
+
+int main(int argc, char **argv)
 {
     RTTEST hTest;
     int rc = RTTestInitAndCreate("tstRTStrCache", &hTest);
@@ -118,6 +231,38 @@ int main()
         return rc;
     RTTestBanner(hTest);
 
+    /*
+     * Parse arguments.
+     */
+    static const RTGETOPTDEF s_aOptions[] =
+    {
+        { "--benchmark",    'b',    RTGETOPT_REQ_NOTHING },
+    };
+    bool fBenchmark = false;
+
+    int ch;
+    RTGETOPTUNION ValueUnion;
+    RTGETOPTSTATE GetState;
+    RTGetOptInit(&GetState, argc, argv, s_aOptions, RT_ELEMENTS(s_aOptions), 1, 0);
+    while ((ch = RTGetOpt(&GetState, &ValueUnion)))
+    {
+        switch (ch)
+        {
+            case 'b':
+                fBenchmark = true;
+                break;
+
+            case 'h':
+                RTTestPrintf(hTest, RTTESTLVL_ALWAYS, "usage: tstRTStrCache [--benchmark]\n");
+                return RTTestSummaryAndDestroy(hTest);
+
+            default:
+                RTTestFailed(hTest, "invalid argument");
+                RTGetOptPrintError(ch, &ValueUnion);
+                return RTTestSummaryAndDestroy(hTest);
+        }
+    }
+
     /*
      * Smoke tests using first the default and then a custom pool.
      */
@@ -140,6 +285,16 @@ int main()
         RTTESTI_CHECK_RC(rc = RTStrCacheDestroy(hStrCache), VINF_SUCCESS);
     }
 
+    /*
+     * Benchmark multi-threaded string interning.  This takes a while, so
+     * it is only done on request.
+     */
+    if (fBenchmark)
+    {
+        RTTestSub(hTest, "Multi-threaded benchmark");
+        tst2(hTest);
+    }
+
     /*
      * Summary.
      */
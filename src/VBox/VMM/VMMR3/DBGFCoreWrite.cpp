@@ -42,6 +42,11 @@
  *    ...
  * Memory dump
  *
+ * Pages which are all zero (which includes ballooned and never touched
+ * pages) are not written to the memory dump but left as holes in the file,
+ * which read back as zeros and take no space on file systems supporting
+ * sparse files.
+ *
  */
 
 /*******************************************************************************
@@ -49,7 +54,9 @@
 *******************************************************************************/
 #define LOG_GROUP LOG_GROUP_DBGF
 #include <iprt/param.h>
+#include <iprt/asm.h>
 #include <iprt/file.h>
+#include <iprt/mem.h>
 
 #include "DBGFInternal.h"
 
@@ -71,6 +78,8 @@
 *   Defined Constants And Macros                                               *
 *******************************************************************************/
 #define DBGFLOG_NAME           "DBGFCoreWrite"
+/** The number of guest pages read and written in one go. */
+#define DBGFCORE_CHUNK_PAGES   256
 
 
 /*******************************************************************************
@@ -440,8 +449,23 @@ static int dbgfR3CoreWriteWorker(PVM pVM, RTFILE hFile)
 
     /*
      * Write memory ranges.
+     *
+     * Guest memory is read a chunk at a time and each run of non-zero pages
+     * in the chunk is written with a single call.  Zero pages are skipped,
+     * leaving a hole which the final size adjustment takes care of.
      */
     Assert(RTFileTell(hFile) == offMemory);
+    uint64_t const offMemoryEnd = offMemRange;
+    uint8_t *pbChunk = (uint8_t *)RTMemPageAlloc(DBGFCORE_CHUNK_PAGES << PAGE_SHIFT);
+    if (!pbChunk)
+    {
+        LogRel((DBGFLOG_NAME ": Failed to allocate the %u page read buffer\n", DBGFCORE_CHUNK_PAGES));
+        return VERR_NO_MEMORY;
+    }
+
+    uint64_t cPagesWritten = 0;
+    uint64_t cPagesZero    = 0;
+    offMemRange = offMemory;
     for (uint16_t iRange = 0; iRange < cMemRanges; iRange++)
     {
         RTGCPHYS GCPhysStart;
@@ -451,38 +475,89 @@ static int dbgfR3CoreWriteWorker(PVM pVM, RTFILE hFile)
         if (RT_FAILURE(rc))
         {
             LogRel((DBGFLOG_NAME ": PGMR3PhysGetRange(2) failed for iRange(%u) rc=%Rrc\n", iRange, rc));
-            return rc;
+            break;
         }
 
         if (fIsMmio)
             continue;
 
         /*
-         * Write page-by-page of this memory range.
+         * Write this memory range chunk by chunk.
          *
          * The read function may fail on MMIO ranges, we write these as zero
          * pages for now (would be nice to have the VGA bits there though).
+         * When reading a whole chunk fails we fall back on reading it page
+         * by page so only the offending pages end up as zeros. Read failures
+         * are kept out of rc, they must not abort the dump.
          */
         uint64_t cbMemRange  = GCPhysEnd - GCPhysStart + 1;
         uint64_t cPages      = cbMemRange >> PAGE_SHIFT;
-        for (uint64_t iPage = 0; iPage < cPages; iPage++)
+        for (uint64_t iPage = 0; iPage < cPages; iPage += DBGFCORE_CHUNK_PAGES)
         {
-            uint8_t abPage[PAGE_SIZE];
-            rc = PGMPhysSimpleReadGCPhys(pVM, abPage, GCPhysStart + (iPage << PAGE_SHIFT),  sizeof(abPage));
-            if (RT_FAILURE(rc))
+            uint32_t const cChunkPages = (uint32_t)RT_MIN(cPages - iPage, DBGFCORE_CHUNK_PAGES);
+            RTGCPHYS const GCPhysChunk = GCPhysStart + (iPage << PAGE_SHIFT);
+            int rcRead = PGMPhysSimpleReadGCPhys(pVM, pbChunk, GCPhysChunk, (size_t)cChunkPages << PAGE_SHIFT);
+            if (RT_FAILURE(rcRead))
             {
-                if (rc != VERR_PGM_PHYS_PAGE_RESERVED)
-                    LogRel((DBGFLOG_NAME ": PGMPhysRead failed for iRange=%u iPage=%u. rc=%Rrc. Ignoring...\n", iRange, iPage, rc));
-                RT_ZERO(abPage);
+                for (uint32_t i = 0; i < cChunkPages; i++)
+                {
+                    uint8_t *pbPage = &pbChunk[i << PAGE_SHIFT];
+                    rcRead = PGMPhysSimpleReadGCPhys(pVM, pbPage, GCPhysChunk + (i << PAGE_SHIFT), PAGE_SIZE);
+                    if (RT_FAILURE(rcRead))
+                    {
+                        if (rcRead != VERR_PGM_PHYS_PAGE_RESERVED)
+                            LogRel((DBGFLOG_NAME ": PGMPhysRead failed for iRange=%u iPage=%RU64. rc=%Rrc. Ignoring...\n",
+                                    iRange, iPage + i, rcRead));
+                        memset(pbPage, 0, PAGE_SIZE);
+                    }
+                }
             }
 
-            rc = RTFileWrite(hFile, abPage, sizeof(abPage), NULL /* all */);
-            if (RT_FAILURE(rc))
+            uint32_t i = 0;
+            while (i < cChunkPages)
             {
-                LogRel((DBGFLOG_NAME ": RTFileWrite failed. iRange=%u iPage=%u rc=%Rrc\n", iRange, iPage, rc));
-                return rc;
+                if (ASMMemIsZeroPage(&pbChunk[i << PAGE_SHIFT]))
+                {
+                    cPagesZero++;
+                    i++;
+                    continue;
+                }
+
+                uint32_t const iFirst = i;
+                while (++i < cChunkPages && !ASMMemIsZeroPage(&pbChunk[i << PAGE_SHIFT]))
+                    ;
+                rc = RTFileWriteAt(hFile, offMemRange + ((iPage + iFirst) << PAGE_SHIFT), &pbChunk[iFirst << PAGE_SHIFT],
+                                   (size_t)(i - iFirst) << PAGE_SHIFT, NULL /* all */);
+                if (RT_FAILURE(rc))
+                {
+                    LogRel((DBGFLOG_NAME ": RTFileWriteAt failed. iRange=%u iPage=%RU64 cPages=%u rc=%Rrc\n",
+                            iRange, iPage + iFirst, i - iFirst, rc));
+                    break;
+                }
+                cPagesWritten += i - iFirst;
             }
+            if (RT_FAILURE(rc))
+                break;
         }
+        if (RT_FAILURE(rc))
+            break;
+
+        offMemRange += cbMemRange;
+    }
+
+    RTMemPageFree(pbChunk, DBGFCORE_CHUNK_PAGES << PAGE_SHIFT);
+
+    /*
+     * Extend the file over any trailing zero pages.
+     */
+    if (RT_SUCCESS(rc))
+    {
+        Assert(offMemRange == offMemoryEnd);
+        rc = RTFileSetSize(hFile, offMemoryEnd);
+        if (RT_FAILURE(rc))
+            LogRel((DBGFLOG_NAME ": RTFileSetSize failed. cbFile=%#RX64 rc=%Rrc\n", offMemoryEnd, rc));
+        else
+            LogRel((DBGFLOG_NAME ": Wrote %RU64 pages, skipped %RU64 zero pages\n", cPagesWritten, cPagesZero));
     }
 
     return rc;
@@ -384,6 +384,9 @@ int main(int argc, char **argv)
         int         rc;
         /** The compression style: block or stream. */
         bool        fBlock;
+        /** The number of threads for parallel stream compression, 0 for
+         *  the regular stream compressor. */
+        uint32_t    cThreads;
         /** Compression type.  */
         RTZIPTYPE   enmType;
         /** Compression level.  */
@@ -392,13 +395,19 @@ int main(int argc, char **argv)
         const char *pszName;
     } aTests[] =
     {
-        { 0, 0, 0, VINF_SUCCESS, false, RTZIPTYPE_STORE, RTZIPLEVEL_DEFAULT, "RTZip/Store"      },
-        { 0, 0, 0, VINF_SUCCESS, false, RTZIPTYPE_LZF,   RTZIPLEVEL_DEFAULT, "RTZip/LZF"        },
-/*      { 0, 0, 0, VINF_SUCCESS, false, RTZIPTYPE_ZLIB,  RTZIPLEVEL_DEFAULT, "RTZip/zlib"       }, - slow plus it randomly hits VERR_GENERAL_FAILURE atm. */
-        { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_STORE, RTZIPLEVEL_DEFAULT, "RTZipBlock/Store" },
-        { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_LZF,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZF"   },
-        { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_LZJB,  RTZIPLEVEL_DEFAULT, "RTZipBlock/LZJB"  },
-        { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_LZO,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZO"   },
+        { 0, 0, 0, VINF_SUCCESS, false, 0, RTZIPTYPE_STORE, RTZIPLEVEL_DEFAULT, "RTZip/Store"      },
+        { 0, 0, 0, VINF_SUCCESS, false, 0, RTZIPTYPE_LZF,   RTZIPLEVEL_DEFAULT, "RTZip/LZF"        },
+        { 0, 0, 0, VINF_SUCCESS, false, 0, RTZIPTYPE_LZ4,   RTZIPLEVEL_DEFAULT, "RTZip/LZ4"        },
+        { 0, 0, 0, VINF_SUCCESS, false, 1, RTZIPTYPE_LZ4,   RTZIPLEVEL_DEFAULT, "RTZipPar/LZ4/1"   },
+        { 0, 0, 0, VINF_SUCCESS, false, 2, RTZIPTYPE_LZ4,   RTZIPLEVEL_DEFAULT, "RTZipPar/LZ4/2"   },
+        { 0, 0, 0, VINF_SUCCESS, false, 4, RTZIPTYPE_LZ4,   RTZIPLEVEL_DEFAULT, "RTZipPar/LZ4/4"   },
+        { 0, 0, 0, VINF_SUCCESS, false, 8, RTZIPTYPE_LZ4,   RTZIPLEVEL_DEFAULT, "RTZipPar/LZ4/8"   },
+/*      { 0, 0, 0, VINF_SUCCESS, false, 0, RTZIPTYPE_ZLIB,  RTZIPLEVEL_DEFAULT, "RTZip/zlib"       }, - slow plus it randomly hits VERR_GENERAL_FAILURE atm. */
+        { 0, 0, 0, VINF_SUCCESS, true,  0, RTZIPTYPE_STORE, RTZIPLEVEL_DEFAULT, "RTZipBlock/Store" },
+        { 0, 0, 0, VINF_SUCCESS, true,  0, RTZIPTYPE_LZF,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZF"   },
+        { 0, 0, 0, VINF_SUCCESS, true,  0, RTZIPTYPE_LZ4,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZ4"   },
+        { 0, 0, 0, VINF_SUCCESS, true,  0, RTZIPTYPE_LZJB,  RTZIPLEVEL_DEFAULT, "RTZipBlock/LZJB"  },
+        { 0, 0, 0, VINF_SUCCESS, true,  0, RTZIPTYPE_LZO,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZO"   },
     };
     RTPrintf("tstCompressionBenchmark: TESTING..");
     for (uint32_t i = 0; i < cIterations; i++)
@@ -448,6 +457,44 @@ int main(int argc, char **argv)
                     continue;
                 g_cbCompr = pbDstPage - g_pabCompr;
             }
+            else if (aTests[j].cThreads)
+            {
+                PRTZIPPARCOMP pZipParComp;
+                rc = RTZipParCompCreate(&pZipParComp, NULL, ComprOutCallback, aTests[j].enmType, aTests[j].enmLevel,
+                                        aTests[j].cThreads, 0 /*cbFrame*/);
+                if (RT_FAILURE(rc))
+                {
+                    Error("Failed to create the parallel compressor for '%s' (#%u): %Rrc\n", aTests[j].pszName, j, rc);
+                    aTests[j].rc = rc;
+                    continue;
+                }
+
+                uint8_t const  *pbSrcPage = g_pabSrc;
+                for (size_t iPage = 0; iPage < g_cPages; iPage += cPagesAtATime)
+                {
+                    size_t cb = RT_MIN(g_cPages - iPage, cPagesAtATime) * PAGE_SIZE;
+                    rc = RTZipParCompress(pZipParComp, pbSrcPage, cb);
+                    if (RT_FAILURE(rc))
+                    {
+                        Error("RTZipParCompress failed for '%s' (#%u): %Rrc\n", aTests[j].pszName, j, rc);
+                        aTests[j].rc = rc;
+                        break;
+                    }
+                    pbSrcPage += cb;
+                }
+                if (RT_SUCCESS(rc))
+                {
+                    rc = RTZipParCompFinish(pZipParComp);
+                    if (RT_FAILURE(rc))
+                    {
+                        Error("RTZipParCompFinish failed for '%s' (#%u): %Rrc\n", aTests[j].pszName, j, rc);
+                        aTests[j].rc = rc;
+                    }
+                }
+                RTZipParCompDestroy(pZipParComp);
+                if (RT_FAILURE(rc))
+                    continue;
+            }
             else
             {
                 PRTZIPCOMP pZipComp;